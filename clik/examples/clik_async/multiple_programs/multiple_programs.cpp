@@ -0,0 +1,201 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "clik_async_api.h"
+#include "option_parser.h"
+
+// These headers contain the kernel binaries resulting from compiling the
+// 'vector_add' and 'ternary' examples' kernels.
+#include "ternary_binary.h"
+#include "vector_add_binary.h"
+
+int main(int argc, char **argv) {
+  // Process command line options.
+  size_t local_size = 16;
+  size_t global_size = 1024;
+  option_parser_t parser;
+  parser.help([]() {
+    fprintf(stderr,
+            "Usage: ./multiple_programs [--local-size L] [--global-size S]\n");
+  });
+  parser.option('L', "local-size", 1,
+                [&](const char *s) { local_size = strtoull(s, 0, 0); });
+  parser.option('S', "global-size", 1,
+                [&](const char *s) { global_size = strtoull(s, 0, 0); });
+  parser.parse(argv);
+  if (local_size < 1) {
+    fprintf(stderr, "error: local size must be positive\n");
+    return 7;
+  } else if (global_size < 1) {
+    fprintf(stderr, "error: global size must be positive\n");
+    return 7;
+  } else if ((global_size % local_size) != 0) {
+    fprintf(stderr,
+            "error: global size (%zd) must be a multiple of local size"
+            "(%zd)\n",
+            global_size, local_size);
+    return 7;
+  }
+
+  // Set up the device.
+  clik_device *device = clik_create_device();
+  if (!device) {
+    fprintf(stderr, "Unable to create a clik device.\n");
+    return 1;
+  }
+  clik_command_queue *queue = clik_get_device_queue(device);
+
+  // Load both kernel programs. They are different binaries, so each must run
+  // its own kernel even though both are loaded at the same time.
+  clik_program *vector_add_program =
+      clik_create_program(device, multiple_programs_vector_add_kernel_binary,
+                          multiple_programs_vector_add_kernel_binary_size);
+  clik_program *ternary_program =
+      clik_create_program(device, multiple_programs_ternary_kernel_binary,
+                          multiple_programs_ternary_kernel_binary_size);
+  if (!vector_add_program || !ternary_program) {
+    fprintf(stderr, "Unable to create programs from the kernel binaries.\n");
+    return 2;
+  }
+
+  // Initialize host data.
+  size_t num_elements = global_size;
+  std::vector<uint32_t> src1_data(num_elements);
+  std::vector<uint32_t> src2_data(num_elements);
+  std::vector<int32_t> out_data(num_elements);
+  for (size_t j = 0; j < num_elements; j++) {
+    src1_data[j] = j;
+    src2_data[j] = (j % 2) - j;
+    out_data[j] = -1;
+  }
+
+  // Create buffers in device memory.
+  uint64_t buffer_size = num_elements * sizeof(uint32_t);
+  clik_buffer *src1_buffer = clik_create_buffer(device, buffer_size);
+  clik_buffer *src2_buffer = clik_create_buffer(device, buffer_size);
+  clik_buffer *sum_buffer = clik_create_buffer(device, buffer_size);
+  clik_buffer *out_buffer = clik_create_buffer(device, buffer_size);
+  if (!src1_buffer || !src2_buffer || !sum_buffer || !out_buffer) {
+    fprintf(stderr, "Could not create buffers.\n");
+    return 3;
+  }
+
+  // Write host data to device memory.
+  if (!clik_enqueue_write_buffer(queue, src1_buffer, 0, &src1_data[0],
+                                 buffer_size)) {
+    fprintf(stderr, "Could not enqueue a write to the src1 buffer.\n");
+    return 4;
+  }
+  if (!clik_enqueue_write_buffer(queue, src2_buffer, 0, &src2_data[0],
+                                 buffer_size)) {
+    fprintf(stderr, "Could not enqueue a write to the src2 buffer.\n");
+    return 4;
+  }
+  if (!clik_enqueue_write_buffer(queue, out_buffer, 0, &out_data[0],
+                                 buffer_size)) {
+    fprintf(stderr, "Could not enqueue a write to the out buffer.\n");
+    return 4;
+  }
+
+  // Run the kernels, the output of the first one being the input of the
+  // second one.
+  clik_ndrange ndrange;
+  clik_init_ndrange_1d(&ndrange, num_elements, local_size);
+  printf(
+      "Running multiple_programs example (Global size: %zu, local size: "
+      "%zu)\n",
+      ndrange.global[0], ndrange.local[0]);
+
+  const size_t num_vector_add_args = 3;
+  clik_argument vector_add_args[num_vector_add_args];
+  clik_init_buffer_arg(&vector_add_args[0], src1_buffer);
+  clik_init_buffer_arg(&vector_add_args[1], src2_buffer);
+  clik_init_buffer_arg(&vector_add_args[2], sum_buffer);
+  clik_kernel *vector_add_kernel =
+      clik_create_kernel(vector_add_program, "kernel_main", &ndrange,
+                         &vector_add_args[0], num_vector_add_args);
+
+  const size_t num_ternary_args = 5;
+  int32_t bias = 1;
+  int32_t trueVal = 10;
+  int32_t falseVal = 20;
+  clik_argument ternary_args[num_ternary_args];
+  clik_init_buffer_arg(&ternary_args[0], sum_buffer);
+  clik_init_scalar_arg(&ternary_args[1], bias);
+  clik_init_buffer_arg(&ternary_args[2], out_buffer);
+  clik_init_scalar_arg(&ternary_args[3], trueVal);
+  clik_init_scalar_arg(&ternary_args[4], falseVal);
+  clik_kernel *ternary_kernel =
+      clik_create_kernel(ternary_program, "kernel_main", &ndrange,
+                         &ternary_args[0], num_ternary_args);
+
+  if (!vector_add_kernel || !ternary_kernel) {
+    fprintf(stderr, "Unable to create kernels.\n");
+    return 5;
+  } else if (!clik_enqueue_kernel(queue, vector_add_kernel) ||
+             !clik_enqueue_kernel(queue, ternary_kernel)) {
+    fprintf(stderr, "Could not enqueue the kernels.\n");
+    return 5;
+  }
+
+  // Read the data produced by the second kernel.
+  if (!clik_enqueue_read_buffer(queue, &out_data[0], out_buffer, 0,
+                                buffer_size)) {
+    fprintf(stderr, "Could not read the output data from the kernel.\n");
+    return 6;
+  }
+
+  // Start executing commands on the device.
+  clik_dispatch(queue);
+
+  // Wait for all commands to have finished executing on the device.
+  clik_wait(queue);
+
+  // Validate output buffer.
+  bool validated = true;
+  size_t num_errors = 0;
+  const size_t max_print_errors = 10;
+  for (size_t i = 0; i < num_elements; i++) {
+    int32_t expected = (i % 2) ? 11 : 21;
+    int32_t actual = out_data[i];
+    if (expected != actual) {
+      num_errors++;
+      if (num_errors <= max_print_errors) {
+        fprintf(stderr, "Result mismatch at %zu: expected %d, but got %d\n", i,
+                expected, actual);
+      }
+      validated = false;
+    }
+  }
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+
+  clik_release_buffer(src1_buffer);
+  clik_release_buffer(src2_buffer);
+  clik_release_buffer(sum_buffer);
+  clik_release_buffer(out_buffer);
+  clik_release_kernel(vector_add_kernel);
+  clik_release_kernel(ternary_kernel);
+  clik_release_program(vector_add_program);
+  clik_release_program(ternary_program);
+  clik_release_device(device);
+  return validated ? 0 : -1;
+}
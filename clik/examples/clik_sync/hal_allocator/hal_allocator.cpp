@@ -0,0 +1,112 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "allocator.h"
+
+#define CHECK(cond)                                                  \
+  if (!(cond)) {                                                     \
+    fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+            #cond);                                                  \
+    validated = false;                                               \
+  }
+
+int main() {
+  bool validated = true;
+  const hal::hal_size_t MiB = 1024 * 1024;
+
+  // Allocations which take up the whole range, the padding for alignment and
+  // the rounding up to a free list boundary must not make them fail.
+  {
+    hal::allocator_t allocator(0x1000, 4096);
+    CHECK(allocator.alloc(4096, 4096) == 0x1000);
+    CHECK(allocator.available() == 0);
+  }
+  {
+    const hal::hal_size_t size = 2048 * MiB;
+    hal::allocator_t allocator(0x80000000, size);
+    const hal::hal_addr_t addr = allocator.alloc(size - MiB, 128);
+    CHECK(addr == 0x80000000);
+    CHECK(allocator.available() == MiB);
+  }
+  {
+    // The only aligned address leaves exactly enough space after it.
+    hal::allocator_t allocator(0x1010, 4096 + 0xff0);
+    CHECK(allocator.alloc(4096, 4096) == 0x2000);
+    CHECK(allocator.alloc(1, 1) == 0x1010);
+    CHECK(allocator.alloc(4096, 1) == hal::hal_nullptr);
+  }
+  {
+    // The only block which fits once aligned is in neither the list the size
+    // maps to nor the list of the largest free blocks.
+    const hal::hal_size_t size = 64 * 1024;
+    hal::allocator_t allocator(0x10000, size);
+    const hal::hal_addr_t first = allocator.alloc(6000, 1);
+    const hal::hal_addr_t second = allocator.alloc(2193, 1);
+    const hal::hal_addr_t third = allocator.alloc(7000, 1);
+    const hal::hal_addr_t rest =
+        allocator.alloc(size - (6000 + 2193 + 7000), 1);
+    CHECK(first == 0x10000);
+    CHECK(second != hal::hal_nullptr);
+    CHECK(third != hal::hal_nullptr);
+    CHECK(rest != hal::hal_nullptr);
+    allocator.free(first);
+    allocator.free(third);
+    CHECK(allocator.alloc(4096, 4096) == 0x10000);
+  }
+
+  // Allocations are aligned, don't overlap, and freeing them merges the free
+  // space back into a single block.
+  {
+    const hal::hal_size_t size = 16 * MiB;
+    hal::allocator_t allocator(0x10000, size);
+    std::vector<hal::hal_addr_t> addrs;
+    std::vector<hal::hal_size_t> sizes;
+    for (hal::hal_size_t i = 0; i < 256; i++) {
+      const hal::hal_size_t alloc_size = 1 + (i * 977) % 20000;
+      const hal::hal_size_t alignment = hal::hal_size_t(1) << (i % 13);
+      const hal::hal_addr_t addr = allocator.alloc(alloc_size, alignment);
+      CHECK(addr != hal::hal_nullptr);
+      CHECK(addr % alignment == 0);
+      for (size_t j = 0; j < addrs.size(); j++) {
+        CHECK(addr + alloc_size <= addrs[j] || addrs[j] + sizes[j] <= addr);
+      }
+      addrs.push_back(addr);
+      sizes.push_back(alloc_size);
+    }
+    // Free every other allocation, then the rest.
+    for (size_t j = 0; j < addrs.size(); j += 2) {
+      allocator.free(addrs[j]);
+    }
+    for (size_t j = 1; j < addrs.size(); j += 2) {
+      allocator.free(addrs[j]);
+    }
+    const hal::allocator_t::stats_t stats = allocator.stats();
+    CHECK(stats.free_bytes == size);
+    CHECK(stats.free_blocks == 1);
+    CHECK(stats.largest_free_block == size);
+    CHECK(stats.allocations == 0);
+    CHECK(allocator.alloc(size, 1) == 0x10000);
+  }
+
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+  return validated ? 0 : -1;
+}
@@ -0,0 +1,145 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+
+// Stress benchmark for the HAL device memory allocator. Thousands of
+// allocations of mixed sizes and alignments are kept live while random ones
+// are freed and replaced, then the time taken per operation and the
+// fragmentation of the free space are reported.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "allocator.h"
+
+#define CHECK(cond)                                                  \
+  if (!(cond)) {                                                     \
+    fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+            #cond);                                                  \
+    validated = false;                                               \
+  }
+
+namespace {
+// xorshift64, so that every run performs the same operations
+uint64_t next_random(uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+// mostly small allocations, with some medium and a few large ones
+hal::hal_size_t random_size(uint64_t &state) {
+  const uint64_t kind = next_random(state) % 100;
+  if (kind < 75) {
+    return 1 + next_random(state) % 512;
+  } else if (kind < 95) {
+    return 1 + next_random(state) % (64 * 1024);
+  }
+  return 1 + next_random(state) % (1024 * 1024);
+}
+}  // namespace
+
+int main() {
+  bool validated = true;
+  const hal::hal_addr_t base = 0x10000000;
+  const hal::hal_size_t size = 1024 * 1024 * 1024;
+  const size_t max_live = 4096;
+  const size_t num_operations = 200000;
+
+  hal::allocator_t allocator(base, size);
+  uint64_t state = 0x9e3779b97f4a7c15;
+  std::vector<hal::hal_addr_t> live;
+  live.reserve(max_live);
+  // live allocations by address, to check that they never overlap
+  std::map<hal::hal_addr_t, hal::hal_size_t> ranges;
+  size_t num_allocs = 0;
+  size_t max_free_blocks = 0;
+  std::chrono::steady_clock::duration elapsed{};
+
+  for (size_t i = 0; i < num_operations && validated; i++) {
+    // fill up to the maximum number of live allocations first, then keep the
+    // number of live allocations around the maximum
+    const bool do_alloc =
+        live.size() < max_live / 2 ||
+        (live.size() < max_live && next_random(state) % 2 == 0);
+    if (do_alloc) {
+      const hal::hal_size_t alloc_size = random_size(state);
+      const hal::hal_size_t alignment = hal::hal_size_t(1)
+                                        << (next_random(state) % 13);
+      const auto start = std::chrono::steady_clock::now();
+      const hal::hal_addr_t addr = allocator.alloc(alloc_size, alignment);
+      elapsed += std::chrono::steady_clock::now() - start;
+      num_allocs++;
+      CHECK(addr != hal::hal_nullptr);
+      if (addr == hal::hal_nullptr) {
+        break;
+      }
+      CHECK(addr % alignment == 0);
+      CHECK(addr >= base && addr + alloc_size <= base + size);
+      auto next = ranges.lower_bound(addr);
+      CHECK(next == ranges.end() || addr + alloc_size <= next->first);
+      if (next != ranges.begin()) {
+        auto prev = std::prev(next);
+        CHECK(prev->first + prev->second <= addr);
+      }
+      ranges.emplace(addr, alloc_size);
+      live.push_back(addr);
+    } else {
+      const size_t index = next_random(state) % live.size();
+      const hal::hal_addr_t addr = live[index];
+      live[index] = live.back();
+      live.pop_back();
+      ranges.erase(addr);
+      const auto start = std::chrono::steady_clock::now();
+      allocator.free(addr);
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+    const size_t free_blocks = allocator.stats().free_blocks;
+    if (free_blocks > max_free_blocks) {
+      max_free_blocks = free_blocks;
+    }
+  }
+
+  const hal::allocator_t::stats_t stats = allocator.stats();
+  CHECK(stats.allocations == live.size());
+  const double ns_per_op =
+      std::chrono::duration<double, std::nano>(elapsed).count() /
+      double(num_operations);
+  printf("%zu operations (%zu allocations) with up to %zu live: %.1f ns per "
+         "operation\n",
+         num_operations, num_allocs, max_live, ns_per_op);
+  printf("%zu free blocks at peak, %zu at the end, largest free block %llu of "
+         "%llu free bytes\n",
+         max_free_blocks, stats.free_blocks,
+         static_cast<unsigned long long>(stats.largest_free_block),
+         static_cast<unsigned long long>(stats.free_bytes));
+
+  // freeing everything merges the free space back into a single block
+  for (const hal::hal_addr_t addr : live) {
+    allocator.free(addr);
+  }
+  const hal::allocator_t::stats_t final_stats = allocator.stats();
+  CHECK(final_stats.free_bytes == size);
+  CHECK(final_stats.free_blocks == 1);
+  CHECK(final_stats.allocations == 0);
+
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+  return validated ? 0 : -1;
+}
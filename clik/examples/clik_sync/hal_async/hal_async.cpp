@@ -0,0 +1,166 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "clik_hal_version.h"
+#include "hal.h"
+#include "hal_library.h"
+
+// A HAL device backed by host memory which can't execute kernels. It doesn't
+// override the asynchronous operations, which tests the synchronous fallbacks
+// provided by the HAL without needing a HAL library.
+class null_hal_device : public hal::hal_device_t {
+ public:
+  null_hal_device() : hal::hal_device_t(&info), memory(1 << 20) {}
+
+  hal::hal_kernel_t program_find_kernel(hal::hal_program_t,
+                                        const char *) override {
+    return hal::hal_invalid_kernel;
+  }
+  hal::hal_program_t program_load(const void *, hal::hal_size_t) override {
+    return hal::hal_invalid_program;
+  }
+  bool kernel_exec(hal::hal_program_t, hal::hal_kernel_t,
+                   const hal::hal_ndrange_t *, const hal::hal_arg_t *,
+                   uint32_t, uint32_t) override {
+    return false;
+  }
+  bool program_free(hal::hal_program_t) override { return false; }
+
+  hal::hal_addr_t mem_alloc(hal::hal_size_t size,
+                            hal::hal_size_t alignment) override {
+    hal::hal_size_t start = (next + alignment - 1) & ~(alignment - 1);
+    if (start + size > memory.size()) {
+      return hal::hal_nullptr;
+    }
+    next = start + size;
+    return base + start;
+  }
+  bool mem_free(hal::hal_addr_t) override { return true; }
+
+  bool mem_read(void *dst, hal::hal_addr_t src,
+                hal::hal_size_t size) override {
+    if (!in_range(src, size)) {
+      return false;
+    }
+    memcpy(dst, &memory[src - base], size);
+    return true;
+  }
+  bool mem_write(hal::hal_addr_t dst, const void *src,
+                 hal::hal_size_t size) override {
+    if (!in_range(dst, size)) {
+      return false;
+    }
+    memcpy(&memory[dst - base], src, size);
+    return true;
+  }
+
+ private:
+  bool in_range(hal::hal_addr_t addr, hal::hal_size_t size) const {
+    return addr >= base && addr - base + size <= memory.size();
+  }
+
+  static constexpr hal::hal_addr_t base = 0x10000;
+  hal::hal_device_info_t info = {};
+  std::vector<uint8_t> memory;
+  hal::hal_size_t next = 0;
+};
+
+// Queue a chain of dependent transfers without waiting in between and check
+// they executed in submission order. Returns true if the test passed.
+bool test_async_transfers(hal::hal_device_t *device, const char *name) {
+  const size_t num_elements = 1024;
+  const hal::hal_size_t buffer_size = num_elements * sizeof(uint32_t);
+  std::vector<uint32_t> src_data(num_elements);
+  std::vector<uint32_t> dst_data(num_elements, ~0u);
+  for (size_t i = 0; i < num_elements; i++) {
+    src_data[i] = i;
+  }
+  const uint32_t pattern = 0xabcdef01;
+
+  hal::hal_addr_t src_buffer = device->mem_alloc(buffer_size, 64);
+  hal::hal_addr_t dst_buffer = device->mem_alloc(buffer_size, 64);
+  if (src_buffer == hal::hal_nullptr || dst_buffer == hal::hal_nullptr) {
+    fprintf(stderr, "%s: could not allocate buffers.\n", name);
+    return false;
+  }
+
+  // Fill the destination, then overwrite its first half with a copy of the
+  // source, each operation depends on the one before it.
+  hal::hal_fence_t fences[4] = {
+      device->mem_write_async(src_buffer, src_data.data(), buffer_size),
+      device->mem_fill_async(dst_buffer, &pattern, sizeof(pattern),
+                             buffer_size),
+      device->mem_copy_async(dst_buffer, src_buffer, buffer_size / 2),
+      device->mem_read_async(dst_data.data(), dst_buffer, buffer_size)};
+  for (hal::hal_fence_t fence : fences) {
+    if (fence == hal::hal_invalid_fence) {
+      fprintf(stderr, "%s: could not submit an operation.\n", name);
+      return false;
+    }
+  }
+
+  // Waiting on the last fence waits for every operation before it, waiting
+  // again on an earlier fence returns immediately.
+  if (!device->fence_wait(fences[3]) || !device->fence_wait(fences[0])) {
+    fprintf(stderr, "%s: an operation failed.\n", name);
+    return false;
+  }
+
+  size_t num_errors = 0;
+  for (size_t i = 0; i < num_elements; i++) {
+    const uint32_t expected = (i < num_elements / 2) ? src_data[i] : pattern;
+    if (dst_data[i] != expected && ++num_errors <= 10) {
+      fprintf(stderr, "%s: result mismatch at %zu: expected %x, but got %x\n",
+              name, i, expected, dst_data[i]);
+    }
+  }
+
+  device->mem_free(src_buffer);
+  device->mem_free(dst_buffer);
+  return num_errors == 0;
+}
+
+int main() {
+  null_hal_device null_device;
+  bool validated = test_async_transfers(&null_device, "null device");
+
+  hal::hal_library_t library = nullptr;
+  hal::hal_t *hal =
+      hal::load_hal(CLIK_HAL_NAME, supported_hal_api_version, library);
+  if (!hal) {
+    fprintf(stderr, "Unable to load the HAL.\n");
+    return 1;
+  }
+  hal::hal_device_t *device = hal->device_create(0);
+  if (!device) {
+    fprintf(stderr, "Unable to create a HAL device.\n");
+    hal::unload_hal(library);
+    return 1;
+  }
+  validated &= test_async_transfers(device, hal->get_info().platform_name);
+  hal->device_delete(device);
+  hal::unload_hal(library);
+
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+  return validated ? 0 : -1;
+}
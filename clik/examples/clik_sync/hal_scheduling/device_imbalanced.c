@@ -0,0 +1,35 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "device_imbalanced.h"
+
+// Carry out the computation for one work-item. Every fourth work-group in the
+// first half of the N-D range does much more work than the others, so that
+// splitting work-groups evenly between hardware threads, whether in contiguous
+// or interleaved ranges, leaves some of them idle.
+__kernel void imbalanced(__global uint *dst, uint heavy_work, uint light_work,
+                         exec_state_t *item) {
+  uint tid = get_global_id(0, item);
+  uint group = get_group_id(0, item);
+  uint num_groups = get_global_size(0, item) / get_local_size(0, item);
+  uint heavy = ((group % 4) == 0) && (group < (num_groups / 2));
+  uint work = heavy ? heavy_work : light_work;
+  uint value = tid;
+  for (uint i = 0; i < work; i++) {
+    value = (value * 1664525u) + 1013904223u;
+  }
+  dst[tid] = value;
+}
@@ -0,0 +1,182 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "clik_hal_version.h"
+#include "hal.h"
+#include "hal_library.h"
+
+// This header contains the kernel binary resulting from compiling
+// 'device_imbalanced.c' and turning it into a C array using the Bin2H tool.
+#include "kernel_binary.h"
+
+namespace {
+const size_t local_size = 16;
+const size_t num_groups = 64;
+const uint32_t heavy_work = 512;
+const uint32_t light_work = 16;
+
+uint32_t expected_value(size_t tid) {
+  const size_t group = tid / local_size;
+  const bool heavy = ((group % 4) == 0) && (group < (num_groups / 2));
+  uint32_t value = tid;
+  for (uint32_t i = 0, e = heavy ? heavy_work : light_work; i < e; i++) {
+    value = (value * 1664525u) + 1013904223u;
+  }
+  return value;
+}
+
+// Run the imbalanced kernel on a new device of the HAL, with the given
+// REFSI_DYNAMIC_SCHEDULING setting. The per-hart elapsed cycles, when the
+// device reports them, are stored in `hart_cycles`. Returns true if the kernel
+// produced the expected results.
+bool run_imbalanced(hal::hal_t *hal, const char *dynamic_scheduling,
+                    std::vector<uint64_t> &hart_cycles) {
+  // The RefSi HALs read the scheduling mode when creating a device.
+  setenv("REFSI_DYNAMIC_SCHEDULING", dynamic_scheduling, 1);
+  hart_cycles.clear();
+  hal::hal_device_t *device = hal->device_create(0);
+  if (!device) {
+    fprintf(stderr, "Unable to create a HAL device.\n");
+    return false;
+  }
+  device->counter_set_enabled(true);
+
+  bool validated = false;
+  const size_t num_elements = local_size * num_groups;
+  const hal::hal_size_t buffer_size = num_elements * sizeof(uint32_t);
+  std::vector<uint32_t> dst_data(num_elements, ~0u);
+  hal::hal_addr_t dst_buffer = device->mem_alloc(buffer_size, 64);
+  hal::hal_program_t program = device->program_load(
+      hal_scheduling_kernel_binary, hal_scheduling_kernel_binary_size);
+  hal::hal_kernel_t kernel = hal::hal_invalid_kernel;
+  if (program != hal::hal_invalid_program) {
+    kernel = device->program_find_kernel(program, "kernel_main");
+  }
+  if (dst_buffer == hal::hal_nullptr || kernel == hal::hal_invalid_kernel) {
+    fprintf(stderr, "Unable to set up the kernel.\n");
+  } else {
+    hal::hal_ndrange_t ndrange = {
+        {0, 0, 0}, {num_elements, 1, 1}, {local_size, 1, 1}};
+    hal::hal_arg_t args[3];
+    args[0].kind = hal::hal_arg_address;
+    args[0].space = hal::hal_space_global;
+    args[0].size = 0;
+    args[0].address = dst_buffer;
+    args[1].kind = hal::hal_arg_value;
+    args[1].space = hal::hal_space_global;
+    args[1].size = sizeof(heavy_work);
+    args[1].pod_data = &heavy_work;
+    args[2].kind = hal::hal_arg_value;
+    args[2].space = hal::hal_space_global;
+    args[2].size = sizeof(light_work);
+    args[2].pod_data = &light_work;
+    if (!device->kernel_exec(program, kernel, &ndrange, args, 3, 1) ||
+        !device->mem_read(dst_data.data(), dst_buffer, buffer_size)) {
+      fprintf(stderr, "Could not execute the kernel.\n");
+    } else {
+      size_t num_errors = 0;
+      for (size_t i = 0; i < num_elements; i++) {
+        const uint32_t expected = expected_value(i);
+        if (dst_data[i] != expected && ++num_errors <= 10) {
+          fprintf(stderr, "Result mismatch at %zu: expected %u, but got %u\n",
+                  i, expected, dst_data[i]);
+        }
+      }
+      validated = (num_errors == 0);
+    }
+  }
+
+  // Retrieve the elapsed cycles of each hart.
+  const hal::hal_device_info_t *info = device->get_info();
+  for (uint32_t i = 0; i < info->num_counters; i++) {
+    const hal::hal_counter_description_t &desc = info->counter_descriptions[i];
+    if (strcmp(desc.name, "cycles") != 0) {
+      continue;
+    }
+    for (uint32_t j = 0; j < desc.contained_values; j++) {
+      uint64_t value = 0;
+      if (device->counter_read(desc.counter_id, value, j)) {
+        hart_cycles.push_back(value);
+      }
+    }
+  }
+
+  if (program != hal::hal_invalid_program) {
+    device->program_free(program);
+  }
+  if (dst_buffer != hal::hal_nullptr) {
+    device->mem_free(dst_buffer);
+  }
+  hal->device_delete(device);
+  return validated;
+}
+
+void print_hart_cycles(const char *mode, const std::vector<uint64_t> &cycles) {
+  printf("%s scheduling cycles per hart:", mode);
+  for (uint64_t value : cycles) {
+    printf(" %llu", (unsigned long long)value);
+  }
+  printf("\n");
+}
+}  // namespace
+
+int main() {
+  hal::hal_library_t library = nullptr;
+  hal::hal_t *hal =
+      hal::load_hal(CLIK_HAL_NAME, supported_hal_api_version, library);
+  if (!hal) {
+    fprintf(stderr, "Unable to load the HAL.\n");
+    return 1;
+  }
+
+  printf("Running hal_scheduling example (Global size: %zu, local size: %zu)\n",
+         local_size * num_groups, local_size);
+  std::vector<uint64_t> static_cycles;
+  std::vector<uint64_t> dynamic_cycles;
+  bool validated = run_imbalanced(hal, "0", static_cycles);
+  validated &= run_imbalanced(hal, "1", dynamic_cycles);
+  hal::unload_hal(library);
+
+  // The kernel takes as long as its busiest hart. Claiming work-groups
+  // dynamically must spread the heavy work-groups over the harts, devices
+  // which do not support dynamic scheduling take as long in both modes.
+  if (!static_cycles.empty() && !dynamic_cycles.empty()) {
+    print_hart_cycles("Static", static_cycles);
+    print_hart_cycles("Dynamic", dynamic_cycles);
+    const uint64_t static_max =
+        *std::max_element(static_cycles.begin(), static_cycles.end());
+    const uint64_t dynamic_max =
+        *std::max_element(dynamic_cycles.begin(), dynamic_cycles.end());
+    if (dynamic_max > static_max) {
+      fprintf(stderr,
+              "Dynamic scheduling took %llu cycles, static scheduling %llu\n",
+              (unsigned long long)dynamic_max, (unsigned long long)static_max);
+      validated = false;
+    }
+  }
+
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+  return validated ? 0 : -1;
+}
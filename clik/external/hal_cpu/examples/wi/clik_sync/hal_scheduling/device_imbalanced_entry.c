@@ -0,0 +1,31 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "device_imbalanced.h"
+
+// Execute the kernel once for each work-group. This function is called on each
+// hardware thread of the device. Together, all hardware threads on the device
+// execute the same work-group. The N-D range can also be divided into slices in
+// order to have more control over how work-groups are mapped to hardware
+// threads.
+void kernel_main(const imbalanced_args *args, exec_state_t *ctx) {
+  wg_info_t *wg = &ctx->wg;
+  ctx->local_id[0] = ctx->thread_id;
+  for (uint i = 0; i < wg->num_groups[0]; i++) {
+    wg->group_id[0] = i;
+    imbalanced(args->dst, args->heavy_work, args->light_work, ctx);
+  }
+}
@@ -18,24 +18,36 @@
 #define _CLIK_RUNTIME_CPU_HAL_H
 
 #include <condition_variable>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include <ucontext.h>
+
 #include "hal.h"
 
 using elf_program = void *;
 struct exec_state;
 
-struct cpu_barrier {
-  std::mutex mutex;
-  std::condition_variable entry;
-  int threads_entered = 0;
-  std::condition_variable exit;
-  int sequence_id = 0;
+// A work-item executing as a user-space fiber. Barriers switch from the fiber
+// back to the scheduler of the worker thread it runs on.
+struct cpu_fiber {
+  ucontext_t context;
+  exec_state *exec = nullptr;
+  bool done = false;
+};
 
-  void wait(int num_threads);
+// A thread executing a contiguous range of the work-items of a work-group.
+struct cpu_worker {
+  ucontext_t scheduler;
+  cpu_fiber *fibers = nullptr;
+  size_t num_fibers = 0;
+  cpu_fiber *current = nullptr;
 };
 
 class cpu_hal : public hal::hal_device_t {
@@ -89,7 +101,29 @@ class cpu_hal : public hal::hal_device_t {
   bool mem_write(hal::hal_addr_t dst, const void *src,
                  hal::hal_size_t size) override;
 
+  // get a host pointer to a range of target memory
+  void *mem_host_ptr(hal::hal_addr_t addr, hal::hal_size_t size) override;
+
  private:
+  // A program loaded with dlopen. Programs are shared between identical loads
+  // and stay loaded for a while after their last use, so that loading the
+  // same binary again is free.
+  struct loaded_program {
+    uint32_t hash = 0;
+    std::vector<uint8_t> binary;
+    // path of the temporary file the program was loaded from, if any
+    std::string path;
+    // anonymous file the program was loaded from, if any. It is kept open
+    // while the program is loaded so that its /proc/self/fd path is not
+    // reused, as dlopen would return this program for that path.
+    int memfd = -1;
+    uint32_t ref_count = 0;
+  };
+
+  elf_program load_elf(const void *data, hal::hal_size_t size,
+                       std::string &path, int &memfd);
+  void unload_program(hal::hal_program_t program);
+
   bool pack_args(std::vector<uint8_t> &packed_data, const hal::hal_arg_t *args,
                  uint32_t num_args, elf_program program, uint32_t hal_flags);
   void pack_arg(std::vector<uint8_t> &packed_data, const void *value,
@@ -103,6 +137,18 @@ class cpu_hal : public hal::hal_device_t {
 
   void kernel_entry(exec_state *state);
 
+  // Execute all work-items of a work-group as fibers spread over the calling
+  // thread and the worker pool.
+  void run_work_items(exec_state *items, size_t num_items);
+  void run_fibers(cpu_worker &worker);
+  void pool_thread(size_t index);
+  void start_pool();
+  // Wait for all workers to have run their fibers up to the next barrier.
+  void wait_for_workers();
+  void leave_workers();
+  static void fiber_entry();
+  static void fiber_barrier();
+
   bool hal_debug() const { return debug; }
 
   std::mutex &hal_lock;
@@ -110,8 +156,36 @@ class cpu_hal : public hal::hal_device_t {
   bool debug = false;
   uint32_t local_mem_size = 8 << 20;
   uint8_t *local_mem = nullptr;
-  cpu_barrier barrier;
-  std::map<hal::hal_program_t, std::string> binary_files;
+  std::map<hal::hal_program_t, loaded_program> programs;
+  // loaded programs indexed by the hash of their binary
+  std::unordered_multimap<uint32_t, hal::hal_program_t> program_hashes;
+  // programs no longer referenced but still loaded, most recently used first
+  std::list<hal::hal_program_t> idle_programs;
+  static constexpr size_t max_idle_programs = 16;
+  // reused between launches to avoid an allocation per kernel_exec
+  std::vector<uint8_t> packed_args;
+
+  // Fibers and their stacks, reused between launches.
+  std::vector<cpu_fiber> fibers;
+  std::vector<std::unique_ptr<uint8_t[]>> fiber_stacks;
+  static constexpr size_t fiber_stack_size = 512 << 10;
+
+  // Persistent worker threads. workers[0] is the thread calling kernel_exec,
+  // pool thread `i` uses workers[i + 1].
+  std::vector<cpu_worker> workers;
+  std::vector<std::thread> pool;
+  std::mutex pool_mutex;
+  std::condition_variable pool_start;
+  std::condition_variable pool_done;
+  uint64_t launch_id = 0;
+  size_t active_workers = 0;
+  size_t workers_running = 0;
+  bool pool_shutdown = false;
+  // Work-group barrier state shared by the active workers.
+  std::condition_variable barrier_cond;
+  size_t barrier_active = 0;
+  size_t barrier_entered = 0;
+  uint64_t barrier_sequence = 0;
 };
 
 #endif
@@ -21,14 +21,15 @@
 #if defined(_WIN32)
 #include <process.h>
 #else
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <string>
-#include <thread>
 
 #include "device/device_if.h"
 
@@ -37,7 +38,20 @@ cpu_hal::cpu_hal(hal::hal_device_info_t *info, std::mutex &hal_lock)
   local_mem = (uint8_t *)malloc(local_mem_size);
 }
 
-cpu_hal::~cpu_hal() { free(local_mem); }
+cpu_hal::~cpu_hal() {
+  {
+    std::lock_guard<std::mutex> locker(pool_mutex);
+    pool_shutdown = true;
+  }
+  pool_start.notify_all();
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+  while (!programs.empty()) {
+    unload_program(programs.begin()->first);
+  }
+  free(local_mem);
+}
 
 hal::hal_kernel_t cpu_hal::program_find_kernel(hal::hal_program_t program,
                                                const char *name) {
@@ -81,13 +95,42 @@ static std::string get_temp_file_for_program(const void *data,
   return ss.str();
 }
 
-hal::hal_program_t cpu_hal::program_load(const void *data,
-                                         hal::hal_size_t size) {
-  std::lock_guard<std::mutex> locker(hal_lock);
+// Load a program with dlopen, from an anonymous in-memory file where supported
+// and from a temporary file otherwise. `path` is set to the temporary file and
+// `memfd` to the in-memory file, which must stay open until the program is
+// unloaded.
+elf_program cpu_hal::load_elf(const void *data, hal::hal_size_t size,
+                              std::string &path, int &memfd) {
+  path.clear();
+  memfd = -1;
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  int fd = memfd_create("clik_kernel", MFD_CLOEXEC);
+  if (fd >= 0) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    hal::hal_size_t written = 0;
+    while (written < size) {
+      ssize_t result = write(fd, bytes + written, size - written);
+      if (result <= 0) {
+        break;
+      }
+      written += result;
+    }
+    elf_program elf = nullptr;
+    if (written == size) {
+      std::string fd_path = "/proc/self/fd/" + std::to_string(fd);
+      elf = dlopen(fd_path.c_str(), RTLD_LAZY);
+    }
+    if (elf) {
+      memfd = fd;
+      return elf;
+    }
+    close(fd);
+  }
+#endif
   std::string kernel_path = get_temp_file_for_program(data, size);
   FILE *f = fopen(kernel_path.c_str(), "wb");
   if (!f) {
-    return hal::hal_invalid_program;
+    return nullptr;
   }
   fwrite(data, 1, size, f);
   fclose(f);
@@ -95,10 +138,47 @@ hal::hal_program_t cpu_hal::program_load(const void *data,
   if (!elf) {
     fprintf(stderr, "Error : dlopen failed '%s'\n", dlerror());
     remove(kernel_path.c_str());
+    return nullptr;
+  }
+  path = kernel_path;
+  return elf;
+}
+
+hal::hal_program_t cpu_hal::program_load(const void *data,
+                                         hal::hal_size_t size) {
+  std::lock_guard<std::mutex> locker(hal_lock);
+  if (!data || !size) {
+    return hal::hal_invalid_program;
+  }
+
+  // Reuse an already loaded program with the same contents.
+  uint32_t hash = djb2_hash((const uint8_t *)data, size);
+  auto range = program_hashes.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    loaded_program &loaded = programs[it->second];
+    if ((loaded.binary.size() == size) &&
+        (memcmp(loaded.binary.data(), data, size) == 0)) {
+      if (loaded.ref_count++ == 0) {
+        idle_programs.remove(it->second);
+      }
+      return it->second;
+    }
+  }
+
+  std::string path;
+  int memfd = -1;
+  elf_program elf = load_elf(data, size, path, memfd);
+  if (!elf) {
     return hal::hal_invalid_program;
   }
   hal::hal_program_t program = (hal::hal_program_t)elf;
-  binary_files[program] = kernel_path;
+  loaded_program &loaded = programs[program];
+  loaded.hash = hash;
+  loaded.binary.assign((const uint8_t *)data, (const uint8_t *)data + size);
+  loaded.path = path;
+  loaded.memfd = memfd;
+  loaded.ref_count = 1;
+  program_hashes.emplace(hash, program);
   return program;
 }
 
@@ -106,45 +186,194 @@ bool cpu_hal::program_free(hal::hal_program_t program) {
   if (program == hal::hal_invalid_program) {
     return false;
   }
+  std::lock_guard<std::mutex> locker(hal_lock);
+  auto it = programs.find(program);
+  if (it == programs.end() || it->second.ref_count == 0) {
+    return false;
+  }
+
+  // Keep the program loaded in case the same binary is loaded again, only
+  // unloading the least recently used idle programs.
+  if (--it->second.ref_count == 0) {
+    idle_programs.push_front(program);
+    if (idle_programs.size() > max_idle_programs) {
+      unload_program(idle_programs.back());
+    }
+  }
+  return true;
+}
+
+void cpu_hal::unload_program(hal::hal_program_t program) {
+  auto it = programs.find(program);
+  if (it == programs.end()) {
+    return;
+  }
+  idle_programs.remove(program);
+  auto range = program_hashes.equal_range(it->second.hash);
+  for (auto hash_it = range.first; hash_it != range.second; ++hash_it) {
+    if (hash_it->second == program) {
+      program_hashes.erase(hash_it);
+      break;
+    }
+  }
   dlclose((void *)program);
 
-  // Remove the program's binary from the disk.
-  auto it = binary_files.find(program);
-  if (it != binary_files.end()) {
-    remove(it->second.c_str());
-    binary_files.erase(it);
+  // Remove the program's binary from the disk or from memory.
+  if (!it->second.path.empty()) {
+    remove(it->second.path.c_str());
+  }
+  if (it->second.memfd >= 0) {
+    close(it->second.memfd);
   }
+  programs.erase(it);
+}
 
-  return true;
+// Worker executing fibers on the current thread, if any.
+static thread_local cpu_worker *current_worker = nullptr;
+
+void cpu_hal::start_pool() {
+  size_t num_workers = std::max(1u, std::thread::hardware_concurrency());
+  workers.resize(num_workers);
+  for (size_t i = 1; i < num_workers; i++) {
+    pool.emplace_back(&cpu_hal::pool_thread, this, i);
+  }
 }
 
-// Pauses the current thread until all threads have encountered the barrier.
-void cpu_barrier::wait(int num_threads) {
-  std::unique_lock<std::mutex> locker(mutex);
-  // Each barrier event in the execution of the kernel is given a sequence
-  // number, which is used to determine when it has been passed.
-  int current_id = sequence_id;
-  if (threads_entered == 0) {
-    // The first thread is responsible for waiting until all other threads have
-    // entered the barrier. The barrier is 'closed'.
-    threads_entered++;
-    while (threads_entered < num_threads) {
-      entry.wait(locker);
+void cpu_hal::pool_thread(size_t index) {
+  uint64_t last_launch = 0;
+  std::unique_lock<std::mutex> locker(pool_mutex);
+  for (;;) {
+    pool_start.wait(locker, [&] {
+      return pool_shutdown || (launch_id != last_launch);
+    });
+    if (pool_shutdown) {
+      return;
+    }
+    last_launch = launch_id;
+    if (index >= active_workers) {
+      continue;
+    }
+    locker.unlock();
+    run_fibers(workers[index]);
+    locker.lock();
+    if (--workers_running == 0) {
+      pool_done.notify_one();
     }
-    // Once all threads have entered the barrier, update the sequence to 'open'
-    // the barrier and wake up the other threads.
-    sequence_id = current_id + 1;
-    threads_entered = 0;
-    exit.notify_all();
+  }
+}
+
+// Pauses the calling worker until all active workers have reached the
+// barrier, i.e. until every work-item of the work-group has.
+void cpu_hal::wait_for_workers() {
+  std::unique_lock<std::mutex> locker(pool_mutex);
+  uint64_t sequence = barrier_sequence;
+  if (++barrier_entered == barrier_active) {
+    barrier_entered = 0;
+    barrier_sequence++;
+    barrier_cond.notify_all();
   } else {
-    // Notify the first thread that one more thread has entered the barrier.
-    threads_entered++;
-    entry.notify_one();
-    // Wait for the barrier to be opened.
-    while (current_id == sequence_id) {
-      exit.wait(locker);
+    barrier_cond.wait(locker, [&] { return barrier_sequence != sequence; });
+  }
+}
+
+// Stop taking part in barriers once all of a worker's fibers have finished.
+void cpu_hal::leave_workers() {
+  std::lock_guard<std::mutex> locker(pool_mutex);
+  barrier_active--;
+  if (barrier_entered && (barrier_entered == barrier_active)) {
+    barrier_entered = 0;
+    barrier_sequence++;
+    barrier_cond.notify_all();
+  }
+}
+
+void cpu_hal::fiber_entry() {
+  cpu_fiber *fiber = current_worker->current;
+  fiber->exec->hal->kernel_entry(fiber->exec);
+  fiber->done = true;
+  // Returning resumes the worker's scheduler through uc_link.
+}
+
+// Switch from the current work-item to the next one on this worker. Work-items
+// are resumed once all of them have reached the barrier.
+void cpu_hal::fiber_barrier() {
+  cpu_worker *worker = current_worker;
+  if (!worker || !worker->current) {
+    // Work-groups with a single work-item do not run as fibers.
+    return;
+  }
+  swapcontext(&worker->current->context, &worker->scheduler);
+}
+
+// Run a worker's fibers in turn, each until it either finishes or reaches a
+// barrier, synchronizing with the other workers in between.
+void cpu_hal::run_fibers(cpu_worker &worker) {
+  current_worker = &worker;
+  size_t live = worker.num_fibers;
+  while (live > 0) {
+    for (size_t i = 0; i < worker.num_fibers; i++) {
+      cpu_fiber &fiber = worker.fibers[i];
+      if (fiber.done) {
+        continue;
+      }
+      worker.current = &fiber;
+      swapcontext(&worker.scheduler, &fiber.context);
+      if (fiber.done) {
+        live--;
+      }
+    }
+    if (live > 0) {
+      wait_for_workers();
+    }
+  }
+  worker.current = nullptr;
+  current_worker = nullptr;
+  leave_workers();
+}
+
+void cpu_hal::run_work_items(exec_state *items, size_t num_items) {
+  if (workers.empty()) {
+    start_pool();
+  }
+  fibers.resize(num_items);
+  while (fiber_stacks.size() < num_items) {
+    fiber_stacks.emplace_back(new uint8_t[fiber_stack_size]);
+  }
+
+  // Spread the work-items evenly over the workers.
+  size_t num_workers = std::min(workers.size(), num_items);
+  for (size_t i = 0; i < num_workers; i++) {
+    size_t begin = (num_items * i) / num_workers;
+    size_t end = (num_items * (i + 1)) / num_workers;
+    cpu_worker &worker = workers[i];
+    worker.fibers = &fibers[begin];
+    worker.num_fibers = end - begin;
+    for (size_t j = begin; j < end; j++) {
+      cpu_fiber &fiber = fibers[j];
+      fiber.exec = &items[j];
+      fiber.done = false;
+      getcontext(&fiber.context);
+      fiber.context.uc_stack.ss_sp = fiber_stacks[j].get();
+      fiber.context.uc_stack.ss_size = fiber_stack_size;
+      fiber.context.uc_link = &worker.scheduler;
+      makecontext(&fiber.context, &cpu_hal::fiber_entry, 0);
     }
   }
+
+  {
+    std::lock_guard<std::mutex> locker(pool_mutex);
+    active_workers = num_workers;
+    workers_running = num_workers - 1;
+    barrier_active = num_workers;
+    barrier_entered = 0;
+    launch_id++;
+  }
+  if (num_workers > 1) {
+    pool_start.notify_all();
+  }
+  run_fibers(workers[0]);
+  std::unique_lock<std::mutex> locker(pool_mutex);
+  pool_done.wait(locker, [&] { return workers_running == 0; });
 }
 
 void cpu_hal::kernel_entry(exec_state *exec) {
@@ -190,13 +419,11 @@ bool cpu_hal::kernel_exec(hal::hal_program_t program, hal::hal_kernel_t kernel,
   }
   exec.kernel_entry = (entry_point_fn)kernel;
   exec.flags = flags;
-  exec.barrier = [](exec_state *exec) {
-    exec->hal->barrier.wait(exec->num_threads);
-  };
+  exec.barrier = [](exec_state *) { fiber_barrier(); };
   exec.hal = this;
 
   // Pack arguments.
-  std::vector<uint8_t> packed_args;
+  packed_args.clear();
   if (!pack_args(packed_args, args, num_args, elf, exec.flags)) {
     return false;
   }
@@ -213,17 +440,10 @@ bool cpu_hal::kernel_exec(hal::hal_program_t program, hal::hal_kernel_t kernel,
     thread_exec.thread_id = thread_id;
   }
 
-  // Execute the kernel on all threads.
+  // Execute the kernel on all threads. Work-items run as fibers on persistent
+  // worker threads rather than on a thread each.
   if (num_threads > 1) {
-    std::vector<std::thread *> threads(num_threads);
-    for (unsigned i = 0; i < num_threads; i++) {
-      threads[i] =
-          new std::thread(&cpu_hal::kernel_entry, this, &exec_for_thread[i]);
-    }
-    for (std::thread *t : threads) {
-      t->join();
-      delete t;
-    }
+    run_work_items(exec_for_thread.data(), num_threads);
   } else {
     kernel_entry(&exec_for_thread[0]);
   }
@@ -367,6 +587,12 @@ bool cpu_hal::mem_write(hal::hal_addr_t dst, const void *src,
   return true;
 }
 
+void *cpu_hal::mem_host_ptr(hal::hal_addr_t addr, hal::hal_size_t size) {
+  // Target memory is host memory.
+  (void)size;
+  return (void *)addr;
+}
+
 bool cpu_hal::mem_fill(hal::hal_addr_t dst, const void *pattern,
                        hal::hal_size_t pattern_size, hal::hal_size_t size) {
   if (!pattern) {
@@ -376,7 +602,7 @@ bool cpu_hal::mem_fill(hal::hal_addr_t dst, const void *pattern,
   while (size >= pattern_size) {
     memcpy(pdst, pattern, pattern_size);
     size -= pattern_size;
-    dst += pattern_size;
+    pdst += pattern_size;
   }
   return true;
 }
@@ -76,7 +76,7 @@ class cpu_hal_platform : public hal::hal_t {
     hal_device_info.linker_script =
         std::string(hal_cpu_linker_script, hal_cpu_linker_script_size);
 
-    constexpr static uint32_t implemented_api_version = 6;
+    constexpr static uint32_t implemented_api_version = 11;
     static_assert(implemented_api_version == hal_t::api_version,
                   "Implemented API version for CPU HAL does not match hal.h");
     hal_info.platform_name = hal_device_info.target_name;
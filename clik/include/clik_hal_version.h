@@ -19,6 +19,6 @@
 
 #include <stdint.h>
 
-constexpr static uint32_t supported_hal_api_version = 6;
+constexpr static uint32_t supported_hal_api_version = 11;
 
 #endif  // _CLIK_CLIK_HAL_VERSION_H
@@ -27,6 +27,11 @@ test_info = [
     ("hello", "-S4 -L1", "hello"),
     ("vector_add", "", None),
     ("copy_buffer", "", None),
+    ("hal_async", "", None),
+    ("hal_allocator", "", None),
+    ("hal_allocator_stress", "", None),
+    ("hal_scheduling", "", None),
+    ("refsi_riscv_encoder", "", None),
     ("hello_async", "-S8 -L4", "hello"),
     ("vector_add_async", "", None),
     ("vector_add_wfv", "", None),
@@ -38,6 +43,7 @@ test_info = [
     ("blur", "", "blur"),
     ("concatenate_dma", "-S8", None),
     ("copy_buffer_async", "", None),
+    ("multiple_programs", "", None),
     ("hello_mux", "-S8 -L4", "hello"),
     ("vector_add_mux", "", None),
     ("barrier_sum_mux", "", None),
@@ -0,0 +1,29 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "device_imbalanced.h"
+
+// Execute the kernel once for each work-item contained in the work-group
+// specified by the work-group information. This function is called once per
+// work-group in the N-D range. It can be called on different hardware threads,
+// however different threads execute separate work-groups.
+void kernel_main(const imbalanced_args *args, wg_info_t *wg) {
+  exec_state_t *ctx = get_context(wg);
+  for (uint i = 0; i < wg->local_size[0]; i++) {
+    ctx->local_id[0] = i;
+    imbalanced(args->dst, args->heavy_work, args->light_work, ctx);
+  }
+}
@@ -80,6 +80,13 @@ REFSI_API refsi_result refsiTerminate();
 /// @param family Type of RefSi device to open a connection to.
 REFSI_API refsi_device_t refsiOpenDevice(refsi_device_family family);
 
+/// @brief Open a new instance of the device. Unlike refsiOpenDevice, which
+/// always returns the same device, each call creates a device with its own
+/// memory and accelerator cores, which can execute commands concurrently with
+/// the other devices.
+/// @param family Type of RefSi device to create.
+REFSI_API refsi_device_t refsiOpenDeviceInstance(refsi_device_family family);
+
 /// @brief Shut down the device. Any pointer returned by refsiGetMappedAddress
 /// can no longer be used after this function is called.
 REFSI_API refsi_result refsiShutdownDevice(refsi_device_t device);
@@ -26,11 +26,14 @@
 #include "fesvr/memif.h"
 #include "common_devices.h"
 
+#include <atomic>
 #include <vector>
 #include <bitset>
 #include <string>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <condition_variable>
 #include <sys/types.h>
 
 class mmu_t;
@@ -44,6 +47,9 @@ struct slim_sim_config {
   bool log = false;
   bool hal_debug = false;
   size_t num_harts = 0;
+  // Number of host threads used to simulate harts. A single thread simulates
+  // the harts round-robin, which is deterministic.
+  size_t num_threads = 1;
   unsigned pmp_num = 0;
   unsigned pmp_granularity = 0;
   bool log_commits = false;
@@ -86,7 +92,9 @@ public:
   // function will print an error message and abort).
   void configure_log(bool enable_log, bool enable_commitlog);
 
-  size_t get_current_hart_id() const { return current_hart_id; }
+  size_t get_current_hart_id() const {
+    return parallel ? worker_hart_id : current_hart_id;
+  }
   processor_t* get_hart(size_t index) const;
   size_t get_hart_number() const;
   size_t get_max_active_harts() const { return max_harts; }
@@ -116,6 +124,13 @@ public:
   log_file_t log_file;
 
   void step(size_t n); // step through simulation
+  void check_hart(processor_t *hart);
+  // step harts on several host threads until the simulation exits
+  void run_parallel(size_t num_workers);
+  void run_worker(size_t first_hart, size_t hart_stride);
+  void step_hart_parallel(size_t hart_id, size_t n);
+  void set_exited_locked(reg_t exit_code);
+  std::unique_lock<std::mutex> lock_devices();
   void handle_trap(processor_t *hart);
   void handle_breakpoint(processor_t *hart);
   void return_from_trap(state_t *hart_state, reg_t new_pc);
@@ -127,7 +142,30 @@ public:
   size_t current_hart_id;
   bool debug;
   bool log;
-  bool signal_exit = false;
+  std::atomic<bool> signal_exit{false};
+  size_t num_threads = 1;
+  // true while harts are being stepped by run_parallel
+  bool parallel = false;
+  // hart being stepped by the current host thread in parallel mode
+  static thread_local size_t worker_hart_id;
+  // set when the hart stepped by the current host thread stops itself, at a
+  // barrier or on exit, so that it can be checked without taking state_mutex
+  static thread_local bool worker_hart_stopped;
+  // straight-line code found at a given PC, cached per hart in parallel mode
+  struct basic_block_t {
+    reg_t pc = ~reg_t(0);
+    size_t steps = 0;
+    bool atomic = false;
+  };
+  static const size_t BLOCK_CACHE_SIZE = 1024;
+  std::vector<std::vector<basic_block_t>> hart_block_cache;
+  // guards the hart running state, barriers and exit state in parallel mode
+  std::mutex state_mutex;
+  std::condition_variable state_cond;
+  // serializes device accesses, which are not thread-safe, in parallel mode
+  std::mutex device_mutex;
+  // serializes atomic memory operations and LR/SC sequences in parallel mode
+  std::mutex atomic_mutex;
   std::bitset<REFSI_SIM_MAX_HARTS> is_hart_running;
   std::vector<reg_t> hart_barrier_address;
   int64_t exit_code = 0;
@@ -18,6 +18,10 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
 #include "refsidrv/refsi_device.h"
 #include "refsidrv/refsi_device_m.h"
 #include "refsidrv/refsi_device_g.h"
@@ -25,6 +29,10 @@
 static refsi_device_t global_m1_device = nullptr;
 static refsi_device_t global_g1_device = nullptr;
 static bool initialized = false;
+// Devices created by refsiOpenDeviceInstance. They can be shut down from
+// different threads.
+static std::mutex instances_lock;
+static std::vector<refsi_device_t> device_instances;
 
 refsi_result refsiInitialize() {
   if (!initialized) {
@@ -42,6 +50,14 @@ refsi_result refsiTerminate() {
   if (global_g1_device) {
     refsiShutdownDevice(global_g1_device);
   }
+  std::vector<refsi_device_t> instances;
+  {
+    std::lock_guard<std::mutex> guard(instances_lock);
+    instances.swap(device_instances);
+  }
+  for (refsi_device_t device : instances) {
+    delete device;
+  }
   return refsi_success;
 }
 
@@ -75,6 +91,31 @@ refsi_device_t refsiOpenDevice(refsi_device_family family) {
   return nullptr;
 }
 
+refsi_device_t refsiOpenDeviceInstance(refsi_device_family family) {
+  const char *isa = nullptr;
+  int vlen = 0;
+  refsi_device_t device = nullptr;
+  switch (family) {
+  default:
+    return nullptr;
+  case REFSI_DEFAULT:
+  case REFSI_M:
+    device = new RefSiMDevice();
+    break;
+  case REFSI_G:
+    RefSiGDevice::getDefaultConfig(isa, vlen);
+    device = new RefSiGDevice(isa, vlen);
+    break;
+  }
+  if (device->initialize() != refsi_success) {
+    delete device;
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(instances_lock);
+  device_instances.push_back(device);
+  return device;
+}
+
 refsi_result refsiShutdownDevice(refsi_device_t device) {
   if (device) {
     if (device == global_m1_device) {
@@ -84,7 +125,15 @@ refsi_result refsiShutdownDevice(refsi_device_t device) {
       delete device;
       global_g1_device = nullptr;
     } else {
-      return refsi_failure;
+      std::unique_lock<std::mutex> guard(instances_lock);
+      auto instance = std::find(device_instances.begin(),
+                                device_instances.end(), device);
+      if (instance == device_instances.end()) {
+        return refsi_failure;
+      }
+      device_instances.erase(instance);
+      guard.unlock();
+      delete device;
     }
     return refsi_success;
   } else {
@@ -27,6 +27,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
+#include <thread>
 #include <signal.h>
 
 slim_sim_config::slim_sim_config() {
@@ -56,6 +57,10 @@ slim_sim_config::slim_sim_config() {
   }
 
   num_harts = 1;
+  num_threads = 1;
+  if (const char *val = getenv("SPIKE_SIM_THREADS")) {
+    num_threads = std::max(atoi(val), 1);
+  }
   pmp_num = 16;
   pmp_granularity = 4;
   log_commits = false;
@@ -70,6 +75,7 @@ slim_sim_t::slim_sim_t(const slim_sim_config &config, MemoryInterface &mem_if)
       current_hart_id(0),
       debug(config.debug),
       log(false),
+      num_threads(config.num_threads),
       isa_parser(config.isa, config.priv) {
   debugger.reset(new debugger_t(*this));
 
@@ -84,6 +90,7 @@ slim_sim_t::slim_sim_t(const slim_sim_config &config, MemoryInterface &mem_if)
     harts[i]->set_pmp_granularity(config.pmp_granularity);
   }
   hart_barrier_address.resize(config.num_harts, 0);
+  hart_block_cache.resize(config.num_harts);
 
   configure_log(config.log, config.log_commits);
 }
@@ -104,6 +111,10 @@ int slim_sim_t::run() {
     hart_barrier_address[i] = 0;
     harts[i]->get_state()->profiler_mode = false;
   }
+  // The program may have been reloaded since the last run.
+  for (std::vector<basic_block_t> &cache : hart_block_cache) {
+    cache.clear();
+  }
   if (!debug && log) {
     set_procs_debug(true);
   }
@@ -121,6 +132,8 @@ int slim_sim_t::run() {
         debugger->read_command();
         debugger->run_command();
       }
+    } else if (!log && (std::min(num_threads, get_hart_number()) > 1)) {
+      run_parallel(std::min(num_threads, get_hart_number()));
     } else {
       step(INTERLEAVE);
     }
@@ -136,11 +149,7 @@ void slim_sim_t::step(size_t n) {
       processor_t *hart = harts[current_hart_id];
       state_t *hart_state = hart->get_state();
       hart->step(steps);
-      if (hart_state->mcause->read() != 0 && trap_handler) {
-        handle_trap(hart);
-      } else if (hart_state->pc == hart_state->bp_addr) {
-        handle_breakpoint(hart);
-      }
+      check_hart(hart);
     }
 
     current_step += steps;
@@ -157,6 +166,185 @@ void slim_sim_t::step(size_t n) {
   }
 }
 
+void slim_sim_t::check_hart(processor_t *hart) {
+  state_t *hart_state = hart->get_state();
+  if (hart_state->mcause->read() != 0 && trap_handler) {
+    handle_trap(hart);
+  } else if (hart_state->pc == hart_state->bp_addr) {
+    handle_breakpoint(hart);
+  }
+}
+
+thread_local size_t slim_sim_t::worker_hart_id = 0;
+thread_local bool slim_sim_t::worker_hart_stopped = false;
+
+void slim_sim_t::run_parallel(size_t num_workers) {
+  // Harts are statically assigned to workers, the calling thread is the first
+  // worker.
+  parallel = true;
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; i++) {
+    workers.emplace_back(&slim_sim_t::run_worker, this, i, num_workers);
+  }
+  run_worker(0, num_workers);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  parallel = false;
+}
+
+void slim_sim_t::run_worker(size_t first_hart, size_t hart_stride) {
+  std::unique_lock<std::mutex> lock(state_mutex);
+  while (!signal_exit) {
+    bool stepped = false;
+    for (size_t i = first_hart; i < get_hart_number() && !signal_exit;
+         i += hart_stride) {
+      if (!is_hart_running[i]) {
+        continue;
+      }
+      lock.unlock();
+      step_hart_parallel(i, INTERLEAVE);
+      lock.lock();
+      stepped = true;
+    }
+    // All of this worker's harts are waiting at a barrier or have exited.
+    if (!stepped && !signal_exit) {
+      state_cond.wait(lock);
+    }
+  }
+}
+
+namespace {
+// Returns true for AMOs as well as LR and SC.
+bool is_atomic_insn(insn_t insn) {
+  return (insn.length() == 4) && ((insn.bits() & 0x7f) == 0x2f);
+}
+
+bool is_load_reserved_insn(insn_t insn) {
+  return is_atomic_insn(insn) && (((insn.bits() >> 27) & 0x1f) == 0x02);
+}
+
+bool is_store_conditional_insn(insn_t insn) {
+  return is_atomic_insn(insn) && (((insn.bits() >> 27) & 0x1f) == 0x03);
+}
+
+// Returns true for instructions which may not fall through to the next one,
+// as well as system instructions since they may trap, and fences.
+bool ends_basic_block(insn_t insn) {
+  const uint64_t bits = insn.bits();
+  if (insn.length() == 2) {
+    const uint64_t quadrant = bits & 0x3;
+    const uint64_t funct3 = (bits >> 13) & 0x7;
+    return (quadrant == 1 && (funct3 == 1 || funct3 == 5 || funct3 >= 6)) ||
+           (quadrant == 2 && funct3 == 4);
+  }
+  switch (bits & 0x7f) {
+    case 0x63:  // branch
+    case 0x67:  // jalr
+    case 0x6f:  // jal
+    case 0x73:  // system
+    case 0x0f:  // fence
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+void slim_sim_t::step_hart_parallel(size_t hart_id, size_t n) {
+  worker_hart_id = hart_id;
+  worker_hart_stopped = false;
+  processor_t *hart = harts[hart_id];
+  state_t *hart_state = hart->get_state();
+  mmu_t *mmu = hart->get_mmu();
+  std::vector<basic_block_t> &block_cache = hart_block_cache[hart_id];
+  if (block_cache.empty()) {
+    block_cache.resize(BLOCK_CACHE_SIZE);
+  }
+  // Maximum length of an LR/SC sequence which is guaranteed to make progress.
+  const size_t max_lr_sc_length = 16;
+
+  for (size_t i = 0; i < n;) {
+    // Find the straight-line code up to the next atomic instruction, which
+    // can be stepped without synchronizing with the other harts. A prefix of
+    // such code is also straight-line, so cached blocks are simply clamped to
+    // the remaining number of steps.
+    size_t steps = 0;
+    bool atomic = false;
+    const reg_t block_pc = hart_state->pc;
+    basic_block_t &block = block_cache[(block_pc >> 1) % BLOCK_CACHE_SIZE];
+    if (block.pc == block_pc) {
+      steps = std::min(block.steps, n - i);
+      atomic = block.atomic && (steps == block.steps);
+    } else {
+      reg_t pc = block_pc;
+      try {
+        while ((i + steps) < n) {
+          insn_t insn = mmu->load_insn(pc).insn;
+          if (is_atomic_insn(insn)) {
+            atomic = true;
+            break;
+          }
+          steps++;
+          if (ends_basic_block(insn)) {
+            break;
+          }
+          pc += insn.length();
+        }
+        block.pc = block_pc;
+        block.steps = steps;
+        block.atomic = atomic;
+      } catch (trap_t &) {
+        // Let the hart raise the fault itself.
+        steps = std::max(steps, size_t(1));
+      }
+    }
+
+    if (steps == 0 && atomic) {
+      // Atomics are performed by spike as a separate load and store, so they
+      // are serialized across harts. A load reservation is held until the
+      // matching store conditional.
+      std::lock_guard<std::mutex> guard(atomic_mutex);
+      insn_t insn = mmu->load_insn(hart_state->pc).insn;
+      const bool reserved = is_load_reserved_insn(insn);
+      hart->step(1);
+      steps = 1;
+      while (reserved && steps < max_lr_sc_length &&
+             hart_state->mcause->read() == 0) {
+        try {
+          insn = mmu->load_insn(hart_state->pc).insn;
+        } catch (trap_t &) {
+          break;
+        }
+        hart->step(1);
+        steps++;
+        if (is_store_conditional_insn(insn)) {
+          break;
+        }
+      }
+      mmu->yield_load_reservation();
+    } else {
+      hart->step(steps);
+    }
+    i += steps;
+
+    // Only this thread can stop the hart, other harts can only abort the
+    // whole simulation, so neither check needs state_mutex.
+    check_hart(hart);
+    if (worker_hart_stopped || signal_exit.load(std::memory_order_relaxed)) {
+      break;
+    }
+  }
+}
+
+std::unique_lock<std::mutex> slim_sim_t::lock_devices() {
+  std::unique_lock<std::mutex> lock(device_mutex, std::defer_lock);
+  if (parallel) {
+    lock.lock();
+  }
+  return lock;
+}
+
 void slim_sim_t::run_single_step(bool noisy, size_t steps) {
   set_procs_debug(noisy);
   for (size_t i = 0; i < steps && !signal_exit; i++) {
@@ -255,6 +443,7 @@ bool slim_sim_t::mmio_load(reg_t addr, size_t len, uint8_t* bytes) {
     return false;
   }
   unit_id_t unit = make_unit(unit_kind::acc_hart, get_current_hart_id());
+  auto lock = lock_devices();
   return mem_if.load(addr, len, bytes, unit);
 }
 
@@ -263,6 +452,7 @@ bool slim_sim_t::mmio_store(reg_t addr, size_t len, const uint8_t* bytes) {
     return false;
   }
   unit_id_t unit = make_unit(unit_kind::acc_hart, get_current_hart_id());
+  auto lock = lock_devices();
   return mem_if.store(addr, len, bytes, unit);
 }
 
@@ -271,6 +461,7 @@ char* slim_sim_t::addr_to_mem(reg_t addr) {
     return NULL;
   }
   unit_id_t unit = make_unit(unit_kind::acc_hart, get_current_hart_id());
+  auto lock = lock_devices();
   return (char *)mem_if.addr_to_mem(addr, sizeof(uint8_t), unit);
 }
 
@@ -278,30 +469,43 @@ void slim_sim_t::proc_reset(unsigned id) {
 }
 
 void slim_sim_t::set_exited(reg_t exit_code) {
+  std::lock_guard<std::mutex> guard(state_mutex);
+  set_exited_locked(exit_code);
+}
+
+void slim_sim_t::set_exited_locked(reg_t exit_code) {
+  if (parallel) {
+    worker_hart_stopped = true;
+  }
   if (exit_code != 0) {
     // When a thread exits with a non-zero code, abort simulation.
     is_hart_running.reset();
   } else {
     // When a thread exits gracefully, wait for other threads to have finished
     // executing before stopping the simulator.
-    is_hart_running[current_hart_id] = false;
+    is_hart_running[get_current_hart_id()] = false;
     if (is_hart_running.any()) {
       return;
     }
   }
   this->exit_code = exit_code;
   signal_exit = true;
+  state_cond.notify_all();
 }
 
 bool slim_sim_t::handle_barrier(reg_t link_address) {
+  std::lock_guard<std::mutex> guard(state_mutex);
+
   // Put the hart to sleep and record the link address. It is used to identify
   // the call site of the barrier in user code and error when different harts
   // hit different barriers at the same time.
-  hart_barrier_address[current_hart_id] = link_address;
-  is_hart_running[current_hart_id] = false;
+  const size_t hart_id = get_current_hart_id();
+  hart_barrier_address[hart_id] = link_address;
+  is_hart_running[hart_id] = false;
 
   // Wait for all harts to be asleep.
   if (is_hart_running.any()) {
+    worker_hart_stopped = parallel;
     return true;
   }
 
@@ -310,7 +514,7 @@ bool slim_sim_t::handle_barrier(reg_t link_address) {
   for (size_t i = 1; i < get_hart_number(); i++) {
     if (hart_barrier_address[i] != barrier_address) {
       fprintf(stderr, "error: all threads must hit the same barrier\n");
-      set_exited(-1);
+      set_exited_locked(-1);
       return false;
     }
   }
@@ -320,6 +524,7 @@ bool slim_sim_t::handle_barrier(reg_t link_address) {
     hart_barrier_address[i] = 0;
     is_hart_running[i] = true;
   }
+  state_cond.notify_all();
   return true;
 }
 
@@ -64,6 +64,13 @@ typedef struct exec_state {
   ALIGN8 uint32_t flags;
   ALIGN4 uint32_t next_xfer_id;
   ALIGN8 uint32_t thread_id;
+  // Address of a 32-bit counter in device memory, incremented atomically by
+  // harts to claim work-groups when dynamic scheduling is enabled.
+  ALIGN8 uint64_t next_group_addr;
+  // One past the index of the last work-group to claim from the counter. The
+  // counter starts at the index of the first one, which is only non-zero when
+  // part of the N-D range is executed.
+  ALIGN8 uint64_t group_end;
 } exec_state_t;
 
 #define REFSI_MAGIC ('R' | ('e' << 8) | ('S' << 16) | ('i' << 24))
@@ -76,6 +83,10 @@ typedef struct exec_state {
 // Launch the kernel using the work-group-per-thread mode.
 #define REFSI_THREAD_MODE_WG            1
 
+// Harts claim work-groups one at a time from a shared counter instead of each
+// executing a fixed range of work-groups.
+#define REFSI_FLAG_DYNAMIC_SCHEDULING   (1 << 1)
+
 // Needed to implement 'print'.
 int vprintm(const char* s, va_list vl);
 
@@ -17,9 +17,13 @@
 #ifndef _HAL_REFSI_REFSI_HAL_H
 #define _HAL_REFSI_REFSI_HAL_H
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "common_devices.h"
@@ -108,6 +112,66 @@ class refsi_hal_device : public hal::hal_device_t {
   bool mem_write(hal::hal_addr_t dst, const void *src,
                  hal::hal_size_t size) override;
 
+  // get a host pointer to a range of target memory
+  void *mem_host_ptr(hal::hal_addr_t addr, hal::hal_size_t size) override;
+
+  // make host writes to a range of target memory visible to the target
+  bool mem_host_flush(hal::hal_addr_t addr, hal::hal_size_t size) override;
+
+  // make target writes to a range of target memory visible to the host
+  bool mem_host_invalidate(hal::hal_addr_t addr,
+                           hal::hal_size_t size) override;
+
+  // read a strided region of target memory to the host
+  bool mem_read_rect(void *dst, hal::hal_addr_t src,
+                     const hal::hal_mem_rect_t *rect) override;
+
+  // write a strided region of host memory to the target
+  bool mem_write_rect(hal::hal_addr_t dst, const void *src,
+                      const hal::hal_mem_rect_t *rect) override;
+
+  // execute a kernel on the target, by executing all of its work-groups with
+  // kernel_exec_groups
+  bool kernel_exec(hal::hal_program_t program, hal::hal_kernel_t kernel,
+                   const hal::hal_ndrange_t *nd_range,
+                   const hal::hal_arg_t *args, uint32_t num_args,
+                   uint32_t work_dim) override;
+
+  // queue operations which are executed in submission order on the device's
+  // worker thread, one at a time under the HAL lock, so a transfer never
+  // overlaps a running kernel
+  hal::hal_fence_t mem_read_async(void *dst, hal::hal_addr_t src,
+                                  hal::hal_size_t size) override;
+  hal::hal_fence_t mem_write_async(hal::hal_addr_t dst, const void *src,
+                                   hal::hal_size_t size) override;
+  hal::hal_fence_t mem_copy_async(hal::hal_addr_t dst, hal::hal_addr_t src,
+                                  hal::hal_size_t size) override;
+  hal::hal_fence_t mem_fill_async(hal::hal_addr_t dst, const void *pattern,
+                                  hal::hal_size_t pattern_size,
+                                  hal::hal_size_t size) override;
+  hal::hal_fence_t mem_read_rect_async(
+      void *dst, hal::hal_addr_t src, const hal::hal_mem_rect_t *rect) override;
+  hal::hal_fence_t mem_write_rect_async(
+      hal::hal_addr_t dst, const void *src,
+      const hal::hal_mem_rect_t *rect) override;
+  hal::hal_fence_t mem_copy_rect_async(
+      hal::hal_addr_t dst, hal::hal_addr_t src,
+      const hal::hal_mem_rect_t *rect) override;
+  hal::hal_fence_t kernel_exec_async(hal::hal_program_t program,
+                                     hal::hal_kernel_t kernel,
+                                     const hal::hal_ndrange_t *nd_range,
+                                     const hal::hal_arg_t *args,
+                                     uint32_t num_args,
+                                     uint32_t work_dim) override;
+
+  // wait for a queued operation and those submitted before it to complete
+  bool fence_wait(hal::hal_fence_t fence) override;
+
+  /// @brief Finish the queued operations and stop the worker thread. This
+  /// must be called before the device is destroyed, since queued operations
+  /// call into the derived device classes.
+  void stop_worker();
+
   bool counter_read(uint32_t counter_id, uint64_t &out,
                     uint32_t index) override;
 
@@ -146,7 +210,31 @@ class refsi_hal_device : public hal::hal_device_t {
   std::vector<hal::util::hal_counter_value_t> host_counter_data;
   bool counters_enabled = false;
   bool debug = false;
+  // Harts claim work-groups from a shared counter rather than being given a
+  // fixed share of the N-D range, which balances uneven work-groups.
+  bool dynamic_scheduling = false;
   std::map<refsi_memory_map_kind, refsi_memory_map_entry> mem_map;
+
+ private:
+  /// @brief Append an operation to the worker thread's queue, starting the
+  /// thread if needed, and return its fence.
+  hal::hal_fence_t submit(std::function<bool()> operation);
+  void worker_main();
+
+  /// @brief Protects the members used to communicate with the worker thread.
+  /// This is separate from the HAL lock, which the queued operations take.
+  std::mutex async_lock;
+  std::condition_variable async_cond;
+  std::deque<std::function<bool()>> async_queue;
+  /// @brief Fence of the last operation submitted. Fences are handed out in
+  /// submission order, starting from one.
+  hal::hal_fence_t async_submitted = hal::hal_invalid_fence;
+  /// @brief Fence of the last operation the worker thread completed.
+  hal::hal_fence_t async_completed = hal::hal_invalid_fence;
+  /// @brief Set when a queued operation fails, reported by `fence_wait`.
+  bool async_failed = false;
+  bool async_stop = false;
+  std::thread async_worker;
 };
 
 class RefSiMemoryWrapper : public MemoryDeviceBase {
@@ -35,11 +35,12 @@ class refsi_g1_hal_device : public refsi_hal_device {
 
   bool initialize(refsi_locker &locker) override;
 
-  // execute a kernel on the target
-  bool kernel_exec(hal::hal_program_t program, hal::hal_kernel_t kernel,
-                   const hal::hal_ndrange_t *nd_range,
-                   const hal::hal_arg_t *args, uint32_t num_args,
-                   uint32_t work_dim) override;
+  // execute a range of the work-groups of a kernel on the target
+  bool kernel_exec_groups(hal::hal_program_t program, hal::hal_kernel_t kernel,
+                          const hal::hal_ndrange_t *nd_range,
+                          const hal::hal_arg_t *args, uint32_t num_args,
+                          uint32_t work_dim, hal::hal_size_t group_begin,
+                          hal::hal_size_t group_end) override;
 
   // copy memory between target buffers
   bool mem_copy(hal::hal_addr_t dst, hal::hal_addr_t src,
@@ -33,16 +33,25 @@ class refsi_m1_hal_device : public refsi_hal_device {
 
   bool initialize(refsi_locker &locker) override;
 
-  // execute a kernel on the target
-  bool kernel_exec(hal::hal_program_t program, hal::hal_kernel_t kernel,
-                   const hal::hal_ndrange_t *nd_range,
-                   const hal::hal_arg_t *args, uint32_t num_args,
-                   uint32_t work_dim) override;
+  // execute a range of the work-groups of a kernel on the target
+  bool kernel_exec_groups(hal::hal_program_t program, hal::hal_kernel_t kernel,
+                          const hal::hal_ndrange_t *nd_range,
+                          const hal::hal_arg_t *args, uint32_t num_args,
+                          uint32_t work_dim, hal::hal_size_t group_begin,
+                          hal::hal_size_t group_end) override;
 
   // copy memory between target buffers
   bool mem_copy(hal::hal_addr_t dst, hal::hal_addr_t src,
                 hal::hal_size_t size) override;
 
+  // copy a list of memory ranges between target buffers
+  bool mem_copy_list(const hal::hal_mem_copy_t *copies,
+                     uint32_t num_copies) override;
+
+  // copy a strided region between target buffers
+  bool mem_copy_rect(hal::hal_addr_t dst, hal::hal_addr_t src,
+                     const hal::hal_mem_rect_t *rect) override;
+
  private:
   bool createWindows(refsi_locker &locker);
   bool createWindow(refsi_command_buffer &cb, uint32_t win_id,
@@ -51,6 +60,7 @@ class refsi_m1_hal_device : public refsi_hal_device {
   bool createROM(refsi_locker &locker);
   void encodeKernelExit(riscv_encoder &enc);
   void encodeLaunchKernel(riscv_encoder &enc, unsigned num_dims);
+  void encodeLaunchKernelDynamic(riscv_encoder &enc);
 
   unsigned num_harts_per_core = 0;
   unsigned num_cores = 0;
@@ -58,6 +68,7 @@ class refsi_m1_hal_device : public refsi_hal_device {
   hal::hal_addr_t rom_base = 0;
   hal::hal_addr_t rom_size = 0;
   std::vector<hal::hal_addr_t> launch_kernel_addrs;
+  hal::hal_addr_t launch_kernel_dynamic_addr = 0;
 
   hal::hal_addr_t elf_mem_base = 0;
   hal::hal_addr_t elf_mem_size = 0;
@@ -74,14 +74,20 @@ public:
   size_t size() const { return insns.size() * sizeof(uint32_t); }
 
   uint32_t addADDI(unsigned rd, unsigned rs, uint32_t imm);
+  uint32_t addAMOADD_W(unsigned rd, unsigned rs2, unsigned rs1);
+  uint32_t addBLTU(unsigned rs1, unsigned rs2, int32_t offset);
   uint32_t addLI(unsigned rd, uint32_t imm) { return addADDI(rd, ZERO, imm); }
   uint32_t addMulInst(riscv_mul_opcode opc, unsigned rd, unsigned rs1,
                       unsigned rs2);
   uint32_t addMV(unsigned rd, unsigned rs) { return addADDI(rd, rs, 0); }
   uint32_t addECALL();
   uint32_t addJR(unsigned rs) { return addJALR(ZERO, rs, 0); }
+  uint32_t addJ(int32_t offset) { return addJAL(ZERO, offset); }
+  uint32_t addJAL(unsigned rd, int32_t offset);
   uint32_t addJALR(unsigned rd, unsigned rs, uint32_t imm);
+  uint32_t addLD(unsigned rd, unsigned rs, uint32_t imm);
   uint32_t addLW(unsigned rd, unsigned rs, uint32_t imm);
+  uint32_t addSD(unsigned rs2, unsigned rs1, uint32_t imm);
   uint32_t addSW(unsigned rs2, unsigned rs1, uint32_t imm);
 
 private:
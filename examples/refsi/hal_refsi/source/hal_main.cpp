@@ -21,6 +21,8 @@
 #include "linker_script.h"
 #include "hal_riscv_common.h"
 
+#include <map>
+#include <memory>
 #include <mutex>
 
 namespace {
@@ -49,6 +51,10 @@ protected:
   riscv::hal_device_info_riscv_t hal_device_info;
   std::mutex lock;
   bool initialized = false;
+  // True while a HAL device uses the device opened by the driver.
+  bool shared_device_in_use = false;
+  // Locks of the HAL devices which use their own device instance.
+  std::map<hal::hal_device_t *, std::unique_ptr<std::mutex>> instance_locks;
 #if defined(HAL_REFSI_TARGET_M1)
   refsi_device_family family = REFSI_M;
 #elif defined(HAL_REFSI_TARGET_G1)
@@ -77,32 +83,65 @@ public:
     if (!initialized || (index > 0)) {
       return nullptr;
     }
-    refsi_device_t device = refsiOpenDevice(family);
+    // Once the device opened by the driver is in use, further HAL devices are
+    // given a new instance of the device with its own lock, so that they can
+    // execute kernels concurrently.
+    std::unique_ptr<std::mutex> instance_lock;
+    refsi_device_t device = nullptr;
+    if (shared_device_in_use) {
+      instance_lock.reset(new std::mutex());
+      device = refsiOpenDeviceInstance(family);
+    } else {
+      device = refsiOpenDevice(family);
+    }
     if (!device) {
       return nullptr;
     }
+    std::mutex &device_lock = instance_lock ? *instance_lock : lock;
     std::unique_ptr<refsi_hal_device> hal_device;
     switch (family) {
     default:
       refsiShutdownDevice(device);
       return nullptr;
     case REFSI_M:
-      hal_device.reset(new refsi_m1_hal_device(device, &hal_device_info, lock));
+      hal_device.reset(
+          new refsi_m1_hal_device(device, &hal_device_info, device_lock));
       break;
     case REFSI_G:
-      hal_device.reset(new refsi_g1_hal_device(device, &hal_device_info, lock));
+      hal_device.reset(
+          new refsi_g1_hal_device(device, &hal_device_info, device_lock));
       break;
     }
+    // Nothing else can access a new device instance yet, so holding the HAL
+    // lock is enough to initialize it.
     if (!hal_device->initialize(locker)) {
       return nullptr;
     }
+    if (instance_lock) {
+      instance_locks[hal_device.get()] = std::move(instance_lock);
+    } else {
+      shared_device_in_use = true;
+    }
     return hal_device.release();
   }
 
   // destroy a device instance
   bool device_delete(hal::hal_device_t *device) override {
     // No locking - this is done by refsi_hal_device's destructor.
-    delete static_cast<refsi_hal_device *>(device);
+    auto *refsi_device = static_cast<refsi_hal_device *>(device);
+    if (refsi_device) {
+      refsi_device->stop_worker();
+    }
+    delete refsi_device;
+    if (device) {
+      refsi_locker locker(lock);
+      auto instance = instance_locks.find(device);
+      if (instance != instance_locks.end()) {
+        instance_locks.erase(instance);
+      } else {
+        shared_device_in_use = false;
+      }
+    }
     return device != nullptr;
   }
 
@@ -119,7 +158,7 @@ public:
   }
 
   refsi_hal() {
-    constexpr static uint32_t implemented_api_version = 6;
+    constexpr static uint32_t implemented_api_version = 11;
     static_assert(implemented_api_version == hal_t::api_version,
                   "Implemented API version for RefSi HAL does not match hal.h");
     hal_info.num_devices = 1;
@@ -172,6 +211,9 @@ public:
     hal_device_info.supports_doubles = false;
 #if defined(HAL_REFSI_MODE_WG)
     hal_device_info.max_workgroup_size = 1024;
+    // Harts claim work-groups from a counter, which can start and stop at any
+    // work-group.
+    hal_device_info.supports_group_range = true;
 #elif defined(HAL_REFSI_MODE_WI)
     // Executing one work-item per hart limits the maximum work-group size to
     // the number of harts.
@@ -180,6 +222,7 @@ public:
 #error Either HAL_REFSI_MODE_WG or HAL_REFSI_MODE_WI needs to be defined.
 #endif
     hal_device_info.is_little_endian = true;
+    hal_device_info.supports_async = true;
     hal_device_info.linker_script =
         std::string(hal_refsi_linker_script, hal_refsi_linker_script_size);
 
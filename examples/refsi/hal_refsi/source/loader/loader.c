@@ -56,6 +56,23 @@ int execute_wg_per_thread_kernel(exec_state_t *exec) {
   const size_t tail_id = divisable_groups + exec->thread_id;
 
   wg_kernel_fn kernel = (wg_kernel_fn)exec->kernel_entry;
+  if (exec->flags & REFSI_FLAG_DYNAMIC_SCHEDULING) {
+    // Keep claiming the next work-group until all of them have been executed,
+    // so that harts which finish early take on more work.
+    uint32_t *next_group = (uint32_t *)(uintptr_t)exec->next_group_addr;
+    for (;;) {
+      const size_t i = __atomic_fetch_add(next_group, 1, __ATOMIC_RELAXED);
+      if (i >= exec->group_end) {
+        break;
+      }
+      wg->group_id[0] = i % ngx;
+      wg->group_id[1] = (i / ngx) % ngy;
+      wg->group_id[2] = (i / (ngx * ngy)) % ngz;
+      kernel(exec->packed_args, wg);
+    }
+    return 0;
+  }
+
   for (size_t i = group_begin; i < group_end; ++i) {
     wg->group_id[0] = i % ngx;
     wg->group_id[1] = (i / ngx) % ngy;
@@ -32,6 +32,9 @@ refsi_hal_device::refsi_hal_device(refsi_device_t device,
       debug = true;
     }
   }
+  if (const char *val = getenv("REFSI_DYNAMIC_SCHEDULING")) {
+    dynamic_scheduling = (strcmp(val, "0") != 0);
+  }
 
   // Query memory map ranges.
   refsi_device_info_t device_info;
@@ -45,7 +48,10 @@ refsi_hal_device::refsi_hal_device(refsi_device_t device,
   }
 }
 
-refsi_hal_device::~refsi_hal_device() {}
+refsi_hal_device::~refsi_hal_device() {
+  assert(!async_worker.joinable() &&
+         "stop_worker must be called before destroying the device");
+}
 
 refsi_hal_kernel *refsi_hal_program::find_kernel(const char *name) {
   std::string name_str(name);
@@ -312,6 +318,100 @@ bool refsi_hal_device::mem_write(hal::hal_addr_t dst, const void *src,
   return mem_write(dst, src, size, locker);
 }
 
+void *refsi_hal_device::mem_host_ptr(hal::hal_addr_t addr,
+                                     hal::hal_size_t size) {
+  refsi_locker locker(hal_lock);
+  if (hal_debug()) {
+    fprintf(stderr, "refsi_hal_device::mem_host_ptr(addr=0x%08lx, size=%ld)\n",
+            addr, size);
+  }
+  // Device memory is backed by host memory for the lifetime of the device.
+  return refsiGetMappedAddress(device, addr, size);
+}
+
+bool refsi_hal_device::mem_host_flush(hal::hal_addr_t addr,
+                                      hal::hal_size_t size) {
+  refsi_locker locker(hal_lock);
+  if (hal_debug()) {
+    fprintf(stderr,
+            "refsi_hal_device::mem_host_flush(addr=0x%08lx, size=%ld)\n", addr,
+            size);
+  }
+  return refsi_success == refsiFlushDeviceMemory(device, addr, size);
+}
+
+bool refsi_hal_device::mem_host_invalidate(hal::hal_addr_t addr,
+                                           hal::hal_size_t size) {
+  refsi_locker locker(hal_lock);
+  if (hal_debug()) {
+    fprintf(stderr,
+            "refsi_hal_device::mem_host_invalidate(addr=0x%08lx, size=%ld)\n",
+            addr, size);
+  }
+  return refsi_success == refsiInvalidateDeviceMemory(device, addr, size);
+}
+
+bool refsi_hal_device::mem_read_rect(void *dst, hal::hal_addr_t src,
+                                     const hal::hal_mem_rect_t *rect) {
+  refsi_locker locker(hal_lock);
+  if (hal_debug()) {
+    fprintf(stderr,
+            "refsi_hal_device::mem_read_rect(src=0x%08lx, region=%ldx%ldx%ld)"
+            "\n",
+            src, rect->region[0], rect->region[1], rect->region[2]);
+  }
+  // Take the lock once for the whole region rather than once per row.
+  for (hal::hal_size_t z = 0; z < rect->region[2]; z++) {
+    for (hal::hal_size_t y = 0; y < rect->region[1]; y++) {
+      const hal::hal_size_t dst_offset =
+          (z * rect->dst_pitch[1]) + (y * rect->dst_pitch[0]);
+      const hal::hal_size_t src_offset =
+          (z * rect->src_pitch[1]) + (y * rect->src_pitch[0]);
+      if (!mem_read((uint8_t *)dst + dst_offset, src + src_offset,
+                    rect->region[0], locker)) {
+        return false;
+      }
+    }
+  }
+
+  // TODO: Remove once performance counters are accumulative.
+  if (counters_enabled) {
+    host_counter_data[CTR_HOST_MEM_READ].set_value(
+        0, rect->region[0] * rect->region[1] * rect->region[2]);
+  }
+  return true;
+}
+
+bool refsi_hal_device::mem_write_rect(hal::hal_addr_t dst, const void *src,
+                                      const hal::hal_mem_rect_t *rect) {
+  refsi_locker locker(hal_lock);
+  if (hal_debug()) {
+    fprintf(stderr,
+            "refsi_hal_device::mem_write_rect(dst=0x%08lx, "
+            "region=%ldx%ldx%ld)\n",
+            dst, rect->region[0], rect->region[1], rect->region[2]);
+  }
+  for (hal::hal_size_t z = 0; z < rect->region[2]; z++) {
+    for (hal::hal_size_t y = 0; y < rect->region[1]; y++) {
+      const hal::hal_size_t dst_offset =
+          (z * rect->dst_pitch[1]) + (y * rect->dst_pitch[0]);
+      const hal::hal_size_t src_offset =
+          (z * rect->src_pitch[1]) + (y * rect->src_pitch[0]);
+      if (!mem_write(dst + dst_offset, (const uint8_t *)src + src_offset,
+                     rect->region[0], locker)) {
+        return false;
+      }
+    }
+  }
+
+  // TODO: Remove once performance counters are accumulative.
+  if (counters_enabled) {
+    host_counter_data[CTR_HOST_MEM_WRITE].set_value(
+        0, rect->region[0] * rect->region[1] * rect->region[2]);
+  }
+  return true;
+}
+
 bool refsi_hal_device::mem_fill(hal::hal_addr_t dst, const void *pattern,
                                 hal::hal_size_t pattern_size,
                                 hal::hal_size_t size) {
@@ -406,3 +506,130 @@ bool RefSiMemoryWrapper::store(reg_t addr, size_t len, const uint8_t *bytes,
   return refsiWriteDeviceMemory(device, addr, bytes, len, unit_id) ==
          refsi_success;
 }
+
+hal::hal_fence_t refsi_hal_device::mem_read_async(void *dst,
+                                                  hal::hal_addr_t src,
+                                                  hal::hal_size_t size) {
+  return submit([=] { return mem_read(dst, src, size); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_write_async(hal::hal_addr_t dst,
+                                                   const void *src,
+                                                   hal::hal_size_t size) {
+  return submit([=] { return mem_write(dst, src, size); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_copy_async(hal::hal_addr_t dst,
+                                                  hal::hal_addr_t src,
+                                                  hal::hal_size_t size) {
+  return submit([=] { return mem_copy(dst, src, size); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_fill_async(hal::hal_addr_t dst,
+                                                  const void *pattern,
+                                                  hal::hal_size_t pattern_size,
+                                                  hal::hal_size_t size) {
+  return submit([=] { return mem_fill(dst, pattern, pattern_size, size); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_read_rect_async(
+    void *dst, hal::hal_addr_t src, const hal::hal_mem_rect_t *rect) {
+  const hal::hal_mem_rect_t region = *rect;
+  return submit([=] { return mem_read_rect(dst, src, &region); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_write_rect_async(
+    hal::hal_addr_t dst, const void *src, const hal::hal_mem_rect_t *rect) {
+  const hal::hal_mem_rect_t region = *rect;
+  return submit([=] { return mem_write_rect(dst, src, &region); });
+}
+
+hal::hal_fence_t refsi_hal_device::mem_copy_rect_async(
+    hal::hal_addr_t dst, hal::hal_addr_t src, const hal::hal_mem_rect_t *rect) {
+  const hal::hal_mem_rect_t region = *rect;
+  return submit([=] { return mem_copy_rect(dst, src, &region); });
+}
+
+bool refsi_hal_device::kernel_exec(hal::hal_program_t program,
+                                   hal::hal_kernel_t kernel,
+                                   const hal::hal_ndrange_t *nd_range,
+                                   const hal::hal_arg_t *args,
+                                   uint32_t num_args, uint32_t work_dim) {
+  if (!nd_range) {
+    return false;
+  }
+  hal::hal_size_t num_groups = 1;
+  for (unsigned i = 0; i < DIMS; i++) {
+    if (nd_range->local[i] == 0) {
+      return false;
+    }
+    num_groups *= nd_range->global[i] / nd_range->local[i];
+  }
+  return kernel_exec_groups(program, kernel, nd_range, args, num_args,
+                            work_dim, 0, num_groups);
+}
+
+hal::hal_fence_t refsi_hal_device::kernel_exec_async(
+    hal::hal_program_t program, hal::hal_kernel_t kernel,
+    const hal::hal_ndrange_t *nd_range, const hal::hal_arg_t *args,
+    uint32_t num_args, uint32_t work_dim) {
+  // The ND-range is copied, the arguments must outlive the operation.
+  const hal::hal_ndrange_t range = *nd_range;
+  return submit([=] {
+    return kernel_exec(program, kernel, &range, args, num_args, work_dim);
+  });
+}
+
+bool refsi_hal_device::fence_wait(hal::hal_fence_t fence) {
+  std::unique_lock<std::mutex> guard(async_lock);
+  async_cond.wait(guard, [&] { return async_completed >= fence; });
+  const bool success = !async_failed;
+  async_failed = false;
+  return success;
+}
+
+void refsi_hal_device::stop_worker() {
+  {
+    std::lock_guard<std::mutex> guard(async_lock);
+    async_stop = true;
+    async_cond.notify_all();
+  }
+  if (async_worker.joinable()) {
+    async_worker.join();
+  }
+}
+
+hal::hal_fence_t refsi_hal_device::submit(std::function<bool()> operation) {
+  std::lock_guard<std::mutex> guard(async_lock);
+  if (async_stop) {
+    return hal::hal_invalid_fence;
+  }
+  if (!async_worker.joinable()) {
+    async_worker = std::thread([this] { worker_main(); });
+  }
+  async_queue.push_back(std::move(operation));
+  async_cond.notify_all();
+  return ++async_submitted;
+}
+
+void refsi_hal_device::worker_main() {
+  std::unique_lock<std::mutex> guard(async_lock);
+  for (;;) {
+    async_cond.wait(guard,
+                    [this] { return async_stop || !async_queue.empty(); });
+    if (async_queue.empty()) {
+      // Stopping, and every queued operation has completed.
+      return;
+    }
+    std::function<bool()> operation = std::move(async_queue.front());
+    async_queue.pop_front();
+    guard.unlock();
+    const bool success = operation();
+    guard.lock();
+    if (!success) {
+      async_failed = true;
+    }
+    async_completed++;
+    async_cond.notify_all();
+  }
+}
@@ -114,15 +114,15 @@ bool refsi_g1_hal_device::open_loader() {
   return true;
 }
 
-bool refsi_g1_hal_device::kernel_exec(hal::hal_program_t program,
-                                      hal::hal_kernel_t kernel,
-                                      const hal::hal_ndrange_t *nd_range,
-                                      const hal::hal_arg_t *args,
-                                      uint32_t num_args, uint32_t work_dim) {
+bool refsi_g1_hal_device::kernel_exec_groups(
+    hal::hal_program_t program, hal::hal_kernel_t kernel,
+    const hal::hal_ndrange_t *nd_range, const hal::hal_arg_t *args,
+    uint32_t num_args, uint32_t work_dim, hal::hal_size_t group_begin,
+    hal::hal_size_t group_end) {
   refsi_locker locker(hal_lock);
   if ((program == hal::hal_invalid_program) ||
       (kernel == hal::hal_invalid_kernel) || !nd_range ||
-      (num_args > 0) && !args) {
+      ((num_args > 0) && !args) || (group_begin > group_end)) {
     return false;
   }
   auto *kernel_wrapper = reinterpret_cast<refsi_hal_kernel *>(kernel);
@@ -176,6 +176,13 @@ bool refsi_g1_hal_device::kernel_exec(hal::hal_program_t program,
     wg.global_offset[i] = nd_range->offset[i];
   }
   wg.hal_extra = REFSI_CONTEXT_ADDRESS;
+  uint64_t num_groups = wg.num_groups[0] * wg.num_groups[1] * wg.num_groups[2];
+  if (group_end > num_groups) {
+    return false;
+  } else if (group_begin == group_end) {
+    return true;
+  }
+  exec.group_end = group_end;
   exec.kernel_entry = kernel_wrapper->symbol;
   exec.magic = REFSI_MAGIC;
   exec.state_size = sizeof(exec_state_t);
@@ -193,6 +200,24 @@ bool refsi_g1_hal_device::kernel_exec(hal::hal_program_t program,
   if (!pack_args(packed_args, args, num_args, elf, exec.flags)) {
     return false;
   }
+
+  // Append the counter harts use to claim work-groups, which starts at the
+  // first work-group to execute. Only work-group-per-thread kernels are
+  // scheduled by the loader, and only the loader's dynamic scheduling can
+  // execute part of the N-D range.
+  size_t counter_offset = 0;
+  bool partial = (group_begin != 0) || (group_end != num_groups);
+  bool dynamic = (dynamic_scheduling || partial) &&
+                 (thread_mode == REFSI_THREAD_MODE_WG);
+  if ((partial && !dynamic) || (dynamic && (group_end > UINT32_MAX))) {
+    return false;
+  } else if (dynamic) {
+    uint32_t first_group = group_begin;
+    counter_offset = (packed_args.size() + sizeof(uint64_t) - 1) &
+                     ~(sizeof(uint64_t) - 1);
+    packed_args.resize(counter_offset + sizeof(uint64_t), 0);
+    memcpy(&packed_args[counter_offset], &first_group, sizeof(first_group));
+  }
   hal::hal_addr_t args_addr = refsiAllocDeviceMemory(device, packed_args.size(),
                                                      sizeof(uint64_t), DRAM);
   if (!args_addr ||
@@ -201,6 +226,10 @@ bool refsi_g1_hal_device::kernel_exec(hal::hal_program_t program,
     return false;
   }
   exec.packed_args = args_addr;
+  if (dynamic) {
+    exec.flags |= REFSI_FLAG_DYNAMIC_SCHEDULING;
+    exec.next_group_addr = args_addr + counter_offset;
+  }
 
   // Specialize the execution state struct for each hardware thread.
   std::vector<exec_state_t> exec_for_hart(num_harts);
@@ -17,6 +17,7 @@
 #include "refsi_hal_m1.h"
 #include "refsi_command_buffer.h"
 
+#include <algorithm>
 #include <string>
 
 #include "device/device_if.h"
@@ -175,6 +176,8 @@ bool refsi_m1_hal_device::createROM(refsi_locker &locker) {
     launch_kernel_addrs[i] = enc.size();
     encodeLaunchKernel(enc, i + 1);
   }
+  launch_kernel_dynamic_addr = enc.size();
+  encodeLaunchKernelDynamic(enc);
 
   // Write the ROM in device memory.
   rom_size = enc.size();
@@ -185,6 +188,7 @@ bool refsi_m1_hal_device::createROM(refsi_locker &locker) {
   for (unsigned i = 0; i < DIMS; i++) {
     launch_kernel_addrs[i] += rom_base;
   }
+  launch_kernel_dynamic_addr += rom_base;
 
   return true;
 }
@@ -230,15 +234,67 @@ void refsi_m1_hal_device::encodeLaunchKernel(riscv_encoder &enc,
   enc.addJR(T1);
 }
 
-bool refsi_m1_hal_device::kernel_exec(hal::hal_program_t program,
-                                      hal::hal_kernel_t kernel,
-                                      const hal::hal_ndrange_t *nd_range,
-                                      const hal::hal_arg_t *args,
-                                      uint32_t num_args, uint32_t work_dim) {
+// Generate a launcher that runs once per hart and keeps claiming work-groups
+// from the counter at exec->next_group_addr until none are left, so that harts
+// which finish early pick up more work instead of idling.
+void refsi_m1_hal_device::encodeLaunchKernelDynamic(riscv_encoder &enc) {
+  auto getRankOffset = [] (uint32_t offset, uint32_t rank) {
+    return offset + (rank * sizeof(uint64_t));
+  };
+
+  unsigned wg_offset = offsetof(exec_state_t, wg);
+  unsigned group_id_offset = wg_offset + offsetof(wg_info_t, group_id);
+  unsigned num_groups_offset = wg_offset + offsetof(wg_info_t, num_groups);
+
+  // The kernel is called several times, keep its arguments, the execution
+  // state, the return address and the counter address in callee-saved
+  // registers.
+  enc.addMV(S0, A2);
+  enc.addMV(S1, A3);
+  enc.addMV(S2, RA);
+  enc.addLD(S3, A3, offsetof(exec_state_t, next_group_addr));
+
+  // Work-groups are claimed until the counter reaches the end of the range of
+  // work-groups to execute.
+  enc.addLD(S4, A3, offsetof(exec_state_t, group_end));
+
+  // Claim the next work-group, returning once all of them have been claimed.
+  int32_t loop_start = enc.size();
+  enc.addLI(T0, 1);
+  enc.addAMOADD_W(T1, T0, S3);
+  enc.addBLTU(T1, S4, 2 * sizeof(uint32_t));
+  enc.addJR(S2);
+
+  // group_id[0] = index % num_groups[0]
+  enc.addLD(T0, S1, getRankOffset(num_groups_offset, 0));
+  enc.addMulInst(REMU, T2, T1, T0);
+  enc.addSD(T2, S1, getRankOffset(group_id_offset, 0));
+  enc.addMulInst(DIVU, T1, T1, T0);
+  // group_id[1] = (index / num_groups[0]) % num_groups[1]
+  enc.addLD(T0, S1, getRankOffset(num_groups_offset, 1));
+  enc.addMulInst(REMU, T2, T1, T0);
+  enc.addSD(T2, S1, getRankOffset(group_id_offset, 1));
+  // group_id[2] = index / (num_groups[0] * num_groups[1])
+  enc.addMulInst(DIVU, T1, T1, T0);
+  enc.addSD(T1, S1, getRankOffset(group_id_offset, 2));
+
+  // Call the kernel entry point and loop.
+  enc.addMV(A0, S0);
+  enc.addADDI(A1, S1, wg_offset);
+  enc.addLD(T0, S1, offsetof(exec_state_t, kernel_entry));
+  enc.addJALR(RA, T0, 0);
+  enc.addJ(loop_start - (int32_t)enc.size());
+}
+
+bool refsi_m1_hal_device::kernel_exec_groups(
+    hal::hal_program_t program, hal::hal_kernel_t kernel,
+    const hal::hal_ndrange_t *nd_range, const hal::hal_arg_t *args,
+    uint32_t num_args, uint32_t work_dim, hal::hal_size_t group_begin,
+    hal::hal_size_t group_end) {
   refsi_locker locker(hal_lock);
   if ((program == hal::hal_invalid_program) ||
       (kernel == hal::hal_invalid_kernel) || !nd_range ||
-      (num_args > 0) && !args) {
+      ((num_args > 0) && !args) || (group_begin > group_end)) {
     return false;
   }
   refsi_hal_program *refsi_program = (refsi_hal_program *)program;
@@ -275,6 +331,21 @@ bool refsi_m1_hal_device::kernel_exec(hal::hal_program_t program,
     wg.global_offset[i] = nd_range->offset[i];
   }
   wg.hal_extra = tcdm_hart_base;
+  uint64_t num_groups = wg.num_groups[0] * wg.num_groups[1] * wg.num_groups[2];
+  if (group_end > num_groups) {
+    return false;
+  } else if (group_begin == group_end) {
+    return true;
+  }
+  exec.group_end = group_end;
+
+  // Only the launcher which claims work-groups from a 32-bit counter can
+  // execute part of the N-D range.
+  bool dynamic =
+      dynamic_scheduling || (group_begin != 0) || (group_end != num_groups);
+  if (dynamic && (group_end > UINT32_MAX)) {
+    return false;
+  }
 
   // Ensure that ELF segments will be loaded in a valid area of memory.
   hal::hal_addr_t text_end_addr = elf_mem_base + elf_mem_size;
@@ -319,12 +390,29 @@ bool refsi_m1_hal_device::kernel_exec(hal::hal_program_t program,
   memcpy(&packed_args[exec_offset], &exec, exec_size);
   alignBuffer(packed_args, sizeof(uint64_t));
 
+  // Reserve the counter harts use to claim work-groups, which starts at the
+  // first work-group to execute.
+  uint32_t counter_offset = packed_args.size();
+  if (dynamic) {
+    uint32_t first_group = group_begin;
+    packed_args.resize(packed_args.size() + sizeof(uint64_t), 0);
+    memcpy(&packed_args[counter_offset], &first_group, sizeof(first_group));
+  }
+
   // Allocate memory for the Kernel Uniform Block.
   uint64_t kub_align = 256;
   alignBuffer(packed_args, kub_align);
   hal::hal_addr_t kub_size = packed_args.size();
   hal::hal_addr_t kub_addr = mem_alloc(kub_size, kub_align, locker);
-  if (!kub_addr || !mem_write(kub_addr, packed_args.data(), kub_size, locker)) {
+  if (!kub_addr) {
+    return false;
+  }
+  if (dynamic) {
+    exec.flags |= REFSI_FLAG_DYNAMIC_SCHEDULING;
+    exec.next_group_addr = kub_addr + counter_offset;
+    memcpy(&packed_args[exec_offset], &exec, exec_size);
+  }
+  if (!mem_write(kub_addr, packed_args.data(), kub_size, locker)) {
     return false;
   }
 
@@ -377,7 +465,9 @@ bool refsi_m1_hal_device::kernel_exec(hal::hal_program_t program,
   if (!return_addr) {
     return false;
   }
-  cb.addWRITE_REG64(CMP_REG_ENTRY_PT_FN, launch_kernel_addrs[work_dim - 1]);
+  uint64_t entry_point = dynamic ? launch_kernel_dynamic_addr
+                                 : launch_kernel_addrs[work_dim - 1];
+  cb.addWRITE_REG64(CMP_REG_ENTRY_PT_FN, entry_point);
   cb.addWRITE_REG64(CMP_REG_STACK_TOP, stack_top);
   cb.addWRITE_REG64(CMP_REG_RETURN_ADDR, return_addr);
   if (counters_enabled) {
@@ -393,14 +483,22 @@ bool refsi_m1_hal_device::kernel_exec(hal::hal_program_t program,
   extra_args.push_back(0);                        // slice_id
   extra_args.push_back(kub_addr + kargs_offset);  // kernel arguments
   extra_args.push_back(tcdm_hart_base);           // execution state
-  uint64_t num_instances = wg.num_groups[0];
-  uint64_t num_slices = 0;
-  num_slices = (work_dim == 2) ? wg.num_groups[1] : 1;
-  num_slices = (work_dim == 3) ? wg.num_groups[1] * wg.num_groups[2]
-                               : num_slices;
-  for (uint64_t i = 0; i < num_slices; i++) {
-    extra_args[0] = i;
+  if (dynamic) {
+    // Run a single instance per hart, each executing work-groups until there
+    // are none left.
+    uint64_t num_instances =
+        std::min<uint64_t>(max_harts, group_end - group_begin);
     cb.addRUN_INSTANCES(max_harts, num_instances, extra_args);
+  } else {
+    uint64_t num_instances = wg.num_groups[0];
+    uint64_t num_slices = 0;
+    num_slices = (work_dim == 2) ? wg.num_groups[1] : 1;
+    num_slices = (work_dim == 3) ? wg.num_groups[1] * wg.num_groups[2]
+                                 : num_slices;
+    for (uint64_t i = 0; i < num_slices; i++) {
+      extra_args[0] = i;
+      cb.addRUN_INSTANCES(max_harts, num_instances, extra_args);
+    }
   }
   cb.addSYNC_CACHE(cache_flags);
   if (counters_enabled) {
@@ -472,3 +570,72 @@ bool refsi_m1_hal_device::mem_copy(hal::hal_addr_t dst, hal::hal_addr_t src,
   // since the data is not leaving the device.
   return refsi_success == cb.run(*this, locker);
 }
+
+bool refsi_m1_hal_device::mem_copy_list(const hal::hal_mem_copy_t *copies,
+                                        uint32_t num_copies) {
+  refsi_locker locker(hal_lock);
+
+  if (hal_debug()) {
+    fprintf(stderr, "refsi_hal_device::mem_copy_list(num_copies=%d)\n",
+            num_copies);
+  }
+
+  // Start one 1D DMA transfer per copy. Transfers complete in the order they
+  // were started, so only waiting for the last one is needed.
+  refsi_command_buffer cb;
+  uint64_t config = REFSI_DMA_1D | REFSI_DMA_STRIDE_NONE;
+  for (uint32_t i = 0; i < num_copies; i++) {
+    cb.addWriteDMAReg(REFSI_REG_DMASRCADDR, copies[i].src);
+    cb.addWriteDMAReg(REFSI_REG_DMADSTADDR, copies[i].dst);
+    cb.addWriteDMAReg(REFSI_REG_DMAXFERSIZE0, copies[i].size);
+    cb.addWriteDMAReg(REFSI_REG_DMACTRL, config | REFSI_DMA_START);
+  }
+  cb.addLOAD_REG64(CMP_REG_SCRATCH, cb.getDMARegAddr(REFSI_REG_DMASTARTSEQ));
+  cb.addSTORE_REG64(CMP_REG_SCRATCH, cb.getDMARegAddr(REFSI_REG_DMADONESEQ));
+
+  return refsi_success == cb.run(*this, locker);
+}
+
+bool refsi_m1_hal_device::mem_copy_rect(hal::hal_addr_t dst,
+                                        hal::hal_addr_t src,
+                                        const hal::hal_mem_rect_t *rect) {
+  // The DMA engine requires rows and slices not to overlap, fall back to a
+  // list of row copies otherwise.
+  auto disjoint = [rect](const hal::hal_size_t *pitch) {
+    return (pitch[0] >= rect->region[0]) &&
+           (pitch[1] >= (pitch[0] * rect->region[1]));
+  };
+  if (!disjoint(rect->dst_pitch) || !disjoint(rect->src_pitch)) {
+    return hal::hal_device_t::mem_copy_rect(dst, src, rect);
+  }
+
+  refsi_locker locker(hal_lock);
+
+  if (hal_debug()) {
+    fprintf(stderr,
+            "refsi_hal_device::mem_copy_rect(dst=0x%08lx, src=0x%08lx, "
+            "region=%ldx%ldx%ld)\n",
+            dst, src, rect->region[0], rect->region[1], rect->region[2]);
+  }
+
+  refsi_command_buffer cb;
+
+  // Start a single 3D DMA transfer with both source and destination strides.
+  uint64_t config = REFSI_DMA_3D | REFSI_DMA_STRIDE_BOTH;
+  cb.addWriteDMAReg(REFSI_REG_DMASRCADDR, src);
+  cb.addWriteDMAReg(REFSI_REG_DMADSTADDR, dst);
+  for (uint32_t i = 0; i < 3; i++) {
+    cb.addWriteDMAReg(REFSI_REG_DMAXFERSIZE0 + i, rect->region[i]);
+  }
+  for (uint32_t i = 0; i < 2; i++) {
+    cb.addWriteDMAReg(REFSI_REG_DMAXFERSRCSTRIDE0 + i, rect->src_pitch[i]);
+    cb.addWriteDMAReg(REFSI_REG_DMAXFERDSTSTRIDE0 + i, rect->dst_pitch[i]);
+  }
+  cb.addWriteDMAReg(REFSI_REG_DMACTRL, config | REFSI_DMA_START);
+  cb.addLOAD_REG64(CMP_REG_SCRATCH, cb.getDMARegAddr(REFSI_REG_DMASTARTSEQ));
+
+  // Wait for the DMA transfer to finish.
+  cb.addSTORE_REG64(CMP_REG_SCRATCH, cb.getDMARegAddr(REFSI_REG_DMADONESEQ));
+
+  return refsi_success == cb.run(*this, locker);
+}
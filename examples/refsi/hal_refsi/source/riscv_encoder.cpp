@@ -38,30 +38,79 @@ static uint32_t encodeR(unsigned opc, unsigned func3, unsigned func7,
       (func7 << 25);
 }
 
+// Encode a B-type instruction.
+static uint32_t encodeB(unsigned opc, unsigned funct3, unsigned rs1,
+                        unsigned rs2, int32_t offset) {
+  uint32_t imm = (uint32_t)offset;
+  return opc | (((imm >> 11) & 0x1) << 7) | (((imm >> 1) & 0xf) << 8) |
+      (funct3 << 12) | (rs1 << 15) | (rs2 << 20) |
+      (((imm >> 5) & 0x3f) << 25) | (((imm >> 12) & 0x1) << 31);
+}
+
+// Encode a J-type instruction.
+static uint32_t encodeJ(unsigned opc, unsigned rd, int32_t offset) {
+  uint32_t imm = (uint32_t)offset;
+  return opc | (rd << 7) | (((imm >> 12) & 0xff) << 12) |
+      (((imm >> 11) & 0x1) << 20) | (((imm >> 1) & 0x3ff) << 21) |
+      (((imm >> 20) & 0x1) << 31);
+}
+
 uint32_t riscv_encoder::addADDI(unsigned rd, unsigned rs, uint32_t imm) {
   uint32_t insn = encodeI(0x13, 0, rd, rs, imm);
   insns.push_back(insn);
   return insn;
 }
 
+uint32_t riscv_encoder::addAMOADD_W(unsigned rd, unsigned rs2,
+                                    unsigned rs1) {
+  // Both the 'aq' and 'rl' bits are set.
+  uint32_t insn = encodeR(0x2f, 0x2, 0x3, rd, rs1, rs2);
+  insns.push_back(insn);
+  return insn;
+}
+
+uint32_t riscv_encoder::addBLTU(unsigned rs1, unsigned rs2, int32_t offset) {
+  uint32_t insn = encodeB(0x63, 0x6, rs1, rs2, offset);
+  insns.push_back(insn);
+  return insn;
+}
+
 uint32_t riscv_encoder::addECALL() {
   uint32_t insn = 0x00000073;
   insns.push_back(insn);
   return insn;
 }
 
+uint32_t riscv_encoder::addJAL(unsigned rd, int32_t offset) {
+  uint32_t insn = encodeJ(0x6f, rd, offset);
+  insns.push_back(insn);
+  return insn;
+}
+
 uint32_t riscv_encoder::addJALR(unsigned rd, unsigned rs, uint32_t imm) {
   uint32_t insn = encodeI(0x67, 0, rd, rs, imm);
   insns.push_back(insn);
   return insn;
 }
 
+uint32_t riscv_encoder::addLD(unsigned rd, unsigned rs, uint32_t imm) {
+  uint32_t insn = encodeI(0x3, 0x3, rd, rs, imm);
+  insns.push_back(insn);
+  return insn;
+}
+
 uint32_t riscv_encoder::addLW(unsigned rd, unsigned rs, uint32_t imm) {
   uint32_t insn = encodeI(0x3, 0x2, rd, rs, imm);
   insns.push_back(insn);
   return insn;
 }
 
+uint32_t riscv_encoder::addSD(unsigned rs2, unsigned rs1, uint32_t imm) {
+  uint32_t insn = encodeS(0x23, 0x3, rs1, rs2, imm);
+  insns.push_back(insn);
+  return insn;
+}
+
 uint32_t riscv_encoder::addSW(unsigned rs2, unsigned rs1, uint32_t imm) {
   uint32_t insn = encodeS(0x23, 0x2, rs1, rs2, imm);
   insns.push_back(insn);
@@ -0,0 +1,62 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdio.h>
+
+#include "riscv_encoder.h"
+
+#define CHECK_INSN(expr, expected)                                           \
+  {                                                                          \
+    const uint32_t insn = (expr);                                            \
+    if (insn != (expected)) {                                                \
+      fprintf(stderr, "%s:%d: %s encoded as 0x%08x, expected 0x%08x\n",      \
+              __FILE__, __LINE__, #expr, insn, (uint32_t)(expected));        \
+      validated = false;                                                     \
+    }                                                                        \
+    num_insns++;                                                             \
+  }
+
+int main() {
+  bool validated = true;
+  size_t num_insns = 0;
+  riscv_encoder enc;
+
+  // The expected encodings were produced with:
+  //   llvm-mc -triple=riscv64 -mattr=+a -show-encoding
+  CHECK_INSN(enc.addAMOADD_W(A0, A1, A2), 0x06b6252f);  // amoadd.w.aqrl
+  CHECK_INSN(enc.addBLTU(T0, T1, 16), 0x0062e863);
+  CHECK_INSN(enc.addBLTU(A0, A1, -8), 0xfeb56ce3);
+  CHECK_INSN(enc.addBLTU(A0, A1, 4094), 0x7eb56fe3);
+  CHECK_INSN(enc.addJAL(RA, 2048), 0x001000ef);
+  CHECK_INSN(enc.addJ(-12), 0xff5ff06f);
+  CHECK_INSN(enc.addJ(1048574), 0x7ffff06f);
+  CHECK_INSN(enc.addLD(A3, SP, 8), 0x00813683);
+  CHECK_INSN(enc.addLD(T0, S0, -16), 0xff043283);
+  CHECK_INSN(enc.addSD(A3, SP, 8), 0x00d13423);
+  CHECK_INSN(enc.addSD(T0, S0, -16), 0xfe543823);
+
+  // All instructions are appended to the encoder's buffer.
+  if (enc.size() != (num_insns * sizeof(uint32_t)) ||
+      enc.data()[0] != 0x06b6252f) {
+    fprintf(stderr, "%s:%d: unexpected encoder buffer\n", __FILE__, __LINE__);
+    validated = false;
+  }
+
+  if (validated) {
+    fprintf(stderr, "Results validated successfully.\n");
+  }
+  return validated ? 0 : -1;
+}
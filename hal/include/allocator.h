@@ -22,25 +22,39 @@
 #define HAL_ALLOCATOR_H_INCLUDED
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
-#include <set>
+#include <unordered_map>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "hal_types.h"
 
 namespace hal {
 
+// Two-Level Segregated Fit allocator for a range of device memory.
+//
+// Free blocks are kept in size-segregated lists indexed by a first level
+// (power of two) and a second level (linear subdivision of that power of two),
+// with a bitmap per level to find a non-empty list in constant time. Blocks
+// are also linked in address order so that a freed block can be merged with
+// its neighbours without searching. Block headers live in host memory since
+// the managed range is device memory which may not be host accessible.
 struct allocator_t {
-  struct block_t {
-    block_t() : addr(0), is_free(true) {}
-
-    // used for block ordering in the set
-    bool operator<(const block_t &rhs) const { return addr < rhs.addr; }
-
-    // block start address
-    hal_addr_t addr;
-
-    // true if this block is not yet allocated
-    bool is_free;
+  // statistics describing the state of the managed memory range
+  struct stats_t {
+    // sum total of all free memory
+    hal_size_t free_bytes = 0;
+    // size of the largest single allocation that could currently succeed,
+    // ignoring alignment
+    hal_size_t largest_free_block = 0;
+    // number of free blocks, a high count relative to `allocations` indicates
+    // fragmentation
+    size_t free_blocks = 0;
+    // number of live allocations
+    size_t allocations = 0;
   };
 
   // allocator constructed which will provide allocations within the memory
@@ -51,14 +65,36 @@ struct allocator_t {
     reset();
   }
 
+  allocator_t(const allocator_t &) = delete;
+  allocator_t &operator=(const allocator_t &) = delete;
+
+  ~allocator_t() {
+    release_blocks();
+    while (spare_blocks) {
+      block_t *next = spare_blocks->next_free;
+      delete spare_blocks;
+      spare_blocks = next;
+    }
+  }
+
   // reset the allocator back to blank slate state.
   void reset() {
-    blocks.clear();
+    release_blocks();
+    allocated.clear();
+    fl_bitmap = 0;
+    for (uint32_t &sl_bitmap : sl_bitmaps) {
+      sl_bitmap = 0;
+    }
+    for (auto &sl_lists : free_lists) {
+      for (block_t *&list : sl_lists) {
+        list = nullptr;
+      }
+    }
+    free_bytes = 0;
+    num_free_blocks = 0;
     // create the initial free block
-    block_t new_block;
-    new_block.addr = addr_lo;
-    new_block.is_free = true;
-    blocks.insert(new_block);
+    head = new_block(addr_lo, addr_hi - addr_lo);
+    insert_free(head);
   }
 
   // request a memory allocation of `size` bytes with the specified byte
@@ -71,40 +107,33 @@ struct allocator_t {
     if (size == 0) {
       size = 1;
     }
-    auto itt = blocks.begin();
-    while (itt != blocks.end()) {
-      // search for a free block
-      auto next = std::next(itt);
-      if (!itt->is_free) {
-        itt = next;
-        continue;
-      }
-      // compute the start point
-      hal_addr_t start = block_end(itt);
-      bool underflow = start < size;
-      start -= size;
-      start &= ~(hal_addr_t(alignment) - 1lu);
-      // check if allocation will fit in this block
-      if (start < itt->addr || underflow) {
-        // this block does not have enough space, try next one
-        itt = next;
-        continue;
-      }
-      // allocation will not fit so create new block
-      block_t new_block;
-      new_block.addr = start;
-      new_block.is_free = false;
-      if (start == itt->addr) {
-        // this block has just enough space and will not be divided.
-        // remove free block so it can be replaced with a taken block.
-        blocks.erase(itt);
+    // over-allocate so that any block found can be aligned
+    const hal_size_t padded = size + (alignment - 1);
+    block_t *block = padded < size ? nullptr : find_free(padded);
+    if (!block) {
+      // padding and rounding up to a list boundary skip lists which may still
+      // hold a block large enough, so search all of those before giving up
+      block = find_aligned(size, alignment);
+      if (!block) {
+        return hal_nullptr;
       }
-      // insert new block
-      blocks.insert(new_block);
-      return start;
     }
-    // return nullptr
-    return 0;
+    remove_free(block);
+    // give the unaligned head of the block back to the free lists
+    const hal_addr_t start =
+        (block->addr + (alignment - 1)) & ~(hal_addr_t(alignment) - 1);
+    if (start != block->addr) {
+      block_t *front = block;
+      block = split(front, start - front->addr);
+      insert_free(front);
+    }
+    // and any space left over after the allocation
+    if (block->size > size) {
+      insert_free(split(block, size));
+    }
+    block->is_free = false;
+    allocated.emplace(block->addr, block);
+    return block->addr;
   }
 
   void free(hal_addr_t ptr) {
@@ -112,88 +141,288 @@ struct allocator_t {
     if (ptr == hal_nullptr) {
       return;
     }
-    // create prototype block to search for
-    block_t proto;
-    proto.addr = ptr;
-    proto.is_free = true;
-    std::set<block_t>::iterator itt = blocks.find(proto);
+    auto itt = allocated.find(ptr);
     // check it is valid
-    assert(itt != blocks.end() && "No block with this address found in free()");
-    assert(itt->addr == ptr && "Found incorrect block in free()");
-    assert(itt->is_free == false && "Block is already free in free()");
-    if (itt != blocks.end()) {
-      // construct a new free block in place of the original.
-      // note that we cant simply change `is_free` as std::set iterators are
-      // const due to the strict ordering.
-      blocks.erase(itt);
-      blocks.insert(proto);
-      // run a pass to merge adjacent free blocks
-      consolidate();
+    assert(itt != allocated.end() && "No block with this address found in "
+                                     "free()");
+    if (itt == allocated.end()) {
+      return;
+    }
+    block_t *block = itt->second;
+    allocated.erase(itt);
+    // merge with the neighbouring blocks if they are also free
+    if (block_t *next = block->next_phys; next && next->is_free) {
+      remove_free(next);
+      merge(block, next);
+    }
+    if (block_t *prev = block->prev_phys; prev && prev->is_free) {
+      remove_free(prev);
+      merge(prev, block);
+      block = prev;
     }
+    insert_free(block);
   }
 
   // return the sum total of all free memory, note however that
   // memory fragmentation may impact the ability to allocate large chunks
   // even if the total memory is available.
-  hal_size_t available() const {
-    hal_size_t sum = 0;
-    auto itt = blocks.begin();
-    while (itt != blocks.end()) {
-      if (itt->is_free) {
-        sum += block_size(itt);
+  hal_size_t available() const { return free_bytes; }
+
+  // return statistics about free space and fragmentation.
+  stats_t stats() const {
+    stats_t result;
+    result.free_bytes = free_bytes;
+    result.free_blocks = num_free_blocks;
+    result.allocations = allocated.size();
+    if (fl_bitmap) {
+      // the largest block is in the highest non-empty list, which only spans
+      // a small range of sizes
+      const uint32_t fl = find_last_set(fl_bitmap);
+      const uint32_t sl = find_last_set(sl_bitmaps[fl]);
+      for (block_t *block = free_lists[fl][sl]; block;
+           block = block->next_free) {
+        if (block->size > result.largest_free_block) {
+          result.largest_free_block = block->size;
+        }
       }
-      itt = std::next(itt);
     }
-    return sum;
+    return result;
   }
 
  protected:
-  // return the end address of this block
-  hal_addr_t block_end(std::set<block_t>::iterator &itt) const {
-    // find the end address
-    hal_addr_t end = addr_hi;
-    auto next = std::next(itt);
-    if (next != blocks.end()) {
-      end = next->addr;
-    }
-    return end;
-  }
-
-  // compute the number of bytes in a block
-  hal_size_t block_size(std::set<block_t>::iterator &itt) const {
-    // get the end address
-    const hal_addr_t end = block_end(itt);
-    // compute the block size
-    const hal_size_t size = end - itt->addr;
-    return size;
-  }
-
-  // merge adjacent free blocks
-  void consolidate() {
-    // loop over all blocks
-    auto itt = blocks.begin();
+  // log2 of the number of second level lists per first level list
+  static constexpr uint32_t sl_index_log2 = 4;
+  static constexpr uint32_t sl_index_count = 1u << sl_index_log2;
+  // sizes below this are all mapped to the first, linear, first level list
+  static constexpr hal_size_t small_block_size = sl_index_count;
+  static constexpr uint32_t fl_index_count = 64 - sl_index_log2 + 1;
+
+  struct block_t {
+    // block start address
+    hal_addr_t addr;
+    // number of bytes in the block
+    hal_size_t size;
+    // true if this block is not yet allocated
+    bool is_free;
+    // neighbouring blocks in address order
+    block_t *prev_phys;
+    block_t *next_phys;
+    // neighbouring blocks in the same free list
+    block_t *prev_free;
+    block_t *next_free;
+  };
+
+  static uint32_t find_last_set(uint64_t value) {
+    assert(value != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+  }
+
+  static uint32_t find_first_set(uint64_t value) {
+    assert(value != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+  }
+
+  // compute the free list a block of `size` bytes belongs to
+  static void mapping(hal_size_t size, uint32_t &fl, uint32_t &sl) {
+    if (size < small_block_size) {
+      fl = 0;
+      sl = static_cast<uint32_t>(size);
+      return;
+    }
+    const uint32_t msb = find_last_set(size);
+    fl = msb - sl_index_log2 + 1;
+    sl = static_cast<uint32_t>(size >> (msb - sl_index_log2)) - sl_index_count;
+  }
+
+  // find a free block of at least `size` bytes
+  block_t *find_free(hal_size_t size) const {
+    // round the size up to the next list boundary so that any block in the
+    // list found is large enough
+    if (size >= small_block_size) {
+      const hal_size_t round =
+          (hal_size_t(1) << (find_last_set(size) - sl_index_log2)) - 1;
+      if (size + round < size) {
+        return nullptr;
+      }
+      size += round;
+    }
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    uint64_t sl_map = sl_bitmaps[fl] & (~uint64_t(0) << sl);
+    if (!sl_map) {
+      // nothing large enough at this first level, move on to the next
+      // non-empty one
+      const uint64_t fl_map = (fl + 1 < fl_index_count)
+                                  ? fl_bitmap & (~uint64_t(0) << (fl + 1))
+                                  : 0;
+      if (!fl_map) {
+        return nullptr;
+      }
+      fl = find_first_set(fl_map);
+      sl_map = sl_bitmaps[fl];
+    }
+    sl = find_first_set(sl_map);
+    return free_lists[fl][sl];
+  }
+
+  // search every non-empty list from the one a block of `size` bytes maps to
+  // upward for a block which fits `size` bytes once aligned
+  block_t *find_aligned(hal_size_t size, hal_size_t alignment) const {
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    uint64_t sl_map = sl_bitmaps[fl] & (~uint64_t(0) << sl);
     for (;;) {
-      auto next = std::next(itt);
-      if (next == blocks.end()) {
-        // there are no more blocks to merge with
-        break;
+      if (!sl_map) {
+        const uint64_t fl_map = (fl + 1 < fl_index_count)
+                                    ? fl_bitmap & (~uint64_t(0) << (fl + 1))
+                                    : 0;
+        if (!fl_map) {
+          return nullptr;
+        }
+        fl = find_first_set(fl_map);
+        sl_map = sl_bitmaps[fl];
       }
-      // we need two free adjacent blocks in order to merge them
-      if (!itt->is_free || !next->is_free) {
-        itt = next;
-        continue;
+      sl = find_first_set(sl_map);
+      sl_map &= sl_map - 1;
+      for (block_t *block = free_lists[fl][sl]; block;
+           block = block->next_free) {
+        const hal_addr_t start =
+            (block->addr + (alignment - 1)) & ~(hal_addr_t(alignment) - 1);
+        const hal_size_t padding = start - block->addr;
+        if (start >= block->addr && padding < block->size &&
+            block->size - padding >= size) {
+          return block;
+        }
       }
-      // erase the next block to effectively give its space back to `itt`
-      blocks.erase(next);
     }
   }
 
+  void insert_free(block_t *block) {
+    uint32_t fl, sl;
+    mapping(block->size, fl, sl);
+    block->is_free = true;
+    block->prev_free = nullptr;
+    block->next_free = free_lists[fl][sl];
+    if (block->next_free) {
+      block->next_free->prev_free = block;
+    }
+    free_lists[fl][sl] = block;
+    fl_bitmap |= uint64_t(1) << fl;
+    sl_bitmaps[fl] |= 1u << sl;
+    free_bytes += block->size;
+    num_free_blocks++;
+  }
+
+  void remove_free(block_t *block) {
+    uint32_t fl, sl;
+    mapping(block->size, fl, sl);
+    if (block->prev_free) {
+      block->prev_free->next_free = block->next_free;
+    } else {
+      free_lists[fl][sl] = block->next_free;
+      if (!free_lists[fl][sl]) {
+        sl_bitmaps[fl] &= ~(1u << sl);
+        if (!sl_bitmaps[fl]) {
+          fl_bitmap &= ~(uint64_t(1) << fl);
+        }
+      }
+    }
+    if (block->next_free) {
+      block->next_free->prev_free = block->prev_free;
+    }
+    block->is_free = false;
+    free_bytes -= block->size;
+    num_free_blocks--;
+  }
+
+  // split `block` after `size` bytes, returning the new trailing block
+  block_t *split(block_t *block, hal_size_t size) {
+    assert(size < block->size);
+    block_t *tail = new_block(block->addr + size, block->size - size);
+    tail->prev_phys = block;
+    tail->next_phys = block->next_phys;
+    if (tail->next_phys) {
+      tail->next_phys->prev_phys = tail;
+    }
+    block->next_phys = tail;
+    block->size = size;
+    return tail;
+  }
+
+  // absorb `next` into `block`, they must be adjacent
+  void merge(block_t *block, block_t *next) {
+    assert(block->next_phys == next);
+    block->size += next->size;
+    block->next_phys = next->next_phys;
+    if (block->next_phys) {
+      block->next_phys->prev_phys = block;
+    }
+    delete_block(next);
+  }
+
+  // block headers are recycled to avoid a host allocation per split
+  block_t *new_block(hal_addr_t addr, hal_size_t size) {
+    block_t *block = spare_blocks;
+    if (block) {
+      spare_blocks = block->next_free;
+    } else {
+      block = new block_t;
+    }
+    *block = block_t{addr, size, false, nullptr, nullptr, nullptr, nullptr};
+    return block;
+  }
+
+  void delete_block(block_t *block) {
+    block->next_free = spare_blocks;
+    spare_blocks = block;
+  }
+
+  // return all blocks to the spare list
+  void release_blocks() {
+    block_t *block = head;
+    while (block) {
+      block_t *next = block->next_phys;
+      delete_block(block);
+      block = next;
+    }
+    head = nullptr;
+  }
+
   // the valid address range to allocate within
   const hal_addr_t addr_lo;
   const hal_addr_t addr_hi;
 
-  // the block list
-  std::set<block_t> blocks;
+  // bitmap of first level lists with at least one non-empty second level list
+  uint64_t fl_bitmap = 0;
+  // bitmaps of non-empty second level lists
+  uint32_t sl_bitmaps[fl_index_count] = {};
+  // heads of the segregated free lists
+  block_t *free_lists[fl_index_count][sl_index_count] = {};
+
+  // allocated blocks indexed by their start address
+  std::unordered_map<hal_addr_t, block_t *> allocated;
+
+  // block starting at `addr_lo`, splits and merges always keep the lower
+  // block so it is only replaced by `reset`
+  block_t *head = nullptr;
+
+  // recycled block headers
+  block_t *spare_blocks = nullptr;
+
+  hal_size_t free_bytes = 0;
+  size_t num_free_blocks = 0;
 };
 
 }  // namespace hal
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "hal_types.h"
 
@@ -182,6 +183,354 @@ struct hal_device_t {
   /// @return returns `false` if the operation fails otherwise `true`.
   virtual bool mem_write(hal_addr_t dst, const void *src, hal_size_t size) = 0;
 
+  /// @brief Get a host pointer aliasing a range of target memory.
+  ///
+  /// Host reads and writes through the pointer access target memory directly,
+  /// without the copies made by `mem_read` and `mem_write`. Host writes are
+  /// made visible to the target with `mem_host_flush`, and target writes to
+  /// the host with `mem_host_invalidate`. The pointer stays valid until the
+  /// memory is freed.
+  ///
+  /// @param addr device address of the start of the range.
+  /// @param size is the number of bytes in the range.
+  ///
+  /// @return Returns `nullptr` if the range cannot be accessed by the host,
+  /// which is the default, in which case `mem_read` and `mem_write` must be
+  /// used instead.
+  virtual void *mem_host_ptr(hal_addr_t addr, hal_size_t size) {
+    (void)addr;
+    (void)size;
+    return nullptr;
+  }
+
+  /// @brief Make host writes through a pointer returned by `mem_host_ptr`
+  /// visible to the target.
+  ///
+  /// @param addr device address of the start of the range.
+  /// @param size is the number of bytes in the range.
+  ///
+  /// @return returns `false` if the operation fails otherwise `true`. The
+  /// default does nothing, for devices whose memory is coherent with the host.
+  virtual bool mem_host_flush(hal_addr_t addr, hal_size_t size) {
+    (void)addr;
+    (void)size;
+    return true;
+  }
+
+  /// @brief Make target writes visible to host reads through a pointer
+  /// returned by `mem_host_ptr`.
+  ///
+  /// @param addr device address of the start of the range.
+  /// @param size is the number of bytes in the range.
+  ///
+  /// @return returns `false` if the operation fails otherwise `true`. The
+  /// default does nothing, for devices whose memory is coherent with the host.
+  virtual bool mem_host_invalidate(hal_addr_t addr, hal_size_t size) {
+    (void)addr;
+    (void)size;
+    return true;
+  }
+
+  /// @brief Copy a list of disjoint memory ranges between target buffers.
+  ///
+  /// @note This is a default implementation issuing one `mem_copy` per entry,
+  /// devices able to batch the copies should override it.
+  ///
+  /// @param copies is the list of copies to perform.
+  /// @param num_copies is the number of entries in `copies`.
+  ///
+  /// @return Returns `false` if any of the copies fail otherwise `true`.
+  virtual bool mem_copy_list(const hal_mem_copy_t *copies,
+                             uint32_t num_copies) {
+    for (uint32_t i = 0; i < num_copies; i++) {
+      if (!mem_copy(copies[i].dst, copies[i].src, copies[i].size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// @brief Copy a strided region between target buffers.
+  ///
+  /// @note This is a default implementation which gathers the rows into a
+  /// single `mem_copy_list` call.
+  ///
+  /// @param dst device address of the first byte of the destination region.
+  /// @param src device address of the first byte of the source region.
+  /// @param rect describes the shape of the region and the pitches of the
+  /// source and destination.
+  ///
+  /// @return Returns `false` if the operation fails otherwise `true`.
+  virtual bool mem_copy_rect(hal_addr_t dst, hal_addr_t src,
+                             const hal_mem_rect_t *rect) {
+    std::vector<hal_mem_copy_t> rows;
+    rows.reserve(rect->region[1] * rect->region[2]);
+    for (hal_size_t z = 0; z < rect->region[2]; z++) {
+      for (hal_size_t y = 0; y < rect->region[1]; y++) {
+        const hal_size_t dst_offset =
+            (z * rect->dst_pitch[1]) + (y * rect->dst_pitch[0]);
+        const hal_size_t src_offset =
+            (z * rect->src_pitch[1]) + (y * rect->src_pitch[0]);
+        rows.push_back({dst + dst_offset, src + src_offset, rect->region[0]});
+      }
+    }
+    return mem_copy_list(rows.data(), static_cast<uint32_t>(rows.size()));
+  }
+
+  /// @brief Read a strided region of target memory to the host.
+  ///
+  /// @note This is a default implementation issuing one `mem_read` per row.
+  ///
+  /// @param dst host address of the first byte of the destination region.
+  /// @param src device address of the first byte of the source region.
+  /// @param rect describes the shape of the region and the pitches of the
+  /// source and destination.
+  ///
+  /// @return Returns `false` if the operation fails otherwise `true`.
+  virtual bool mem_read_rect(void *dst, hal_addr_t src,
+                             const hal_mem_rect_t *rect) {
+    for (hal_size_t z = 0; z < rect->region[2]; z++) {
+      for (hal_size_t y = 0; y < rect->region[1]; y++) {
+        const hal_size_t dst_offset =
+            (z * rect->dst_pitch[1]) + (y * rect->dst_pitch[0]);
+        const hal_size_t src_offset =
+            (z * rect->src_pitch[1]) + (y * rect->src_pitch[0]);
+        if (!mem_read(static_cast<uint8_t *>(dst) + dst_offset,
+                      src + src_offset, rect->region[0])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// @brief Write a strided region of host memory to the target.
+  ///
+  /// @note This is a default implementation issuing one `mem_write` per row.
+  ///
+  /// @param dst device address of the first byte of the destination region.
+  /// @param src host address of the first byte of the source region.
+  /// @param rect describes the shape of the region and the pitches of the
+  /// source and destination.
+  ///
+  /// @return Returns `false` if the operation fails otherwise `true`.
+  virtual bool mem_write_rect(hal_addr_t dst, const void *src,
+                              const hal_mem_rect_t *rect) {
+    for (hal_size_t z = 0; z < rect->region[2]; z++) {
+      for (hal_size_t y = 0; y < rect->region[1]; y++) {
+        const hal_size_t dst_offset =
+            (z * rect->dst_pitch[1]) + (y * rect->dst_pitch[0]);
+        const hal_size_t src_offset =
+            (z * rect->src_pitch[1]) + (y * rect->src_pitch[0]);
+        if (!mem_write(dst + dst_offset,
+                       static_cast<const uint8_t *>(src) + src_offset,
+                       rect->region[0])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// @brief Execute a contiguous range of the work-groups of a kernel on the
+  /// target.
+  ///
+  /// Work-groups are numbered in row-major order with dimension 0 varying
+  /// fastest, so that group `(x, y, z)` has the index `x + (y * num_groups[0])
+  /// + (z * num_groups[0] * num_groups[1])`. Only the work-groups with an index
+  /// in `[group_begin, group_end)` are executed, but the work-items observe
+  /// the whole N-D range, e.g. `get_global_size` and `get_num_groups` are not
+  /// affected. This allows an N-D range to be split across several devices.
+  ///
+  /// @param program is a handle to a previously loaded program.
+  /// @param kernel is a handle to a previously found kernel.
+  /// @param nd_range contains the whole work range of the kernel.
+  /// @param args is a list of argument descriptors for the kernel.
+  /// @param num_args is the number of argument descriptors provided.
+  /// @param work_dim specifies the work dimension for execution (1, 2 or 3).
+  /// @param group_begin is the index of the first work-group to execute.
+  /// @param group_end is one past the index of the last work-group to execute.
+  ///
+  /// @return Returns `false` if the operation fails or if the device does not
+  /// support executing part of an N-D range, which is the default, otherwise
+  /// `true`. Devices which support it set
+  /// `hal_device_info_t::supports_group_range`.
+  virtual bool kernel_exec_groups(hal_program_t program, hal_kernel_t kernel,
+                                  const hal_ndrange_t *nd_range,
+                                  const hal_arg_t *args, uint32_t num_args,
+                                  uint32_t work_dim, hal_size_t group_begin,
+                                  hal_size_t group_end) {
+    (void)program;
+    (void)kernel;
+    (void)nd_range;
+    (void)args;
+    (void)num_args;
+    (void)work_dim;
+    (void)group_begin;
+    (void)group_end;
+    return false;
+  }
+
+  /// @brief Queue a read of memory from the target to the host.
+  ///
+  /// Asynchronous operations execute in the order they were submitted, so
+  /// waiting on a fence also waits for all the operations submitted before it.
+  /// The default implementation performs the read before returning, devices
+  /// which set `hal_device_info_t::supports_async` return immediately.
+  ///
+  /// @param dst host address which is the read destination, it must remain
+  /// valid until the returned fence has been waited on.
+  /// @param src device address which is the source memory location.
+  /// @param size is the number of bytes to be read.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_read_async(void *dst, hal_addr_t src,
+                                     hal_size_t size) {
+    return mem_read(dst, src, size) ? completed_fence
+                                    : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a write of host memory to the target.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst device address which is the write destination.
+  /// @param src host address which is the source memory location, it must
+  /// remain valid until the returned fence has been waited on.
+  /// @param size is the number of bytes to be written.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_write_async(hal_addr_t dst, const void *src,
+                                      hal_size_t size) {
+    return mem_write(dst, src, size) ? completed_fence
+                                     : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a copy of memory between target buffers.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst device address which is the copy destination.
+  /// @param src device address which is the copy source.
+  /// @param size is the total number of bytes to be transferred.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_copy_async(hal_addr_t dst, hal_addr_t src,
+                                     hal_size_t size) {
+    return mem_copy(dst, src, size) ? completed_fence
+                                    : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a fill of memory with a repeating pattern.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst device address which is the fill destination.
+  /// @param pattern host address of the pattern, it must remain valid until
+  /// the returned fence has been waited on.
+  /// @param pattern_size is the number of bytes in the memory pattern.
+  /// @param size is the total number of bytes to be written.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_fill_async(hal_addr_t dst, const void *pattern,
+                                     hal_size_t pattern_size, hal_size_t size) {
+    return mem_fill(dst, pattern, pattern_size, size)
+               ? completed_fence
+               : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a strided read of target memory to the host.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst host address of the first byte of the destination region, it
+  /// must remain valid until the returned fence has been waited on.
+  /// @param src device address of the first byte of the source region.
+  /// @param rect describes the shape of the region, it is copied.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_read_rect_async(void *dst, hal_addr_t src,
+                                          const hal_mem_rect_t *rect) {
+    return mem_read_rect(dst, src, rect) ? completed_fence
+                                         : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a strided write of host memory to the target.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst device address of the first byte of the destination region.
+  /// @param src host address of the first byte of the source region, it must
+  /// remain valid until the returned fence has been waited on.
+  /// @param rect describes the shape of the region, it is copied.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_write_rect_async(hal_addr_t dst, const void *src,
+                                           const hal_mem_rect_t *rect) {
+    return mem_write_rect(dst, src, rect) ? completed_fence
+                                          : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue a strided copy between target buffers.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param dst device address of the first byte of the destination region.
+  /// @param src device address of the first byte of the source region.
+  /// @param rect describes the shape of the region, it is copied.
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t mem_copy_rect_async(hal_addr_t dst, hal_addr_t src,
+                                          const hal_mem_rect_t *rect) {
+    return mem_copy_rect(dst, src, rect) ? completed_fence
+                                         : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Queue the execution of a kernel on the target.
+  ///
+  /// @see mem_read_async for the ordering of asynchronous operations.
+  ///
+  /// @param program is a handle to a previously loaded program, it must not
+  /// be freed until the returned fence has been waited on.
+  /// @param kernel is a handle to a previously found kernel.
+  /// @param nd_range contains the work range to execute, it is copied.
+  /// @param args is a list of argument descriptors for the kernel, the list
+  /// and any data it points to must remain valid until the returned fence has
+  /// been waited on.
+  /// @param num_args is the number of argument descriptors provided.
+  /// @param work_dim specifies the work dimension for execution (1, 2 or 3).
+  ///
+  /// @return Returns `hal_invalid_fence` if the operation fails otherwise a
+  /// fence which can be passed to `fence_wait`.
+  virtual hal_fence_t kernel_exec_async(hal_program_t program,
+                                        hal_kernel_t kernel,
+                                        const hal_ndrange_t *nd_range,
+                                        const hal_arg_t *args,
+                                        uint32_t num_args, uint32_t work_dim) {
+    return kernel_exec(program, kernel, nd_range, args, num_args, work_dim)
+               ? completed_fence
+               : hal_fence_t{hal_invalid_fence};
+  }
+
+  /// @brief Wait for an asynchronous operation, and all the operations
+  /// submitted before it, to complete.
+  ///
+  /// @param fence is a fence returned by one of the `*_async` operations.
+  ///
+  /// @return Returns `false` if any of the operations waited on failed
+  /// otherwise `true`.
+  virtual bool fence_wait(hal_fence_t fence) {
+    (void)fence;
+    return true;
+  }
+
   /// @brief If the counter specified has an unread value, read it out.
   /// This will implicitly mark the data as read.
   ///
@@ -206,6 +555,11 @@ struct hal_device_t {
   /// @param enable True to enable counter support, false to disable
   virtual void counter_set_enabled(bool enable) { (void)enable; };
 
+ protected:
+  /// @brief Fence returned by the default `*_async` operations, which have
+  /// already completed when they return.
+  static constexpr hal_fence_t completed_fence = 1;
+
  private:
   /// @brief device_info is the default hal_device_info_t structure provided by
   /// the hal when this device was instanciated. it is returned by the base
@@ -218,7 +572,7 @@ struct hal_device_t {
 struct hal_t {
   /// @brief Current version of the HAL API. The version number needs to be
   /// bumped any time the interface is changed.
-  static constexpr uint32_t api_version = 6;
+  static constexpr uint32_t api_version = 11;
 
   /// @brief Return generic platform information.
   ///
@@ -38,11 +38,14 @@ typedef uint64_t hal_word_t;
 typedef uint64_t hal_program_t;
 /// @brief A unique handle identifying a kernel.
 typedef uint64_t hal_kernel_t;
+/// @brief A handle identifying the completion of an asynchronous operation.
+typedef uint64_t hal_fence_t;
 
 enum {
   hal_nullptr = 0,
   hal_invalid_program = 0,
   hal_invalid_kernel = 0,
+  hal_invalid_fence = 0,
 };
 
 enum hal_arg_kind_t {
@@ -124,6 +127,25 @@ struct hal_ndrange_t {
   hal_size_t local[3];
 };
 
+/// @brief Describes a strided transfer of up to three dimensions. Each row of
+/// `region[0]` bytes is contiguous, rows and slices are separated by a pitch.
+struct hal_mem_rect_t {
+  /// @brief Number of bytes in a row, rows in a slice and slices to transfer.
+  hal_size_t region[3];
+  /// @brief Bytes between the start of consecutive destination rows and
+  /// slices.
+  hal_size_t dst_pitch[2];
+  /// @brief Bytes between the start of consecutive source rows and slices.
+  hal_size_t src_pitch[2];
+};
+
+/// @brief A single contiguous copy within a scatter-gather list.
+struct hal_mem_copy_t {
+  hal_addr_t dst;
+  hal_addr_t src;
+  hal_size_t size;
+};
+
 enum hal_device_type_t {
   hal_device_type_riscv,  // hal_device_riscv_t
 };
@@ -176,6 +198,13 @@ struct hal_device_info_t {
 
   /// @brief Array of counter descriptions. Can be null if num_counters == 0.
   hal_counter_description_t *counter_descriptions = nullptr;
+
+  /// @brief true if the `*_async` operations of the device return before the
+  /// operation completes, false if they are the synchronous fallbacks.
+  bool supports_async = false;
+
+  /// @brief true if `kernel_exec_groups` can execute part of an N-D range.
+  bool supports_group_range = false;
 };
 
 struct hal_info_t {
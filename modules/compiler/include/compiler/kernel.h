@@ -21,6 +21,7 @@
 #ifndef COMPILER_KERNEL_H_INCLUDED
 #define COMPILER_KERNEL_H_INCLUDED
 
+#include <cargo/array_view.h>
 #include <cargo/dynamic_array.h>
 #include <cargo/expected.h>
 #include <compiler/result.h>
@@ -90,6 +91,9 @@ class Kernel {
   /// function provides an opportunity to defer compilation of kernels until
   /// enqueue time.
   ///
+  /// @note This function may be called concurrently from multiple threads
+  /// enqueueing the same kernel, implementations must be thread-safe.
+  ///
   /// @param specialization_options Mux execution options to specialize for.
   ///
   /// @return A valid binary object if specialization was successful,
@@ -103,6 +107,26 @@ class Kernel {
   createSpecializedKernel(
       const mux_ndrange_options_t &specialization_options) = 0;
 
+  /// @brief Returns whether createSpecializedKernel specializes on the number
+  /// of dimensions, global size and global offset of the ND range.
+  ///
+  /// The binary created by createSpecializedKernel only depends on the local
+  /// size, and on the inputs reported by this function and
+  /// getSpecializedArgumentIndices, so callers caching binaries only need to
+  /// tell launches apart by those.
+  ///
+  /// @return Returns true if the global shape is specialized on.
+  virtual bool specializesOnGlobalShape() const { return false; }
+
+  /// @brief Returns the indices of the plain old data arguments whose values
+  /// createSpecializedKernel specializes on.
+  ///
+  /// @return Returns the argument indices, which may be empty.
+  virtual cargo::array_view<const uint32_t> getSpecializedArgumentIndices()
+      const {
+    return {};
+  }
+
   /// @brief Returns the sub-group size for this kernel.
   ///
   /// This function queries a kernel for maximum sub-group size that would exist
@@ -141,7 +141,8 @@ struct Options {
         prevec_mode(PreVectorizationMode::DEFAULT),
         vectorization_mode(VectorizationMode::DEFAULT),
         llvm_stats(false),
-        single_precision_constant(false) {}
+        single_precision_constant(false),
+        specialize_global_size(false) {}
 
   /// @brief List of preprocessor macro definition.
   std::vector<std::string> definitions;
@@ -208,6 +209,16 @@ struct Options {
   /// with the `reqd_work_group_size` function attribute, in that enqueuing a
   /// kernel built with one of the local sizes in this list will be quicker.
   std::vector<std::array<size_t, 3>> precache_local_sizes;
+  /// @brief Indices of kernel arguments whose values kernels may be
+  /// specialized on.
+  ///
+  /// When a kernel is enqueued, targets supporting this may fold the values of
+  /// any of these arguments which are plain-old-data into the kernel as
+  /// constants, compiling a variant per distinct set of values.
+  std::vector<uint32_t> specialize_arg_indices;
+  /// @brief Allow kernels to be specialized on the global size and offset
+  /// they are enqueued with.
+  bool specialize_global_size;
 
   /// @brief Enumeration of option parsing modes.
   enum class Mode {
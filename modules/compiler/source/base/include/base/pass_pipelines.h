@@ -53,6 +53,11 @@ struct BasePassPipelineTuner {
   /// @brief Whether or not to generate code for degenerate sub groups.
   bool degenerate_sub_groups = false;
 
+  /// @brief Whether or not work-group collectives may initialize their
+  /// accumulators in their (linearly-ordered) combine step, saving a barrier.
+  /// See compiler::utils::ReplaceWGCPassOptions::LinearCombine.
+  bool linear_work_group_collectives = false;
+
   /// @brief The desired target calling convention, used to configure the
   /// FixupCallingConvention pass.
   llvm::CallingConv::ID calling_convention = llvm::CallingConv::C;
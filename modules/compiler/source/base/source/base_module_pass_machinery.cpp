@@ -267,6 +267,18 @@ Expected<bool> parseReplaceMuxMathDeclsPassOptions(StringRef Params) {
                                                 "ReplaceMuxMathDeclsPass");
 }
 
+Expected<compiler::utils::ReplaceWGCPassOptions> parseReplaceWGCPassOptions(
+    StringRef Params) {
+  compiler::utils::ReplaceWGCPassOptions Opts;
+  auto LinearCombine = compiler::utils::parseSinglePassOption(
+      Params, "linear-combine", "ReplaceWGCPass");
+  if (!LinearCombine) {
+    return LinearCombine.takeError();
+  }
+  Opts.LinearCombine = *LinearCombine;
+  return Opts;
+}
+
 // Lookup table for calling convention enums
 std::unordered_map<std::string, CallingConv::ID> CallConvMap = {
     {"C", CallingConv::C},
@@ -546,6 +546,35 @@ Result BaseModule::parseOptions(cargo::string_view input_options,
       return Result::OUT_OF_MEMORY;
     }
 
+    const auto specialize_args_parser = [this](cargo::string_view indices) {
+      for (const auto &index_string : cargo::split(indices, ",")) {
+        std::string index(index_string.begin(), index_string.end());
+        char *endptr;
+        const int64_t arg_index = std::strtol(index.data(), &endptr, 10);
+        // Fail if we got a dodgy value or a non-number character.
+        if (index.empty() || endptr != index.data() + index.size() ||
+            arg_index < 0 || arg_index > UINT32_MAX) {
+          return cargo::argument::parse::INVALID;
+        }
+        this->options.specialize_arg_indices.push_back(
+            static_cast<uint32_t>(arg_index));
+      }
+      return cargo::argument::parse::COMPLETE;
+    };
+
+    if (parser.add_argument({"-cl-specialize-args=",
+                             [](cargo::string_view) {
+                               return cargo::argument::parse::INCOMPLETE;
+                             },
+                             specialize_args_parser})) {
+      return Result::OUT_OF_MEMORY;
+    }
+
+    if (parser.add_argument({"-cl-specialize-global-size",
+                             options.specialize_global_size})) {
+      return Result::OUT_OF_MEMORY;
+    }
+
     // Device argument name handler
     const auto name_parser = [&device_custom_options](
                                  cargo::string_view argument,
@@ -57,7 +57,9 @@ void addPreVeczPasses(ModulePassManager &PM,
   // We need to use the software implementation of the work-group collective
   // builtins. Because ReplaceWGCPass may introduce barrier calls it needs to be
   // run before PrepareBarriersPass.
-  PM.addPass(compiler::utils::ReplaceWGCPass());
+  compiler::utils::ReplaceWGCPassOptions WGCOpts;
+  WGCOpts.LinearCombine = tuner.linear_work_group_collectives;
+  PM.addPass(compiler::utils::ReplaceWGCPass(WGCOpts));
 
   // We have to inline all functions containing barriers before running vecz,
   // because the barriers in both the scalar and vector kernels need to be
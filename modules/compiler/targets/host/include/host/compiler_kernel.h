@@ -22,11 +22,16 @@
 #define HOST_COMPILER_KERNEL_H_INCLUDED
 
 #include <base/kernel.h>
+#include <cargo/optional.h>
 #include <compiler/module.h>
 #include <host/utils/jit_kernel.h>
 
 #include <map>
+#include <mutex>
+#include <tuple>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/module.h"
 
@@ -50,6 +55,45 @@ struct OptimizedKernel {
   std::unique_ptr<::host::utils::jit_kernel_s> binary_kernel;
 };
 
+/// @brief Values of plain-old-data kernel arguments folded into an optimized
+/// kernel, as pairs of argument index and the argument's bytes.
+using ArgumentValues = std::vector<std::pair<uint32_t, std::vector<uint8_t>>>;
+
+/// @brief The shape of an ND range an optimized kernel is specialized for.
+struct GlobalShape {
+  /// @brief Number of dimensions of the ND range.
+  uint32_t work_dim;
+  /// @brief Global size in each dimension, 1 for unused dimensions.
+  std::array<size_t, 3> global_size;
+  /// @brief Global offset in each dimension, 0 for unused dimensions.
+  std::array<size_t, 3> global_offset;
+
+  bool operator<(const GlobalShape &other) const {
+    return std::tie(work_dim, global_size, global_offset) <
+           std::tie(other.work_dim, other.global_size, other.global_offset);
+  }
+};
+
+/// @brief Everything an `OptimizedKernel` has been specialized on.
+struct SpecializationKey {
+  /// @brief Local size the kernel is optimized for.
+  std::array<size_t, 3> local_size;
+  /// @brief ND range shape, if the kernel is specialized on it.
+  cargo::optional<GlobalShape> global_shape;
+  /// @brief Argument values folded into the kernel, may be empty.
+  ArgumentValues arg_values;
+
+  /// @brief Returns true if the key specializes on more than the local size.
+  bool isLaunchSpecialized() const {
+    return global_shape.has_value() || !arg_values.empty();
+  }
+
+  bool operator<(const SpecializationKey &other) const {
+    return std::tie(local_size, global_shape, arg_values) <
+           std::tie(other.local_size, other.global_shape, other.arg_values);
+  }
+};
+
 class HostKernel : public compiler::BaseKernel {
  public:
   HostKernel(HostTarget &target, compiler::Options &build_options,
@@ -73,6 +117,17 @@ class HostKernel : public compiler::BaseKernel {
   createSpecializedKernel(
       const mux_ndrange_options_t &specialization_options) override;
 
+  /// @see Kernel::specializesOnGlobalShape
+  bool specializesOnGlobalShape() const override {
+    return build_options.specialize_global_size;
+  }
+
+  /// @see Kernel::getSpecializedArgumentIndices
+  cargo::array_view<const uint32_t> getSpecializedArgumentIndices()
+      const override {
+    return build_options.specialize_arg_indices;
+  }
+
   /// @brief No-op implementation indicating sub-groups are not supported.
   cargo::expected<uint32_t, compiler::Result> querySubGroupSizeForLocalSize(
       size_t local_size_x, size_t local_size_y, size_t local_size_z) override;
@@ -89,17 +144,46 @@ class HostKernel : public compiler::BaseKernel {
   ///
   /// @param local_size Local size to optimize the kernel for.
   cargo::expected<const OptimizedKernel &, compiler::Result>
-  lookupOrCreateOptimizedKernel(std::array<size_t, 3> local_size);
+  lookupOrCreateOptimizedKernel(std::array<size_t, 3> local_size) {
+    return lookupOrCreateOptimizedKernel(SpecializationKey{local_size, {}, {}});
+  }
+
+  /// @brief Gets an `OptimizedKernel` object for the given specialization.
+  ///
+  /// @param key Local size, ND range shape and argument values to optimize
+  /// the kernel for.
+  cargo::expected<const OptimizedKernel &, compiler::Result>
+  lookupOrCreateOptimizedKernel(SpecializationKey key);
+
+  /// @brief Collects the values of the arguments this kernel should be
+  /// specialized on for an ND range.
+  ///
+  /// @param specialization_options ND range options containing the kernel's
+  /// argument descriptors.
+  ///
+  /// @return Values of the plain-old-data arguments selected by
+  /// `-cl-specialize-args`, empty if there are none or the variant cache is
+  /// full.
+  ArgumentValues getSpecializedArgumentValues(
+      const mux_ndrange_options_t &specialization_options) const;
 
   /// @brief LLVM module containing only the kernel function and functions it
   /// calls, not yet optimized for a local size.
   llvm::Module *module;
 
-  /// @brief Map of optimized modules to their local sizes.
+  /// @brief Map of optimized modules to what they were specialized on.
   ///
   /// By an "optimized module" we mean a copy of this kernel's LLVM module which
   /// has had passes that optimize for a specific local size run on it.
-  std::map<std::array<size_t, 3>, OptimizedKernel> optimized_kernel_map;
+  std::map<SpecializationKey, OptimizedKernel> optimized_kernel_map;
+
+  /// @brief Mutex guarding `optimized_kernel_map` and
+  /// `num_launch_specializations`.
+  std::mutex optimized_kernel_map_mutex;
+
+  /// @brief Number of entries in `optimized_kernel_map` specialized on more
+  /// than the local size.
+  size_t num_launch_specializations = 0;
 
   /// @brief A set of JITDylibs created to manage JIT resources for kernels.
   std::unordered_set<std::string> kernel_jit_dylibs;
@@ -52,6 +52,22 @@ class HostBIMuxInfo : public compiler::utils::BIMuxInfoConcept {
   llvm::Value *initializeSchedulingParamForWrappedKernel(
       const compiler::utils::BuiltinInfo::SchedParamInfo &Info,
       llvm::IRBuilder<> &B, llvm::Function &IntoF, llvm::Function &) override;
+
+ private:
+  /// @brief Defines a __mux_dma_(read|write)_(1|2|3)D builtin for host.
+  ///
+  /// Host memory is directly accessible, so rather than the generic byte loop
+  /// each line of the transfer is a single bulk memcpy. Reads additionally
+  /// issue software prefetches for the tile following the one being copied
+  /// (continuing along the outermost dimension of the transfer), so that the
+  /// next tile streams into the cache while the kernel computes on this one.
+  ///
+  /// @param[in] F The DMA builtin declaration to define.
+  /// @param[in] Dims The dimensionality of the DMA, in the range [1, 3].
+  /// @param[in] IsRead True if the DMA is a read (global to local).
+  ///
+  /// @return The defined function.
+  llvm::Function *defineDMA(llvm::Function &F, unsigned Dims, bool IsRead);
 };
 
 }  // namespace host
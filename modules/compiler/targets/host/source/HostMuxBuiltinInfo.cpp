@@ -14,10 +14,13 @@
 //
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <compiler/utils/dma.h>
 #include <compiler/utils/metadata.h>
 #include <compiler/utils/pass_functions.h>
 #include <compiler/utils/scheduling.h>
 #include <host/host_mux_builtin_info.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
 #include <multi_llvm/multi_llvm.h>
 
 using namespace host;
@@ -154,6 +157,18 @@ Function *HostBIMuxInfo::defineMuxBuiltin(compiler::utils::BuiltinID ID,
   switch (ID) {
     default:
       return compiler::utils::BIMuxInfoConcept::defineMuxBuiltin(ID, M);
+    case compiler::utils::eMuxBuiltinDMARead1D:
+      return defineDMA(*F, 1, /*IsRead*/ true);
+    case compiler::utils::eMuxBuiltinDMARead2D:
+      return defineDMA(*F, 2, /*IsRead*/ true);
+    case compiler::utils::eMuxBuiltinDMARead3D:
+      return defineDMA(*F, 3, /*IsRead*/ true);
+    case compiler::utils::eMuxBuiltinDMAWrite1D:
+      return defineDMA(*F, 1, /*IsRead*/ false);
+    case compiler::utils::eMuxBuiltinDMAWrite2D:
+      return defineDMA(*F, 2, /*IsRead*/ false);
+    case compiler::utils::eMuxBuiltinDMAWrite3D:
+      return defineDMA(*F, 3, /*IsRead*/ false);
     case compiler::utils::eMuxBuiltinGetLocalSize:
       ParamIdx = SchedParamIndices::SCHED;
       DefaultVal = 1;
@@ -195,6 +210,136 @@ Function *HostBIMuxInfo::defineMuxBuiltin(compiler::utils::BuiltinID ID,
   return nullptr;
 }
 
+/// @brief The distance in bytes between successive software prefetches issued
+/// by the host DMA builtins. This is a conservative cache line size for the
+/// architectures host supports.
+static constexpr uint64_t HostDMAPrefetchStride = 64;
+
+Function *HostBIMuxInfo::defineDMA(Function &F, unsigned Dims, bool IsRead) {
+  assert(Dims >= 1 && Dims <= 3 && "Unexpected DMA dimensionality");
+  auto &M = *F.getParent();
+  auto &Ctx = F.getContext();
+  auto *const SizeTy = compiler::utils::getSizeType(M);
+  auto *const I8Ty = Type::getInt8Ty(Ctx);
+  auto *const One = ConstantInt::get(SizeTy, 1);
+
+  // Treat every transfer as 3D, with the missing dimensions being a single
+  // line or plane. The event is always the last argument.
+  Value *const DstPtr = F.getArg(0);
+  Value *const SrcPtr = F.getArg(1);
+  Value *const LineSize = F.getArg(2);
+  Value *DstLineStride = LineSize;
+  Value *SrcLineStride = LineSize;
+  Value *NumLines = One;
+  Value *DstPlaneStride = LineSize;
+  Value *SrcPlaneStride = LineSize;
+  Value *NumPlanes = One;
+  if (Dims >= 2) {
+    DstLineStride = F.getArg(3);
+    SrcLineStride = F.getArg(4);
+    NumLines = F.getArg(5);
+  }
+  if (Dims == 3) {
+    DstPlaneStride = F.getArg(6);
+    SrcPlaneStride = F.getArg(7);
+    NumPlanes = F.getArg(8);
+  }
+  Argument *const ArgEvent = F.getArg(F.arg_size() - 1);
+
+  auto *const ExitBB = BasicBlock::Create(Ctx, "exit", &F);
+  auto *const CopyBB = BasicBlock::Create(Ctx, "copy", &F, ExitBB);
+  auto *const EntryBB = BasicBlock::Create(Ctx, "entry", &F, CopyBB);
+
+  // Only the first work-item in the work-group performs the transfer.
+  auto *const GetLocalIDFn =
+      getOrDeclareMuxBuiltin(compiler::utils::eMuxBuiltinGetLocalId, M);
+  compiler::utils::buildThreadCheck(EntryBB, CopyBB, ExitBB, *GetLocalIDFn);
+
+  // Visits each line of a tile starting at the given source and destination
+  // pointers, calling LineFn on the line's source and destination.
+  auto forEachLine =
+      [&](BasicBlock *BB, Value *Src, Value *Dst,
+          function_ref<BasicBlock *(BasicBlock *, Value *, Value *)> LineFn) {
+        Value *PlaneIVs[] = {Src, Dst};
+        return compiler::utils::createLoop(
+            BB, nullptr, ConstantInt::get(SizeTy, 0), NumPlanes, PlaneIVs,
+            compiler::utils::CreateLoopOpts{},
+            [&](BasicBlock *PlaneBB, Value *, ArrayRef<Value *> PlaneCurr,
+                MutableArrayRef<Value *> PlaneNext) {
+              IRBuilder<> PB(PlaneBB);
+              PlaneNext[0] = PB.CreateGEP(I8Ty, PlaneCurr[0], SrcPlaneStride);
+              PlaneNext[1] = PB.CreateGEP(I8Ty, PlaneCurr[1], DstPlaneStride);
+              Value *LineIVs[] = {PlaneCurr[0], PlaneCurr[1]};
+              return compiler::utils::createLoop(
+                  PlaneBB, nullptr, ConstantInt::get(SizeTy, 0), NumLines,
+                  LineIVs, compiler::utils::CreateLoopOpts{},
+                  [&](BasicBlock *LineBB, Value *, ArrayRef<Value *> LineCurr,
+                      MutableArrayRef<Value *> LineNext) {
+                    IRBuilder<> LB(LineBB);
+                    LineNext[0] =
+                        LB.CreateGEP(I8Ty, LineCurr[0], SrcLineStride);
+                    LineNext[1] =
+                        LB.CreateGEP(I8Ty, LineCurr[1], DstLineStride);
+                    return LineFn(LineBB, LineCurr[0], LineCurr[1]);
+                  });
+            });
+      };
+
+  // Copy each line with a single bulk memcpy, which the backend lowers to the
+  // best available block move for the host architecture.
+  BasicBlock *const CopyExitBB = forEachLine(
+      CopyBB, SrcPtr, DstPtr, [&](BasicBlock *BB, Value *Src, Value *Dst) {
+        IRBuilder<> B(BB);
+        B.CreateMemCpy(Dst, MaybeAlign(), Src, MaybeAlign(), LineSize);
+        return BB;
+      });
+
+  if (!IsRead) {
+    IRBuilder<>(CopyExitBB).CreateBr(ExitBB);
+  } else {
+    // Tiled kernels typically walk through global memory a tile at a time, so
+    // prefetch the tile immediately following this one along the outermost
+    // dimension of the transfer. The prefetches are only hints, so they are
+    // safe even if the next tile lies outside of the buffer.
+    IRBuilder<> B(CopyExitBB);
+    Value *TileSize = LineSize;
+    if (Dims == 2) {
+      TileSize = B.CreateMul(NumLines, SrcLineStride);
+    } else if (Dims == 3) {
+      TileSize = B.CreateMul(NumPlanes, SrcPlaneStride);
+    }
+    auto *const NextSrcPtr = B.CreateGEP(I8Ty, SrcPtr, TileSize, "next.tile");
+    auto *const Prefetch = Intrinsic::getDeclaration(&M, Intrinsic::prefetch,
+                                                     {NextSrcPtr->getType()});
+
+    compiler::utils::CreateLoopOpts PrefetchOpts;
+    PrefetchOpts.indexInc = ConstantInt::get(SizeTy, HostDMAPrefetchStride);
+    BasicBlock *const PrefetchExitBB = forEachLine(
+        CopyExitBB, NextSrcPtr, DstPtr,
+        [&](BasicBlock *BB, Value *Src, Value *) {
+          return compiler::utils::createLoop(
+              BB, nullptr, ConstantInt::get(SizeTy, 0), LineSize, {},
+              PrefetchOpts,
+              [&](BasicBlock *PrefetchBB, Value *Offset, ArrayRef<Value *>,
+                  MutableArrayRef<Value *>) {
+                IRBuilder<> PB(PrefetchBB);
+                // Read access, high temporal locality, data cache.
+                PB.CreateCall(Prefetch,
+                              {PB.CreateGEP(I8Ty, Src, Offset),
+                               PB.getInt32(0), PB.getInt32(3),
+                               PB.getInt32(1)});
+                return PrefetchBB;
+              });
+        });
+    IRBuilder<>(PrefetchExitBB).CreateBr(ExitBB);
+  }
+
+  IRBuilder<> ExitIRB(ExitBB);
+  ExitIRB.CreateRet(ArgEvent);
+
+  return &F;
+}
+
 Value *HostBIMuxInfo::initializeSchedulingParamForWrappedKernel(
     const compiler::utils::BuiltinInfo::SchedParamInfo &Info, IRBuilder<> &B,
     Function &IntoF, Function &) {
@@ -19,9 +19,11 @@
 #include <compiler/utils/cl_builtin_info.h>
 #include <compiler/utils/encode_kernel_metadata_pass.h>
 #include <compiler/utils/llvm_global_mutex.h>
+#include <compiler/utils/mangling.h>
 #include <compiler/utils/metadata.h>
 #include <compiler/utils/metadata_analysis.h>
 #include <compiler/utils/pass_functions.h>
+#include <compiler/utils/simple_callback_pass.h>
 #include <host/compiler_kernel.h>
 #include <host/host_mux_builtin_info.h>
 #include <host/host_pass_machinery.h>
@@ -29,6 +31,7 @@
 #include <host/passes.h>
 #include <host/target.h>
 #include <host/utils/relocations.h>
+#include <llvm/ADT/APInt.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
@@ -39,12 +42,144 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 #include <multi_llvm/llvm_version.h>
+#include <multi_llvm/multi_llvm.h>
+
+#include <algorithm>
 
 #include "cargo/expected.h"
 #include "tracer/tracer.h"
 
 namespace host {
 
+namespace {
+/// @brief Maximum number of argument value or ND range shape specializations
+/// kept per kernel.
+///
+/// Variants can't be evicted because in-flight executables reference them, so
+/// once this is reached further launches use the local size variant.
+constexpr size_t max_launch_specializations = 16;
+
+/// @brief Replaces uses of kernel arguments with their constant values.
+///
+/// @param function Kernel function to specialize.
+/// @param arg_values Values of the arguments to fold.
+void foldArgumentValues(llvm::Function &function,
+                        const ArgumentValues &arg_values) {
+  const auto &DL = function.getParent()->getDataLayout();
+  for (const auto &arg_value : arg_values) {
+    if (arg_value.first >= function.arg_size()) {
+      continue;
+    }
+    llvm::Argument *arg = function.getArg(arg_value.first);
+    llvm::Type *type = arg->getType();
+    if (!type->isIntOrIntVectorTy() && !type->isFPOrFPVectorTy()) {
+      continue;
+    }
+    // Only fold arguments whose bytes map exactly onto the IR type, this
+    // excludes e.g. 3 element vectors which are padded to 4 elements.
+    const auto &bytes = arg_value.second;
+    const uint64_t bits = multi_llvm::getFixedValue(DL.getTypeSizeInBits(type));
+    if (bits != bytes.size() * 8) {
+      continue;
+    }
+    llvm::APInt int_value(bits, 0);
+    llvm::LoadIntFromMemory(int_value, bytes.data(), bytes.size());
+    llvm::Constant *value = llvm::ConstantExpr::getBitCast(
+        llvm::ConstantInt::get(function.getContext(), int_value), type);
+    arg->replaceAllUsesWith(value);
+  }
+}
+
+/// @brief Folds the ND range builtins of a kernel to the given shape.
+///
+/// Size, offset and group count queries become constants, while global and
+/// group ID queries get precise range metadata so that bounds checks against
+/// the global size can be folded away.
+///
+/// @param module Module containing the kernel to specialize.
+/// @param shape ND range shape to specialize for.
+/// @param local_size Local size the kernel is being optimized for.
+void foldGlobalShape(llvm::Module &module, const GlobalShape &shape,
+                     const std::array<size_t, 3> &local_size) {
+  compiler::utils::NameMangler mangler(&module.getContext());
+  for (auto &builtin : module) {
+    if (!builtin.isDeclaration()) {
+      continue;
+    }
+    const auto builtin_name = mangler.demangleName(builtin.getName());
+    const bool is_work_dim = builtin_name == "get_work_dim";
+    if (!is_work_dim && builtin_name != "get_global_size" &&
+        builtin_name != "get_global_offset" &&
+        builtin_name != "get_num_groups" && builtin_name != "get_global_id" &&
+        builtin_name != "get_group_id") {
+      continue;
+    }
+    auto *const type =
+        llvm::dyn_cast<llvm::IntegerType>(builtin.getReturnType());
+    if (!type) {
+      continue;
+    }
+
+    llvm::SmallVector<llvm::CallInst *, 8> calls;
+    for (auto *user : builtin.users()) {
+      if (auto *call = llvm::dyn_cast<llvm::CallInst>(user)) {
+        if (call->getCalledFunction() == &builtin) {
+          calls.push_back(call);
+        }
+      }
+    }
+
+    for (auto *call : calls) {
+      if (is_work_dim) {
+        call->replaceAllUsesWith(llvm::ConstantInt::get(type, shape.work_dim));
+        call->eraseFromParent();
+        continue;
+      }
+      auto *const dim =
+          llvm::dyn_cast<llvm::ConstantInt>(call->getArgOperand(0));
+      if (!dim) {
+        continue;
+      }
+      // Out of range dimensions are handled by the builtins themselves.
+      const uint64_t d = dim->getZExtValue();
+      if (d >= 3) {
+        continue;
+      }
+      const uint64_t num_groups = shape.global_size[d] / local_size[d];
+      uint64_t lower = 0;
+      uint64_t upper = 0;
+      if (builtin_name == "get_global_size") {
+        lower = shape.global_size[d];
+      } else if (builtin_name == "get_global_offset") {
+        lower = shape.global_offset[d];
+      } else if (builtin_name == "get_num_groups") {
+        lower = num_groups;
+      } else if (builtin_name == "get_global_id") {
+        lower = shape.global_offset[d];
+        upper = shape.global_offset[d] + shape.global_size[d];
+      } else {
+        upper = num_groups;
+      }
+
+      // IDs are constant too if there's only one work-item or work-group in
+      // this dimension.
+      if (!upper || lower + 1 == upper) {
+        call->replaceAllUsesWith(llvm::ConstantInt::get(type, lower));
+        call->eraseFromParent();
+      } else if (!call->getMetadata(llvm::LLVMContext::MD_range) &&
+                 upper < type->getBitMask()) {
+        llvm::Metadata *range[] = {
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(type, lower)),
+            llvm::ConstantAsMetadata::get(
+                llvm::ConstantInt::get(type, upper))};
+        call->setMetadata(llvm::LLVMContext::MD_range,
+                          llvm::MDNode::get(module.getContext(), range));
+      }
+    }
+  }
+}
+}  // namespace
+
 HostKernel::HostKernel(
     HostTarget &target, compiler::Options &build_options,
     cargo::array_view<compiler::BaseModule::SnapshotDetails> snapshots,
@@ -139,7 +274,17 @@ HostKernel::createSpecializedKernel(
   std::copy(std::begin(specialization_options.local_size),
             std::end(specialization_options.local_size),
             std::begin(local_size));
-  auto optimized_kernel = lookupOrCreateOptimizedKernel(local_size);
+  SpecializationKey key{local_size, {},
+                        getSpecializedArgumentValues(specialization_options)};
+  if (build_options.specialize_global_size) {
+    GlobalShape shape{specialization_options.dimensions, {1, 1, 1}, {0, 0, 0}};
+    for (uint32_t i = 0; i < specialization_options.dimensions; i++) {
+      shape.global_size[i] = specialization_options.global_size[i];
+      shape.global_offset[i] = specialization_options.global_offset[i];
+    }
+    key.global_shape = shape;
+  }
+  auto optimized_kernel = lookupOrCreateOptimizedKernel(std::move(key));
   if (!optimized_kernel) {
     return cargo::make_unexpected(optimized_kernel.error());
   }
@@ -226,10 +371,49 @@ cargo::expected<size_t, compiler::Result> HostKernel::queryMaxSubGroupCount() {
          static_cast<size_t>(info.max_work_group_size_z);
 }
 
+ArgumentValues HostKernel::getSpecializedArgumentValues(
+    const mux_ndrange_options_t &specialization_options) const {
+  ArgumentValues arg_values;
+  for (const uint32_t index : build_options.specialize_arg_indices) {
+    if (index >= specialization_options.descriptors_length) {
+      continue;
+    }
+    const auto &descriptor = specialization_options.descriptors[index];
+    if (descriptor.type != mux_descriptor_info_type_plain_old_data) {
+      continue;
+    }
+    const auto &pod = descriptor.plain_old_data_descriptor;
+    const auto *data = static_cast<const uint8_t *>(pod.data);
+    arg_values.emplace_back(index,
+                            std::vector<uint8_t>(data, data + pod.length));
+  }
+  std::sort(arg_values.begin(), arg_values.end());
+  arg_values.erase(std::unique(arg_values.begin(), arg_values.end()),
+                   arg_values.end());
+  return arg_values;
+}
+
 cargo::expected<const OptimizedKernel &, compiler::Result>
-HostKernel::lookupOrCreateOptimizedKernel(std::array<size_t, 3> local_size) {
-  if (0 < optimized_kernel_map.count(local_size)) {
-    return optimized_kernel_map[local_size];
+HostKernel::lookupOrCreateOptimizedKernel(SpecializationKey key) {
+  // Enqueues don't hold a command queue lock while specializing, so guard the
+  // map against concurrent launches of this kernel.
+  std::lock_guard<std::mutex> lock(optimized_kernel_map_mutex);
+
+  auto found = optimized_kernel_map.find(key);
+  if (found != optimized_kernel_map.end()) {
+    return found->second;
+  }
+
+  // Don't create any more launch specializations once the cache is full, fall
+  // back to the variant specialized on only the local size.
+  const std::array<size_t, 3> local_size = key.local_size;
+  if (key.isLaunchSpecialized() &&
+      num_launch_specializations >= max_launch_specializations) {
+    key = SpecializationKey{local_size, {}, {}};
+    found = optimized_kernel_map.find(key);
+    if (found != optimized_kernel_map.end()) {
+      return found->second;
+    }
   }
 
   {
@@ -279,6 +463,21 @@ HostKernel::lookupOrCreateOptimizedKernel(std::array<size_t, 3> local_size) {
                             static_cast<uint64_t>(local_size[2])};
     pm.addPass(compiler::utils::EncodeKernelMetadataPass(pass_opts));
 
+    // Fold the launch properties we're specializing on before anything else,
+    // so that vecz and loop unrolling see constant sizes and strides.
+    if (!key.arg_values.empty()) {
+      pm.addPass(compiler::utils::SimpleCallbackPass([&](llvm::Module &m) {
+        if (auto *f = m.getFunction(name)) {
+          foldArgumentValues(*f, key.arg_values);
+        }
+      }));
+    }
+    if (key.global_shape) {
+      pm.addPass(compiler::utils::SimpleCallbackPass([&](llvm::Module &m) {
+        foldGlobalShape(m, *key.global_shape, local_size);
+      }));
+    }
+
     pm.addPass(hostGetKernelPasses(build_options, pass_mach.getPB(), snapshots,
                                    unique_name));
 
@@ -400,10 +599,15 @@ HostKernel::lookupOrCreateOptimizedKernel(std::array<size_t, 3> local_size) {
         new host::utils::jit_kernel_s{
             name, hook, static_cast<uint32_t>(fn_metadata.local_memory_usage),
             min_width, pref_width, sub_group_size});
-    optimized_kernel_map.emplace(
-        local_size,
-        OptimizedKernel{optimized_module_ptr, std::move(jit_kernel)});
+    if (key.isLaunchSpecialized()) {
+      num_launch_specializations++;
+    }
+    found = optimized_kernel_map
+                .emplace(std::move(key),
+                         OptimizedKernel{optimized_module_ptr,
+                                         std::move(jit_kernel)})
+                .first;
   }
-  return optimized_kernel_map[local_size];
+  return found->second;
 }
 }  // namespace host
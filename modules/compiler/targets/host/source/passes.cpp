@@ -88,6 +88,11 @@ llvm::ModulePassManager hostGetKernelPasses(
   // On host we have degenerate sub-groups i.e. sub-group == work-group.
   tuner.degenerate_sub_groups = true;
 
+  // Host executes all the work-items in a work-group on a single thread, so
+  // linearly ordered barrier regions are cheap and let work-group collectives
+  // skip their accumulator initialization barrier.
+  tuner.linear_work_group_collectives = true;
+
   // Forcibly compute the BuiltinInfoAnalysis so that cached retrievals work.
   PM.addPass(llvm::RequireAnalysisPass<compiler::utils::BuiltinInfoAnalysis,
                                        llvm::Module>());
@@ -0,0 +1,120 @@
+; Copyright (C) Codeplay Software Limited
+;
+; Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+; Exceptions; you may not use this file except in compliance with the License.
+; You may obtain a copy of the License at
+;
+;     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+;
+; Unless required by applicable law or agreed to in writing, software
+; distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+; WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+; License for the specific language governing permissions and limitations
+; under the License.
+;
+; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+; RUN: muxc --device "%default_device" --passes define-mux-dma,verify -S %s | FileCheck %s
+
+; Check that host defines the DMA builtins in terms of bulk memcpys, and that
+; reads prefetch the following tile.
+
+target triple = "spir64-unknown-unknown"
+target datalayout = "e-p:64:64:64-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; CHECK-LABEL: define spir_func ptr @__mux_dma_read_1D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, ptr %event)
+; CHECK: entry:
+; CHECK: br i1 %{{.*}}, label %copy, label %exit
+; CHECK: copy:
+; CHECK: call void @llvm.memcpy.p3.p1.i64(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, i1 false)
+; CHECK: %next.tile = getelementptr i8, ptr addrspace(1) %src, i64 %width
+; CHECK: exit:
+; CHECK-NEXT: ret ptr %event
+; CHECK: [[IV:%.*]] = phi i64 [ 0, {{.*}} ], [ [[INC:%.*]], {{.*}} ]
+; CHECK: [[ADDR:%.*]] = getelementptr i8, ptr addrspace(1) {{.*}}, i64 [[IV]]
+; CHECK: call void @llvm.prefetch.p1(ptr addrspace(1) [[ADDR]], i32 0, i32 3, i32 1)
+; CHECK: [[INC]] = add i64 [[IV]], 64
+; CHECK: icmp ult i64 [[INC]], %width
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_read_1D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, ptr %event)
+
+; CHECK-LABEL: define spir_func ptr @__mux_dma_write_1D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, ptr %event)
+; CHECK: call void @llvm.memcpy.p1.p3.i64(ptr addrspace(1) {{.*}}, ptr addrspace(3) {{.*}}, i64 %width, i1 false)
+; CHECK-NOT: @llvm.prefetch
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_write_1D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, ptr %event)
+
+; 2D transfers copy one line per iteration, stepping each side by its own line
+; stride, and prefetch the next block of height lines.
+; CHECK-LABEL: define spir_func ptr @__mux_dma_read_2D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, i64 %dst_stride, i64 %src_stride, i64 %height, ptr %event)
+; CHECK: br i1 %{{.*}}, label %copy, label %exit
+; CHECK: exit:
+; CHECK-NEXT: ret ptr %event
+; CHECK: [[LINE:%.*]] = phi i64 [ 0, %copy ], [ [[NEXTLINE:%.*]], {{.*}} ]
+; CHECK: [[SRC:%.*]] = phi ptr addrspace(1) [ %src, %copy ], [ [[NEXTSRC:%.*]], {{.*}} ]
+; CHECK: [[DST:%.*]] = phi ptr addrspace(3) [ %dst, %copy ], [ [[NEXTDST:%.*]], {{.*}} ]
+; CHECK: [[NEXTSRC]] = getelementptr i8, ptr addrspace(1) [[SRC]], i64 %src_stride
+; CHECK: [[NEXTDST]] = getelementptr i8, ptr addrspace(3) [[DST]], i64 %dst_stride
+; CHECK: call void @llvm.memcpy.p3.p1.i64(ptr addrspace(3) [[DST]], ptr addrspace(1) [[SRC]], i64 %width, i1 false)
+; CHECK: [[NEXTLINE]] = add i64 [[LINE]], 1
+; CHECK: icmp ult i64 [[NEXTLINE]], %height
+; CHECK: [[TILE:%.*]] = mul i64 %height, %src_stride
+; CHECK: %next.tile = getelementptr i8, ptr addrspace(1) %src, i64 [[TILE]]
+; CHECK: phi ptr addrspace(1) [ %next.tile, {{.*}} ]
+; CHECK: getelementptr i8, ptr addrspace(1) {{.*}}, i64 %src_stride
+; CHECK: call void @llvm.prefetch.p1(ptr addrspace(1) {{.*}}, i32 0, i32 3, i32 1)
+; CHECK: add i64 {{.*}}, 64
+; CHECK: icmp ult i64 {{.*}}, %width
+; CHECK: icmp ult i64 {{.*}}, %height
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_read_2D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, i64 %dst_stride, i64 %src_stride, i64 %height, ptr %event)
+
+; CHECK-LABEL: define spir_func ptr @__mux_dma_write_2D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, i64 %dst_stride, i64 %src_stride, i64 %height, ptr %event)
+; CHECK: [[SRC:%.*]] = phi ptr addrspace(3) [ %src, %copy ], [ [[NEXTSRC:%.*]], {{.*}} ]
+; CHECK: [[DST:%.*]] = phi ptr addrspace(1) [ %dst, %copy ], [ [[NEXTDST:%.*]], {{.*}} ]
+; CHECK: [[NEXTSRC]] = getelementptr i8, ptr addrspace(3) [[SRC]], i64 %src_stride
+; CHECK: [[NEXTDST]] = getelementptr i8, ptr addrspace(1) [[DST]], i64 %dst_stride
+; CHECK: call void @llvm.memcpy.p1.p3.i64(ptr addrspace(1) [[DST]], ptr addrspace(3) [[SRC]], i64 %width, i1 false)
+; CHECK: icmp ult i64 {{.*}}, %height
+; CHECK-NOT: @llvm.prefetch
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_write_2D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, i64 %dst_stride, i64 %src_stride, i64 %height, ptr %event)
+
+; 3D transfers nest the line loop inside a plane loop, and prefetch the next
+; block of depth planes.
+; CHECK-LABEL: define spir_func ptr @__mux_dma_read_3D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, i64 %dst_line_stride, i64 %src_line_stride, i64 %height, i64 %dst_plane_stride, i64 %src_plane_stride, i64 %depth, ptr %event)
+; CHECK: br i1 %{{.*}}, label %copy, label %exit
+; CHECK: exit:
+; CHECK-NEXT: ret ptr %event
+; CHECK: [[PSRC:%.*]] = phi ptr addrspace(1) [ %src, %copy ], [ [[NEXTPSRC:%.*]], {{.*}} ]
+; CHECK: [[PDST:%.*]] = phi ptr addrspace(3) [ %dst, %copy ], [ [[NEXTPDST:%.*]], {{.*}} ]
+; CHECK: [[NEXTPSRC]] = getelementptr i8, ptr addrspace(1) [[PSRC]], i64 %src_plane_stride
+; CHECK: [[NEXTPDST]] = getelementptr i8, ptr addrspace(3) [[PDST]], i64 %dst_plane_stride
+; CHECK: [[SRC:%.*]] = phi ptr addrspace(1) [ [[PSRC]], {{.*}} ], [ [[NEXTSRC:%.*]], {{.*}} ]
+; CHECK: [[DST:%.*]] = phi ptr addrspace(3) [ [[PDST]], {{.*}} ], [ [[NEXTDST:%.*]], {{.*}} ]
+; CHECK: [[NEXTSRC]] = getelementptr i8, ptr addrspace(1) [[SRC]], i64 %src_line_stride
+; CHECK: [[NEXTDST]] = getelementptr i8, ptr addrspace(3) [[DST]], i64 %dst_line_stride
+; CHECK: call void @llvm.memcpy.p3.p1.i64(ptr addrspace(3) [[DST]], ptr addrspace(1) [[SRC]], i64 %width, i1 false)
+; CHECK: icmp ult i64 {{.*}}, %height
+; CHECK: icmp ult i64 {{.*}}, %depth
+; CHECK: [[TILE:%.*]] = mul i64 %depth, %src_plane_stride
+; CHECK: %next.tile = getelementptr i8, ptr addrspace(1) %src, i64 [[TILE]]
+; CHECK: phi ptr addrspace(1) [ %next.tile, {{.*}} ]
+; CHECK: call void @llvm.prefetch.p1(ptr addrspace(1) {{.*}}, i32 0, i32 3, i32 1)
+; CHECK: icmp ult i64 {{.*}}, %width
+; CHECK: icmp ult i64 {{.*}}, %height
+; CHECK: icmp ult i64 {{.*}}, %depth
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_read_3D(ptr addrspace(3) %dst, ptr addrspace(1) %src, i64 %width, i64 %dst_line_stride, i64 %src_line_stride, i64 %height, i64 %dst_plane_stride, i64 %src_plane_stride, i64 %depth, ptr %event)
+
+; CHECK-LABEL: define spir_func ptr @__mux_dma_write_3D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, i64 %dst_line_stride, i64 %src_line_stride, i64 %height, i64 %dst_plane_stride, i64 %src_plane_stride, i64 %depth, ptr %event)
+; CHECK: getelementptr i8, ptr addrspace(3) {{.*}}, i64 %src_plane_stride
+; CHECK: getelementptr i8, ptr addrspace(1) {{.*}}, i64 %dst_plane_stride
+; CHECK: getelementptr i8, ptr addrspace(3) {{.*}}, i64 %src_line_stride
+; CHECK: getelementptr i8, ptr addrspace(1) {{.*}}, i64 %dst_line_stride
+; CHECK: call void @llvm.memcpy.p1.p3.i64(ptr addrspace(1) {{.*}}, ptr addrspace(3) {{.*}}, i64 %width, i1 false)
+; CHECK: icmp ult i64 {{.*}}, %height
+; CHECK: icmp ult i64 {{.*}}, %depth
+; CHECK-NOT: @llvm.prefetch
+; CHECK: br label %exit
+declare spir_func ptr @__mux_dma_write_3D(ptr addrspace(1) %dst, ptr addrspace(3) %src, i64 %width, i64 %dst_line_stride, i64 %src_line_stride, i64 %height, i64 %dst_plane_stride, i64 %src_plane_stride, i64 %depth, ptr %event)
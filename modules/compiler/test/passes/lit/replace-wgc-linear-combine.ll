@@ -0,0 +1,563 @@
+; Copyright (C) Codeplay Software Limited
+;
+; Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+; Exceptions; you may not use this file except in compliance with the License.
+; You may obtain a copy of the License at
+;
+;     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+;
+; Unless required by applicable law or agreed to in writing, software
+; distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+; WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+; License for the specific language governing permissions and limitations
+; under the License.
+;
+; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+; RUN: muxc --passes "replace-wgc<linear-combine>,verify" -S %s | FileCheck %s
+
+; Check that replace-wgc with linear-combine folds the accumulator
+; initialization into the linearly-scheduled combine step, removing the "once"
+; barrier from every reduction and scan, for each operation and element type,
+; while leaving broadcasts untouched.
+
+target triple = "spir64-unknown-unknown"
+target datalayout = "e-p:64:64:64-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; CHECK: @[[ADD_ACCUM:.+]] = internal addrspace(3) global i32 undef
+; CHECK: @_Z29work_group_scan_inclusive_maxj.accumulator = internal addrspace(3) global i32 undef
+; CHECK: @_Z29work_group_scan_exclusive_addf.accumulator = internal addrspace(3) global float undef
+
+; CHECK: define spir_func i32 @_Z21work_group_reduce_addi(i32 [[PARAM:%.*]])
+declare spir_func i32 @_Z21work_group_reduce_addi(i32 %x)
+; CHECK-LABEL: entry:
+; CHECK: %[[SUBGROUP:.+]] = call i32 @_Z20sub_group_reduce_addj(i32 %{{.+}})
+; CHECK-NOT: store
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR:#[0-9]+]]
+; CHECK-NOT: call void @__mux_work_group_barrier
+; CHECK: %[[LIDX:.+]] = call spir_func i64 @__mux_get_local_id(i32 0)
+; CHECK: %[[CMPX:.+]] = icmp eq i64 %[[LIDX]], 0
+; CHECK: %[[LIDY:.+]] = call spir_func i64 @__mux_get_local_id(i32 1)
+; CHECK: %[[CMPY:.+]] = icmp eq i64 %[[LIDY]], 0
+; CHECK: %[[CMPXY:.+]] = and i1 %[[CMPX]], %[[CMPY]]
+; CHECK: %[[LIDZ:.+]] = call spir_func i64 @__mux_get_local_id(i32 2)
+; CHECK: %[[CMPZ:.+]] = icmp eq i64 %[[LIDZ]], 0
+; CHECK: %[[CMPXYZ:.+]] = and i1 %[[CMPXY]], %[[CMPZ]]
+; CHECK: %[[EXT:.+]] = zext i1 %[[CMPXYZ]] to i32
+; CHECK: %[[ANY:.+]] = call i32 @_Z13sub_group_anyi(i32 %[[EXT]])
+; CHECK: %[[FIRST:.+]] = icmp ne i32 %[[ANY]], 0
+; CHECK: %[[LOADVAL:.+]] = load i32, [[PTR_i32:(i32 addrspace\(3\)\*)|(ptr addrspace\(3\))]] @[[ADD_ACCUM]]
+; CHECK: %[[CURRVAL:.+]] = select i1 %[[FIRST]], i32 0, i32 %[[LOADVAL]]
+; CHECK: %[[ACCUM:.*]] = add i32 %[[CURRVAL]], %[[SUBGROUP]]
+; CHECK: store i32 %[[ACCUM]], [[PTR_i32]] @[[ADD_ACCUM]]
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272)
+; CHECK: %[[RESULT:.*]] = load i32, [[PTR_i32]] @[[ADD_ACCUM]]
+; CHECK: ret i32 %[[RESULT]]
+
+; CHECK: define spir_func i32 @_Z29work_group_scan_inclusive_maxj(i32 [[PARAM:%.*]])
+declare spir_func i32 @_Z29work_group_scan_inclusive_maxj(i32 %x)
+; CHECK-LABEL: entry:
+; CHECK-NOT: store
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: %[[LOADVAL:.+]] = load i32, [[PTR_i32]] @_Z29work_group_scan_inclusive_maxj.accumulator
+; CHECK: %[[ANY:.+]] = call i32 @_Z13sub_group_anyi(i32 %{{.+}})
+; CHECK: %[[FIRST:.+]] = icmp ne i32 %[[ANY]], 0
+; CHECK: %[[CURRVAL:.+]] = select i1 %[[FIRST]], i32 0, i32 %[[LOADVAL]]
+; CHECK: %[[SCAN:.+]] = call i32 @_Z28sub_group_scan_inclusive_maxj(i32 %x)
+; CHECK: %[[RESULT:.+]] = call i32 @llvm.umax.i32(i32 %[[CURRVAL]], i32 %[[SCAN]])
+; CHECK: %[[SIZE:.+]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: %[[LAST:.+]] = sub nuw i32 %[[SIZE]], 1
+; CHECK: %[[TAIL:.+]] = call i32 @_Z19sub_group_broadcastjj(i32 %[[SCAN]], i32 %[[LAST]])
+; CHECK: %[[ACCUM:.+]] = call i32 @llvm.umax.i32(i32 %[[CURRVAL]], i32 %[[TAIL]])
+; CHECK: store i32 %[[ACCUM]], [[PTR_i32]] @_Z29work_group_scan_inclusive_maxj.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272)
+; CHECK: ret i32 %[[RESULT]]
+
+; CHECK: define spir_func float @_Z29work_group_scan_exclusive_addf(float [[PARAM:%.*]])
+declare spir_func float @_Z29work_group_scan_exclusive_addf(float %x)
+; CHECK-LABEL: entry:
+; CHECK-NOT: store
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: %[[LOADVAL:.+]] = load float, [[PTR_float:(float addrspace\(3\)\*)|(ptr addrspace\(3\))]] @_Z29work_group_scan_exclusive_addf.accumulator
+; CHECK: %[[CURRVAL:.+]] = select i1 %{{.+}}, float -0.000000e+00, float %[[LOADVAL]]
+; CHECK: %[[SGSCAN:.+]] = call float @_Z28sub_group_scan_exclusive_addf(float %x)
+; CHECK: %[[WGSCAN:.+]] = fadd float %[[CURRVAL]], %{{.+}}
+; CHECK: store float %{{.+}}, [[PTR_float]] @_Z29work_group_scan_exclusive_addf.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272)
+; CHECK: %[[RESULT:.+]] = select i1 %{{.+}}, float 0.000000e+00, float %[[WGSCAN]]
+; CHECK: ret float %[[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z14work_group_alli(i32 %x)
+declare spir_func i32 @_Z14work_group_alli(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z13sub_group_alli(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z14work_group_alli.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 -1, i32 [[LOAD]]
+; CHECK: [[CMP:%.*]] = icmp ne i32 [[SG]], 0
+; CHECK: [[EXT:%.*]] = sext i1 [[CMP]] to i32
+; CHECK: [[ACCUM:%.*]] = and i32 [[EXT]], [[CURR]]
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z14work_group_alli.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z14work_group_alli.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z14work_group_anyi(i32 %x)
+declare spir_func i32 @_Z14work_group_anyi(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z13sub_group_anyi(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z14work_group_anyi.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 0, i32 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = or i32 [[CURR]], [[SG]]
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z14work_group_anyi.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z14work_group_anyi.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z21work_group_reduce_addm(i64 %x)
+declare spir_func i64 @_Z21work_group_reduce_addm(i64 %x)
+; CHECK: [[SG:%.*]] = call i64 @_Z20sub_group_reduce_addm(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_addm.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = add i64 [[CURR]], [[SG]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_addm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_addm.accumulator
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-LABEL: define spir_func float @_Z21work_group_reduce_addf(float %x)
+declare spir_func float @_Z21work_group_reduce_addf(float %x)
+; CHECK: [[SG:%.*]] = call float @_Z20sub_group_reduce_addf(float %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load float, ptr addrspace(3) @_Z21work_group_reduce_addf.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], float -0.000000e+00, float [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = fadd float [[CURR]], [[SG]]
+; CHECK: store float [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_addf.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load float, ptr addrspace(3) @_Z21work_group_reduce_addf.accumulator
+; CHECK: ret float [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z21work_group_reduce_minl(i64 %x)
+declare spir_func i64 @_Z21work_group_reduce_minl(i64 %x)
+; CHECK: [[SG:%.*]] = call i64 @_Z20sub_group_reduce_minl(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_minl.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 9223372036854775807, i64 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call i64 @llvm.smin.i64(i64 [[CURR]], i64 [[SG]])
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_minl.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_minl.accumulator
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z21work_group_reduce_minj(i32 %x)
+declare spir_func i32 @_Z21work_group_reduce_minj(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z20sub_group_reduce_minj(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_minj.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 -1, i32 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call i32 @llvm.umin.i32(i32 [[CURR]], i32 [[SG]])
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_minj.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_minj.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func double @_Z21work_group_reduce_mind(double %x)
+declare spir_func double @_Z21work_group_reduce_mind(double %x)
+; CHECK: [[SG:%.*]] = call double @_Z20sub_group_reduce_mind(double %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load double, ptr addrspace(3) @_Z21work_group_reduce_mind.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], double 0x7FF8000000000000, double [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call double @llvm.minnum.f64(double [[CURR]], double [[SG]])
+; CHECK: store double [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_mind.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load double, ptr addrspace(3) @_Z21work_group_reduce_mind.accumulator
+; CHECK: ret double [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z21work_group_reduce_maxi(i32 %x)
+declare spir_func i32 @_Z21work_group_reduce_maxi(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z20sub_group_reduce_maxi(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_maxi.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 -2147483648, i32 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call i32 @llvm.smax.i32(i32 [[CURR]], i32 [[SG]])
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_maxi.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_maxi.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z21work_group_reduce_maxm(i64 %x)
+declare spir_func i64 @_Z21work_group_reduce_maxm(i64 %x)
+; CHECK: [[SG:%.*]] = call i64 @_Z20sub_group_reduce_maxm(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_maxm.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call i64 @llvm.umax.i64(i64 [[CURR]], i64 [[SG]])
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_maxm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_maxm.accumulator
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-LABEL: define spir_func half @_Z21work_group_reduce_maxDh(half %x)
+declare spir_func half @_Z21work_group_reduce_maxDh(half %x)
+; CHECK: [[SG:%.*]] = call half @_Z20sub_group_reduce_maxDh(half %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load half, ptr addrspace(3) @_Z21work_group_reduce_maxDh.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], half 0xHFE00, half [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = call half @llvm.maxnum.f16(half [[CURR]], half [[SG]])
+; CHECK: store half [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_maxDh.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load half, ptr addrspace(3) @_Z21work_group_reduce_maxDh.accumulator
+; CHECK: ret half [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z21work_group_reduce_muli(i32 %x)
+declare spir_func i32 @_Z21work_group_reduce_muli(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z20sub_group_reduce_mulj(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_muli.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 1, i32 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = mul i32 [[CURR]], [[SG]]
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_muli.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_muli.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func float @_Z21work_group_reduce_mulf(float %x)
+declare spir_func float @_Z21work_group_reduce_mulf(float %x)
+; CHECK: [[SG:%.*]] = call float @_Z20sub_group_reduce_mulf(float %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load float, ptr addrspace(3) @_Z21work_group_reduce_mulf.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], float 1.000000e+00, float [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = fmul float [[CURR]], [[SG]]
+; CHECK: store float [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_mulf.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load float, ptr addrspace(3) @_Z21work_group_reduce_mulf.accumulator
+; CHECK: ret float [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z21work_group_reduce_andj(i32 %x)
+declare spir_func i32 @_Z21work_group_reduce_andj(i32 %x)
+; CHECK: [[SG:%.*]] = call i32 @_Z20sub_group_reduce_andj(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_andj.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 -1, i32 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = and i32 [[CURR]], [[SG]]
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_andj.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i32, ptr addrspace(3) @_Z21work_group_reduce_andj.accumulator
+; CHECK: ret i32 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z20work_group_reduce_orl(i64 %x)
+declare spir_func i64 @_Z20work_group_reduce_orl(i64 %x)
+; CHECK: [[SG:%.*]] = call i64 @_Z19sub_group_reduce_orm(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z20work_group_reduce_orl.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = or i64 [[CURR]], [[SG]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z20work_group_reduce_orl.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z20work_group_reduce_orl.accumulator
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z21work_group_reduce_xorm(i64 %x)
+declare spir_func i64 @_Z21work_group_reduce_xorm(i64 %x)
+; CHECK: [[SG:%.*]] = call i64 @_Z20sub_group_reduce_xorm(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_xorm.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = xor i64 [[CURR]], [[SG]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z21work_group_reduce_xorm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z21work_group_reduce_xorm.accumulator
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i1 @_Z29work_group_reduce_logical_andb(i1 %x)
+declare spir_func i1 @_Z29work_group_reduce_logical_andb(i1 %x)
+; CHECK: [[SG:%.*]] = call i1 @_Z28sub_group_reduce_logical_andb(i1 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i1, ptr addrspace(3) @_Z29work_group_reduce_logical_andb.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i1 true, i1 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = and i1 [[CURR]], [[SG]]
+; CHECK: store i1 [[ACCUM]], ptr addrspace(3) @_Z29work_group_reduce_logical_andb.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i1, ptr addrspace(3) @_Z29work_group_reduce_logical_andb.accumulator
+; CHECK: ret i1 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i1 @_Z28work_group_reduce_logical_orb(i1 %x)
+declare spir_func i1 @_Z28work_group_reduce_logical_orb(i1 %x)
+; CHECK: [[SG:%.*]] = call i1 @_Z27sub_group_reduce_logical_orb(i1 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i1, ptr addrspace(3) @_Z28work_group_reduce_logical_orb.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i1 false, i1 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = or i1 [[CURR]], [[SG]]
+; CHECK: store i1 [[ACCUM]], ptr addrspace(3) @_Z28work_group_reduce_logical_orb.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i1, ptr addrspace(3) @_Z28work_group_reduce_logical_orb.accumulator
+; CHECK: ret i1 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i1 @_Z29work_group_reduce_logical_xorb(i1 %x)
+declare spir_func i1 @_Z29work_group_reduce_logical_xorb(i1 %x)
+; CHECK: [[SG:%.*]] = call i1 @_Z28sub_group_reduce_logical_xorb(i1 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[LOAD:%.*]] = load i1, ptr addrspace(3) @_Z29work_group_reduce_logical_xorb.accumulator
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i1 false, i1 [[LOAD]]
+; CHECK: [[ACCUM:%.*]] = xor i1 [[CURR]], [[SG]]
+; CHECK: store i1 [[ACCUM]], ptr addrspace(3) @_Z29work_group_reduce_logical_xorb.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i1, ptr addrspace(3) @_Z29work_group_reduce_logical_xorb.accumulator
+; CHECK: ret i1 [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z29work_group_scan_inclusive_addl(i64 %x)
+declare spir_func i64 @_Z29work_group_scan_inclusive_addl(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z29work_group_scan_inclusive_addl.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i64 @_Z28sub_group_scan_inclusive_addm(i64 %x)
+; CHECK: [[WGSCAN:%.*]] = add i64 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i64 @_Z19sub_group_broadcastmj(i64 [[SCAN]], i32 [[LAST]])
+; CHECK: [[ACCUM:%.*]] = add i64 [[CURR]], [[SCAN_TAIL]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_inclusive_addl.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i64 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func float @_Z29work_group_scan_inclusive_minf(float %x)
+declare spir_func float @_Z29work_group_scan_inclusive_minf(float %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load float, ptr addrspace(3) @_Z29work_group_scan_inclusive_minf.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], float 0x7FF8000000000000, float [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call float @_Z28sub_group_scan_inclusive_minf(float %x)
+; CHECK: [[WGSCAN:%.*]] = call float @llvm.minnum.f32(float [[CURR]], float [[SCAN]])
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call float @_Z19sub_group_broadcastfj(float [[SCAN]], i32 [[LAST]])
+; CHECK: [[ACCUM:%.*]] = call float @llvm.minnum.f32(float [[CURR]], float [[SCAN_TAIL]])
+; CHECK: store float [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_inclusive_minf.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret float [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func half @_Z29work_group_scan_inclusive_mulDh(half %x)
+declare spir_func half @_Z29work_group_scan_inclusive_mulDh(half %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load half, ptr addrspace(3) @_Z29work_group_scan_inclusive_mulDh.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], half 0xH3C00, half [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call half @_Z28sub_group_scan_inclusive_mulDh(half %x)
+; CHECK: [[WGSCAN:%.*]] = fmul half [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call half @_Z19sub_group_broadcastDhj(half [[SCAN]], i32 [[LAST]])
+; CHECK: [[ACCUM:%.*]] = fmul half [[CURR]], [[SCAN_TAIL]]
+; CHECK: store half [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_inclusive_mulDh.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret half [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func i64 @_Z28work_group_scan_inclusive_orm(i64 %x)
+declare spir_func i64 @_Z28work_group_scan_inclusive_orm(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z28work_group_scan_inclusive_orm.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i64 @_Z27sub_group_scan_inclusive_orm(i64 %x)
+; CHECK: [[WGSCAN:%.*]] = or i64 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i64 @_Z19sub_group_broadcastmj(i64 [[SCAN]], i32 [[LAST]])
+; CHECK: [[ACCUM:%.*]] = or i64 [[CURR]], [[SCAN_TAIL]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z28work_group_scan_inclusive_orm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i64 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func i1 @_Z37work_group_scan_inclusive_logical_andb(i1 %x)
+declare spir_func i1 @_Z37work_group_scan_inclusive_logical_andb(i1 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i1, ptr addrspace(3) @_Z37work_group_scan_inclusive_logical_andb.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i1 true, i1 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i1 @_Z36sub_group_scan_inclusive_logical_andb(i1 %x)
+; CHECK: [[WGSCAN:%.*]] = and i1 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i1 @_Z19sub_group_broadcastbj(i1 [[SCAN]], i32 [[LAST]])
+; CHECK: [[ACCUM:%.*]] = and i1 [[CURR]], [[SCAN_TAIL]]
+; CHECK: store i1 [[ACCUM]], ptr addrspace(3) @_Z37work_group_scan_inclusive_logical_andb.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i1 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func i32 @_Z29work_group_scan_exclusive_mini(i32 %x)
+declare spir_func i32 @_Z29work_group_scan_exclusive_mini(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z29work_group_scan_exclusive_mini.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 2147483647, i32 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i32 @_Z28sub_group_scan_exclusive_mini(i32 %x)
+; CHECK: [[WGSCAN:%.*]] = call i32 @llvm.smin.i32(i32 [[CURR]], i32 [[SCAN]])
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i32 @_Z19sub_group_broadcastjj(i32 [[SCAN]], i32 [[LAST]])
+; CHECK: [[TAIL:%.*]] = call i32 @_Z19sub_group_broadcastjj(i32 %x, i32 [[LAST]])
+; CHECK: [[TOTAL:%.*]] = call i32 @llvm.smin.i32(i32 [[SCAN_TAIL]], i32 [[TAIL]])
+; CHECK: [[ACCUM:%.*]] = call i32 @llvm.smin.i32(i32 [[CURR]], i32 [[TOTAL]])
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_exclusive_mini.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i32 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func double @_Z29work_group_scan_exclusive_maxd(double %x)
+declare spir_func double @_Z29work_group_scan_exclusive_maxd(double %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load double, ptr addrspace(3) @_Z29work_group_scan_exclusive_maxd.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], double 0xFFF8000000000000, double [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call double @_Z28sub_group_scan_exclusive_maxd(double %x)
+; CHECK: [[SGID:%.*]] = call i32 @_Z22get_sub_group_local_idv()
+; CHECK: [[ISZERO:%.*]] = icmp eq i32 [[SGID]], 0
+; CHECK: [[FIXED:%.*]] = select i1 [[ISZERO]], double 0xFFF8000000000000, double [[SCAN]]
+; CHECK: [[WGSCAN:%.*]] = call double @llvm.maxnum.f64(double [[CURR]], double [[FIXED]])
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call double @_Z19sub_group_broadcastdj(double [[FIXED]], i32 [[LAST]])
+; CHECK: [[TAIL:%.*]] = call double @_Z19sub_group_broadcastdj(double %x, i32 [[LAST]])
+; CHECK: [[TOTAL:%.*]] = call double @llvm.maxnum.f64(double [[SCAN_TAIL]], double [[TAIL]])
+; CHECK: [[ACCUM:%.*]] = call double @llvm.maxnum.f64(double [[CURR]], double [[TOTAL]])
+; CHECK: store double [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_exclusive_maxd.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = select i1 {{%.*}}, double 0xFFF0000000000000, double [[WGSCAN]]
+; CHECK: ret double [[RESULT]]
+
+; CHECK-LABEL: define spir_func i32 @_Z29work_group_scan_exclusive_mulj(i32 %x)
+declare spir_func i32 @_Z29work_group_scan_exclusive_mulj(i32 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i32, ptr addrspace(3) @_Z29work_group_scan_exclusive_mulj.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i32 1, i32 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i32 @_Z28sub_group_scan_exclusive_mulj(i32 %x)
+; CHECK: [[WGSCAN:%.*]] = mul i32 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i32 @_Z19sub_group_broadcastjj(i32 [[SCAN]], i32 [[LAST]])
+; CHECK: [[TAIL:%.*]] = call i32 @_Z19sub_group_broadcastjj(i32 %x, i32 [[LAST]])
+; CHECK: [[TOTAL:%.*]] = mul i32 [[SCAN_TAIL]], [[TAIL]]
+; CHECK: [[ACCUM:%.*]] = mul i32 [[CURR]], [[TOTAL]]
+; CHECK: store i32 [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_exclusive_mulj.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i32 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func i64 @_Z29work_group_scan_exclusive_xorl(i64 %x)
+declare spir_func i64 @_Z29work_group_scan_exclusive_xorl(i64 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i64, ptr addrspace(3) @_Z29work_group_scan_exclusive_xorl.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i64 0, i64 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i64 @_Z28sub_group_scan_exclusive_xorm(i64 %x)
+; CHECK: [[WGSCAN:%.*]] = xor i64 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i64 @_Z19sub_group_broadcastmj(i64 [[SCAN]], i32 [[LAST]])
+; CHECK: [[TAIL:%.*]] = call i64 @_Z19sub_group_broadcastmj(i64 %x, i32 [[LAST]])
+; CHECK: [[TOTAL:%.*]] = xor i64 [[SCAN_TAIL]], [[TAIL]]
+; CHECK: [[ACCUM:%.*]] = xor i64 [[CURR]], [[TOTAL]]
+; CHECK: store i64 [[ACCUM]], ptr addrspace(3) @_Z29work_group_scan_exclusive_xorl.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i64 [[WGSCAN]]
+
+; CHECK-LABEL: define spir_func i1 @_Z36work_group_scan_exclusive_logical_orb(i1 %x)
+declare spir_func i1 @_Z36work_group_scan_exclusive_logical_orb(i1 %x)
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272) [[SCHEDULE_LINEAR]]
+; CHECK: [[LOAD:%.*]] = load i1, ptr addrspace(3) @_Z36work_group_scan_exclusive_logical_orb.accumulator
+; CHECK: [[ANY:%.*]] = call i32 @_Z13sub_group_anyi(i32 {{%.*}})
+; CHECK: [[FIRST:%.*]] = icmp ne i32 [[ANY]], 0
+; CHECK: [[CURR:%.*]] = select i1 [[FIRST]], i1 false, i1 [[LOAD]]
+; CHECK: [[SCAN:%.*]] = call i1 @_Z35sub_group_scan_exclusive_logical_orb(i1 %x)
+; CHECK: [[WGSCAN:%.*]] = or i1 [[CURR]], [[SCAN]]
+; CHECK: [[SIZE:%.*]] = call i32 @_Z18get_sub_group_sizev()
+; CHECK: [[LAST:%.*]] = sub nuw i32 [[SIZE]], 1
+; CHECK: [[SCAN_TAIL:%.*]] = call i1 @_Z19sub_group_broadcastbj(i1 [[SCAN]], i32 [[LAST]])
+; CHECK: [[TAIL:%.*]] = call i1 @_Z19sub_group_broadcastbj(i1 %x, i32 [[LAST]])
+; CHECK: [[TOTAL:%.*]] = or i1 [[SCAN_TAIL]], [[TAIL]]
+; CHECK: [[ACCUM:%.*]] = or i1 [[CURR]], [[TOTAL]]
+; CHECK: store i1 [[ACCUM]], ptr addrspace(3) @_Z36work_group_scan_exclusive_logical_orb.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i1 [[WGSCAN]]
+
+
+; Broadcasts have no accumulator to initialize, so linear-combine leaves them
+; using plain barriers.
+; CHECK-LABEL: define spir_func float @_Z20work_group_broadcastfm(float %x, i64 %lid)
+declare spir_func float @_Z20work_group_broadcastfm(float %x, i64 %lid)
+; CHECK: [[LID:%.*]] = call i64 @_Z12get_local_idj(i32 0)
+; CHECK: [[CMP:%.*]] = icmp eq i64 [[LID]], %lid
+; CHECK: broadcast:
+; CHECK: store float %x, ptr addrspace(3) @_Z20work_group_broadcastfm.accumulator
+; CHECK: exit:
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load float, ptr addrspace(3) @_Z20work_group_broadcastfm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret float [[RESULT]]
+
+; CHECK-LABEL: define spir_func i64 @_Z20work_group_broadcastlmmm(i64 %x, i64 %lidx, i64 %lidy, i64 %lidz)
+declare spir_func i64 @_Z20work_group_broadcastlmmm(i64 %x, i64 %lidx, i64 %lidy, i64 %lidz)
+; CHECK: call i64 @_Z12get_local_idj(i32 0)
+; CHECK: icmp eq i64 {{%.*}}, %lidx
+; CHECK: call i64 @_Z12get_local_idj(i32 1)
+; CHECK: icmp eq i64 {{%.*}}, %lidy
+; CHECK: call i64 @_Z12get_local_idj(i32 2)
+; CHECK: icmp eq i64 {{%.*}}, %lidz
+; CHECK: broadcast:
+; CHECK: store i64 %x, ptr addrspace(3) @_Z20work_group_broadcastlmmm.accumulator
+; CHECK: exit:
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: [[RESULT:%.*]] = load i64, ptr addrspace(3) @_Z20work_group_broadcastlmmm.accumulator
+; CHECK: call void @__mux_work_group_barrier(i32 0, i32 2, i32 272){{$}}
+; CHECK: ret i64 [[RESULT]]
+
+; CHECK-NOT: "mux-barrier-schedule"="once"
+; CHECK-DAG: attributes [[SCHEDULE_LINEAR]] = { "mux-barrier-schedule"="linear" }
+
+!opencl.ocl.version = !{!0}
+!0 = !{i32 3, i32 0}
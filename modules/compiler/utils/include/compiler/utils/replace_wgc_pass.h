@@ -26,6 +26,22 @@
 namespace compiler {
 namespace utils {
 
+struct ReplaceWGCPassOptions {
+  /// @brief Whether to fold the initialization of the work-group collective
+  /// accumulators into the region that combines the per-sub-group results.
+  ///
+  /// When set, reductions and scans no longer begin with a
+  /// `BarrierSchedule::Once` region that initializes the accumulator. Instead
+  /// the combine region is scheduled `BarrierSchedule::Linear` and the
+  /// sub-group containing work-item {0, 0, 0} combines with the neutral value
+  /// rather than with the accumulator. This saves one barrier (and therefore
+  /// one work-item loop and one round-trip through the barrier struct) per
+  /// collective call, at the cost of requiring the combine region to run in
+  /// local linear ID order. This suits targets such as host where all
+  /// work-items of a work-group run in a single thread.
+  bool LinearCombine = false;
+};
+
 /// @brief Provides a default implementation of the work-group collective
 /// builtins using local memory as an accumulator. Targets with no hardware
 /// support for work-group collectives may use this pass to provide a software
@@ -39,7 +55,13 @@ namespace utils {
 /// target making use of that pass.
 class ReplaceWGCPass final : public llvm::PassInfoMixin<ReplaceWGCPass> {
  public:
+  ReplaceWGCPass(ReplaceWGCPassOptions Options = ReplaceWGCPassOptions())
+      : Options(Options) {}
+
   llvm::PreservedAnalyses run(llvm::Module &, llvm::ModuleAnalysisManager &);
+
+ private:
+  ReplaceWGCPassOptions Options;
 };
 }  // namespace utils
 }  // namespace compiler
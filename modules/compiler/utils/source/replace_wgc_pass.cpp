@@ -283,6 +283,42 @@ Function *getOrCreateGetSubGroupLocalID(Module &M) {
   return GetSubGroupLocalID;
 }
 
+/// @brief Helper function to determine whether the current sub-group contains
+/// the work-item with local ID {0, 0, 0}.
+///
+/// The result is uniform across the sub-group, so it may safely be used to
+/// select a sub-group uniform value which is then stored to local memory.
+///
+/// @param[in] Builder IR builder to build the check with. The builder must be
+/// inserting at the end of its basic block.
+/// @param[in] BI BuiltinInfo used to declare the local ID builtin.
+///
+/// @return An i1 value which is true in the first sub-group.
+Value *createIsFirstSubGroup(IRBuilder<> &Builder,
+                             compiler::utils::BuiltinInfo &BI) {
+  auto *const BB = Builder.GetInsertBlock();
+  auto &M = *BB->getModule();
+  auto *const GetLocalIDFn =
+      BI.getOrDeclareMuxBuiltin(compiler::utils::eMuxBuiltinGetLocalId, M);
+  assert(GetLocalIDFn && "__mux_get_local_id is not in module");
+  auto *const IsThreadZero = compiler::utils::isThreadZero(BB, *GetLocalIDFn);
+
+  auto *const Int32Ty = Builder.getInt32Ty();
+  compiler::utils::NameMangler Mangler(&M.getContext());
+  std::string const MangledName = Mangler.mangleName(
+      "sub_group_any", {Int32Ty}, {compiler::utils::eTypeQualSignedInt});
+  auto *const SubGroupAny = cast<Function>(
+      M.getOrInsertFunction(MangledName,
+                            FunctionType::get(Int32Ty, {Int32Ty}, false))
+          .getCallee());
+  SubGroupAny->setCallingConv(CallingConv::SPIR_FUNC);
+
+  auto *const AnyIsThreadZero = Builder.CreateCall(
+      SubGroupAny, {Builder.CreateZExt(IsThreadZero, Int32Ty)},
+      "wgc_first_sg");
+  return Builder.CreateICmpNE(AnyIsThreadZero, Builder.getInt32(0));
+}
+
 /// @brief Helper function to emit the binary op on the global accumulator
 ///
 /// @param[in] Builder IR builder to build the operation with.
@@ -337,8 +373,25 @@ Value *createBinOp(llvm::IRBuilder<> &Builder, llvm::Value *CurrentVal,
 ///  function also handles work_group_all and work_group_any since they are
 ///  essentially work_group_reduce_and work_group_reduce_or on the int type
 ///  only.
+///
+///  With LinearCombine set, the accumulator initialization is folded into
+///  the combine step, which is then executed in local linear ID order:
+///
+/// local T accumulator;
+/// T work_group_reduce_<op>(T x) {
+///    reduce = sub_group_reduce_<op>(x);
+///
+///    barrier(CLK_LOCAL_MEM_FENCE); // BarrierSchedule = Linear
+///    T current = sub_group_any(local_id == {0, 0, 0}) ? I : accumulator;
+///    accumulator = current + reduce;
+///
+///    barrier(CLK_LOCAL_MEM_FENCE);
+///    T result = accumulator;
+///    return result;
+/// }
 void emitWorkGroupReductionBody(const compiler::utils::GroupCollective &WGC,
-                                compiler::utils::BuiltinInfo &BI) {
+                                compiler::utils::BuiltinInfo &BI,
+                                bool LinearCombine) {
   // Create a global variable to do the reduction on.
   auto &F = *WGC.func;
   auto *const Operand = F.getArg(0);
@@ -368,22 +421,41 @@ void emitWorkGroupReductionBody(const compiler::utils::GroupCollective &WGC,
   auto *const SubReduce = createSubgroupReduction(Builder, Operand, WGC);
   assert(SubReduce && "Invalid subgroup reduce");
 
-  // We need three barriers:
-  // The barrier after the store ensures that the initialization is complete
-  // before the accumulation begins. The barrer after the accumulation ensures
-  // that the result is complete for reloading afterwards. And this, the first
-  // barrier, ensures that if there are two (or more) calls to this function,
-  // multiple uses of the same accumulator cannot get tangled up.
-  compiler::utils::setBarrierSchedule(*createLocalBarrierCall(Builder, BI),
-                                      compiler::utils::BarrierSchedule::Once);
-
-  // Initialize the accumulator.
-  Builder.CreateStore(ReductionNeutralValue, Accumulator);
-  createLocalBarrierCall(Builder, BI);
-
-  // Read-modify-write the accumulator.
-  auto *const CurrentVal =
-      Builder.CreateLoad(ReductionType, Accumulator, "current.val");
+  Value *CurrentVal = nullptr;
+  if (LinearCombine) {
+    // We only need two barriers: the first ensures that if there are two (or
+    // more) calls to this function, multiple uses of the same accumulator
+    // cannot get tangled up, and also orders the combine step so that the
+    // first sub-group is guaranteed to run first and can initialize the
+    // accumulator. The second ensures that the result is complete for
+    // reloading afterwards.
+    compiler::utils::setBarrierSchedule(
+        *createLocalBarrierCall(Builder, BI),
+        compiler::utils::BarrierSchedule::Linear);
+
+    auto *const IsFirst = createIsFirstSubGroup(Builder, BI);
+    auto *const LoadedVal =
+        Builder.CreateLoad(ReductionType, Accumulator, "current.val");
+    CurrentVal = Builder.CreateSelect(IsFirst, ReductionNeutralValue,
+                                      LoadedVal, "current.init");
+  } else {
+    // We need three barriers:
+    // The barrier after the store ensures that the initialization is complete
+    // before the accumulation begins. The barrer after the accumulation ensures
+    // that the result is complete for reloading afterwards. And this, the first
+    // barrier, ensures that if there are two (or more) calls to this function,
+    // multiple uses of the same accumulator cannot get tangled up.
+    compiler::utils::setBarrierSchedule(
+        *createLocalBarrierCall(Builder, BI),
+        compiler::utils::BarrierSchedule::Once);
+
+    // Initialize the accumulator.
+    Builder.CreateStore(ReductionNeutralValue, Accumulator);
+    createLocalBarrierCall(Builder, BI);
+
+    // Read-modify-write the accumulator.
+    CurrentVal = Builder.CreateLoad(ReductionType, Accumulator, "current.val");
+  }
   auto *const NextVal = createBinOp(Builder, CurrentVal, SubReduce,
                                     WGC.recurKind, WGC.isAnyAll());
   Builder.CreateStore(NextVal, Accumulator);
@@ -518,8 +590,15 @@ void emitWorkGroupBroadcastBody(const compiler::utils::GroupCollective &WGC,
 /// result with +/INFINITY. There is a similar situation for FAdd, where the
 /// identity element is defined to be `0.0` but the true neutral value is
 /// `-0.0`.
+///
+/// With LinearCombine set, the first barrier and the accumulator
+/// initialization are removed, and the sub-group containing work-item
+/// {0, 0, 0} reads I in place of the accumulator. The combine region is
+/// already Linear so this is guaranteed to happen before any other sub-group
+/// reads the accumulator.
 void emitWorkGroupScanBody(const compiler::utils::GroupCollective &WGC,
-                           compiler::utils::BuiltinInfo &BI) {
+                           compiler::utils::BuiltinInfo &BI,
+                           bool LinearCombine) {
   // Create a global variable to do the scan on.
   auto &F = *WGC.func;
   auto *const Operand = F.getArg(0);
@@ -546,20 +625,28 @@ void emitWorkGroupScanBody(const compiler::utils::GroupCollective &WGC,
 
   IRBuilder<> Builder{EntryBB};
 
-  // We need two barriers to isolate the accumulator initialization.
-  compiler::utils::setBarrierSchedule(*createLocalBarrierCall(Builder, BI),
-                                      compiler::utils::BarrierSchedule::Once);
+  if (!LinearCombine) {
+    // We need two barriers to isolate the accumulator initialization.
+    compiler::utils::setBarrierSchedule(
+        *createLocalBarrierCall(Builder, BI),
+        compiler::utils::BarrierSchedule::Once);
 
-  // Initialize the accumulator.
-  Builder.CreateStore(ReductionNeutralValue, Accumulator);
+    // Initialize the accumulator.
+    Builder.CreateStore(ReductionNeutralValue, Accumulator);
+  }
 
   // The scans are defined in Linear order, so we must create a Linear barrier.
   compiler::utils::setBarrierSchedule(*createLocalBarrierCall(Builder, BI),
                                       compiler::utils::BarrierSchedule::Linear);
 
   // Read the accumulator.
-  auto *const CurrentVal =
+  Value *CurrentVal =
       Builder.CreateLoad(ReductionType, Accumulator, "current.val");
+  if (LinearCombine) {
+    auto *const IsFirst = createIsFirstSubGroup(Builder, BI);
+    CurrentVal = Builder.CreateSelect(IsFirst, ReductionNeutralValue,
+                                      CurrentVal, "current.init");
+  }
 
   // Perform the subgroup scan operation and add it to the accumulator.
   auto *SubScan = createSubgroupScan(Builder, Operand, WGC.recurKind,
@@ -627,20 +714,24 @@ void emitWorkGroupScanBody(const compiler::utils::GroupCollective &WGC,
 /// @brief Defines the work-group collective functions.
 ///
 /// @param[in] WGC Work-group collective function to be defined.
-void emitWorkGroupCollectiveBody(const compiler::utils::GroupCollective &WGC,
-                                 compiler::utils::BuiltinInfo &BI) {
+/// @param[in] BI BuiltinInfo used to declare mux builtins.
+/// @param[in] Options Options controlling how the collectives are lowered.
+void emitWorkGroupCollectiveBody(
+    const compiler::utils::GroupCollective &WGC,
+    compiler::utils::BuiltinInfo &BI,
+    const compiler::utils::ReplaceWGCPassOptions &Options) {
   switch (WGC.op) {
     case compiler::utils::GroupCollective::Op::All:
     case compiler::utils::GroupCollective::Op::Any:
     case compiler::utils::GroupCollective::Op::Reduction:
-      emitWorkGroupReductionBody(WGC, BI);
+      emitWorkGroupReductionBody(WGC, BI, Options.LinearCombine);
       break;
     case compiler::utils::GroupCollective::Op::Broadcast:
       emitWorkGroupBroadcastBody(WGC, BI);
       break;
     case compiler::utils::GroupCollective::Op::ScanExclusive:
     case compiler::utils::GroupCollective::Op::ScanInclusive:
-      emitWorkGroupScanBody(WGC, BI);
+      emitWorkGroupScanBody(WGC, BI, Options.LinearCombine);
       break;
     default:
       llvm_unreachable("unhandled work-group collective");
@@ -669,7 +760,7 @@ PreservedAnalyses compiler::utils::ReplaceWGCPass::run(
   }
 
   for (auto const WGC : WGCollectives) {
-    emitWorkGroupCollectiveBody(WGC, BI);
+    emitWorkGroupCollectiveBody(WGC, BI, Options);
   }
   return !WGCollectives.empty() ? PreservedAnalyses::none()
                                 : PreservedAnalyses::all();
@@ -122,6 +122,10 @@ struct memory : mux_memory_s {
   void *hostPtr;
   uint64_t mapOffset;
   cargo::dynamic_array<uint8_t> mappedMemory;
+  /// @brief Host pointer aliasing device memory at `mapOffset`, set while
+  /// mapped when the HAL supports host access to device memory, in which case
+  /// `mappedMemory` is unused.
+  void *mappedPtr = nullptr;
 };
 }  // namespace hal
 }  // namespace mux
@@ -32,10 +32,15 @@ memory::memory(uint64_t size, uint32_t properties, ::hal::hal_addr_t targetPtr,
 cargo::expected<void *, mux_result_t> memory::map(::hal::hal_device_t *device,
                                                   uint64_t offset,
                                                   uint64_t size) {
-  (void)device;
   if (hostPtr) {
     return static_cast<unsigned char *>(hostPtr) + offset;
   }
+  // Access device memory in place rather than through a copy when possible.
+  if (void *ptr = device->mem_host_ptr(targetPtr + offset, size)) {
+    mappedPtr = ptr;
+    mapOffset = offset;
+    return ptr;
+  }
   if (cargo::success != mappedMemory.alloc(size)) {
     return cargo::make_unexpected(mux_error_out_of_memory);
   }
@@ -46,6 +51,12 @@ cargo::expected<void *, mux_result_t> memory::map(::hal::hal_device_t *device,
 // muxFlushMappedMemoryToDevice
 mux_result_t memory::flushToDevice(::hal::hal_device_t *device, uint64_t offset,
                                    uint64_t size) {
+  if (mappedPtr) {
+    // The mapping aliases device memory, there is nothing to copy.
+    return device->mem_host_flush(targetPtr + offset, size)
+               ? mux_success
+               : mux_error_failure;
+  }
   uint8_t *src = nullptr;
   if (hostPtr) {
     src = static_cast<uint8_t *>(hostPtr) + offset;
@@ -64,6 +75,11 @@ mux_result_t memory::flushToDevice(::hal::hal_device_t *device, uint64_t offset,
 // muxFlushMappedMemoryFromDevice
 mux_result_t memory::flushFromDevice(::hal::hal_device_t *device,
                                      uint64_t offset, uint64_t size) {
+  if (mappedPtr) {
+    return device->mem_host_invalidate(targetPtr + offset, size)
+               ? mux_success
+               : mux_error_failure;
+  }
   uint8_t *dst = nullptr;
   if (hostPtr) {
     dst = static_cast<uint8_t *>(hostPtr) + offset;
@@ -83,6 +99,7 @@ mux_result_t memory::flushFromDevice(::hal::hal_device_t *device,
 mux_result_t memory::unmap(::hal::hal_device_t *device) {
   (void)device;
   mappedMemory.clear();
+  mappedPtr = nullptr;
   hostPtr = nullptr;
   return mux_success;
 }
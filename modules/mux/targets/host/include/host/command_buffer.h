@@ -40,13 +40,14 @@ namespace host {
 /// This struct later gets cast to `void*` and passed to the lambda that threads
 /// in the threadpool execute to actually run the range.
 struct ndrange_info_s {
-  ndrange_info_s(void *packed_args,
+  ndrange_info_s(void *packed_args, uint64_t packed_args_size,
                  mux::dynamic_array<uint8_t *> &arg_addresses,
                  mux::dynamic_array<mux_descriptor_info_t> &descriptors,
                  std::array<size_t, 3> global_size,
                  std::array<size_t, 3> global_offset,
                  std::array<size_t, 3> local_size, size_t dimensions)
       : packed_args(packed_args),
+        packed_args_size(packed_args_size),
         arg_addresses(std::move(arg_addresses)),
         descriptors(std::move(descriptors)),
         global_size(global_size),
@@ -57,6 +58,9 @@ struct ndrange_info_s {
   /// @brief Packed descriptors.
   void *packed_args;
 
+  /// @brief Size in bytes of the `packed_args` allocation.
+  uint64_t packed_args_size;
+
   /// @brief Addresses of arguments in packed descriptors.
   ///
   /// Recording this information is required when packedArgs is populated in
@@ -307,6 +311,8 @@ struct command_buffer_s final : public mux_command_buffer_s {
 
   mux::small_vector<host::command_info_s, 16> commands;
   mux::small_vector<std::unique_ptr<host::ndrange_info_s>, 4> ndranges;
+  /// @brief ND ranges released by the last reset, reused by later recordings.
+  mux::small_vector<std::unique_ptr<host::ndrange_info_s>, 4> free_ndranges;
   mux::small_vector<host::sync_point_s *, 4> sync_points;
   std::mutex mutex;
   mux::small_vector<mux_semaphore_t, 8> signal_semaphores;
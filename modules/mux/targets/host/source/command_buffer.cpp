@@ -23,6 +23,7 @@
 #include <mux/utils/allocator.h>
 #include <mux/utils/helpers.h>
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <new>
@@ -30,33 +31,47 @@
 #include "mux/mux.h"
 
 namespace {
-// Returns the number of bytes which need allocated to hold all the packed args,
-// and stores the offset into the allocation for each argument
+// Number of released ND ranges a command buffer keeps for reuse, any more are
+// freed when it is reset.
+constexpr size_t max_free_ndranges = 16;
+
+// Returns the number of bytes an argument occupies in the packed args.
+size_t getPackedArgSize(const mux_descriptor_info_t &descriptor) {
+  switch (descriptor.type) {
+    case mux_descriptor_info_type_sampler:
+    case mux_descriptor_info_type_buffer:
+    case mux_descriptor_info_type_null_buffer:
+    case mux_descriptor_info_type_image:
+      return sizeof(void *);
+    case mux_descriptor_info_type_plain_old_data:
+      return descriptor.plain_old_data_descriptor.length;
+    case mux_descriptor_info_type_shared_local_buffer:
+      return sizeof(size_t);
+    default:
+      return 0;
+  }
+}
+
+// Returns the number of bytes which need allocated to hold all the packed args.
 size_t calcPackedArgsAllocSize(
+    cargo::array_view<mux_descriptor_info_t> descriptors) {
+  size_t size = 0;
+  for (const auto &descriptor : descriptors) {
+    size += getPackedArgSize(descriptor);
+  }
+  return size;
+}
+
+// Stores the address of each argument within the packed args allocation.
+void setArgAddresses(
+    uint8_t *packed_args_alloc,
     const mux::dynamic_array<mux_descriptor_info_t> &descriptors,
-    mux::dynamic_array<size_t> &offsets) {
+    mux::dynamic_array<uint8_t *> &arg_addresses) {
   size_t offset = 0;
   for (unsigned i = 0; i < descriptors.size(); i++) {
-    const auto descriptor = descriptors[i];
-    size_t size = 0;
-    switch (descriptor.type) {
-      case mux_descriptor_info_type_sampler:
-      case mux_descriptor_info_type_buffer:
-      case mux_descriptor_info_type_null_buffer:
-      case mux_descriptor_info_type_image:
-        size = sizeof(void *);
-        break;
-      case mux_descriptor_info_type_plain_old_data: {
-        size = descriptor.plain_old_data_descriptor.length;
-      } break;
-      case mux_descriptor_info_type_shared_local_buffer: {
-        size = sizeof(size_t);
-      } break;
-    }
-    offsets[i] = offset;
-    offset += size;
+    arg_addresses[i] = packed_args_alloc + offset;
+    offset += getPackedArgSize(descriptors[i]);
   }
-  return offset;
 }
 
 // Iterates through the argument descriptors and for each argument sets the
@@ -163,6 +178,7 @@ command_buffer_s::command_buffer_s(mux_device_t device,
                                    mux_fence_t fence)
     : commands(allocator_info),
       ndranges(allocator_info),
+      free_ndranges(allocator_info),
       sync_points(allocator_info),
       signal_semaphores(allocator_info),
       fence(static_cast<host::fence_s *>(fence)),
@@ -193,15 +209,8 @@ ndrange_info_s::clone(mux_allocator_info_t allocator_info) const {
             std::begin(clone_descriptors));
 
   // Setup a new packed args allocation for this cloned command
-  mux::dynamic_array<size_t> clone_offsets{allocator};
-  if (clone_offsets.alloc(descriptors.size())) {
-    return cargo::make_unexpected(mux_error_out_of_memory);
-  }
-
-  // Allocate data for packed arguments and record offset into it for each
-  // argument
   const uint64_t packed_args_alloc_size =
-      calcPackedArgsAllocSize(clone_descriptors, clone_offsets);
+      calcPackedArgsAllocSize(clone_descriptors);
   uint8_t *const packed_args_allocation =
       static_cast<uint8_t *>(allocator.alloc(packed_args_alloc_size, 1));
   if (nullptr == packed_args_allocation) {
@@ -211,11 +220,11 @@ ndrange_info_s::clone(mux_allocator_info_t allocator_info) const {
   // Store address of each argument
   mux::dynamic_array<uint8_t *> clone_arg_addresses{allocator};
   if (clone_arg_addresses.alloc(descriptors.size())) {
+    allocator.free(packed_args_allocation);
     return cargo::make_unexpected(mux_error_out_of_memory);
   }
-  for (size_t i = 0; i < descriptors.size(); i++) {
-    clone_arg_addresses[i] = packed_args_allocation + clone_offsets[i];
-  }
+  setArgAddresses(packed_args_allocation, clone_descriptors,
+                  clone_arg_addresses);
 
   // Populate packed args struct by copying original. We do this rather
   // than recreating from the descriptors, as for POD descriptors the data
@@ -225,8 +234,8 @@ ndrange_info_s::clone(mux_allocator_info_t allocator_info) const {
   std::memcpy(packed_args_allocation, packed_args, packed_args_alloc_size);
 
   return std::make_unique<host::ndrange_info_s>(
-      packed_args_allocation, clone_arg_addresses, clone_descriptors,
-      global_size, global_offset, local_size, dimensions);
+      packed_args_allocation, packed_args_alloc_size, clone_arg_addresses,
+      clone_descriptors, global_size, global_offset, local_size, dimensions);
 }
 }  // namespace host
 
@@ -918,48 +927,84 @@ mux_result_t hostCommandNDRange(mux_command_buffer_t command_buffer,
     local_size[i] = options.local_size[i];
   }
 
-  mux::dynamic_array<mux_descriptor_info_t> descriptors{allocator};
-  if (descriptors.alloc(options.descriptors_length)) {
-    return mux_error_out_of_memory;
+  cargo::array_view<mux_descriptor_info_t> option_descriptors(
+      options.descriptors, options.descriptors_length);
+
+  // Reuse the storage of an ND range recorded before the command buffer was
+  // last reset if one with the same number of arguments is available, to
+  // avoid allocating per launch when the same kernel is enqueued repeatedly.
+  // Prefer one whose packed args are already big enough, so that recording the
+  // same kernel again doesn't need to reallocate them.
+  const uint64_t required_packed_args_size =
+      calcPackedArgsAllocSize(option_descriptors);
+  std::unique_ptr<host::ndrange_info_s> *reusable = nullptr;
+  for (auto &candidate : host->free_ndranges) {
+    if (candidate->descriptors.size() != option_descriptors.size()) {
+      continue;
+    }
+    reusable = &candidate;
+    if (candidate->packed_args_size >= required_packed_args_size) {
+      break;
+    }
+  }
+  std::unique_ptr<host::ndrange_info_s> ndrange;
+  if (reusable) {
+    std::swap(*reusable, host->free_ndranges.back());
+    ndrange = std::move(host->free_ndranges.back());
+    host->free_ndranges.pop_back();
+  }
+
+  if (!ndrange) {
+    mux::dynamic_array<mux_descriptor_info_t> descriptors{allocator};
+    mux::dynamic_array<uint8_t *> arg_addresses{allocator};
+    if (descriptors.alloc(option_descriptors.size()) ||
+        arg_addresses.alloc(option_descriptors.size())) {
+      return mux_error_out_of_memory;
+    }
+    ndrange = std::make_unique<host::ndrange_info_s>(
+        nullptr, 0, arg_addresses, descriptors, global_size, global_offset,
+        local_size, options.dimensions);
+  } else {
+    ndrange->global_size = global_size;
+    ndrange->global_offset = global_offset;
+    ndrange->local_size = local_size;
+    ndrange->dimensions = options.dimensions;
   }
 
   // Make a copy of the descriptor so that their lifetime extends beyond this
   // function call.
-  cargo::array_view<mux_descriptor_info_t> option_descriptors(
-      options.descriptors, options.descriptors_length);
   std::copy(std::begin(option_descriptors), std::end(option_descriptors),
-            std::begin(descriptors));
-
-  mux::dynamic_array<size_t> offsets{allocator};
-  if (offsets.alloc(descriptors.size())) {
-    return mux_error_out_of_memory;
+            std::begin(ndrange->descriptors));
+
+  // Allocate memory for the packed kernel arguments, unless the reused
+  // allocation is already big enough.
+  if (nullptr == ndrange->packed_args ||
+      ndrange->packed_args_size < required_packed_args_size) {
+    if (nullptr != ndrange->packed_args) {
+      allocator.free(ndrange->packed_args);
+    }
+    ndrange->packed_args = allocator.alloc(required_packed_args_size, 1);
+    ndrange->packed_args_size = required_packed_args_size;
+    if (nullptr == ndrange->packed_args) {
+      return mux_error_out_of_memory;
+    }
   }
-
-  // Allocate memory for the packed kernel arguments and record the offset
-  // into the allocation for each argument
-  const uint64_t packed_args_alloc_size =
-      calcPackedArgsAllocSize(descriptors, offsets);
   uint8_t *const packed_args_allocation =
-      static_cast<uint8_t *>(allocator.alloc(packed_args_alloc_size, 1));
-  if (nullptr == packed_args_allocation) {
-    return mux_error_out_of_memory;
-  }
+      static_cast<uint8_t *>(ndrange->packed_args);
 
   // Store the address in packed args allocation of each argument
-  mux::dynamic_array<uint8_t *> arg_addresses{allocator};
-  if (arg_addresses.alloc(descriptors.size())) {
-    return mux_error_out_of_memory;
-  }
-  for (size_t i = 0; i < descriptors.size(); i++) {
-    arg_addresses[i] = packed_args_allocation + offsets[i];
-  }
+  setArgAddresses(packed_args_allocation, ndrange->descriptors,
+                  ndrange->arg_addresses);
 
   // Store necessary argument information in the packed args allocation
-  populatePackedArgs(packed_args_allocation, descriptors);
+  populatePackedArgs(packed_args_allocation, ndrange->descriptors);
 
-  if (host->ndranges.emplace_back(std::make_unique<host::ndrange_info_s>(
-          packed_args_allocation, arg_addresses, descriptors, global_size,
-          global_offset, local_size, options.dimensions))) {
+  if (host->ndranges.emplace_back(std::move(ndrange))) {
+    // The ND range doesn't own its packed args, they are only freed through
+    // the command buffer's lists.
+    if (ndrange) {
+      allocator.free(ndrange->packed_args);
+    }
     return mux_error_out_of_memory;
   }
 
@@ -1181,6 +1226,31 @@ mux_result_t hostResetCommandBuffer(mux_command_buffer_t command_buffer) {
 
   host->commands.clear();
 
+  // Keep some of the ND range storage around to be reused when the command
+  // buffer is recorded again, up to a limit so that recording many distinct
+  // commands between resets doesn't grow the free list without bound.
+  mux::allocator allocator(host->allocator_info);
+  const size_t free_slots =
+      max_free_ndranges -
+      std::min(max_free_ndranges, host->free_ndranges.size());
+  const size_t keep = std::min(host->ndranges.size(), free_slots);
+  if (host->free_ndranges.reserve(host->free_ndranges.size() + keep)) {
+    for (auto &ndrange : host->ndranges) {
+      allocator.free(ndrange->packed_args);
+    }
+  } else {
+    for (size_t i = 0; i < host->ndranges.size(); i++) {
+      auto &ndrange = host->ndranges[i];
+      if (i < keep) {
+        // Can't fail, the capacity has been reserved.
+        (void)host->free_ndranges.push_back(std::move(ndrange));
+      } else {
+        allocator.free(ndrange->packed_args);
+      }
+    }
+  }
+  host->ndranges.clear();
+
   return mux_success;
 }
 
@@ -1259,6 +1329,9 @@ void hostDestroyCommandBuffer(mux_device_t device,
   for (auto &range : host->ndranges) {
     allocator.free(range->packed_args);
   }
+  for (auto &range : host->free_ndranges) {
+    allocator.free(range->packed_args);
+  }
 
   for (auto sync_point : host->sync_points) {
     allocator.destroy(sync_point);
@@ -45,8 +45,11 @@ struct command_buffer_s;
 
 enum command_type_e : uint32_t {
   command_type_read_buffer,
+  command_type_read_buffer_rect,
   command_type_write_buffer,
+  command_type_write_buffer_rect,
   command_type_copy_buffer,
+  command_type_copy_buffer_rect,
   command_type_fill_buffer,
   command_type_ndrange,
   command_type_user_callback,
@@ -83,6 +86,38 @@ struct command_copy_buffer_s {
   void operator()(riscv::device_s *device, bool &error);
 };
 
+/// @brief Strided read of a buffer region, the source of `rect` is the buffer.
+struct command_read_buffer_rect_s {
+  riscv::buffer_s *buffer;
+  uint64_t offset;
+  void *host_pointer;
+  hal::hal_mem_rect_t rect;
+
+  void operator()(riscv::device_s *device, bool &error);
+};
+
+/// @brief Strided write of a buffer region, the destination of `rect` is the
+/// buffer.
+struct command_write_buffer_rect_s {
+  riscv::buffer_s *buffer;
+  uint64_t offset;
+  const void *host_pointer;
+  hal::hal_mem_rect_t rect;
+
+  void operator()(riscv::device_s *device, bool &error);
+};
+
+/// @brief Strided copy of a region between buffers.
+struct command_copy_buffer_rect_s {
+  riscv::buffer_s *src_buffer;
+  uint64_t src_offset;
+  riscv::buffer_s *dst_buffer;
+  uint64_t dst_offset;
+  hal::hal_mem_rect_t rect;
+
+  void operator()(riscv::device_s *device, bool &error);
+};
+
 struct command_fill_buffer_s {
   riscv::buffer_s *buffer;
   uint64_t offset;
@@ -151,6 +186,18 @@ struct command_s {
   command_s(command_copy_buffer_s copy_buffer)
       : type(command_type_copy_buffer), copy_buffer(copy_buffer) {}
 
+  command_s(command_read_buffer_rect_s read_buffer_rect)
+      : type(command_type_read_buffer_rect),
+        read_buffer_rect(read_buffer_rect) {}
+
+  command_s(command_write_buffer_rect_s write_buffer_rect)
+      : type(command_type_write_buffer_rect),
+        write_buffer_rect(write_buffer_rect) {}
+
+  command_s(command_copy_buffer_rect_s copy_buffer_rect)
+      : type(command_type_copy_buffer_rect),
+        copy_buffer_rect(copy_buffer_rect) {}
+
   command_s(command_fill_buffer_s fill_buffer)
       : type(command_type_fill_buffer), fill_buffer(fill_buffer) {}
 
@@ -175,6 +222,9 @@ struct command_s {
     struct riscv::command_read_buffer_s read_buffer;
     struct riscv::command_write_buffer_s write_buffer;
     struct riscv::command_copy_buffer_s copy_buffer;
+    struct riscv::command_read_buffer_rect_s read_buffer_rect;
+    struct riscv::command_write_buffer_rect_s write_buffer_rect;
+    struct riscv::command_copy_buffer_rect_s copy_buffer_rect;
     struct riscv::command_fill_buffer_s fill_buffer;
     struct riscv::command_ndrange_s ndrange;
     struct riscv::command_user_callback_s user_callback;
@@ -20,23 +20,195 @@
 #ifndef RISCV_DEVICE_H_INCLUDED
 #define RISCV_DEVICE_H_INCLUDED
 
+#include <atomic>
+#include <string>
+
+#include "cargo/mutex.h"
+#include "cargo/string_view.h"
 #include "mux/hal/device.h"
+#include "mux/utils/small_vector.h"
 #include "riscv/queue.h"
 #include "riscv/riscv.h"
 
 namespace riscv {
 /// @addtogroup riscv
 /// @{
+struct executable_s;
+
 struct device_s final : mux::hal::device {
   /// @brief Main constructor.
   ///
   /// @param info The device info associated with this device.
   /// @param allocator The mux allocate to use for allocations.
   explicit device_s(mux_device_info_t info, mux::allocator allocator)
-      : mux::hal::device(info), queue(allocator, this) {}
+      : mux::hal::device(info),
+        queue(allocator, this),
+        hal_instances(allocator),
+        resident_executables(allocator),
+        instance_programs(allocator) {}
+
+  /// @brief Find a kernel entry point in the program of an executable, loading
+  /// the program onto the device if it isn't already resident.
+  ///
+  /// Programs stay resident across dispatches so that each kernel launch
+  /// doesn't load the ELF file again. If a program fails to load, least
+  /// recently used resident programs roughly the size of the new program are
+  /// evicted to free device memory before trying once more.
+  ///
+  /// @param[in] executable Executable containing the kernel.
+  /// @param[in] name Null terminated name of the kernel variant to find.
+  /// @param[out] out_program Program containing the kernel.
+  /// @param[out] out_kernel Entry point of the kernel.
+  ///
+  /// @return Returns `mux_success`, `mux_error_failure` if the program could
+  /// not be loaded, `mux_error_missing_kernel` if the kernel could not be
+  /// found or `mux_error_out_of_memory`.
+  mux_result_t findKernel(riscv::executable_s *executable,
+                          cargo::string_view name,
+                          hal::hal_program_t *out_program,
+                          hal::hal_kernel_t *out_kernel);
+
+  /// @brief Unload the program of an executable if it is resident.
+  ///
+  /// @param[in] executable Executable being destroyed.
+  void unloadProgram(riscv::executable_s *executable);
+
+  /// @brief Execute a kernel, splitting its work-groups across `hal_device`
+  /// and the devices in `hal_instances`.
+  ///
+  /// Each HAL device executes a contiguous range of the work-groups on its own
+  /// host thread. The buffers used by the kernel are copied to the instances
+  /// beforehand, and the bytes the instances change are copied back to
+  /// `hal_device` afterwards. The kernel only executes on `hal_device` when
+  /// the executable contains atomics, or calls printf, since the bytes several
+  /// instances write could not be merged.
+  ///
+  /// Only the memory bound to buffer arguments is copied, and only those
+  /// arguments are redirected to the copies. Pointers reaching the kernel any
+  /// other way, e.g. USM pointers stored in buffers or accessed indirectly,
+  /// would refer to `hal_device`, so the kernel also only executes on
+  /// `hal_device` while any `device_local_allocations` are live.
+  ///
+  /// @param[in] executable Executable containing the kernel.
+  /// @param[in] name Null terminated name of the kernel variant to execute.
+  /// @param[in] program Program containing the kernel on `hal_device`.
+  /// @param[in] kernel Entry point of the kernel on `hal_device`.
+  /// @param[in] nd_range N-D range to execute.
+  /// @param[in] args Arguments of the kernel on `hal_device`.
+  /// @param[in] descriptors Descriptors the arguments were created from.
+  /// @param[in] num_args Number of arguments and descriptors.
+  /// @param[in] work_dim Number of dimensions of the N-D range.
+  ///
+  /// @return Returns false if the kernel could not be executed.
+  bool kernelExecSplit(riscv::executable_s *executable,
+                       cargo::string_view name, hal::hal_program_t program,
+                       hal::hal_kernel_t kernel,
+                       const hal::hal_ndrange_t &nd_range,
+                       const hal::hal_arg_t *args,
+                       const mux_descriptor_info_t *descriptors,
+                       uint32_t num_args, uint32_t work_dim);
+
+  /// @brief Record the fence of an asynchronous HAL operation submitted by
+  /// the queue.
+  ///
+  /// @param[in] fence Fence returned by the HAL operation.
+  /// @param[in] kernel_name Name of the kernel launched by the operation, if
+  /// any, which the profiler counters are attributed to once it completes.
+  ///
+  /// @return Returns false if the operation could not be submitted.
+  bool submitted(hal::hal_fence_t fence, const std::string &kernel_name = {}) {
+    if (fence == hal::hal_invalid_fence) {
+      return false;
+    }
+    submitted_fence = fence;
+    if (!kernel_name.empty()) {
+      submitted_kernel_name = kernel_name;
+    }
+    return true;
+  }
+
+  /// @brief Returns true if a kernel launch has been submitted which has not
+  /// been waited on yet.
+  bool kernelSubmitted() const { return !submitted_kernel_name.empty(); }
+
+  /// @brief Wait for all the asynchronous HAL operations submitted by the
+  /// queue to complete, and update the profiler counters.
+  ///
+  /// @return Returns false if any of the operations failed.
+  bool waitForSubmitted() {
+    if (submitted_fence == hal::hal_invalid_fence) {
+      return true;
+    }
+    const bool success = hal_device->fence_wait(submitted_fence);
+    submitted_fence = hal::hal_invalid_fence;
+    profiler.update_counters(*hal_device, std::move(submitted_kernel_name));
+    submitted_kernel_name.clear();
+    return success;
+  }
 
   /// @brief Riscv's single queue for command execution.
   riscv::queue_s queue;
+
+  /// @brief True if the HAL device supports asynchronous operations, in which
+  /// case transfers and kernel launches are submitted without waiting for the
+  /// previous command to complete.
+  bool hal_async = false;
+
+  /// @brief Additional instances of the HAL device, which execute a share of
+  /// the work-groups of each N-D range, see `CA_RISCV_NUM_HAL_DEVICES`.
+  mux::small_vector<hal::hal_device_t *, 4> hal_instances;
+
+  /// @brief Number of live allocations with `mux_memory_property_device_local`,
+  /// which USM device allocations are made from.
+  std::atomic<size_t> device_local_allocations{0};
+
+ private:
+  /// @brief Program of an executable loaded on a device in `hal_instances`.
+  struct instance_program_s {
+    /// @brief Executable the program was loaded from.
+    riscv::executable_s *executable;
+    /// @brief Index of the device in `hal_instances`.
+    size_t instance;
+    /// @brief Program on the device.
+    hal::hal_program_t program;
+  };
+
+  /// @brief Free the resident program of an executable.
+  void evictProgram(riscv::executable_s *executable)
+      CARGO_TS_REQUIRES(program_mutex);
+
+  /// @brief Find a kernel entry point on a device in `hal_instances`, loading
+  /// the program of the executable onto it if it isn't already.
+  ///
+  /// @param[in] instance Index of the device in `hal_instances`.
+  /// @param[in] executable Executable containing the kernel.
+  /// @param[in] name Null terminated name of the kernel variant to find.
+  /// @param[out] out_program Program containing the kernel.
+  /// @param[out] out_kernel Entry point of the kernel.
+  ///
+  /// @return Returns `mux_success`, `mux_error_failure` if the program could
+  /// not be loaded, `mux_error_missing_kernel` if the kernel could not be
+  /// found or `mux_error_out_of_memory`.
+  mux_result_t findInstanceKernel(size_t instance,
+                                  riscv::executable_s *executable,
+                                  cargo::string_view name,
+                                  hal::hal_program_t *out_program,
+                                  hal::hal_kernel_t *out_kernel);
+
+  /// @brief Fence of the last asynchronous HAL operation submitted, only
+  /// accessed from the queue thread.
+  hal::hal_fence_t submitted_fence = hal::hal_invalid_fence;
+  /// @brief Name of the kernel launched by the operations submitted since the
+  /// last wait, empty if there is none. Only accessed from the queue thread.
+  std::string submitted_kernel_name;
+  /// @brief Mutex protecting the resident programs.
+  cargo::mutex program_mutex;
+  /// @brief Executables with a resident program, least recently used first.
+  mux::small_vector<riscv::executable_s *, 8> resident_executables
+      CARGO_TS_GUARDED_BY(program_mutex);
+  /// @brief Programs loaded on the devices in `hal_instances`.
+  mux::small_vector<instance_program_s, 8> instance_programs
+      CARGO_TS_GUARDED_BY(program_mutex);
 };
 /// @}
 };      // namespace riscv
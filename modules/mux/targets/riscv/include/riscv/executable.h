@@ -23,6 +23,10 @@
 #include <metadata/handler/vectorize_info_metadata.h>
 #include <metadata/metadata.h>
 
+#include <utility>
+
+#include "cargo/string_view.h"
+#include "hal_types.h"
 #include "mux/hal/executable.h"
 #include "mux/utils/small_vector.h"
 
@@ -46,6 +50,19 @@ struct executable_s final : mux::hal::executable {
 
   /// @brief per kernel information such as names and vectorization factor
   cargo::small_vector<handler::VectorizeInfoMetadata, 4> kernel_info;
+
+  /// @brief true if the code contains atomic instructions, which includes
+  /// kernels calling printf since it claims space in its buffer atomically.
+  bool has_atomics = false;
+
+  /// @brief Program loaded onto the device from `object_code`, or
+  /// `hal::hal_invalid_program` if it isn't resident.
+  ///
+  /// Only accessed by `riscv::device_s` while holding its program mutex.
+  hal::hal_program_t program = hal::hal_invalid_program;
+  /// @brief Kernel entry points already found in `program`, by variant name.
+  cargo::small_vector<std::pair<cargo::string_view, hal::hal_kernel_t>, 4>
+      kernel_symbols;
 };
 
 /// @}
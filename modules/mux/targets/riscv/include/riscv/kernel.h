@@ -55,6 +55,10 @@ struct kernel_s final : mux::hal::kernel<mux::hal::kernel_variant_s> {
   mux_result_t getKernelVariantForWGSize(
       size_t local_size_x, size_t local_size_y, size_t local_size_z,
       mux::hal::kernel_variant_s *out_variant_data);
+
+  /// @brief Executable the kernel was created from, which owns the program
+  /// loaded onto the device.
+  riscv::executable_s *executable = nullptr;
 };
 
 }  // namespace riscv
@@ -22,6 +22,11 @@
 
 namespace riscv {
 void command_read_buffer_s::operator()(riscv::device_s *device, bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_read_async(
+        host_pointer, buffer->targetPtr + offset, size));
+    return;
+  }
   if (!device->hal_device->mem_read(host_pointer, buffer->targetPtr + offset,
                                     size)) {
     error = true;
@@ -30,6 +35,11 @@ void command_read_buffer_s::operator()(riscv::device_s *device, bool &error) {
 }
 
 void command_write_buffer_s::operator()(riscv::device_s *device, bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_write_async(
+        buffer->targetPtr + offset, host_pointer, size));
+    return;
+  }
   if (!device->hal_device->mem_write(buffer->targetPtr + offset, host_pointer,
                                      size)) {
     error = true;
@@ -38,6 +48,12 @@ void command_write_buffer_s::operator()(riscv::device_s *device, bool &error) {
 }
 
 void command_copy_buffer_s::operator()(riscv::device_s *device, bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_copy_async(
+        dst_buffer->targetPtr + dst_offset, src_buffer->targetPtr + src_offset,
+        size));
+    return;
+  }
   if (!device->hal_device->mem_copy(dst_buffer->targetPtr + dst_offset,
                                     src_buffer->targetPtr + src_offset, size)) {
     error = true;
@@ -45,7 +61,56 @@ void command_copy_buffer_s::operator()(riscv::device_s *device, bool &error) {
   device->profiler.update_counters(*device->hal_device);
 }
 
+void command_read_buffer_rect_s::operator()(riscv::device_s *device,
+                                            bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_read_rect_async(
+        host_pointer, buffer->targetPtr + offset, &rect));
+    return;
+  }
+  if (!device->hal_device->mem_read_rect(host_pointer,
+                                         buffer->targetPtr + offset, &rect)) {
+    error = true;
+  }
+  device->profiler.update_counters(*device->hal_device);
+}
+
+void command_write_buffer_rect_s::operator()(riscv::device_s *device,
+                                             bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_write_rect_async(
+        buffer->targetPtr + offset, host_pointer, &rect));
+    return;
+  }
+  if (!device->hal_device->mem_write_rect(buffer->targetPtr + offset,
+                                          host_pointer, &rect)) {
+    error = true;
+  }
+  device->profiler.update_counters(*device->hal_device);
+}
+
+void command_copy_buffer_rect_s::operator()(riscv::device_s *device,
+                                            bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_copy_rect_async(
+        dst_buffer->targetPtr + dst_offset, src_buffer->targetPtr + src_offset,
+        &rect));
+    return;
+  }
+  if (!device->hal_device->mem_copy_rect(dst_buffer->targetPtr + dst_offset,
+                                         src_buffer->targetPtr + src_offset,
+                                         &rect)) {
+    error = true;
+  }
+  device->profiler.update_counters(*device->hal_device);
+}
+
 void command_fill_buffer_s::operator()(riscv::device_s *device, bool &error) {
+  if (device->hal_async) {
+    error = !device->submitted(device->hal_device->mem_fill_async(
+        buffer->targetPtr + offset, pattern, pattern_size, size));
+    return;
+  }
   if (!device->hal_device->mem_fill(buffer->targetPtr + offset, pattern,
                                     pattern_size, size)) {
     error = true;
@@ -62,12 +127,6 @@ void command_ndrange_s::operator()(riscv::queue_s *queue, bool &error) {
     error = true;
     return;
   }
-  hal::hal_program_t program = hal_device->program_load(
-      kernel->object_code.data(), kernel->object_code.size());
-  if (program == hal::hal_invalid_program) {
-    error = true;
-    return;
-  }
   // decide on which kernel to execute
   mux::hal::kernel_variant_s variant;
   if (mux_success !=
@@ -76,10 +135,13 @@ void command_ndrange_s::operator()(riscv::queue_s *queue, bool &error) {
     error = true;
     return;
   }
-  // find the kernel entry point
-  auto hal_kernel =
-      hal_device->program_find_kernel(program, variant.variant_name.data());
-  if (hal_kernel == hal::hal_invalid_kernel) {
+  // find the kernel entry point, the program stays resident on the device
+  // between dispatches
+  hal::hal_program_t program = hal::hal_invalid_program;
+  hal::hal_kernel_t hal_kernel = hal::hal_invalid_kernel;
+  if (mux_success != device->findKernel(kernel->executable,
+                                        variant.variant_name, &program,
+                                        &hal_kernel)) {
     error = true;
     return;
   }
@@ -88,11 +150,36 @@ void command_ndrange_s::operator()(riscv::queue_s *queue, bool &error) {
       {global_offset[0], global_offset[1], global_offset[2]},
       {global_size[0], global_size[1], global_size[2]},
       {local_size[0], local_size[1], local_size[2]}};
-  // execute the kernel
+  if (!device->hal_instances.empty()) {
+    // the work-groups are split across several HAL devices, which copies
+    // buffers between them so the previous commands must have completed
+    if (!device->waitForSubmitted() ||
+        !device->kernelExecSplit(kernel->executable, variant.variant_name,
+                                 program, hal_kernel, hal_ndrange, kernel_args,
+                                 descriptors, num_kernel_args, dimensions)) {
+      error = true;
+    }
+    device->profiler.update_counters(*device->hal_device, kernel->name.data());
+    return;
+  }
+  // execute the kernel, the arguments live in the command buffer so they stay
+  // valid until an asynchronous launch completes
+  if (device->hal_async) {
+    // counters are read when the HAL is waited on, so only one kernel launch
+    // is in flight at a time to attribute them to the right kernel
+    if (device->kernelSubmitted() && !device->waitForSubmitted()) {
+      error = true;
+      return;
+    }
+    error = !device->submitted(
+        hal_device->kernel_exec_async(program, hal_kernel, &hal_ndrange,
+                                      kernel_args, num_kernel_args, dimensions),
+        kernel->name);
+    return;
+  }
   bool success =
       hal_device->kernel_exec(program, hal_kernel, &hal_ndrange, kernel_args,
                               num_kernel_args, dimensions);
-  hal_device->program_free(program);
   if (!success) {
     error = true;
   }
@@ -166,27 +253,63 @@ mux_result_t command_buffer_s::execute(riscv::queue_s *queue) {
   riscv::device_s *riscv_device = static_cast<riscv::device_s *>(device);
   mux_query_duration_result_t duration_query = nullptr;
 
+  // With an asynchronous HAL, transfers and kernel launches are submitted
+  // back to back so the queue thread doesn't block on each one, only waiting
+  // when the host needs to observe their results. Whether a transfer overlaps
+  // a running kernel on the device is up to the HAL, RefSi runs them one at a
+  // time.
+  auto wait_for_hal = [riscv_device]() {
+    return !riscv_device->hal_async || riscv_device->waitForSubmitted();
+  };
+
   for (riscv::command_s &command : commands) {
     uint64_t start = 0;
     if (duration_query) {
+      // Duration queries time each command, so earlier commands must not
+      // still be running.
+      if (!wait_for_hal()) {
+        return mux_error_fence_failure;
+      }
       start = utils::timestampNanoSeconds();
     }
 
     bool error = false;
 
+    switch (command.type) {
+      case riscv::command_type_user_callback:
+      case riscv::command_type_begin_query:
+      case riscv::command_type_end_query:
+      case riscv::command_type_reset_query_pool:
+        if (!wait_for_hal()) {
+          return mux_error_fence_failure;
+        }
+        break;
+      default:
+        break;
+    }
+
     switch (command.type) {
       case riscv::command_type_read_buffer:
         command.read_buffer(riscv_device, error);
         break;
+      case riscv::command_type_read_buffer_rect:
+        command.read_buffer_rect(riscv_device, error);
+        break;
       case riscv::command_type_write_buffer:
         command.write_buffer(riscv_device, error);
         break;
+      case riscv::command_type_write_buffer_rect:
+        command.write_buffer_rect(riscv_device, error);
+        break;
       case riscv::command_type_fill_buffer:
         command.fill_buffer(riscv_device, error);
         break;
       case riscv::command_type_copy_buffer:
         command.copy_buffer(riscv_device, error);
         break;
+      case riscv::command_type_copy_buffer_rect:
+        command.copy_buffer_rect(riscv_device, error);
+        break;
       case riscv::command_type_ndrange:
         command.ndrange(queue, error);
         break;
@@ -207,6 +330,7 @@ mux_result_t command_buffer_s::execute(riscv::queue_s *queue) {
     }
 
     if (duration_query) {
+      error |= !wait_for_hal();
       auto end = utils::timestampNanoSeconds();
       duration_query->start = start;
       duration_query->end = end;
@@ -214,10 +338,14 @@ mux_result_t command_buffer_s::execute(riscv::queue_s *queue) {
 
     // TODO: Act on error - see CA-3979
     if (error) {
+      wait_for_hal();
       return mux_error_fence_failure;
     }
   }
 
+  if (!wait_for_hal()) {
+    return mux_error_fence_failure;
+  }
   return mux_success;
 }
 }  // namespace riscv
@@ -291,46 +419,23 @@ mux_result_t riscvCommandReadBufferRegions(mux_command_buffer_t command_buffer,
     return mux_error_out_of_memory;
   }
 
-  /* Assign more space */
-  {
-    size_t cmd_count = 0;
-
-    for (uint64_t i = 0; i < regions_length; ++i) {
-      const auto &r = regions[i];
-      cmd_count += (r.region.z * r.region.y);
-    }
-
-    cmd_count += riscv->commands.size();
-
-    if (riscv->commands.reserve(cmd_count)) {
-      return mux_error_out_of_memory;
-    }
-  }
-
-  /* Convert the 3D shapes into 1D slices */
+  // Each region is a single strided transfer in the HAL
   for (uint64_t i = 0; i < regions_length; i++) {
     const auto &r = regions[i];
-
-    for (uint64_t z = 0; z < r.region.z; ++z) {
-      const size_t dst_slice_offset = (r.dst_origin.z + z) * r.dst_desc.y;
-      const size_t src_slice_offset = (r.src_origin.z + z) * r.src_desc.y;
-
-      for (uint64_t y = 0; y < r.region.y; ++y) {
-        const size_t dst_row_offset = (r.dst_origin.y + y) * r.dst_desc.x;
-        const size_t src_row_offset = (r.src_origin.y + y) * r.src_desc.x;
-        const size_t size = r.region.x;
-
-        const uint64_t dst_offset =
-            dst_slice_offset + dst_row_offset + r.dst_origin.x;
-        const uint64_t src_offset =
-            src_slice_offset + src_row_offset + r.src_origin.x;
-
-        if (riscv->commands.emplace_back(riscv::command_read_buffer_s{
-                static_cast<riscv::buffer_s *>(buffer), src_offset,
-                data + dst_offset, size})) {
-          return mux_error_out_of_memory;
-        }
-      }
+    const uint64_t dst_offset = (r.dst_origin.z * r.dst_desc.y) +
+                                (r.dst_origin.y * r.dst_desc.x) +
+                                r.dst_origin.x;
+    const uint64_t src_offset = (r.src_origin.z * r.src_desc.y) +
+                                (r.src_origin.y * r.src_desc.x) +
+                                r.src_origin.x;
+    const hal::hal_mem_rect_t rect = {{r.region.x, r.region.y, r.region.z},
+                                      {r.dst_desc.x, r.dst_desc.y},
+                                      {r.src_desc.x, r.src_desc.y}};
+
+    if (riscv->commands.emplace_back(riscv::command_read_buffer_rect_s{
+            static_cast<riscv::buffer_s *>(buffer), src_offset,
+            data + dst_offset, rect})) {
+      return mux_error_out_of_memory;
     }
   }
 
@@ -397,46 +502,24 @@ mux_result_t riscvCommandWriteBufferRegions(mux_command_buffer_t command_buffer,
     return mux_error_out_of_memory;
   }
 
-  /* Assign more space */
-  {
-    size_t cmd_count = 0;
-
-    for (uint64_t i = 0; i < regions_length; ++i) {
-      const auto &r = regions[i];
-      cmd_count += (r.region.z * r.region.y);
-    }
-
-    cmd_count += riscv->commands.size();
-
-    if (riscv->commands.reserve(cmd_count)) {
-      return mux_error_out_of_memory;
-    }
-  }
-
-  /* Convert the 3D shapes into 1D slices */
+  // Each region is a single strided transfer in the HAL, the buffer is
+  // described by the source of the region
   for (uint64_t i = 0; i < regions_length; i++) {
     const auto &r = regions[i];
-
-    for (uint64_t z = 0; z < r.region.z; ++z) {
-      const size_t dst_slice_offset = (r.dst_origin.z + z) * r.dst_desc.y;
-      const size_t src_slice_offset = (r.src_origin.z + z) * r.src_desc.y;
-
-      for (uint64_t y = 0; y < r.region.y; ++y) {
-        const size_t dst_row_offset = (r.dst_origin.y + y) * r.dst_desc.x;
-        const size_t src_row_offset = (r.src_origin.y + y) * r.src_desc.x;
-        const size_t size = r.region.x;
-
-        const uint64_t dst_offset =
-            dst_slice_offset + dst_row_offset + r.dst_origin.x;
-        const uint64_t src_offset =
-            src_slice_offset + src_row_offset + r.src_origin.x;
-
-        if (riscv->commands.emplace_back(riscv::command_write_buffer_s{
-                static_cast<riscv::buffer_s *>(buffer), src_offset,
-                data + dst_offset, size})) {
-          return mux_error_out_of_memory;
-        }
-      }
+    const uint64_t dst_offset = (r.dst_origin.z * r.dst_desc.y) +
+                                (r.dst_origin.y * r.dst_desc.x) +
+                                r.dst_origin.x;
+    const uint64_t src_offset = (r.src_origin.z * r.src_desc.y) +
+                                (r.src_origin.y * r.src_desc.x) +
+                                r.src_origin.x;
+    const hal::hal_mem_rect_t rect = {{r.region.x, r.region.y, r.region.z},
+                                      {r.src_desc.x, r.src_desc.y},
+                                      {r.dst_desc.x, r.dst_desc.y}};
+
+    if (riscv->commands.emplace_back(riscv::command_write_buffer_rect_s{
+            static_cast<riscv::buffer_s *>(buffer), src_offset,
+            data + dst_offset, rect})) {
+      return mux_error_out_of_memory;
     }
   }
 
@@ -499,47 +582,23 @@ mux_result_t riscvCommandCopyBufferRegions(mux_command_buffer_t command_buffer,
     return mux_error_out_of_memory;
   }
 
-  // Assign more space
-  {
-    size_t cmd_count = 0;
-
-    for (uint64_t i = 0; i < regions_length; ++i) {
-      const auto &r = regions[i];
-      cmd_count += (r.region.z * r.region.y);
-    }
-
-    cmd_count += riscv->commands.size();
-
-    if (riscv->commands.reserve(cmd_count)) {
-      return mux_error_out_of_memory;
-    }
-  }
-
-  // Convert the 3D shapes into 1D slices
+  // Each region is a single strided transfer in the HAL
   for (uint64_t i = 0; i < regions_length; i++) {
     const auto &r = regions[i];
-
-    for (uint64_t z = 0; z < r.region.z; ++z) {
-      const size_t dst_slice_offset = (r.dst_origin.z + z) * r.dst_desc.y;
-      const size_t src_slice_offset = (r.src_origin.z + z) * r.src_desc.y;
-
-      for (uint64_t y = 0; y < r.region.y; ++y) {
-        const size_t dst_row_offset = (r.dst_origin.y + y) * r.dst_desc.x;
-        const size_t src_row_offset = (r.src_origin.y + y) * r.src_desc.x;
-        const size_t size = r.region.x;
-
-        const uint64_t dst_offset =
-            dst_slice_offset + dst_row_offset + r.dst_origin.x;
-        const uint64_t src_offset =
-            src_slice_offset + src_row_offset + r.src_origin.x;
-
-        if (riscv->commands.emplace_back(riscv::command_copy_buffer_s{
-                static_cast<riscv::buffer_s *>(src_buffer), src_offset,
-                static_cast<riscv::buffer_s *>(dst_buffer), dst_offset,
-                size})) {
-          return mux_error_out_of_memory;
-        }
-      }
+    const uint64_t dst_offset = (r.dst_origin.z * r.dst_desc.y) +
+                                (r.dst_origin.y * r.dst_desc.x) +
+                                r.dst_origin.x;
+    const uint64_t src_offset = (r.src_origin.z * r.src_desc.y) +
+                                (r.src_origin.y * r.src_desc.x) +
+                                r.src_origin.x;
+    const hal::hal_mem_rect_t rect = {{r.region.x, r.region.y, r.region.z},
+                                      {r.dst_desc.x, r.dst_desc.y},
+                                      {r.src_desc.x, r.src_desc.y}};
+
+    if (riscv->commands.emplace_back(riscv::command_copy_buffer_rect_s{
+            static_cast<riscv::buffer_s *>(src_buffer), src_offset,
+            static_cast<riscv::buffer_s *>(dst_buffer), dst_offset, rect})) {
+      return mux_error_out_of_memory;
     }
   }
 
@@ -919,6 +978,8 @@ mux_result_t riscvUpdateDescriptors(mux_command_buffer_t command_buffer,
         arg.address = hal::hal_nullptr;
       } break;
     }
+    // The buffer descriptors are needed to split the kernel across HAL devices.
+    nd_range_command.descriptors[index] = arg_descriptor;
   }
 
   return mux_success;
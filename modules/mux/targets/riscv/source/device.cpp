@@ -16,11 +16,348 @@
 
 #include "riscv/device.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "riscv/buffer.h"
 #include "riscv/device_info.h"
+#include "riscv/executable.h"
 #include "riscv/hal.h"
 
+namespace {
+/// @brief Range of device memory, as the address of its first byte and the
+/// address one past its last byte.
+using addr_range_t = std::pair<hal::hal_addr_t, hal::hal_addr_t>;
+
+/// @brief Alignment kept when memory is copied to another HAL device, which is
+/// the minimum alignment of memory allocations.
+constexpr hal::hal_size_t copy_alignment = 128;
+}  // namespace
+
+namespace riscv {
+mux_result_t device_s::findKernel(riscv::executable_s *executable,
+                                  cargo::string_view name,
+                                  hal::hal_program_t *out_program,
+                                  hal::hal_kernel_t *out_kernel) {
+  cargo::lock_guard<cargo::mutex> lock(program_mutex);
+  if (executable->program == hal::hal_invalid_program) {
+    hal::hal_program_t program = hal_device->program_load(
+        executable->object_code.data(), executable->object_code.size());
+    // The device may be out of memory, make room by evicting the least
+    // recently used programs and retry once. The HAL doesn't say why a load
+    // failed, so only evict about as much as the program needs rather than
+    // emptying the device for a program which can never load.
+    if (program == hal::hal_invalid_program && !resident_executables.empty()) {
+      // Queued kernels may still be using the programs being evicted.
+      if (!waitForSubmitted()) {
+        return mux_error_failure;
+      }
+      size_t evicted_size = 0;
+      while (evicted_size < executable->object_code.size() &&
+             !resident_executables.empty()) {
+        evicted_size += resident_executables.front()->object_code.size();
+        evictProgram(resident_executables.front());
+      }
+      program = hal_device->program_load(executable->object_code.data(),
+                                         executable->object_code.size());
+    }
+    if (program == hal::hal_invalid_program) {
+      return mux_error_failure;
+    }
+    if (resident_executables.push_back(executable)) {
+      hal_device->program_free(program);
+      return mux_error_out_of_memory;
+    }
+    executable->program = program;
+  } else if (resident_executables.back() != executable) {
+    // Keep the most recently used program at the back of the list.
+    auto resident = std::find(resident_executables.begin(),
+                              resident_executables.end(), executable);
+    assert(resident != resident_executables.end());
+    std::rotate(resident, resident + 1, resident_executables.end());
+  }
+  *out_program = executable->program;
+
+  for (const auto &symbol : executable->kernel_symbols) {
+    if (symbol.first == name) {
+      *out_kernel = symbol.second;
+      return mux_success;
+    }
+  }
+  const hal::hal_kernel_t kernel =
+      hal_device->program_find_kernel(executable->program, name.data());
+  if (kernel == hal::hal_invalid_kernel) {
+    return mux_error_missing_kernel;
+  }
+  if (executable->kernel_symbols.push_back(std::make_pair(name, kernel))) {
+    return mux_error_out_of_memory;
+  }
+  *out_kernel = kernel;
+  return mux_success;
+}
+
+void device_s::unloadProgram(riscv::executable_s *executable) {
+  cargo::lock_guard<cargo::mutex> lock(program_mutex);
+  if (executable->program != hal::hal_invalid_program) {
+    evictProgram(executable);
+  }
+  for (auto loaded = instance_programs.begin();
+       loaded != instance_programs.end();) {
+    if (loaded->executable == executable) {
+      hal_instances[loaded->instance]->program_free(loaded->program);
+      loaded = instance_programs.erase(loaded);
+    } else {
+      ++loaded;
+    }
+  }
+}
+
+mux_result_t device_s::findInstanceKernel(size_t instance,
+                                          riscv::executable_s *executable,
+                                          cargo::string_view name,
+                                          hal::hal_program_t *out_program,
+                                          hal::hal_kernel_t *out_kernel) {
+  cargo::lock_guard<cargo::mutex> lock(program_mutex);
+  hal::hal_device_t *instance_device = hal_instances[instance];
+  auto loaded = std::find_if(
+      instance_programs.begin(), instance_programs.end(),
+      [&](const instance_program_s &loaded) {
+        return loaded.executable == executable && loaded.instance == instance;
+      });
+  hal::hal_program_t program = hal::hal_invalid_program;
+  if (loaded != instance_programs.end()) {
+    program = loaded->program;
+  } else {
+    program = instance_device->program_load(executable->object_code.data(),
+                                            executable->object_code.size());
+    if (program == hal::hal_invalid_program) {
+      // The device may be out of memory, make room by unloading the other
+      // programs loaded on it before trying again. Nothing executes on the
+      // instances between kernels so none of them are in use.
+      for (auto other = instance_programs.begin();
+           other != instance_programs.end();) {
+        if (other->instance == instance) {
+          instance_device->program_free(other->program);
+          other = instance_programs.erase(other);
+        } else {
+          ++other;
+        }
+      }
+      program = instance_device->program_load(executable->object_code.data(),
+                                              executable->object_code.size());
+      if (program == hal::hal_invalid_program) {
+        return mux_error_failure;
+      }
+    }
+    if (instance_programs.push_back({executable, instance, program})) {
+      instance_device->program_free(program);
+      return mux_error_out_of_memory;
+    }
+  }
+  const hal::hal_kernel_t kernel =
+      instance_device->program_find_kernel(program, name.data());
+  if (kernel == hal::hal_invalid_kernel) {
+    return mux_error_missing_kernel;
+  }
+  *out_program = program;
+  *out_kernel = kernel;
+  return mux_success;
+}
+
+bool device_s::kernelExecSplit(riscv::executable_s *executable,
+                               cargo::string_view name,
+                               hal::hal_program_t program,
+                               hal::hal_kernel_t kernel,
+                               const hal::hal_ndrange_t &nd_range,
+                               const hal::hal_arg_t *args,
+                               const mux_descriptor_info_t *descriptors,
+                               uint32_t num_args, uint32_t work_dim) {
+  hal::hal_size_t num_groups = 1;
+  for (size_t i = 0; i < 3; i++) {
+    num_groups *= nd_range.global[i] / nd_range.local[i];
+  }
+  const size_t num_devices =
+      std::min<hal::hal_size_t>(hal_instances.size() + 1, num_groups);
+  // Merging the bytes each instance changed loses updates when several
+  // instances write the same bytes, which atomics do and which includes the
+  // printf buffer, so such kernels are not split. Neither are kernels which
+  // may reach USM allocations through pointers other than their buffer
+  // arguments, as those pointers can't be redirected to the copies, which
+  // can't be ruled out while any device-local memory is allocated.
+  if ((num_devices < 2) || executable->has_atomics ||
+      (device_local_allocations.load() > 0)) {
+    return hal_device->kernel_exec(program, kernel, &nd_range, args, num_args,
+                                   work_dim);
+  }
+  // HAL device `i` executes the work-groups from `groupBegin(i)` up to
+  // `groupBegin(i + 1)`, with `hal_device` being device 0.
+  auto groupBegin = [&](size_t i) { return (num_groups * i) / num_devices; };
+
+  // Find the device memory the kernel can access through its buffers, merging
+  // buffers which overlap so that each byte is only copied once.
+  std::vector<addr_range_t> ranges;
+  for (uint32_t i = 0; i < num_args; i++) {
+    if (descriptors[i].type == mux_descriptor_info_type_buffer) {
+      auto *buffer = static_cast<riscv::buffer_s *>(
+          descriptors[i].buffer_descriptor.buffer);
+      ranges.emplace_back(buffer->targetPtr,
+                          buffer->targetPtr + buffer->memory_requirements.size);
+    }
+  }
+  std::sort(ranges.begin(), ranges.end());
+  size_t num_ranges = 0;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    addr_range_t *last = num_ranges > 0 ? &ranges[num_ranges - 1] : nullptr;
+    if (last && (ranges[i].first <= last->second)) {
+      last->second = std::max(last->second, ranges[i].second);
+    } else {
+      ranges[num_ranges++] = ranges[i];
+    }
+  }
+  ranges.resize(num_ranges);
+
+  // The original contents of the memory are copied to the instances, then
+  // compared with the memory once the kernel has run to find the bytes each
+  // instance changed.
+  std::vector<std::vector<uint8_t>> original(ranges.size());
+  for (size_t i = 0; i < ranges.size(); i++) {
+    original[i].resize(ranges[i].second - ranges[i].first);
+    if (!hal_device->mem_read(original[i].data(), ranges[i].first,
+                              original[i].size())) {
+      return false;
+    }
+  }
+
+  struct replica_s {
+    hal::hal_program_t program = hal::hal_invalid_program;
+    hal::hal_kernel_t kernel = hal::hal_invalid_kernel;
+    // Allocations holding the copies of the memory ranges.
+    std::vector<hal::hal_addr_t> allocations;
+    // Address of the copy of each memory range.
+    std::vector<hal::hal_addr_t> copies;
+    // Kernel arguments, pointing to the copies.
+    std::vector<hal::hal_arg_t> args;
+    bool success = false;
+  };
+  std::vector<replica_s> replicas(num_devices - 1);
+  bool success = true;
+  for (size_t i = 0; success && (i < replicas.size()); i++) {
+    replica_s &replica = replicas[i];
+    hal::hal_device_t *instance_device = hal_instances[i];
+    if (mux_success != findInstanceKernel(i, executable, name,
+                                          &replica.program, &replica.kernel)) {
+      success = false;
+      break;
+    }
+    for (size_t j = 0; j < ranges.size(); j++) {
+      // Keep the offset of the memory from an allocation boundary so that the
+      // copy is as aligned as the original.
+      const hal::hal_size_t offset = ranges[j].first % copy_alignment;
+      const hal::hal_addr_t allocation = instance_device->mem_alloc(
+          offset + original[j].size(), copy_alignment);
+      if (allocation == hal::hal_nullptr) {
+        success = false;
+        break;
+      }
+      replica.allocations.push_back(allocation);
+      replica.copies.push_back(allocation + offset);
+      if (!instance_device->mem_write(allocation + offset, original[j].data(),
+                                      original[j].size())) {
+        success = false;
+        break;
+      }
+    }
+    if (!success) {
+      break;
+    }
+    replica.args.assign(args, args + num_args);
+    for (hal::hal_arg_t &arg : replica.args) {
+      if ((arg.kind != hal::hal_arg_address) ||
+          (arg.space != hal::hal_space_global) ||
+          (arg.address == hal::hal_nullptr)) {
+        continue;
+      }
+      // Find the last range starting at or before the argument, which is the
+      // one containing it.
+      const addr_range_t key{arg.address,
+                             std::numeric_limits<hal::hal_addr_t>::max()};
+      auto range = std::upper_bound(ranges.begin(), ranges.end(), key);
+      assert(range != ranges.begin());
+      --range;
+      arg.address = replica.copies[range - ranges.begin()] +
+                    (arg.address - range->first);
+    }
+  }
+
+  if (success) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < replicas.size(); i++) {
+      threads.emplace_back([&, i] {
+        replica_s &replica = replicas[i];
+        replica.success = hal_instances[i]->kernel_exec_groups(
+            replica.program, replica.kernel, &nd_range, replica.args.data(),
+            num_args, work_dim, groupBegin(i + 1), groupBegin(i + 2));
+      });
+    }
+    success = hal_device->kernel_exec_groups(program, kernel, &nd_range, args,
+                                             num_args, work_dim, 0,
+                                             groupBegin(1));
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    for (const replica_s &replica : replicas) {
+      success = success && replica.success;
+    }
+  }
+
+  // Apply the changes made by each instance to the memory of `hal_device`.
+  // Work-groups don't write to the same bytes, so the order doesn't matter.
+  std::vector<uint8_t> merged;
+  std::vector<uint8_t> changed;
+  for (size_t i = 0; success && (i < ranges.size()); i++) {
+    const uint8_t *before = original[i].data();
+    const size_t size = original[i].size();
+    merged.resize(size);
+    changed.resize(size);
+    success = hal_device->mem_read(merged.data(), ranges[i].first, size);
+    for (size_t j = 0; success && (j < replicas.size()); j++) {
+      if (!hal_instances[j]->mem_read(changed.data(), replicas[j].copies[i],
+                                      size)) {
+        success = false;
+        break;
+      }
+      for (size_t k = 0; k < size; k++) {
+        merged[k] = (changed[k] != before[k]) ? changed[k] : merged[k];
+      }
+    }
+    success = success && hal_device->mem_write(ranges[i].first, merged.data(),
+                                               size);
+  }
+
+  for (size_t i = 0; i < replicas.size(); i++) {
+    for (hal::hal_addr_t allocation : replicas[i].allocations) {
+      hal_instances[i]->mem_free(allocation);
+    }
+  }
+  return success;
+}
+
+void device_s::evictProgram(riscv::executable_s *executable) {
+  auto resident = std::find(resident_executables.begin(),
+                            resident_executables.end(), executable);
+  assert(resident != resident_executables.end());
+  resident_executables.erase(resident);
+  hal_device->program_free(executable->program);
+  executable->program = hal::hal_invalid_program;
+  executable->kernel_symbols.clear();
+}
+}  // namespace riscv
+
 mux_result_t riscvCreateDevices(uint64_t devices_length,
                                 mux_device_info_t *device_infos,
                                 mux_allocator_info_t allocator_info,
@@ -57,6 +394,24 @@ mux_result_t riscvCreateDevices(uint64_t devices_length,
     }
     rv_device->hal = hal;
     rv_device->hal_device = hal_device;
+    rv_device->hal_async = hal_device->get_info()->supports_async;
+    // Create the additional HAL devices kernels are split across, which needs
+    // the HAL to be able to execute part of an N-D range.
+    const char *num_hal_devices_env = std::getenv("CA_RISCV_NUM_HAL_DEVICES");
+    if (num_hal_devices_env && hal_device->get_info()->supports_group_range) {
+      const int num_hal_devices = std::atoi(num_hal_devices_env);
+      for (int j = 1; j < num_hal_devices; j++) {
+        hal::hal_device_t *instance =
+            hal->device_create(info->hal_device_index);
+        if (!instance) {
+          break;
+        }
+        if (rv_device->hal_instances.push_back(instance)) {
+          hal->device_delete(instance);
+          return mux_error_out_of_memory;
+        }
+      }
+    }
     rv_device->profiler.setup_counters(*hal_device);
     const char *csv_path = std::getenv("CA_PROFILE_CSV_PATH");
     if (!csv_path) {
@@ -73,6 +428,12 @@ void riscvDestroyDevice(mux_device_t device,
                         mux_allocator_info_t allocator_info) {
   riscv::device_s *riscvDevice = static_cast<riscv::device_s *>(device);
   riscvDevice->profiler.write_summary();
+  if (riscvDevice->hal) {
+    for (hal::hal_device_t *instance : riscvDevice->hal_instances) {
+      riscvDevice->hal->device_delete(instance);
+    }
+    riscvDevice->hal_instances.clear();
+  }
   if (riscvDevice->hal && riscvDevice->hal_device) {
     riscvDevice->hal->device_delete(riscvDevice->hal_device);
     riscvDevice->hal_device = nullptr;
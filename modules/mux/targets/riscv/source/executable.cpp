@@ -92,6 +92,35 @@ mux_result_t readBinaryMetadata(
   }
   return mux_success;
 }
+
+// Returns true if the executable sections of the ELF file contain any
+// instruction from the RISC-V 'A' extension, i.e. AMOs as well as LR and SC.
+bool hasAtomicInstructions(cargo::array_view<uint8_t> elf_view) {
+  if (!loader::ElfFile::isValidElf(elf_view)) {
+    return false;
+  }
+  loader::ElfFile elf{elf_view};
+  for (auto &section : elf.sections()) {
+    if (!(section.flags() & loader::ElfFields::SectionFlags::EXECINSTR) ||
+        (section.type() == loader::ElfFields::SectionType::NOBITS)) {
+      continue;
+    }
+    const cargo::array_view<uint8_t> code = section.data();
+    for (size_t i = 0; (i + 4) <= code.size();) {
+      const uint32_t low = code[i] | (code[i + 1] << 8);
+      if ((low & 0x3) != 0x3) {
+        i += 2;  // compressed instruction
+      } else if ((low & 0x1f) == 0x1f) {
+        i += ((low & 0x3f) == 0x1f) ? 6 : 8;  // 48-bit or longer instruction
+      } else if ((low & 0x7f) == 0x2f) {
+        return true;
+      } else {
+        i += 4;
+      }
+    }
+  }
+  return false;
+}
 }  // namespace
 
 namespace riscv {
@@ -114,12 +143,14 @@ cargo::expected<riscv::executable_s *, mux_result_t> executable_s::create(
     allocator.destroy(executable.value());
     return cargo::make_unexpected(error);
   }
+  executable.value()->has_atomics =
+      hasAtomicInstructions(executable.value()->object_code);
   return executable.value();
 }
 
 void executable_s::destroy(device_s *device, executable_s *executable,
                            mux::allocator allocator) {
-  (void)device;
+  device->unloadProgram(executable);
   allocator.destroy(executable);
 }
 }  // namespace riscv
@@ -77,6 +77,7 @@ cargo::expected<riscv::kernel_s *, mux_result_t> kernel_s::create(
     return cargo::make_unexpected(mux_error_out_of_memory);
   }
 
+  kernel.value()->executable = executable;
   kernel.value()->local_memory_size = 0;
   // These preferred local sizes are fairly arbitrary, at the moment the key
   // point is that they are greater than 1 to ensure that the vectorizer,
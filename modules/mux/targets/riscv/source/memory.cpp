@@ -49,9 +49,9 @@ mux_result_t riscvAllocateMemory(mux_device_t device, size_t size,
                                  uint32_t alignment,
                                  mux_allocator_info_t allocator_info,
                                  mux_memory_t *out_memory) {
+  auto *riscv_device = static_cast<riscv::device_s *>(device);
   // TODO(CA-4163): Cast to mux::hal::device and pass in directly.
-  hal::hal_device_t *hal_device =
-      static_cast<riscv::device_s *>(device)->hal_device;
+  hal::hal_device_t *hal_device = riscv_device->hal_device;
   assert(hal_device);
   auto memory = riscv::memory_s::create<riscv::memory_s>(
       hal_device, size, heap, memory_properties, allocation_type, alignment,
@@ -59,6 +59,9 @@ mux_result_t riscvAllocateMemory(mux_device_t device, size_t size,
   if (!memory) {
     return memory.error();
   }
+  if (memory_properties & mux_memory_property_device_local) {
+    riscv_device->device_local_allocations++;
+  }
   *out_memory = memory.value();
   return mux_success;
 }
@@ -81,10 +84,13 @@ mux_result_t riscvCreateMemoryFromHost(mux_device_t device, size_t size,
 
 void riscvFreeMemory(mux_device_t device, mux_memory_t memory,
                      mux_allocator_info_t allocator_info) {
+  auto *riscv_device = static_cast<riscv::device_s *>(device);
   // TODO(CA-4163): Cast to mux::hal::device and pass in directly.
-  hal::hal_device_t *hal_device =
-      static_cast<riscv::device_s *>(device)->hal_device;
+  hal::hal_device_t *hal_device = riscv_device->hal_device;
   assert(hal_device);
+  if (memory->properties & mux_memory_property_device_local) {
+    riscv_device->device_local_allocations--;
+  }
   riscv::memory_s::destroy(hal_device, static_cast<riscv::memory_s *>(memory),
                            allocator_info);
 }
@@ -24,6 +24,7 @@
 #include <CL/cl.h>
 #include <cargo/array_view.h>
 #include <cargo/expected.h>
+#include <cargo/optional.h>
 #include <cargo/ring_buffer.h>
 #include <cargo/small_vector.h>
 #include <cl/base.h>
@@ -39,6 +40,7 @@
 #include <mutex>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 /// @addtogroup cl
@@ -83,6 +85,11 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   ///
   /// @note This member function is not thread-safe, callers **must** hold a
   /// lock on `_cl_command_queue->mutex` when calling it.
+  ///
+  /// Other command queues with pending dispatches that the dispatched command
+  /// buffers wait on are added to `flush_dependencies` rather than flushed
+  /// here, `cl::command_queue_lock` flushes them once the mutex is released.
+  ///
   /// @return Returns an OpenCL error code.
   /// @retval `CL_SUCCESS` if there are no failures.
   /// @retval `CL_OUT_OF_RESOURCES` if destroying a resource fails.
@@ -114,9 +121,12 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// Implements a cleanup algorithm which checks for command buffer dispatch
   /// completion, when a completed dispatch is found; the command buffer is
   /// destroyed; the dispatches signal semaphore is removed from pending
-  /// dispatches; if the signal semaphore is not being waited upon by a running
-  /// command buffer dispatch, it is destroyed; otherwise it is added to
-  /// `_cl_command_queue::completed_signal_semaphores` for later cleanup.
+  /// dispatches; and the queue's reference to the signal semaphore is
+  /// released, it is destroyed once no running dispatch waits upon it.
+  ///
+  /// Dispatches on an in-order command queue complete in order so cleanup
+  /// stops at the first incomplete dispatch, on an out-of-order command queue
+  /// all running dispatches are checked.
   ///
   /// @return OpenCL error code.
   cl_int cleanupCompletedCommandBuffers();
@@ -140,11 +150,38 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   ///
   /// @param event_wait_list List of events to wait on.
   /// @param event Return event the dispatch sets status of.
+  /// @param wait_for_all Wait for all previously enqueued commands, as markers
+  /// and barriers with an empty @p event_wait_list do. Only has an effect on
+  /// out-of-order command queues, in-order command queues always do so.
   ///
-  /// @return Returns the expected command buffer or `CL_OUT_OF_RESOURCES`.
+  /// @return Returns the expected command buffer, `CL_OUT_OF_RESOURCES`, or
+  /// `CL_INVALID_OPERATION` if the command queue is capturing commands into a
+  /// command-buffer.
   CARGO_NODISCARD cargo::expected<mux_command_buffer_t, cl_int>
   getCommandBuffer(cargo::array_view<const cl_event> event_wait_list,
-                   cl_event event);
+                   cl_event event, bool wait_for_all = false);
+
+  /// @brief Make all later commands wait for a barrier command buffer.
+  ///
+  /// @note This member function is not thread-safe, callers **must** hold a
+  /// lock on `_cl_command_queue->mutex` when calling it.
+  ///
+  /// Only has an effect on out-of-order command queues, in-order command queues
+  /// already execute commands in submission order.
+  ///
+  /// @param command_buffer Pending command buffer returned by
+  /// `getCommandBuffer()` for the barrier.
+  ///
+  /// @return Returns `CL_SUCCESS` or `CL_OUT_OF_RESOURCES`.
+  CARGO_NODISCARD cl_int setBarrier(mux_command_buffer_t command_buffer);
+
+  /// @brief Check if the command queue executes commands out-of-order.
+  ///
+  /// @return Returns `true` if `CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE` was
+  /// set when the command queue was created, `false` otherwise.
+  bool isOutOfOrder() const {
+    return 0 != (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+  }
 
   /// @brief Register a command buffer dispatch completion callback.
   ///
@@ -204,6 +241,22 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// @brief Device the command queue targets.
   cl_device_id device;
 
+  /// @brief Mutex guarding the command queue's dispatch state.
+  ///
+  /// Enqueues which wait on events signalled by another command queue also
+  /// look up that queue's pending dispatches, and flushes may leave
+  /// `flush_dependencies` to be flushed, so both **must** lock it through
+  /// `cl::command_queue_lock` which locks every command queue involved in
+  /// address order. A thread holding the mutex **must not** lock any other
+  /// command queue's mutex.
+  std::mutex mutex;
+  /// @brief Other command queues to flush once `mutex` is released.
+  ///
+  /// Dispatches flushed from this command queue wait on their pending
+  /// dispatches, they would never start unless those are flushed too. Each
+  /// holds an internal reference until it has been flushed.
+  cargo::small_vector<cl_command_queue, 4> flush_dependencies;
+
   /// @brief Properties enabled when the command queue was created.
   cl_command_queue_properties properties;
 
@@ -220,6 +273,22 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// @brief Mux query pool for storing performance counter results.
   mux_query_pool_t counter_queries;
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  /// @brief Command-buffer enqueued commands are being captured into, or
+  /// `nullptr` when the command queue is not capturing.
+  ///
+  /// Access **must** be guarded by the command queue's mutex. The
+  /// command-buffer is not retained, it retains the command queue, instead it
+  /// resets this member when destroyed.
+  cl_command_buffer_khr capture_command_buffer = nullptr;
+  /// @brief Sync-point of the last captured command, used to preserve
+  /// in-order execution of captured commands.
+  cargo::optional<cl_sync_point_khr> capture_sync_point;
+  /// @brief Mutable-command handles of captured kernel commands in capture
+  /// order.
+  cargo::small_vector<cl_mutable_command_khr, 8> capture_mutable_handles;
+#endif
+
  private:
   /// @brief Get the current command buffer, or create one if none exists.
   ///
@@ -254,7 +323,7 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   ///    dispatched), get an unused (new or reseted and cached) command buffer.
   ///
   /// When commands can't be batched into a single comand group, semaphores are
-  /// used to maintain submission order since the command queue is in-order.
+  /// used to maintain submission order if the command queue is in-order.
   /// Dispatches will have wait semaphores in the following cases:
   ///
   /// 1.  There are no wait events and there is a running command buffer.
@@ -264,15 +333,23 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// 4.  There are wait events, no pending dispatches, and there is a running
   ///     command buffer.
   ///
+  /// Out-of-order command queues only add wait semaphores for the dispatches
+  /// signalling events in `event_wait_list`, including running dispatches, and
+  /// for the last barrier. Commands without dependencies get an unused command
+  /// buffer so they can execute concurrently with other dispatches.
+  ///
   /// A user event completion callback is registered with all user events, it
   /// submits pending dispatches to the queue when the user event is in a
   /// success state, and removes them when in a failure state.
   ///
   /// @param event_wait_list List of events to wait for.
+  /// @param wait_for_all Wait for all pending and running dispatches on an
+  /// out-of-order command queue.
   ///
   /// @return Returns the expected command buffer or `CL_OUT_OF_RESOURCES`.
   CARGO_NODISCARD cargo::expected<mux_command_buffer_t, cl_int>
-  getCommandBufferPending(cargo::array_view<const cl_event> event_wait_list);
+  getCommandBufferPending(cargo::array_view<const cl_event> event_wait_list,
+                          bool wait_for_all);
 
   /// @brief Dispatch the given command buffers.
   ///
@@ -357,7 +434,7 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// @brief Create or get a cached semaphore.
   ///
   /// @note This member function is not thread-safe, callers **must** hold a
-  /// lock on `context->getCommandQueueMutex()` when calling it.
+  /// lock on `_cl_command_queue->mutex` when calling it.
   ///
   /// @return Returns the expected semaphore or `CL_OUT_OF_RESOURCES`.
   CARGO_NODISCARD cargo::expected<mux_shared_semaphore, cl_int>
@@ -366,12 +443,25 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// @brief Drop ref count on  mux semaphore and delete if zero
   ///
   /// @note This member function is not thread-safe, callers **must** hold a
-  /// lock on `context->getCommandQueueMutex()` when calling it.
+  /// lock on `_cl_command_queue->mutex` when calling it.
   ///
   /// @param semaphore a mux semaphore.
   /// @return Returns `CL_SUCCESS` or `CL_OUT_OF_RESOURCES`.
   cl_int releaseSemaphore(mux_shared_semaphore semaphore);
 
+  /// @brief Register the user event completion callback with a user event.
+  ///
+  /// @note This member function is not thread-safe, callers **must** hold a
+  /// lock on `_cl_command_queue->mutex` when calling it.
+  ///
+  /// The callback is only registered the first time a command on this queue
+  /// waits on `user_event`.
+  ///
+  /// @param[in] user_event Incomplete user event a command waits on.
+  ///
+  /// @return Returns `CL_SUCCESS` or `CL_OUT_OF_RESOURCES`.
+  cl_int addUserEventCallback(cl_event user_event);
+
   /// @brief Completion callback for user events.
   ///
   /// @param[in] user_event The user event that has completed.
@@ -451,6 +541,9 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
     /// to destroy  the command buffer. This is true for non-user command
     /// buffers and user command buffers which have been cloned.
     bool should_destroy_command_buffer;
+    /// @brief Events signalled by the dispatch, only tracked on out-of-order
+    /// command queues to remove them from `running_signal_events`.
+    cargo::small_vector<cl_event, 8> signal_events;
   };
 
   /// @brief Double ended queue to track currently running command buffers.
@@ -502,9 +595,33 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   /// @brief A set of command buffers that are idle and ready to use.
   cargo::ring_buffer<mux_command_buffer_t, 16> cached_command_buffers;
 
-  /// @brief List of completed signal semaphores which are still being waited
-  /// on by running dispatches.
-  cargo::small_vector<mux_shared_semaphore, 32> completed_signal_semaphores;
+  /// @brief Mapping from an event to the pending dispatch which signals it.
+  ///
+  /// Lets wait events be resolved to the dispatch they depend on without
+  /// searching the signal events of every pending dispatch. Entries are added
+  /// when an event is registered with a pending dispatch and removed when the
+  /// dispatch is submitted or dropped.
+  std::unordered_map<cl_event, mux_command_buffer_t> pending_signal_events;
+
+  /// @brief User events this command queue has registered a completion
+  /// callback with.
+  ///
+  /// A single callback dispatches every pending command buffer waiting on the
+  /// user event, so it is only registered once however many commands wait.
+  std::unordered_set<cl_event> user_event_callbacks;
+
+  /// @brief Mapping from an event to the signal semaphore of the running
+  /// dispatch which signals it, only used by out-of-order command queues.
+  ///
+  /// In-order command queues order new dispatches after all running ones, an
+  /// out-of-order command queue instead waits on the semaphores of running
+  /// dispatches signalling events in the wait list. Entries are added when a
+  /// dispatch is submitted and removed once it has completed.
+  std::unordered_map<cl_event, mux_shared_semaphore> running_signal_events;
+
+  /// @brief Signal semaphore of the last barrier on an out-of-order command
+  /// queue, all later dispatches wait on it until the barrier has completed.
+  mux_shared_semaphore barrier_semaphore = nullptr;
 
 #ifdef OCL_EXTENSION_cl_khr_command_buffer
   /// @brief A map of mux_command_buffer_t to their associated
@@ -512,12 +629,6 @@ struct _cl_command_queue final : public cl::base<_cl_command_queue> {
   std::unordered_map<mux_command_buffer_t, cl_command_buffer_khr>
       user_command_buffers;
 #endif
-
-  /// true if we are currently in flush() on this command queue
-  /// This helps us avoid an infinite loop on flushing, as we can
-  /// call flushes on other command queues if there is a cross
-  /// queue event dependency.
-  bool in_flush;
 };
 
 /// @}
@@ -526,6 +637,44 @@ namespace cl {
 /// @addtogroup cl
 /// @{
 
+/// @brief Scoped lock of a command queue's mutex along with the mutexes of the
+/// command queues signalling the events in a wait list.
+///
+/// Mutexes are locked in address order so enqueues with cross-queue event
+/// dependencies in opposite directions can't deadlock. Once every mutex has
+/// been released the `flush_dependencies` of the locked command queues are
+/// flushed, each under a lock of its own.
+class command_queue_lock final {
+ public:
+  /// @brief Lock the command queue and the queues signalling the wait events.
+  ///
+  /// @param command_queue Command queue to lock.
+  /// @param event_wait_list Events the command being enqueued waits on, the
+  /// storage **must** outlive the lock.
+  command_queue_lock(cl_command_queue command_queue,
+                     cargo::array_view<const cl_event> event_wait_list = {});
+
+  /// @brief Unlock the command queues, then flush their dependencies.
+  ~command_queue_lock();
+
+  command_queue_lock(const command_queue_lock &) = delete;
+  command_queue_lock &operator=(const command_queue_lock &) = delete;
+
+ private:
+  /// @brief Get the next command queue to lock in address order.
+  ///
+  /// @param previous Command queue locked last, or `nullptr` for the first.
+  ///
+  /// @return Returns the command queue with the lowest address above
+  /// @p previous, or `nullptr` if there are no more.
+  cl_command_queue next(cl_command_queue previous) const;
+
+  /// @brief Command queue the command is enqueued on.
+  cl_command_queue command_queue;
+  /// @brief Events the command waits on.
+  cargo::array_view<const cl_event> event_wait_list;
+};
+
 /// @brief Create an OpenCL command queue object.
 ///
 /// @param context Context the command queue belongs to.
@@ -36,8 +36,10 @@
 
 #include <compiler/module.h>
 
+#include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 
 namespace cl {
@@ -209,11 +211,20 @@ struct _cl_context final : public cl::base<_cl_context> {
   /// @brief List of the context's enabled properties.
   cargo::dynamic_array<cl_context_properties> properties;
 #ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
-  /// @brief List of allocations made through the USM extension entry points.
-  cargo::small_vector<std::unique_ptr<extension::usm::allocation_info>, 1>
+  /// @brief Allocations made through the USM extension entry points, keyed on
+  /// their base address.
+  ///
+  /// USM allocations never overlap, so ordering them by base address lets the
+  /// owner of any pointer be found in logarithmic time by looking at the
+  /// closest allocation starting at or below it.
+  std::map<const void *, std::unique_ptr<extension::usm::allocation_info>>
       usm_allocations;
+  /// @brief Mutex protecting `usm_allocations`, lookups take a shared lock so
+  /// concurrent kernel argument setting and enqueues do not serialize.
+  std::shared_mutex usm_mutex;
+  /// @brief Cache of the memory backing freed USM allocations.
+  extension::usm::allocation_pool usm_pool;
 #endif
-  std::mutex &getCommandQueueMutex() { return command_queue_mutex; }
 
  private:
   /// @brief Default constructor, made private to enforce use of `create`.
@@ -228,8 +239,6 @@ struct _cl_context final : public cl::base<_cl_context> {
   std::unique_ptr<compiler::Context> compiler_context;
   /// @brief A mutex that guards the compiler_targets map.
   std::mutex compiler_targets_mutex;
-  /// @brief A mutex that guards any command queues.
-  std::mutex command_queue_mutex;
   /// @brief Map of OpenCL devices to compiler targets.
   std::unordered_map<cl_device_id, std::unique_ptr<compiler::Target>>
       compiler_targets;
@@ -26,13 +26,16 @@
 #include <cargo/dynamic_array.h>
 #include <cargo/expected.h>
 #include <cargo/optional.h>
+#include <cargo/small_vector.h>
 #include <cl/base.h>
 #include <cl/binary/kernel_info.h>
 #include <cl/validate.h>
 #include <compiler/kernel.h>
 #include <mux/mux.hpp>
 
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace cl {
 /// @addtogroup cl
@@ -90,6 +93,14 @@ class MuxKernelWrapper {
   /// @param deferred_kernel Deferred compiled kernel to wrap.
   MuxKernelWrapper(cl_device_id device, compiler::Kernel *deferred_kernel);
 
+  /// @brief Copy constructor, the copy starts with an empty cache of
+  /// specialized kernels.
+  ///
+  /// @param other Kernel wrapper to copy.
+  MuxKernelWrapper(const MuxKernelWrapper &other);
+
+  MuxKernelWrapper &operator=(const MuxKernelWrapper &) = delete;
+
   /// @brief Queries whether this kernel's compilation is being deferred using a
   /// runtime compiler.
   bool supportsDeferredCompilation() const;
@@ -134,6 +145,29 @@ class MuxKernelWrapper {
   cargo::expected<SpecializedKernel, compiler::Result> createSpecializedKernel(
       const mux_ndrange_options_t &specialization_options);
 
+  /// @brief Gets a Mux kernel specialized for the specific Mux execution
+  /// parameters, reusing a previously created Mux executable when the compiler
+  /// produces the same binary.
+  ///
+  /// Every successful call must be matched by a call to
+  /// `releaseSpecializedKernel` once the kernel has finished executing.
+  ///
+  /// @param specialization_options Mux execution options to specialize for.
+  ///
+  /// @return A Mux kernel owned by this wrapper if specialization was
+  /// successful, or a status code otherwise.
+  /// @retval `Result::OUT_OF_MEMORY` if an allocation failed.
+  /// @retval `Result::INVALID_VALUE` if any of the specialization options are
+  /// invalid.
+  /// @retval `Result::FAILURE` if this kernel is not specializable.
+  cargo::expected<mux_kernel_t, compiler::Result> acquireSpecializedKernel(
+      const mux_ndrange_options_t &specialization_options);
+
+  /// @brief Releases a kernel returned by `acquireSpecializedKernel`.
+  ///
+  /// @param mux_kernel Specialized kernel to release.
+  void releaseSpecializedKernel(mux_kernel_t mux_kernel);
+
   /// @brief If this kernel does not support specialization, this returns the
   /// generic Mux kernel that is not specialized for any particular config.
   mux_kernel_t getPrecompiledKernel() const;
@@ -213,6 +247,61 @@ class MuxKernelWrapper {
   mux_allocator_info_t mux_allocator_info;
   mux_kernel_t precompiled_kernel;
   compiler::Kernel *deferred_kernel;
+
+  /// @brief Creates a Mux executable and kernel from a binary produced by the
+  /// deferred kernel.
+  ///
+  /// @param binary Specialized binary to load.
+  ///
+  /// @return A valid SpecializedKernel object, or a status code otherwise.
+  cargo::expected<SpecializedKernel, compiler::Result> loadSpecializedKernel(
+      cargo::array_view<const uint8_t> binary);
+
+  /// @brief Key identifying the inputs a kernel was specialized for.
+  struct SpecializationKey {
+    /// @brief Hash of `inputs`, compared first to reject most mismatches.
+    uint64_t hash;
+    /// @brief Serialized local size, followed by the global shape and the
+    /// values of the plain old data arguments the kernel is specialized on.
+    std::vector<uint8_t> inputs;
+
+    bool operator==(const SpecializationKey &other) const {
+      return hash == other.hash && inputs == other.inputs;
+    }
+  };
+
+  /// @brief Builds the cache key for a set of specialization options.
+  ///
+  /// Only the inputs the deferred kernel reports it specializes on are part of
+  /// the key, so launches which only change other arguments, or the global
+  /// size when the kernel isn't specialized on it, share a kernel.
+  ///
+  /// @param specialization_options Mux execution options to specialize for.
+  ///
+  /// @return The key for the specialization options.
+  SpecializationKey getSpecializationKey(
+      const mux_ndrange_options_t &specialization_options) const;
+
+  /// @brief A specialized kernel cached for reuse by later launches.
+  struct CachedSpecializedKernel {
+    /// @brief The specialization inputs, used as the cache key.
+    SpecializationKey key;
+    /// @brief The loaded Mux executable and kernel.
+    SpecializedKernel specialized_kernel;
+    /// @brief Number of launches currently using the kernel.
+    uint32_t ref_count;
+    /// @brief Value of `specialized_kernel_uses` when last acquired.
+    uint64_t last_use;
+  };
+
+  /// @brief Mutex guarding `specialized_kernels` and
+  /// `specialized_kernel_uses`.
+  std::mutex specialized_kernels_mutex;
+  /// @brief Specialized kernels available for reuse, kernels which are not in
+  /// use are evicted least recently used first once the cache is full.
+  std::vector<CachedSpecializedKernel> specialized_kernels;
+  /// @brief Number of times a specialized kernel has been acquired.
+  uint64_t specialized_kernel_uses = 0;
 };
 
 /// @brief Definition of the OpenCL kernel object.
@@ -403,6 +492,36 @@ struct _cl_kernel final : public cl::base<_cl_kernel> {
   cargo::expected<const cl::binary::ArgumentType &, cl_int> GetArgType(
       const cl_uint arg_index) const;
 
+  /// @brief Validate and store the value of a single kernel argument.
+  ///
+  /// Implements the argument handling shared by `clSetKernelArg` and
+  /// `clSetKernelArgsCODEPLAY`, any cached argument descriptors are discarded.
+  ///
+  /// @param[in] arg_index Index of the argument to set.
+  /// @param[in] arg_size Size in bytes of the value pointed to by `arg_value`.
+  /// @param[in] arg_value Pointer to the argument value.
+  ///
+  /// @return Returns `CL_SUCCESS`, or an error code as for `clSetKernelArg`.
+  cl_int setArg(cl_uint arg_index, size_t arg_size, const void *arg_value);
+
+  /// @brief Storage for the argument descriptors of a single launch, kernels
+  /// with few arguments don't need a heap allocation per enqueue.
+  using descriptor_storage = cargo::small_vector<mux_descriptor_info_t, 8>;
+
+  /// @brief Build the argument descriptors of every device in the context.
+  ///
+  /// The cached descriptors are copied by `createKernelExecutionOptions`
+  /// instead of being rebuilt from `saved_args` on every enqueue. Nothing is
+  /// cached unless all the kernel arguments have been set.
+  ///
+  /// @return Returns `CL_SUCCESS`, or `CL_OUT_OF_HOST_MEMORY` if the
+  /// descriptors could not be allocated.
+  cl_int cacheArgDescriptors();
+
+  /// @brief Discard the descriptors built by `cacheArgDescriptors`, must be
+  /// called whenever `saved_args` is modified.
+  void invalidateArgDescriptors() { cached_descriptors.clear(); }
+
   /// @brief Set up the mux kernel execution options.
   ///
   /// @param[in] device OpenCL device to target.
@@ -412,18 +531,25 @@ struct _cl_kernel final : public cl::base<_cl_kernel> {
   /// @param[in] global_offset Global index offset to begin work at.
   /// @param[in] global_size Global size of work to do.
   /// @param[in] printf_buffer Buffer to write printf output into.
-  /// @param[out] descriptors A unique_ptr that can be used to store the
-  /// allocated array of mux_descriptor_info_t used in the resulting
-  /// mux_execution_options_t.
+  /// @param[out] descriptors Storage for the array of mux_descriptor_info_t
+  /// used in the resulting mux_execution_options_t, must outlive them.
   ///
-  /// @return Returns the relevant kernel execution options.
-  mux_ndrange_options_t createKernelExecutionOptions(
+  /// @return Returns the relevant kernel execution options, or
+  /// `CL_OUT_OF_HOST_MEMORY` if the descriptors could not be allocated.
+  cargo::expected<mux_ndrange_options_t, cl_int> createKernelExecutionOptions(
       cl_device_id device, cl_uint device_index, size_t work_dim,
       const std::array<size_t, cl::max::WORK_ITEM_DIM> &local_size,
       const std::array<size_t, cl::max::WORK_ITEM_DIM> &global_offset,
       const std::array<size_t, cl::max::WORK_ITEM_DIM> &global_size,
-      mux_buffer_t printf_buffer,
-      std::unique_ptr<mux_descriptor_info_t[]> &descriptors);
+      mux_buffer_t printf_buffer, descriptor_storage &descriptors);
+
+  /// @brief Fill in the argument descriptors for a device from `saved_args`.
+  ///
+  /// @param[in] device OpenCL device to target.
+  /// @param[in] device_index Index of the device in OpenCL context device list.
+  /// @param[out] descriptors Array of at least `info->num_arguments` elements.
+  void fillArgDescriptors(cl_device_id device, cl_uint device_index,
+                          mux_descriptor_info_t *descriptors);
 
   /// @brief Retain cl_mem objects that are the arguments to a kernel.
   ///
@@ -497,6 +623,9 @@ struct _cl_kernel final : public cl::base<_cl_kernel> {
   const cl::binary::KernelInfo *info;
   /// @brief Array of arguments.
   cargo::dynamic_array<argument> saved_args;
+  /// @brief Argument descriptors per context device, built by
+  /// `cacheArgDescriptors`, empty when `saved_args` has since changed.
+  cargo::dynamic_array<descriptor_storage> cached_descriptors;
   /// @brief Array of argument information.
   cargo::optional<cargo::dynamic_array<argument::info>> arg_info;
   /// @brief OpenCL device to kernels map.
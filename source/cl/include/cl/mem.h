@@ -92,7 +92,9 @@ struct _cl_mem : public cl::base<_cl_mem> {
   /// Before calling this function the `::_cl_mem` object will not have *any*
   /// physical device memory associated with it. After this function succeeds
   /// there *will* physical device memory but inherited `::_cl_mem_buffer` or
-  /// `::_cl_mem_image` **will not** be bound to this memory.
+  /// `::_cl_mem_image` **will not** be bound to this memory. The allocated
+  /// memory is `memory_offset` bytes larger than the memory object, and its
+  /// data begins at that offset.
   ///
   /// @param[in] mux_device Mux device to allocate memory on.
   /// @param[in] supported_heaps Supported heaps to allocate from.
@@ -142,6 +144,15 @@ struct _cl_mem : public cl::base<_cl_mem> {
 
   /// @brief List of mux memory objects, the physical device memory allocation.
   cargo::dynamic_array<mux_memory_t> mux_memories;
+  /// @brief Offset in bytes of the memory object's data within each of the
+  /// `mux_memories`.
+  ///
+  /// Non-zero when a `CL_MEM_USE_HOST_PTR` buffer's `host_ptr` is not aligned
+  /// to the device buffer alignment. The memory then starts at `host_ptr`
+  /// rounded down to that alignment, so it can still wrap the user's memory
+  /// without copying, and the buffer is bound at this offset. For sub-buffers
+  /// this will always be zero, the memory_offset of the parent should be used.
+  size_t memory_offset;
 
   // TODO: redmine(7053) _cl_event makes use of a callback container which
   // contains the function pointer and the user data pointer which allows it to
@@ -22,21 +22,24 @@
 #include <cargo/expected.h>
 #include <mux/mux.h>
 
+#include <atomic>
+
 #ifndef CL_SEMAPHORE_H_INCLUDED
 #define CL_SEMAPHORE_H_INCLUDED
 
 typedef struct _mux_shared_semaphore *mux_shared_semaphore;
 
 /// @brief A shared wrapper for a semaphore, allowing references across queues
-/// @note This is not thread safe and should only be used when there is a
-/// command queue mutex.
+/// @note The reference count is atomic because a dispatch on one command queue
+/// may wait on the signal semaphore of another, each queue only holds its own
+/// mutex when releasing its references.
 struct _mux_shared_semaphore final {
  private:
   cl_device_id device;
 
   _mux_shared_semaphore(cl_device_id device, mux_semaphore_t semaphore)
       : device(device), ref_count(1), semaphore(semaphore){};
-  cl_uint ref_count;
+  std::atomic<cl_uint> ref_count;
 
  public:
   mux_semaphore_t semaphore;
@@ -45,8 +48,6 @@ struct _mux_shared_semaphore final {
   ~_mux_shared_semaphore();
 
   /// @brief Increment the semaphore's reference count
-  /// @note This is not thread safe and should only be done inside a command
-  /// buffer mutex.
   /// @return CL_SUCCESS on success, CL_OUT_OF_RESOURCES if retain results in an
   /// overflow.
   cl_int retain();
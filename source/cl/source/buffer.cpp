@@ -22,6 +22,9 @@
 #include <cl/mux.h>
 #include <cl/platform.h>
 #include <cl/validate.h>
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+#include <extension/codeplay_command_buffer_capture.h>
+#endif
 #include <tracer/tracer.h>
 
 #include <algorithm>
@@ -86,6 +89,22 @@ cargo::expected<std::unique_ptr<_cl_mem_buffer>, cl_int> _cl_mem_buffer::create(
     return cargo::make_unexpected(CL_OUT_OF_HOST_MEMORY);
   }
 
+  if (CL_MEM_USE_HOST_PTR & flags) {
+    // Devices with host coherent memory can wrap `host_ptr` without copying
+    // as long as the memory starts at an aligned address, so unaligned
+    // pointers are rounded down to the strictest alignment of those devices
+    // and the buffer is bound at the remaining offset.
+    size_t alignment = 1;
+    for (auto device : context->devices) {
+      const auto info = device->mux_device->info;
+      if (info->allocation_capabilities &
+          mux_allocation_capabilities_coherent_host) {
+        alignment = std::max<size_t>(alignment, info->buffer_alignment);
+      }
+    }
+    buffer->memory_offset = reinterpret_cast<uintptr_t>(host_ptr) % alignment;
+  }
+
   for (cl_uint index = 0; index < context->devices.size(); ++index) {
     auto device = context->devices[index];
     mux_device_t mux_device = device->mux_device;
@@ -98,7 +117,7 @@ cargo::expected<std::unique_ptr<_cl_mem_buffer>, cl_int> _cl_mem_buffer::create(
     OCL_CHECK(error, return cargo::make_unexpected(error));
     buffer->mux_memories[index] = mux_memory;
 
-    uint64_t offset = 0;
+    const uint64_t offset = buffer->memory_offset;
     auto mux_error =
         muxBindBufferMemory(mux_device, mux_memory, mux_buffer, offset);
     OCL_CHECK(mux_error,
@@ -159,7 +178,7 @@ cl_int _cl_mem_buffer::synchronize(cl_command_queue command_queue) {
       // Perform the synchronization.
       if (auto mux_error = mux::synchronizeMemory(
               source_mux_device, dest_mux_device, source_mux_memory,
-              dest_mux_memory, nullptr, nullptr, /* offset */ 0,
+              dest_mux_memory, nullptr, nullptr, owning_buffer->memory_offset,
               owning_buffer->size)) {
         return cl::getErrorFrom(mux_error);
       }
@@ -315,7 +334,8 @@ CL_API_ENTRY cl_mem CL_API_CALL cl::CreateSubBuffer(
 
     mux_error =
         muxBindBufferMemory(device->mux_device, sub_buffer->mux_memories[index],
-                            sub_buffer->mux_buffers[index], origin);
+                            sub_buffer->mux_buffers[index],
+                            buffer->memory_offset + origin);
     OCL_CHECK(mux_error, OCL_SET_IF_NOT_NULL(errcode_ret,
                                              CL_MEM_OBJECT_ALLOCATION_FAILURE);
               return nullptr);
@@ -410,13 +430,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueWriteBufferRect(
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, event_release_guard.get());
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -555,13 +575,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueReadBufferRect(
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, return_event);
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -657,13 +677,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueCopyBufferRect(
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -870,13 +890,13 @@ cl::EnqueueWriteBuffer(cl_command_queue command_queue, cl_mem buffer,
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, event_release_guard.get());
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -957,13 +977,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueReadBuffer(
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, event_release_guard.get());
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -1025,6 +1045,14 @@ cl::EnqueueCopyBuffer(cl_command_queue command_queue, cl_mem src_buffer,
                                       command_queue->context, event);
   OCL_CHECK(error != CL_SUCCESS, return error);
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  if (auto captured = extension::CaptureCopyBuffer(
+          command_queue, src_buffer, dst_buffer, src_offset, dst_offset, size,
+          num_events_in_wait_list, event)) {
+    return *captured;
+  }
+#endif
+
   cl_event return_event = nullptr;
   if (nullptr != event) {
     auto new_event = _cl_event::create(command_queue, CL_COMMAND_COPY_BUFFER);
@@ -1035,13 +1063,13 @@ cl::EnqueueCopyBuffer(cl_command_queue command_queue, cl_mem src_buffer,
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -1091,6 +1119,14 @@ cl::EnqueueFillBuffer(cl_command_queue command_queue, cl_mem buffer,
                                       command_queue->context, event);
   OCL_CHECK(error != CL_SUCCESS, return error);
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  if (auto captured = extension::CaptureFillBuffer(
+          command_queue, buffer, pattern, pattern_size, offset, size,
+          num_events_in_wait_list, event)) {
+    return *captured;
+  }
+#endif
+
   cl_event return_event = nullptr;
   if (nullptr != event) {
     auto new_event = _cl_event::create(command_queue, CL_COMMAND_FILL_BUFFER);
@@ -1101,13 +1137,13 @@ cl::EnqueueFillBuffer(cl_command_queue command_queue, cl_mem buffer,
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -48,8 +48,7 @@ _cl_command_queue::_cl_command_queue(cl_context context, cl_device_id device,
       pending_dispatches(),
       running_command_buffers(),
       finish_state(),
-      cached_command_buffers(),
-      in_flush(false) {
+      cached_command_buffers() {
   cl::retainInternal(context);
   cl::retainInternal(device);
 }
@@ -58,14 +57,12 @@ _cl_command_queue::~_cl_command_queue() {
   muxWaitAll(mux_queue);
 
   {
-    std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+    std::lock_guard<std::mutex> lock(mutex);
     cleanupCompletedCommandBuffers();
+    if (barrier_semaphore) {
+      releaseSemaphore(barrier_semaphore);
+    }
   }
-  // Release any completed signal semaphores
-  for (auto semaphore : completed_signal_semaphores) {
-    releaseSemaphore(semaphore);
-  }
-
   for (auto pair : fences) {
     muxDestroyFence(device->mux_device, pair.second, device->mux_allocator);
   }
@@ -103,7 +100,11 @@ _cl_command_queue::create(cl_context context, cl_device_id device,
 
   if (cl::validate::IsInBitSet(properties,
                                CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
-    return cargo::make_unexpected(CL_INVALID_QUEUE_PROPERTIES);
+    if (!cl::validate::IsInBitSet(device->queue_properties,
+                                  CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+      return cargo::make_unexpected(CL_INVALID_QUEUE_PROPERTIES);
+    }
+    queueProperties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
   }
 
   // Set profiling enable
@@ -163,15 +164,20 @@ _cl_command_queue::create(cl_context context, cl_device_id device,
         case CL_QUEUE_PROPERTIES:
           if (value & ~valid_properties_mask) {
             return cargo::make_unexpected(CL_INVALID_VALUE);
-          } else if (value & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
-            // TODO(CA-1123): Support out of order command queues.
-            return cargo::make_unexpected(CL_INVALID_QUEUE_PROPERTIES);
 #if defined(CL_VERSION_3_0)
           } else if (value & CL_QUEUE_ON_DEVICE ||
                      value & CL_QUEUE_ON_DEVICE_DEFAULT) {
             return cargo::make_unexpected(CL_INVALID_QUEUE_PROPERTIES);
 #endif
-          } else if (value & CL_QUEUE_PROFILING_ENABLE) {
+          }
+          if (value & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+            if (!(device->queue_properties &
+                  CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+              return cargo::make_unexpected(CL_INVALID_QUEUE_PROPERTIES);
+            }
+            command_queue_properties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+          }
+          if (value & CL_QUEUE_PROFILING_ENABLE) {
             command_queue_properties |= CL_QUEUE_PROFILING_ENABLE;
           }
           break;
@@ -208,19 +214,6 @@ _cl_command_queue::create(cl_context context, cl_device_id device,
 }
 
 cl_int _cl_command_queue::flush() {
-  if (in_flush) {
-    return CL_SUCCESS;
-  }
-  in_flush = true;
-
-  // Use a raii_wrapper to ensure in_flush is set to false on exit
-  struct raii_wrapper {
-    raii_wrapper(bool &in_flush) : in_flush(in_flush){};
-    ~raii_wrapper() { in_flush = false; }
-    bool &in_flush;
-  };
-  raii_wrapper wrapper(in_flush);
-
   if (auto error = cleanupCompletedCommandBuffers()) {
     return error;
   }
@@ -238,12 +231,17 @@ cl_int _cl_command_queue::flush() {
         if (std::none_of(dispatch.wait_events.begin(),
                          dispatch.wait_events.end(), cl::isUserEvent)) {
           for (auto &wait_event : dispatch.wait_events) {
-            // Force a flush if from a different queue
+            // Force a flush if from a different queue, it must wait until
+            // this queue's mutex is released to avoid lock order inversion.
+            auto queue = wait_event->queue;
             if (CL_COMMAND_USER != wait_event->command_type &&
-                wait_event->command_status != CL_COMPLETE) {
-              if (wait_event->queue != this) {
-                wait_event->queue->flush();
+                wait_event->command_status != CL_COMPLETE && queue != this &&
+                std::find(flush_dependencies.begin(), flush_dependencies.end(),
+                          queue) == flush_dependencies.end()) {
+              if (flush_dependencies.push_back(queue)) {
+                return CL_OUT_OF_RESOURCES;
               }
+              cl::retainInternal(queue);
             }
           }
           if (command_buffers.push_back(command_buffer)) {
@@ -267,7 +265,7 @@ cl_int _cl_command_queue::waitForEvents(const cl_uint num_events,
   for (cl_uint i = 0; i < num_events; i++) {
     events[i]->wait();
   }
-  std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+  cl::command_queue_lock lock(this);
 
   return CL_SUCCESS == cleanupCompletedCommandBuffers()
              ? CL_SUCCESS
@@ -275,7 +273,7 @@ cl_int _cl_command_queue::waitForEvents(const cl_uint num_events,
 }
 
 cl_int _cl_command_queue::getEventStatus(cl_event event) {
-  std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+  cl::command_queue_lock lock(this);
   cl_int error = cleanupCompletedCommandBuffers();
   OCL_UNUSED(error);
   assert(CL_SUCCESS == error);
@@ -284,14 +282,10 @@ cl_int _cl_command_queue::getEventStatus(cl_event event) {
 
 cl_int _cl_command_queue::cleanupCompletedCommandBuffers() {
   // Check to see if there are any command buffers ready to be cleaned up.
-  while (true) {
-    if (running_command_buffers.empty()) {
-      // There are no running command buffers so we can stop processing.
-      break;
-    }
-
-    // Check if the first running command buffer has completed.
-    auto fence = fences[running_command_buffers.front().command_buffer];
+  auto running = running_command_buffers.begin();
+  while (running != running_command_buffers.end()) {
+    // Check if the running command buffer has completed.
+    auto fence = fences[running->command_buffer];
     assert(fence && "Missing fence entry for command buffer dispatch!");
     mux_result_t error = muxTryWait(mux_queue, 0, fence);
     OCL_ASSERT(mux_success == error || mux_error_fence_failure == error ||
@@ -299,6 +293,12 @@ cl_int _cl_command_queue::cleanupCompletedCommandBuffers() {
                "muxTryWait failed!");
 
     if (mux_fence_not_ready == error) {
+      if (isOutOfOrder()) {
+        // Dispatches on an out-of-order queue may complete in any order, so
+        // keep looking for completed ones.
+        ++running;
+        continue;
+      }
       // The command buffer wasn't yet complete. Because of how our command
       // groups are linearly chained together (we have an in order queue)
       // we can bail now as if this command buffer isn't complete, future
@@ -310,7 +310,7 @@ cl_int _cl_command_queue::cleanupCompletedCommandBuffers() {
     // and remove the associated entry from the map.
     // TODO: We could do better here and reset the fences then reuse them.
     muxDestroyFence(device->mux_device, fence, device->mux_allocator);
-    fences.erase(running_command_buffers.front().command_buffer);
+    fences.erase(running->command_buffer);
 
     // Note that by this point 'error' may be either mux_success or
     // mux_error_fence_failure.  This function does not care about
@@ -319,13 +319,27 @@ cl_int _cl_command_queue::cleanupCompletedCommandBuffers() {
     // accordingly.
 
     // The command buffer has completed so stop tracking it then destroy it.
-    auto completed = std::move(running_command_buffers.front());
+    auto completed = std::move(*running);
     // Any completed buffers that have wait semaphores should be cleaned
     // up
     for (auto &s : completed.wait_semaphores) {
       releaseSemaphore(s);
     }
-    running_command_buffers.pop_front();
+    running = running_command_buffers.erase(running);
+
+    // Later commands no longer need to wait for the completed dispatch, the
+    // entry may have been replaced if the event's address was reused.
+    for (auto signal_event : completed.signal_events) {
+      auto found = running_signal_events.find(signal_event);
+      if (found != running_signal_events.end() &&
+          found->second == completed.signal_semaphore) {
+        running_signal_events.erase(found);
+      }
+    }
+    if (barrier_semaphore && barrier_semaphore == completed.signal_semaphore) {
+      releaseSemaphore(barrier_semaphore);
+      barrier_semaphore = nullptr;
+    }
 
 #ifdef OCL_EXTENSION_cl_khr_command_buffer
     // We need to release references on any command buffers associated with user
@@ -357,53 +371,11 @@ cl_int _cl_command_queue::cleanupCompletedCommandBuffers() {
       }
     }
 
-    // Append the completed signal semaphore to the cleanup list.
-    if (completed_signal_semaphores.push_back(completed.signal_semaphore)) {
-      return CL_OUT_OF_HOST_MEMORY;
-    }
-
-    // Get list of all wait_semaphores from running dispatches.
-    cargo::small_vector<mux_shared_semaphore, 64> running_wait_semaphores;
-    for (auto &running : running_command_buffers) {
-      if (!running_wait_semaphores.insert(running_wait_semaphores.end(),
-                                          running.wait_semaphores.begin(),
-                                          running.wait_semaphores.end())) {
-        return CL_OUT_OF_HOST_MEMORY;
-      }
-    }
-    // Remove any duplicates from the list of all running wait semaphores.
-    running_wait_semaphores.erase(std::unique(running_wait_semaphores.begin(),
-                                              running_wait_semaphores.end()),
-                                  running_wait_semaphores.end());
-
-    // Iterate over completed signal semaphores and release them.
-
-    // Store destroyed semaphores for later processing.
-    cargo::small_vector<mux_shared_semaphore, 16> released_semaphores;
-    for (auto signal_semaphore : completed_signal_semaphores) {
-      // Release the semaphore now that nothing depends on it.
-      if (auto error = releaseSemaphore(signal_semaphore)) {
-        return error;
-      }
-      // Append to the list of destroyed semaphores to be removed from
-      // completed signal semaphores list.
-      if (released_semaphores.push_back(signal_semaphore)) {
-        return CL_OUT_OF_HOST_MEMORY;
-      }
+    // Drop the queue's reference to the completed signal semaphore, running
+    // dispatches which still wait on it hold their own references.
+    if (auto error = releaseSemaphore(completed.signal_semaphore)) {
+      return error;
     }
-
-    // Move destroyed semaphores to the back, then erase them.
-    auto first_released_semaphore = std::stable_partition(
-        completed_signal_semaphores.begin(), completed_signal_semaphores.end(),
-        [&released_semaphores](mux_shared_semaphore semaphore) {
-          // When semaphore is not in released_semaphores return true which
-          // moves it to the front, otherwise move it to the back.
-          return std::find(released_semaphores.begin(),
-                           released_semaphores.end(),
-                           semaphore) == released_semaphores.end();
-        });
-    completed_signal_semaphores.erase(first_released_semaphore,
-                                      completed_signal_semaphores.end());
   }
 
   return CL_SUCCESS;
@@ -415,7 +387,20 @@ cl_uint _cl_command_queue::getDeviceIndex() {
 
 CARGO_NODISCARD cargo::expected<mux_command_buffer_t, cl_int>
 _cl_command_queue::getCommandBuffer(
-    cargo::array_view<const cl_event> event_wait_list, cl_event event) {
+    cargo::array_view<const cl_event> event_wait_list, cl_event event,
+    bool wait_for_all) {
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  // Only commands which can be recorded into a command-buffer are accepted
+  // while capturing, executing anything else immediately would reorder it
+  // before the captured commands.
+  if (capture_command_buffer) {
+    if (event) {
+      event->complete(CL_INVALID_OPERATION);
+    }
+    return cargo::make_unexpected(CL_INVALID_OPERATION);
+  }
+#endif
+
   // Register the wait and signal events for the command buffer's dispatch.
   auto registerEvents = [this, event_wait_list,
                          event](mux_command_buffer_t command_buffer)
@@ -427,6 +412,9 @@ _cl_command_queue::getCommandBuffer(
     if (auto error = dispatch.addSignalEvent(event)) {
       return cargo::make_unexpected(error);
     }
+    if (event) {
+      pending_signal_events[event] = command_buffer;
+    }
     if (event && (properties & CL_QUEUE_PROFILING_ENABLE)) {
       if (auto mux_error = muxCommandBeginQuery(
               command_buffer, event->profiling.duration_queries, 0, 1, 0,
@@ -443,11 +431,30 @@ _cl_command_queue::getCommandBuffer(
     }
   };
 
-  return getCommandBufferPending(event_wait_list)
+  return getCommandBufferPending(event_wait_list, wait_for_all)
       .and_then(registerEvents)
       .or_else(setEventFailure);
 }
 
+CARGO_NODISCARD cl_int _cl_command_queue::setBarrier(
+    mux_command_buffer_t command_buffer) {
+  if (!isOutOfOrder()) {
+    return CL_SUCCESS;
+  }
+  auto dispatch = pending_dispatches.find(command_buffer);
+  OCL_ASSERT(dispatch != pending_dispatches.end(),
+             "command_buffer not found in pending_dispatches");
+  auto semaphore = dispatch->second.signal_semaphore;
+  if (auto error = semaphore->retain()) {
+    return error;
+  }
+  if (barrier_semaphore) {
+    releaseSemaphore(barrier_semaphore);
+  }
+  barrier_semaphore = semaphore;
+  return CL_SUCCESS;
+}
+
 CARGO_NODISCARD cl_int _cl_command_queue::registerDispatchCallback(
     mux_command_buffer_t command_buffer, cl_event event,
     std::function<void()> callback) {
@@ -480,7 +487,7 @@ _cl_command_queue::getCurrentCommandBuffer() {
 
 CARGO_NODISCARD cargo::expected<mux_command_buffer_t, cl_int>
 _cl_command_queue::getCommandBufferPending(
-    cargo::array_view<const cl_event> event_wait_list) {
+    cargo::array_view<const cl_event> event_wait_list, bool wait_for_all) {
   // Utility function object adds wait semaphores to a pending dispatch.
   struct add_wait {
     add_wait(cargo::array_view<mux_shared_semaphore> semaphores,
@@ -530,13 +537,32 @@ _cl_command_queue::getCommandBufferPending(
   using dispatch_pair = std::pair<const mux_command_buffer_t, dispatch_state_t>;
   cargo::small_vector<dispatch_pair *, 8> dependent_dispatches;
 
+  // Storage for wait semaphores to set on a pending command buffer.
+  cargo::small_vector<mux_shared_semaphore, 8> semaphores;
+
   // Flag indicating whether it is safe to append to the last command buffer in
   // the case that we only have one dependent command (which will always be the
-  // last dispatch).
+  // last dispatch on an in-order queue).
   bool can_append_last_dispatch = true;
 
-  // We always need to wait on the last pending dispatch (if there is one).
-  if (!pending_command_buffers.empty()) {
+  const bool out_of_order = isOutOfOrder();
+  if (out_of_order) {
+    // Commands on an out-of-order queue only depend on their wait events,
+    // unless they must wait for all previously enqueued commands.
+    if (wait_for_all) {
+      for (auto command_buffer : pending_command_buffers) {
+        auto pending_dispatch = pending_dispatches.find(command_buffer);
+        OCL_ASSERT(pending_dispatch != std::end(pending_dispatches),
+                   "A pending command buffer has no entry in the pending "
+                   "dispatches map.");
+        if (dependent_dispatches.push_back(&*pending_dispatch)) {
+          return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
+        }
+      }
+      can_append_last_dispatch = false;
+    }
+  } else if (!pending_command_buffers.empty()) {
+    // We always need to wait on the last pending dispatch (if there is one).
     auto &pending_command_buffer = pending_command_buffers.back();
     auto pending_dispatch = pending_dispatches.find(pending_command_buffer);
     OCL_ASSERT(pending_dispatch != std::end(pending_dispatches),
@@ -558,44 +584,44 @@ _cl_command_queue::getCommandBufferPending(
       // We can't append to the last dispatch if we need to wait on a user
       // event.
       can_append_last_dispatch = false;
-      if (!wait_event->addCallback(CL_COMPLETE, &userEventDispatch, this)) {
-        return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
+      if (auto error = addUserEventCallback(wait_event)) {
+        return cargo::make_unexpected(error);
       }
+      continue;
     }
-
-    auto isWaitEvent = [wait_event](const cl_event signal_event) {
-      return wait_event == signal_event;
-    };
-
-    for (auto &pending : pending_dispatches) {
-      auto &dispatch = pending.second;
-      // Check if any signal events are the wait event and add them to
-      // dependent_dispatches.
-      if (std::any_of(dispatch.signal_events.begin(),
-                      dispatch.signal_events.end(), isWaitEvent)) {
-        if (dependent_dispatches.push_back(&pending)) {
-          return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
-        }
-      }
+    if (CL_COMMAND_USER == wait_event->command_type) {
+      continue;
     }
 
-    // Check the pending dispatches of the wait event's queue if it is
-    // different from this one
-    if (wait_event->queue != this &&
-        CL_COMMAND_USER != wait_event->command_type) {
-      for (auto &pending : wait_event->queue->pending_dispatches) {
-        auto &dispatch = pending.second;
-        // Check if any signal events are the wait event and add them to
-        // dependent_dispatches.
-        if (std::any_of(dispatch.signal_events.begin(),
-                        dispatch.signal_events.end(), isWaitEvent)) {
-          can_append_last_dispatch = false;
-
-          if (dependent_dispatches.push_back(&pending)) {
+    // Look up the pending dispatch which signals the wait event, this may be
+    // on the wait event's queue if it is different from this one.
+    auto signal_queue = wait_event->queue;
+    auto signal_dispatch = signal_queue->pending_signal_events.find(wait_event);
+    if (signal_dispatch == signal_queue->pending_signal_events.end()) {
+      // The wait event's command has already been dispatched, an in-order
+      // queue waits on all running dispatches but an out-of-order queue must
+      // wait on the running dispatch which signals the event.
+      if (out_of_order && signal_queue == this &&
+          wait_event->command_status != CL_COMPLETE) {
+        auto running = running_signal_events.find(wait_event);
+        if (running != running_signal_events.end()) {
+          if (semaphores.push_back(running->second)) {
             return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
           }
         }
       }
+      continue;
+    }
+    auto pending =
+        signal_queue->pending_dispatches.find(signal_dispatch->second);
+    OCL_ASSERT(pending != signal_queue->pending_dispatches.end(),
+               "Pending signal event has no entry in the pending dispatches "
+               "map.");
+    if (signal_queue != this) {
+      can_append_last_dispatch = false;
+    }
+    if (dependent_dispatches.push_back(&*pending)) {
+      return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
     }
   }
 
@@ -609,29 +635,36 @@ _cl_command_queue::getCommandBufferPending(
   }
 
   // There is only a single dependent dispatch so return its command buffer.
-  // Since there is only one it must be the most recent dispatch.
-  if (dependent_dispatches.size() == 1 && can_append_last_dispatch) {
-    return dependent_dispatches.front()->first;
+  // On an in-order queue it must be the most recent dispatch, on an
+  // out-of-order queue it must already be ordered after the last barrier.
+  if (dependent_dispatches.size() == 1 && can_append_last_dispatch &&
+      semaphores.empty()) {
+    auto &dependent_dispatch = dependent_dispatches.front()->second;
+    auto &wait_semaphores = dependent_dispatch.wait_semaphores;
+    if (!out_of_order || !barrier_semaphore ||
+        dependent_dispatch.signal_semaphore == barrier_semaphore ||
+        std::find(wait_semaphores.begin(), wait_semaphores.end(),
+                  barrier_semaphore) != wait_semaphores.end()) {
+      return dependent_dispatches.front()->first;
+    }
   }
 
-  // Storage for wait semaphores to set on a pending command buffer.
-  cargo::small_vector<mux_shared_semaphore, 8> semaphores;
-
   // There are one or more dependent dispatches we must create a new command
   // group and wait on the their signal semaphores.
-  if (!dependent_dispatches.empty()) {
-    for (auto &dependent : dependent_dispatches) {
-      auto &dependent_dispatch = dependent->second;
-      // Append the signal semaphore to wait_semaphores of the current
-      // dispatch.
-      if (semaphores.push_back(dependent_dispatch.signal_semaphore)) {
-        return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
-      }
+  for (auto &dependent : dependent_dispatches) {
+    auto &dependent_dispatch = dependent->second;
+    // Append the signal semaphore to wait_semaphores of the current
+    // dispatch.
+    if (semaphores.push_back(dependent_dispatch.signal_semaphore)) {
+      return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
     }
-  } else {
-    // There are no dependent dispatches, this means the command buffer is
-    // running now or has already completed or there were never any wait events
-    // in the first place.
+  }
+
+  // On an in-order queue with no dependent dispatches, the command buffer is
+  // running now or has already completed or there were never any wait events
+  // in the first place. On an out-of-order queue running dispatches are only
+  // waited on by commands which must wait for all previous commands.
+  if (out_of_order ? wait_for_all : dependent_dispatches.empty()) {
     // Wait on all running dispatches to ensure ordering since the commands in
     // running_command_buffers may be out of order with respect the
     // container (ordering is still enforced via semaphore dependencies though).
@@ -642,6 +675,13 @@ _cl_command_queue::getCommandBufferPending(
     }
   }
 
+  // Commands on an out-of-order queue are ordered after the last barrier.
+  if (out_of_order && barrier_semaphore) {
+    if (semaphores.push_back(barrier_semaphore)) {
+      return cargo::make_unexpected(CL_OUT_OF_RESOURCES);
+    }
+  }
+
   return createCommandBuffer().and_then(
       add_wait{semaphores, pending_dispatches});
 }
@@ -696,6 +736,7 @@ CARGO_NODISCARD cl_int _cl_command_queue::dispatch(
     // Set all events as submitted.
     for (auto signal_event : dispatch.signal_events) {
       signal_event->submitted();
+      pending_signal_events.erase(signal_event);
     }
 
     for (auto &w : dispatch.wait_events) {
@@ -729,6 +770,20 @@ CARGO_NODISCARD cl_int _cl_command_queue::dispatch(
       signal_event->running();
     }
 
+    // Later commands on an out-of-order queue wait directly on the running
+    // dispatch signalling their wait events. The events must be copied before
+    // the dispatch, its completion callback clears `finished`.
+    cargo::small_vector<cl_event, 8> signal_events;
+    if (isOutOfOrder() && dispatch.signal_semaphore) {
+      if (signal_events.assign(finished.signal_events.begin(),
+                               finished.signal_events.end())) {
+        return CL_OUT_OF_RESOURCES;
+      }
+      for (auto signal_event : signal_events) {
+        running_signal_events[signal_event] = dispatch.signal_semaphore;
+      }
+    }
+
     // Actually dispatch the command buffer.
     cargo::small_vector<mux_semaphore_t, 8> wait_semaphores_storage;
     for (auto s : dispatch.wait_semaphores) {
@@ -743,6 +798,9 @@ CARGO_NODISCARD cl_int _cl_command_queue::dispatch(
                                             : wait_semaphores_storage.data(),
             dispatch.wait_semaphores.size(), signal_semaphores,
             signal_semaphores_length, dispatchComplete, &finished)) {
+      for (auto signal_event : signal_events) {
+        running_signal_events.erase(signal_event);
+      }
       finished.clear(command_buffer, error, /* locked */ true);
       return CL_OUT_OF_RESOURCES;
     }
@@ -751,7 +809,7 @@ CARGO_NODISCARD cl_int _cl_command_queue::dispatch(
     running_command_buffers.push_back(
         {command_buffer, std::move(dispatch.wait_semaphores),
          dispatch.signal_semaphore, dispatch.is_user_command_buffer,
-         dispatch.should_destroy_command_buffer});
+         dispatch.should_destroy_command_buffer, std::move(signal_events)});
   }
 
   // Remove dispatched command buffers from pending.
@@ -759,7 +817,11 @@ CARGO_NODISCARD cl_int _cl_command_queue::dispatch(
 }
 
 cl_int _cl_command_queue::dispatchPending(cl_event user_event) {
-  std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+  cl::command_queue_lock lock(this);
+
+  // The callback has fired, any later commands waiting on the user event must
+  // register a new one.
+  user_event_callbacks.erase(user_event);
 
   // Remove the user event from all pending dispatches wait event lists.
   for (auto &pending : pending_dispatches) {
@@ -787,13 +849,19 @@ cl_int _cl_command_queue::removeFromPending(
     pending_dispatches.erase(command_buffer);
   }
 
+  // Sort the removed command buffers so each pending command buffer can be
+  // checked with a binary search, a linear search makes flushing a queue with
+  // many pending dispatches quadratic.
+  cargo::small_vector<mux_command_buffer_t, 16> removed;
+  if (removed.assign(command_buffers.begin(), command_buffers.end())) {
+    return CL_OUT_OF_RESOURCES;
+  }
+  std::sort(removed.begin(), removed.end());
+
   // Predicate returns `true` if the command buffer should be kept, `false` if
   // it should be removed.
-  auto isRetained = [&command_buffers](mux_command_buffer_t command_buffer) {
-    return std::none_of(command_buffers.begin(), command_buffers.end(),
-                        [command_buffer](mux_command_buffer_t dropped) {
-                          return command_buffer == dropped;
-                        });
+  auto isRetained = [&removed](mux_command_buffer_t command_buffer) {
+    return !std::binary_search(removed.begin(), removed.end(), command_buffer);
   };
 
   // Partition the command buffers whilst maintaining original ordering,
@@ -817,7 +885,7 @@ cl_int _cl_command_queue::removeFromPending(
 
 cl_int _cl_command_queue::dropDispatchesPending(
     cl_event user_event, cl_int event_command_exec_status) {
-  std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+  cl::command_queue_lock lock(this);
 
   cargo::small_vector<mux_command_buffer_t, 16> command_buffers;
 
@@ -834,6 +902,13 @@ cl_int _cl_command_queue::dropDispatchesPending(
                     [](std::function<void()> &callback) { callback(); });
       dispatch.callbacks.clear();
 
+      // A dropped barrier will never be signalled, so later commands must not
+      // wait for it.
+      if (barrier_semaphore && barrier_semaphore == dispatch.signal_semaphore) {
+        releaseSemaphore(barrier_semaphore);
+        barrier_semaphore = nullptr;
+      }
+
       // Release the signal semaphore if it exists.
       if (auto error = releaseSemaphore(dispatch.signal_semaphore)) {
         return error;
@@ -842,6 +917,7 @@ cl_int _cl_command_queue::dropDispatchesPending(
 
       // Mark all signal_events as failed and release them.
       for (auto signal_event : dispatch.signal_events) {
+        pending_signal_events.erase(signal_event);
         signal_event->complete(event_command_exec_status);
         cl::releaseInternal(signal_event);
       }
@@ -959,6 +1035,19 @@ cl_int _cl_command_queue::releaseSemaphore(mux_shared_semaphore semaphore) {
   return CL_SUCCESS;
 }
 
+cl_int _cl_command_queue::addUserEventCallback(cl_event user_event) {
+  if (!user_event_callbacks.insert(user_event).second) {
+    // A callback is already registered, it dispatches all pending command
+    // buffers waiting on the user event.
+    return CL_SUCCESS;
+  }
+  if (!user_event->addCallback(CL_COMPLETE, &userEventDispatch, this)) {
+    user_event_callbacks.erase(user_event);
+    return CL_OUT_OF_RESOURCES;
+  }
+  return CL_SUCCESS;
+}
+
 void _cl_command_queue::userEventDispatch(cl_event user_event,
                                           cl_int event_command_exec_status,
                                           void *user_data) {
@@ -1038,12 +1127,69 @@ void _cl_command_queue::finish_state_t::clear(
   if (locked) {
     command_queue->finish_state.erase(command_buffer);
   } else {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    // Don't flush the command queue's dependencies from a mux completion
+    // callback, only the state's own entry needs the lock.
+    std::lock_guard<std::mutex> lock(command_queue->mutex);
     command_queue->finish_state.erase(command_buffer);
   }
 }
 
+cl::command_queue_lock::command_queue_lock(
+    cl_command_queue command_queue,
+    cargo::array_view<const cl_event> event_wait_list)
+    : command_queue(command_queue), event_wait_list(event_wait_list) {
+  for (auto queue = next(nullptr); queue; queue = next(queue)) {
+    queue->mutex.lock();
+  }
+}
+
+cl::command_queue_lock::~command_queue_lock() {
+  bool has_flush_dependencies = false;
+  for (auto queue = next(nullptr); queue; queue = next(queue)) {
+    has_flush_dependencies |= !queue->flush_dependencies.empty();
+    queue->mutex.unlock();
+  }
+  if (!has_flush_dependencies) {
+    return;
+  }
+
+  // Flush the command queues the locked ones depend on, each is only locked
+  // while it is flushed and may in turn flush its own dependencies.
+  for (auto queue = next(nullptr); queue; queue = next(queue)) {
+    cargo::small_vector<cl_command_queue, 4> dependencies;
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      dependencies.swap(queue->flush_dependencies);
+    }
+    for (auto dependency : dependencies) {
+      {
+        command_queue_lock lock(dependency);
+        dependency->flush();
+      }
+      cl::releaseInternal(dependency);
+    }
+  }
+}
+
+cl_command_queue cl::command_queue_lock::next(
+    cl_command_queue previous) const {
+  // Wait lists are short and rarely span more than a couple of command queues,
+  // so scanning them for each queue is cheaper than sorting a copy.
+  const std::less<cl_command_queue> less;
+  cl_command_queue next = nullptr;
+  auto consider = [&](cl_command_queue queue) {
+    if (queue && (!previous || less(previous, queue)) &&
+        (!next || less(queue, next))) {
+      next = queue;
+    }
+  };
+  consider(command_queue);
+  for (auto event : event_wait_list) {
+    consider(event->queue);
+  }
+  return next;
+}
+
 CL_API_ENTRY cl_command_queue CL_API_CALL cl::CreateCommandQueue(
     cl_context context, cl_device_id device_id,
     cl_command_queue_properties properties, cl_int *errcode_ret) {
@@ -1083,8 +1229,7 @@ cl::ReleaseCommandQueue(cl_command_queue command_queue) {
       command_queue->refCountInternal()) {
     command_queue->finish();
   } else {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue);
 
     // releasing a command queue causes an implicit flush
     if (auto error = command_queue->flush()) {
@@ -1162,26 +1307,35 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueBarrierWithWaitList(
       num_events_in_wait_list, event_wait_list, command_queue->context, event);
   OCL_CHECK(error != CL_SUCCESS, return error);
 
+  // barriers are implicit in in-order queues, could mostly be a no-op
+  // (especially if we don't have a return event!)
+  if (nullptr == event && !command_queue->isOutOfOrder()) {
+    return CL_SUCCESS;
+  }
+
+  cl_event barrier_event = nullptr;
   if (nullptr != event) {
     auto new_event = _cl_event::create(command_queue, CL_COMMAND_BARRIER);
     if (!new_event) {
       return new_event.error();
     }
     *event = *new_event;
+    barrier_event = *new_event;
+  }
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                             {event_wait_list, num_events_in_wait_list});
 
-    // barriers are implicit in in-order queues, could mostly be a no-op
-    // (especially if we don't have a return event!)
-    auto command_buffer = command_queue->getCommandBuffer(
-        {event_wait_list, num_events_in_wait_list}, *event);
-    if (!command_buffer) {
-      return CL_OUT_OF_RESOURCES;
-    }
+  // On an out-of-order queue the barrier waits for all previous commands when
+  // there is no wait list, and all later commands wait for the barrier.
+  auto command_buffer = command_queue->getCommandBuffer(
+      {event_wait_list, num_events_in_wait_list}, barrier_event,
+      /* wait_for_all */ 0 == num_events_in_wait_list);
+  if (!command_buffer) {
+    return command_buffer.error();
   }
 
-  return CL_SUCCESS;
+  return command_queue->setBarrier(*command_buffer);
 }
 
 CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueMarkerWithWaitList(
@@ -1201,13 +1355,16 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueMarkerWithWaitList(
     }
     *event = *new_event;
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                               {event_wait_list, num_events_in_wait_list});
 
+    // On an out-of-order queue the marker waits for all previous commands
+    // when there is no wait list.
     auto mux_command_buffer = command_queue->getCommandBuffer(
-        {event_wait_list, num_events_in_wait_list}, *event);
+        {event_wait_list, num_events_in_wait_list}, *event,
+        /* wait_for_all */ 0 == num_events_in_wait_list);
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
   }
 
@@ -1229,28 +1386,34 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueWaitForEvents(
               return CL_INVALID_CONTEXT);
   }
 
-  OCL_CHECK(cl::validate::IsInBitSet(queue->properties,
-                                     CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE),
-            OCL_ABORT("OCL API objects event. Error clEnqueueWaitForEvents "
-                      "does not support out of order execution"));
+  if (!queue->isOutOfOrder()) {
+    // no-op, as our queue is in-order we guarantee that all events are
+    // executed before this could be!
+    return CL_SUCCESS;
+  }
 
-  // no-op, as our queue is in-order we guarantee that all events are executed
-  // before this could be!
+  // On an out-of-order queue later commands must wait for the events, which
+  // is a barrier with a wait list.
+  cl::command_queue_lock lock(queue, {event_list, num_events});
+  auto command_buffer =
+      queue->getCommandBuffer({event_list, num_events}, nullptr);
+  if (!command_buffer) {
+    return command_buffer.error();
+  }
 
-  return CL_SUCCESS;
+  return queue->setBarrier(*command_buffer);
 }
 
 CL_API_ENTRY cl_int CL_API_CALL cl::Flush(cl_command_queue command_queue) {
   tracer::TraceGuard<tracer::OpenCL> guard("clFlush");
   OCL_CHECK(!command_queue, return CL_INVALID_COMMAND_QUEUE);
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue);
   return command_queue->flush();
 }
 
 cl_int _cl_command_queue::finish() {
   {
-    std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+    cl::command_queue_lock lock(this);
     flush();
   }
 
@@ -1259,7 +1422,7 @@ cl_int _cl_command_queue::finish() {
   }
 
   {
-    std::lock_guard<std::mutex> lock(context->getCommandQueueMutex());
+    cl::command_queue_lock lock(this);
     if (CL_SUCCESS != cleanupCompletedCommandBuffers()) {
       return CL_OUT_OF_RESOURCES;
     }
@@ -1287,8 +1450,7 @@ CL_API_ENTRY cl_int CL_API_CALL cl::Finish(cl_command_queue command_queue) {
 
   cl_int result;
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue);
     result = command_queue->flush();
   }
 
@@ -1304,7 +1466,20 @@ CL_API_ENTRY cl_int CL_API_CALL cl::Finish(cl_command_queue command_queue) {
 CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueBarrier(cl_command_queue queue) {
   tracer::TraceGuard<tracer::OpenCL> guard("clEnqueueBarrier");
   OCL_CHECK(!queue, return CL_INVALID_COMMAND_QUEUE);
-  return CL_SUCCESS;
+
+  // Barriers are implicit in in-order queues.
+  if (!queue->isOutOfOrder()) {
+    return CL_SUCCESS;
+  }
+
+  cl::command_queue_lock lock(queue);
+  auto command_buffer =
+      queue->getCommandBuffer({}, nullptr, /* wait_for_all */ true);
+  if (!command_buffer) {
+    return command_buffer.error();
+  }
+
+  return queue->setBarrier(*command_buffer);
 }
 
 CL_API_ENTRY cl_int CL_API_CALL
@@ -1321,12 +1496,12 @@ cl::EnqueueMarker(cl_command_queue command_queue, cl_event *event) {
     }
     *event = *new_event;
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue);
 
-    auto mux_command_buffer = command_queue->getCommandBuffer({}, *event);
+    auto mux_command_buffer =
+        command_queue->getCommandBuffer({}, *event, /* wait_for_all */ true);
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
   }
 
@@ -1338,9 +1513,15 @@ CARGO_NODISCARD cl_int _cl_command_queue::enqueueCommandBuffer(
     cl_command_buffer_khr command_buffer, cl_uint num_events_in_wait_list,
     const cl_event *event_wait_list, cl_event *return_event) {
   // Lock both queue and command-buffer
-  std::lock_guard<std::mutex> lock_queue(context->getCommandQueueMutex());
+  cl::command_queue_lock lock_queue(this);
   std::lock_guard<std::mutex> lock_command_buffer(command_buffer->mutex);
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  if (capture_command_buffer) {
+    return CL_INVALID_OPERATION;
+  }
+#endif
+
   // Create the signal event if caller asks for it.
   cl_event event = nullptr;
   if (nullptr != return_event) {
@@ -1396,15 +1577,41 @@ CARGO_NODISCARD cl_int _cl_command_queue::enqueueCommandBuffer(
   // directly on the last pending dispatch (we need to do this anyway to enforce
   // an in order queue). Since the queue is in order, we know that any event
   // dependencies requested by the user will still be respected. This will not
-  // work for cross queue event dependencies (see CA-3276).
-  if (!pending_command_buffers.empty()) {
-    auto &signal_semaphore =
-        pending_dispatches[pending_command_buffers.back()].signal_semaphore;
+  // work for cross queue event dependencies (see CA-3276). An out-of-order
+  // queue has no single last dispatch, so instead wait on everything enqueued
+  // before, pending or running, and the last barrier. This respects the event
+  // dependencies even when the event's command has already been dispatched.
+  cargo::small_vector<mux_shared_semaphore, 8> semaphores;
+  if (isOutOfOrder()) {
+    for (auto pending : pending_command_buffers) {
+      if (semaphores.push_back(pending_dispatches[pending].signal_semaphore)) {
+        return CL_OUT_OF_RESOURCES;
+      }
+    }
+    for (auto &running : running_command_buffers) {
+      if (semaphores.push_back(running.signal_semaphore)) {
+        return CL_OUT_OF_RESOURCES;
+      }
+    }
+    if (barrier_semaphore &&
+        std::find(semaphores.begin(), semaphores.end(), barrier_semaphore) ==
+            semaphores.end()) {
+      if (semaphores.push_back(barrier_semaphore)) {
+        return CL_OUT_OF_RESOURCES;
+      }
+    }
+  } else if (!pending_command_buffers.empty()) {
+    auto pending = pending_command_buffers.back();
+    if (semaphores.push_back(pending_dispatches[pending].signal_semaphore)) {
+      return CL_OUT_OF_RESOURCES;
+    }
+  }
+  for (auto &semaphore : semaphores) {
     if (pending_dispatches[mux_command_buffer].wait_semaphores.push_back(
-            signal_semaphore)) {
+            semaphore)) {
       return CL_OUT_OF_RESOURCES;
     } else {
-      signal_semaphore->retain();
+      semaphore->retain();
     }
   }
 
@@ -1443,6 +1650,9 @@ CARGO_NODISCARD cl_int _cl_command_queue::enqueueCommandBuffer(
     }
     return CL_OUT_OF_RESOURCES;
   }
+  if (event) {
+    pending_signal_events[event] = mux_command_buffer;
+  }
 
   // Add callbacks to all the user events in the wait list.
   for (unsigned i = 0; i < num_events_in_wait_list; ++i) {
@@ -1450,8 +1660,8 @@ CARGO_NODISCARD cl_int _cl_command_queue::enqueueCommandBuffer(
     // Do not wait on completed commands.
     if (cl::isUserEvent(wait_event) &&
         wait_event->command_status != CL_COMPLETE) {
-      if (!wait_event->addCallback(CL_COMPLETE, &userEventDispatch, this)) {
-        return CL_OUT_OF_RESOURCES;
+      if (auto error = addUserEventCallback(wait_event)) {
+        return error;
       }
     }
   }
@@ -78,6 +78,10 @@ _cl_context::~_cl_context() {
   // The compiler context must be destroyed before we release the internal
   // references to the devices within the context.
   compiler_context.reset();
+#ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
+  // Pooled USM blocks hold Mux objects created on the context's devices.
+  usm_pool.clear(this);
+#endif
   // In applications which release the context in a global variables destructor
   // releasing the devices here may cause them to be destroyed at this point if
   // their internal reference count is 1, therefore any objects in the context
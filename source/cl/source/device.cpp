@@ -187,7 +187,8 @@ _cl_device_id::_cl_device_id(cl_platform_id platform,
       preferred_interop_user_sync(CL_TRUE),
       profile(),
       profiling_timer_resolution(5),                // Get from Mux?
-      queue_properties(CL_QUEUE_PROFILING_ENABLE),  // Get from Mux?
+      queue_properties(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE |
+                       CL_QUEUE_PROFILING_ENABLE),  // Get from Mux?
       reference_count(1),  // All devices are root devices.
       single_fp_config(setOpenCLFromMux(mux_device->info->float_capabilities)),
       type(),
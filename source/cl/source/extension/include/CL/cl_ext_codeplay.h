@@ -18,6 +18,7 @@
 #define CL_EXT_CODEPLAY_H_INCLUDED
 
 #include <CL/cl.h>
+#include <CL/cl_ext.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,108 @@ typedef CL_API_ENTRY cl_int(CL_API_CALL *clSetKernelExecInfoCODEPLAY_fn)(
     size_t param_value_size,
     const void *param_value) CL_API_SUFFIX__VERSION_1_2;
 
+/*******************************
+ * cl_codeplay_set_kernel_args *
+ *******************************/
+
+/// @brief Value of a single kernel argument passed to
+/// `clSetKernelArgsCODEPLAY`, the members match the parameters of
+/// `clSetKernelArg`.
+typedef struct _cl_kernel_arg_codeplay {
+  /// @brief Index of the argument to set.
+  cl_uint arg_index;
+  /// @brief Size in bytes of the value pointed to by `arg_value`.
+  size_t arg_size;
+  /// @brief Pointer to the argument value.
+  const void *arg_value;
+} cl_kernel_arg_codeplay;
+
+/// @brief Set several kernel arguments in a single call.
+///
+/// Each element of `args` is validated and set as if by `clSetKernelArg`, in
+/// order, stopping at the first error. When every argument of the kernel has
+/// been set the argument descriptors are prepared up front so that subsequent
+/// enqueues of the kernel don't need to build them again.
+///
+/// @param[in] kernel Kernel to set the arguments of.
+/// @param[in] num_args Number of elements in `args`.
+/// @param[in] args Array of argument values to set.
+///
+/// @return Returns `CL_SUCCESS`, `CL_INVALID_KERNEL` if `kernel` is not a
+/// valid kernel, `CL_INVALID_VALUE` if `num_args` is zero or `args` is null,
+/// or any error code returned by `clSetKernelArg`.
+extern CL_API_ENTRY cl_int CL_API_CALL
+clSetKernelArgsCODEPLAY(cl_kernel kernel, cl_uint num_args,
+                        const cl_kernel_arg_codeplay *args);
+
+typedef CL_API_ENTRY cl_int(CL_API_CALL *clSetKernelArgsCODEPLAY_fn)(
+    cl_kernel kernel, cl_uint num_args,
+    const cl_kernel_arg_codeplay *args) CL_API_SUFFIX__VERSION_1_2;
+
+/***************************************
+ * cl_codeplay_command_buffer_capture *
+ ***************************************/
+
+/// @brief Begin capturing commands enqueued to a command-queue into a
+/// command-buffer.
+///
+/// While capturing, `clEnqueueNDRangeKernel`, `clEnqueueCopyBuffer` and
+/// `clEnqueueFillBuffer` calls on `command_queue` are recorded into
+/// `command_buffer` instead of being executed, all other enqueue commands
+/// return `CL_INVALID_OPERATION`. Captured commands may not have an event wait
+/// list or return an event. On an in-order queue each captured command depends
+/// on the previously captured command.
+///
+/// @param[in] command_queue Command-queue to capture, it must be the queue
+/// `command_buffer` was created with.
+/// @param[in] command_buffer Command-buffer to record into, it must not be
+/// finalized.
+///
+/// @return CL_SUCCESS if the function is executed successfully.
+/// Otherwise, it returns one of the following errors:
+/// * CL_INVALID_COMMAND_QUEUE if command_queue is not a valid command-queue or
+/// is not the command-queue command_buffer was created with.
+/// * CL_INVALID_COMMAND_BUFFER_KHR if command_buffer is not a valid
+/// command-buffer.
+/// * CL_INVALID_OPERATION if command_buffer is finalized or command_queue is
+/// already capturing.
+extern CL_API_ENTRY cl_int CL_API_CALL clCommandBufferBeginCaptureCODEPLAY(
+    cl_command_queue command_queue, cl_command_buffer_khr command_buffer);
+
+typedef CL_API_ENTRY cl_int(
+    CL_API_CALL *clCommandBufferBeginCaptureCODEPLAY_fn)(
+    cl_command_queue command_queue, cl_command_buffer_khr command_buffer);
+
+/// @brief End capturing commands and finalize the captured command-buffer.
+///
+/// If the command-buffer was created with `CL_COMMAND_BUFFER_MUTABLE_KHR` the
+/// mutable-command handles of the captured kernel commands are returned in
+/// capture order, these can be passed to `clUpdateMutableCommandsKHR` to update
+/// kernel arguments before the command-buffer is enqueued again.
+///
+/// @param[in] command_queue Command-queue which is capturing.
+/// @param[in] num_mutable_handles Number of elements in mutable_handles.
+/// @param[out] mutable_handles Array to store the mutable-command handles of
+/// the captured kernel commands in, may be NULL.
+/// @param[out] num_mutable_handles_ret Returns the number of captured
+/// mutable-command handles, may be NULL.
+///
+/// @return CL_SUCCESS if the function is executed successfully.
+/// Otherwise, it returns one of the following errors:
+/// * CL_INVALID_COMMAND_QUEUE if command_queue is not a valid command-queue.
+/// * CL_INVALID_OPERATION if command_queue is not capturing.
+/// * CL_INVALID_VALUE if mutable_handles is not NULL and num_mutable_handles
+/// is less than the number of captured mutable-command handles, in which case
+/// capturing continues.
+/// * Any error returned by `clFinalizeCommandBufferKHR`.
+extern CL_API_ENTRY cl_int CL_API_CALL clCommandBufferEndCaptureCODEPLAY(
+    cl_command_queue command_queue, cl_uint num_mutable_handles,
+    cl_mutable_command_khr *mutable_handles, cl_uint *num_mutable_handles_ret);
+
+typedef CL_API_ENTRY cl_int(CL_API_CALL *clCommandBufferEndCaptureCODEPLAY_fn)(
+    cl_command_queue command_queue, cl_uint num_mutable_handles,
+    cl_mutable_command_khr *mutable_handles, cl_uint *num_mutable_handles_ret);
+
 /************************************
  * cl_codeplay_performance_counter   *
  ************************************/
@@ -357,6 +460,32 @@ typedef cl_int(CL_API_CALL *clGetKernelWFVInfoCODEPLAY_fn)(
     cl_kernel_wfv_info_codeplay param_name, size_t param_value_size,
     void *param_value, size_t *param_value_size_ret);
 
+/*************************************
+ * cl_intel_unified_shared_memory pool *
+ *************************************/
+
+/// @brief Accepted as `param_name` parameter to `clGetContextInfo` when the
+/// context supports `cl_intel_unified_shared_memory`, returns a
+/// `cl_usm_pool_statistics_codeplay` describing the context's USM pool.
+///
+/// The pool retains the memory of freed USM allocations of up to 1MiB so it
+/// can be reused by later allocations. The number of bytes retained can be
+/// limited with the `CA_CL_USM_POOL_SIZE` environment variable, a value of zero
+/// disables pooling.
+#define CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY 0x4263
+
+/// @brief Result of a `CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY` query.
+typedef struct _cl_usm_pool_statistics_codeplay {
+  /// @brief Number of allocations satisfied from the pool.
+  cl_ulong hits;
+  /// @brief Number of poolable allocations not satisfied from the pool.
+  cl_ulong misses;
+  /// @brief Number of freed blocks currently retained by the pool.
+  cl_ulong cached_blocks;
+  /// @brief Total size in bytes of freed blocks retained by the pool.
+  cl_ulong cached_bytes;
+} cl_usm_pool_statistics_codeplay;
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -0,0 +1,108 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+/// @file
+///
+/// @brief Implementation of `cl_codeplay_command_buffer_capture` extension.
+
+#ifndef EXTENSION_CODEPLAY_COMMAND_BUFFER_CAPTURE_H_INCLUDED
+#define EXTENSION_CODEPLAY_COMMAND_BUFFER_CAPTURE_H_INCLUDED
+
+#include <CL/cl_ext_codeplay.h>
+#include <cargo/optional.h>
+#include <extension/extension.h>
+
+namespace extension {
+/// @addtogroup cl_extension
+/// @{
+
+/// @brief Definition of cl_codeplay_command_buffer_capture extension.
+struct codeplay_command_buffer_capture : extension {
+  /// @brief Default constructor.
+  codeplay_command_buffer_capture();
+
+  /// @brief Queries for the extension function associated with func_name.
+  ///
+  /// If extension is enabled, then makes the following extension functions
+  /// query-able:
+  /// * "clCommandBufferBeginCaptureCODEPLAY"
+  /// * "clCommandBufferEndCaptureCODEPLAY"
+  ///
+  /// @see clGetExtensionFunctionAddressForPlatform.
+  ///
+  /// @param[in] platform OpenCL platform func_name belongs to.
+  /// @param[in] func_name name of the extension function to query for.
+  ///
+  /// @return Returns a pointer to the extension function or nullptr if no
+  /// function with the name func_name exists.
+  void *GetExtensionFunctionAddressForPlatform(
+      cl_platform_id platform, const char *func_name) const override;
+};
+
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+/// @brief Record a kernel enqueue into the command-buffer being captured.
+///
+/// Called by `clEnqueueNDRangeKernel` once the arguments have been validated.
+///
+/// @param[in] command_queue Command queue the kernel was enqueued on.
+/// @param[in] kernel Kernel to record.
+/// @param[in] work_dim Number of work dimensions.
+/// @param[in] global_work_offset Global offset, may be null.
+/// @param[in] global_work_size Global size.
+/// @param[in] local_work_size Local size, may be null.
+/// @param[in] num_events_in_wait_list Number of events in event_wait_list.
+/// @param[in] event Return event requested by the user, may be null.
+///
+/// @return Returns `cargo::nullopt` if `command_queue` is not capturing and
+/// the kernel should be enqueued as normal, otherwise `CL_SUCCESS` or an
+/// appropriate OpenCL error code.
+cargo::optional<cl_int> CaptureNDRangeKernel(
+    cl_command_queue command_queue, cl_kernel kernel, cl_uint work_dim,
+    const size_t *global_work_offset, const size_t *global_work_size,
+    const size_t *local_work_size, cl_uint num_events_in_wait_list,
+    cl_event *event);
+
+/// @brief Record a buffer copy into the command-buffer being captured.
+///
+/// Called by `clEnqueueCopyBuffer` once the arguments have been validated.
+///
+/// @return Returns `cargo::nullopt` if `command_queue` is not capturing and
+/// the copy should be enqueued as normal, otherwise `CL_SUCCESS` or an
+/// appropriate OpenCL error code.
+cargo::optional<cl_int> CaptureCopyBuffer(
+    cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer,
+    size_t src_offset, size_t dst_offset, size_t size,
+    cl_uint num_events_in_wait_list, cl_event *event);
+
+/// @brief Record a buffer fill into the command-buffer being captured.
+///
+/// Called by `clEnqueueFillBuffer` once the arguments have been validated.
+///
+/// @return Returns `cargo::nullopt` if `command_queue` is not capturing and
+/// the fill should be enqueued as normal, otherwise `CL_SUCCESS` or an
+/// appropriate OpenCL error code.
+cargo::optional<cl_int> CaptureFillBuffer(cl_command_queue command_queue,
+                                          cl_mem buffer, const void *pattern,
+                                          size_t pattern_size, size_t offset,
+                                          size_t size,
+                                          cl_uint num_events_in_wait_list,
+                                          cl_event *event);
+#endif
+
+/// @}
+}  // namespace extension
+
+#endif  // EXTENSION_CODEPLAY_COMMAND_BUFFER_CAPTURE_H_INCLUDED
@@ -28,7 +28,10 @@
 #include <extension/extension.h>
 #include <mux/mux.h>
 
+#include <map>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace extension {
 /// @addtogroup cl_extension
@@ -48,6 +51,11 @@ class intel_unified_shared_memory final : public extension {
                        size_t param_value_size, void *param_value,
                        size_t *param_value_size_ret) const override;
 
+  /// @copydoc extension::extension::GetContextInfo
+  cl_int GetContextInfo(cl_context context, cl_context_info param_name,
+                        size_t param_value_size, void *param_value,
+                        size_t *param_value_size_ret) const override;
+
 #if (defined(CL_VERSION_3_0) || \
      defined(OCL_EXTENSION_cl_codeplay_kernel_exec_info))
   /// @copydoc extension::extension::SetKernelExecInfo
@@ -127,6 +135,9 @@ class allocation_info {
   const cl_context context;
   /// @brief Size in bytes of the requested device allocation.
   size_t size;
+  /// @brief Size in bytes of the pool block backing the allocation, or zero
+  /// if the allocation is too large to be pooled.
+  size_t block_size;
   /// @brief Pointer returned by USM allocation entry points
   void *base_ptr;
   /// @brief Properties set on allocation
@@ -254,6 +265,137 @@ class device_allocation_info final : public allocation_info {
   mux_buffer_t mux_buffer;
 };
 
+/// @brief Per-context cache of the memory backing freed USM allocations.
+///
+/// Pooled allocations are rounded up to a power of two size class and when
+/// freed their host memory and Mux objects are kept here, rather than being
+/// destroyed, so a later allocation of the same size class on the same device
+/// can reuse them without calling into Mux. Device allocations are bucketed
+/// per device, host allocations are shared by every device in the context.
+class allocation_pool {
+ public:
+  /// @brief Smallest size class, smaller allocations are rounded up to this.
+  static constexpr size_t min_block_size = 256;
+  /// @brief Largest size class, larger allocations bypass the pool.
+  static constexpr size_t max_block_size = 1 << 20;
+  /// @brief Default limit on the bytes of freed memory retained by a pool,
+  /// overridden by the `CA_CL_USM_POOL_SIZE` environment variable.
+  static constexpr size_t default_retain_limit = 16 << 20;
+
+  /// @brief Memory and Mux objects backing a device allocation.
+  struct device_block {
+    mux_memory_t mux_memory = nullptr;
+    mux_buffer_t mux_buffer = nullptr;
+  };
+
+  /// @brief Memory and Mux objects backing a host allocation.
+  struct host_block {
+    void *base_ptr = nullptr;
+    cargo::dynamic_array<mux_memory_t> mux_memories;
+    cargo::dynamic_array<mux_buffer_t> mux_buffers;
+  };
+
+  /// @brief Pool statistics, reported by
+  /// `CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY`.
+  struct statistics {
+    /// @brief Number of allocations satisfied from the pool.
+    uint64_t hits = 0;
+    /// @brief Number of poolable allocations which had to call into Mux.
+    uint64_t misses = 0;
+    /// @brief Number of freed blocks currently retained.
+    uint64_t cached_blocks = 0;
+    /// @brief Total size in bytes of freed blocks currently retained.
+    uint64_t cached_bytes = 0;
+  };
+
+  /// @brief Constructor, reads the retention limit from the environment.
+  allocation_pool();
+
+  allocation_pool(const allocation_pool &) = delete;
+
+  /// @brief Returns the size class an allocation of `size` bytes belongs to.
+  ///
+  /// @param[in] size Requested size of the allocation in bytes.
+  ///
+  /// @return Size of the pool block, or zero if `size` is too large to be
+  /// pooled or pooling is disabled.
+  size_t getBlockSize(size_t size) const;
+
+  /// @brief Takes a freed device block of `block_size` bytes from the pool.
+  ///
+  /// @param[in] device Device the block must have been allocated on.
+  /// @param[in] block_size Size class returned by `getBlockSize()`.
+  /// @param[out] block Block to reuse, only written on success.
+  ///
+  /// @return True if a block was found, false if the caller must allocate.
+  bool acquire(cl_device_id device, size_t block_size, device_block &block);
+
+  /// @brief Takes a freed host block of `block_size` bytes from the pool.
+  ///
+  /// @param[in] block_size Size class returned by `getBlockSize()`.
+  /// @param[out] block Block to reuse, only written on success.
+  ///
+  /// @return True if a block was found, false if the caller must allocate.
+  bool acquire(size_t block_size, host_block &block);
+
+  /// @brief Returns a device block to the pool.
+  ///
+  /// @param[in] device Device the block was allocated on.
+  /// @param[in] block_size Size class of the block.
+  /// @param[in] block Block to retain.
+  ///
+  /// @return True if the pool took ownership of the block, false if the
+  /// retention limit was reached and the caller must destroy it.
+  bool release(cl_device_id device, size_t block_size,
+               const device_block &block);
+
+  /// @brief Returns a host block to the pool.
+  ///
+  /// @param[in] block_size Size class of the block.
+  /// @param[in,out] block Block to retain, moved from on success.
+  ///
+  /// @return True if the pool took ownership of the block, false if the
+  /// retention limit was reached and the caller must destroy it.
+  bool release(size_t block_size, host_block &block);
+
+  /// @brief Destroys all retained blocks.
+  ///
+  /// Must be called before the context releases its devices.
+  ///
+  /// @param[in] context Context owning the pool.
+  void clear(cl_context context);
+
+  /// @brief Returns a snapshot of the pool statistics.
+  statistics getStatistics();
+
+ private:
+  /// @brief Mutex protecting the members below.
+  std::mutex mutex;
+  /// @brief Maximum number of bytes retained in `device_blocks` and
+  /// `host_blocks` combined, zero disables pooling.
+  size_t retain_limit;
+  /// @brief Pool statistics.
+  statistics stats;
+  /// @brief Freed device blocks keyed on device and size class.
+  std::map<std::pair<cl_device_id, size_t>, std::vector<device_block>>
+      device_blocks;
+  /// @brief Freed host blocks keyed on size class.
+  std::map<size_t, std::vector<host_block>> host_blocks;
+};
+
+/// @brief Destroys the Mux objects backing a device allocation.
+///
+/// @param[in] device Device the objects were created on.
+/// @param[in] block Block to destroy.
+void destroyBlock(cl_device_id device,
+                  const allocation_pool::device_block &block);
+
+/// @brief Destroys the host memory and Mux objects backing a host allocation.
+///
+/// @param[in] context Context whose devices the Mux objects were created on.
+/// @param[in] block Block to destroy.
+void destroyBlock(cl_context context, allocation_pool::host_block &block);
+
 /// @brief Validates properties passed to the USM allocation entry points for
 /// correctness, returning memory allocation flags so they can be stored for
 /// later user queries.
@@ -0,0 +1,220 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <CL/cl.h>
+#include <CL/cl_ext.h>
+#include <CL/cl_ext_codeplay.h>
+#include <cl/command_queue.h>
+#include <cl/context.h>
+#include <cl/macros.h>
+#include <extension/codeplay_command_buffer_capture.h>
+#include <tracer/tracer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+extension::codeplay_command_buffer_capture::codeplay_command_buffer_capture()
+    : extension("cl_codeplay_command_buffer_capture",
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+                usage_category::DEVICE
+#else
+                usage_category::DISABLED
+#endif
+                    CA_CL_EXT_VERSION(0, 1, 0)) {
+}
+
+void *extension::codeplay_command_buffer_capture::
+    GetExtensionFunctionAddressForPlatform(cl_platform_id platform,
+                                           const char *func_name) const {
+  OCL_UNUSED(platform);
+
+#ifndef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  OCL_UNUSED(func_name);
+  return nullptr;
+#else
+  if (func_name &&
+      0 == std::strcmp("clCommandBufferBeginCaptureCODEPLAY", func_name)) {
+    return reinterpret_cast<void *>(&clCommandBufferBeginCaptureCODEPLAY);
+  } else if (func_name &&
+             0 == std::strcmp("clCommandBufferEndCaptureCODEPLAY", func_name)) {
+    return reinterpret_cast<void *>(&clCommandBufferEndCaptureCODEPLAY);
+  }
+  return nullptr;
+#endif
+}
+
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+namespace {
+/// @brief Record a command into the command-buffer a queue is capturing.
+///
+/// @tparam Record Callable with signature `cl_int(cl_command_buffer_khr,
+/// cl_uint, const cl_sync_point_khr *, cl_sync_point_khr *)` which records the
+/// command with the given sync-point wait list.
+///
+/// @return Returns `cargo::nullopt` if `command_queue` is not capturing,
+/// otherwise the result of recording the command.
+template <class Record>
+cargo::optional<cl_int> captureCommand(cl_command_queue command_queue,
+                                       cl_uint num_events_in_wait_list,
+                                       cl_event *event, Record &&record) {
+  cl::command_queue_lock lock(command_queue);
+  auto command_buffer = command_queue->capture_command_buffer;
+  if (!command_buffer) {
+    return cargo::nullopt;
+  }
+
+  // Captured commands only execute when the command-buffer is enqueued, so
+  // there is nothing to associate events with at this point.
+  if (num_events_in_wait_list || event) {
+    return CL_INVALID_OPERATION;
+  }
+
+  // Chain each command after the previously captured command to preserve the
+  // in-order semantics the commands were enqueued with.
+  const cl_sync_point_khr *wait_list = nullptr;
+  if (command_queue->capture_sync_point && !command_queue->isOutOfOrder()) {
+    wait_list = &*command_queue->capture_sync_point;
+  }
+
+  cl_sync_point_khr sync_point = 0;
+  if (auto error =
+          record(command_buffer, wait_list ? 1 : 0, wait_list, &sync_point)) {
+    return error;
+  }
+  command_queue->capture_sync_point = sync_point;
+  return CL_SUCCESS;
+}
+}  // namespace
+
+cargo::optional<cl_int> extension::CaptureNDRangeKernel(
+    cl_command_queue command_queue, cl_kernel kernel, cl_uint work_dim,
+    const size_t *global_work_offset, const size_t *global_work_size,
+    const size_t *local_work_size, cl_uint num_events_in_wait_list,
+    cl_event *event) {
+  return captureCommand(
+      command_queue, num_events_in_wait_list, event,
+      [&](cl_command_buffer_khr command_buffer, cl_uint num_sync_points,
+          const cl_sync_point_khr *sync_point_wait_list,
+          cl_sync_point_khr *sync_point) -> cl_int {
+        cl_mutable_command_khr mutable_handle = nullptr;
+        cl_mutable_command_khr *mutable_handle_ptr = nullptr;
+#ifdef OCL_EXTENSION_cl_khr_command_buffer_mutable_dispatch
+        if (command_buffer->isMutable()) {
+          mutable_handle_ptr = &mutable_handle;
+        }
+#endif
+        if (auto error = clCommandNDRangeKernelKHR(
+                command_buffer, nullptr, nullptr, kernel, work_dim,
+                global_work_offset, global_work_size, local_work_size,
+                num_sync_points, sync_point_wait_list, sync_point,
+                mutable_handle_ptr)) {
+          return error;
+        }
+        if (mutable_handle &&
+            command_queue->capture_mutable_handles.push_back(mutable_handle)) {
+          return CL_OUT_OF_HOST_MEMORY;
+        }
+        return CL_SUCCESS;
+      });
+}
+
+cargo::optional<cl_int> extension::CaptureCopyBuffer(
+    cl_command_queue command_queue, cl_mem src_buffer, cl_mem dst_buffer,
+    size_t src_offset, size_t dst_offset, size_t size,
+    cl_uint num_events_in_wait_list, cl_event *event) {
+  return captureCommand(
+      command_queue, num_events_in_wait_list, event,
+      [&](cl_command_buffer_khr command_buffer, cl_uint num_sync_points,
+          const cl_sync_point_khr *sync_point_wait_list,
+          cl_sync_point_khr *sync_point) {
+        return clCommandCopyBufferKHR(command_buffer, nullptr, src_buffer,
+                                      dst_buffer, src_offset, dst_offset, size,
+                                      num_sync_points, sync_point_wait_list,
+                                      sync_point, nullptr);
+      });
+}
+
+cargo::optional<cl_int> extension::CaptureFillBuffer(
+    cl_command_queue command_queue, cl_mem buffer, const void *pattern,
+    size_t pattern_size, size_t offset, size_t size,
+    cl_uint num_events_in_wait_list, cl_event *event) {
+  return captureCommand(
+      command_queue, num_events_in_wait_list, event,
+      [&](cl_command_buffer_khr command_buffer, cl_uint num_sync_points,
+          const cl_sync_point_khr *sync_point_wait_list,
+          cl_sync_point_khr *sync_point) {
+        return clCommandFillBufferKHR(command_buffer, nullptr, buffer, pattern,
+                                      pattern_size, offset, size,
+                                      num_sync_points, sync_point_wait_list,
+                                      sync_point, nullptr);
+      });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL clCommandBufferBeginCaptureCODEPLAY(
+    cl_command_queue command_queue, cl_command_buffer_khr command_buffer) {
+  tracer::TraceGuard<tracer::OpenCL> guard(
+      "clCommandBufferBeginCaptureCODEPLAY");
+  OCL_CHECK(!command_queue, return CL_INVALID_COMMAND_QUEUE);
+  OCL_CHECK(!command_buffer, return CL_INVALID_COMMAND_BUFFER_KHR);
+  OCL_CHECK(command_buffer->command_queue != command_queue,
+            return CL_INVALID_COMMAND_QUEUE);
+
+  cl::command_queue_lock lock(command_queue);
+  OCL_CHECK(command_queue->capture_command_buffer,
+            return CL_INVALID_OPERATION);
+  {
+    std::lock_guard<std::mutex> lock_command_buffer(command_buffer->mutex);
+    OCL_CHECK(command_buffer->is_finalized, return CL_INVALID_OPERATION);
+  }
+
+  command_queue->capture_command_buffer = command_buffer;
+  command_queue->capture_sync_point = cargo::nullopt;
+  command_queue->capture_mutable_handles.clear();
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL clCommandBufferEndCaptureCODEPLAY(
+    cl_command_queue command_queue, cl_uint num_mutable_handles,
+    cl_mutable_command_khr *mutable_handles, cl_uint *num_mutable_handles_ret) {
+  tracer::TraceGuard<tracer::OpenCL> guard("clCommandBufferEndCaptureCODEPLAY");
+  OCL_CHECK(!command_queue, return CL_INVALID_COMMAND_QUEUE);
+
+  cl_command_buffer_khr command_buffer = nullptr;
+  {
+    cl::command_queue_lock lock(command_queue);
+    command_buffer = command_queue->capture_command_buffer;
+    OCL_CHECK(!command_buffer, return CL_INVALID_OPERATION);
+
+    const auto &handles = command_queue->capture_mutable_handles;
+    OCL_CHECK(mutable_handles && num_mutable_handles < handles.size(),
+              return CL_INVALID_VALUE);
+    if (mutable_handles) {
+      std::copy(handles.begin(), handles.end(), mutable_handles);
+    }
+    OCL_SET_IF_NOT_NULL(num_mutable_handles_ret,
+                        static_cast<cl_uint>(handles.size()));
+
+    command_queue->capture_command_buffer = nullptr;
+    command_queue->capture_sync_point = cargo::nullopt;
+    command_queue->capture_mutable_handles.clear();
+  }
+
+  // Finalizing takes the command-buffer's lock so is done after the command
+  // queue is no longer capturing.
+  return clFinalizeCommandBufferKHR(command_buffer);
+}
+#endif  // OCL_EXTENSION_cl_codeplay_command_buffer_capture
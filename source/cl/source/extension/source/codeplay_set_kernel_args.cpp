@@ -0,0 +1,67 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <CL/cl.h>
+#include <CL/cl_ext.h>
+#include <CL/cl_ext_codeplay.h>
+#include <cl/kernel.h>
+#include <extension/codeplay_set_kernel_args.h>
+#include <tracer/tracer.h>
+
+#include <cstring>
+
+extension::codeplay_set_kernel_args::codeplay_set_kernel_args()
+    : extension("cl_codeplay_set_kernel_args",
+#ifdef OCL_EXTENSION_cl_codeplay_set_kernel_args
+                usage_category::PLATFORM
+#else
+                usage_category::DISABLED
+#endif
+                    CA_CL_EXT_VERSION(0, 1, 0)) {
+}
+
+void* extension::codeplay_set_kernel_args::
+    GetExtensionFunctionAddressForPlatform(cl_platform_id platform,
+                                           const char* func_name) const {
+  OCL_UNUSED(platform);
+
+#ifndef OCL_EXTENSION_cl_codeplay_set_kernel_args
+  OCL_UNUSED(func_name);
+  return nullptr;
+#else
+  if (func_name && 0 == strcmp("clSetKernelArgsCODEPLAY", func_name)) {
+    return (void*)&clSetKernelArgsCODEPLAY;
+  }
+  return nullptr;
+#endif
+}
+
+cl_int CL_API_CALL clSetKernelArgsCODEPLAY(cl_kernel kernel, cl_uint num_args,
+                                           const cl_kernel_arg_codeplay* args) {
+  tracer::TraceGuard<tracer::OpenCL> guard("clSetKernelArgsCODEPLAY");
+  OCL_CHECK(!kernel, return CL_INVALID_KERNEL);
+  OCL_CHECK(0 == num_args || !args, return CL_INVALID_VALUE);
+
+  for (cl_uint i = 0; i < num_args; i++) {
+    const cl_int error =
+        kernel->setArg(args[i].arg_index, args[i].arg_size, args[i].arg_value);
+    OCL_CHECK(error != CL_SUCCESS, return error);
+  }
+
+  // Prepare the descriptors now that all arguments are known so that
+  // enqueuing the kernel only has to copy them.
+  return kernel->cacheArgDescriptors();
+}
@@ -22,6 +22,8 @@
 #include <cl/program.h>
 #include <extension/intel_unified_shared_memory.h>
 
+#include <cstdlib>
+
 namespace extension {
 #ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
 namespace usm {
@@ -73,18 +75,19 @@ cargo::expected<cl_mem_alloc_flags_intel, cl_int> parseProperties(
 }
 
 allocation_info* findAllocation(const cl_context context, const void* ptr) {
-  // Lock context to ensure usm allocation iterators are valid
-  std::lock_guard<std::mutex> context_guard(context->mutex);
-
-  auto ownsUsmPtr = [ptr](const std::unique_ptr<allocation_info>& usm_alloc) {
-    return usm_alloc->isOwnerOf(ptr);
-  };
-
-  auto usm_alloc_itr = std::find_if(context->usm_allocations.begin(),
-                                    context->usm_allocations.end(), ownsUsmPtr);
+  // Lookups only need shared access, allowing them to run concurrently
+  const std::shared_lock<std::shared_mutex> usm_guard(context->usm_mutex);
+
+  // Allocations are disjoint, so only the last allocation starting at or
+  // before `ptr` can own it.
+  auto usm_alloc_itr = context->usm_allocations.upper_bound(ptr);
+  if (usm_alloc_itr == context->usm_allocations.begin()) {
+    return nullptr;
+  }
+  --usm_alloc_itr;
 
-  const bool found = usm_alloc_itr != context->usm_allocations.end();
-  return found ? usm_alloc_itr->get() : nullptr;
+  allocation_info* usm_alloc = usm_alloc_itr->second.get();
+  return usm_alloc->isOwnerOf(ptr) ? usm_alloc : nullptr;
 }
 
 bool deviceSupportsDeviceAllocations(cl_device_id device) {
@@ -158,7 +161,9 @@ cl_int createBlockingEventForKernel(cl_command_queue queue, cl_kernel kernel,
     // Kernel may access any device USM alloc
     const bool device_flag_set = kernel->kernel_exec_info_usm_flags &
                                  kernel_exec_info_indirect_device_access;
-    for (auto& usm_alloc : context->usm_allocations) {
+    const std::shared_lock<std::shared_mutex> usm_guard(context->usm_mutex);
+    for (auto& usm_entry : context->usm_allocations) {
+      auto& usm_alloc = usm_entry.second;
       const bool host_alloc = nullptr == usm_alloc->getDevice();
 
       const bool is_indirect_alloc =
@@ -174,7 +179,11 @@ cl_int createBlockingEventForKernel(cl_command_queue queue, cl_kernel kernel,
 }
 
 allocation_info::allocation_info(const cl_context context, const size_t size)
-    : context(context), size(size), base_ptr(nullptr), alloc_flags(0) {
+    : context(context),
+      size(size),
+      block_size(0),
+      base_ptr(nullptr),
+      alloc_flags(0) {
   cl::retainInternal(context);
 }
 
@@ -193,31 +202,148 @@ mux_result_t allocation_info::record_event(cl_event event) {
   return queued_commands.push_back(event);
 }
 
-host_allocation_info::host_allocation_info(const cl_context context,
-                                           const size_t size)
-    : allocation_info(context, size) {}
+allocation_pool::allocation_pool() : retain_limit(default_retain_limit) {
+  // Allow the amount of memory kept alive by the pool to be tuned, or the pool
+  // to be disabled entirely by setting the limit to zero.
+  if (const char* env = std::getenv("CA_CL_USM_POOL_SIZE")) {
+    retain_limit = std::strtoull(env, nullptr, 0);
+  }
+}
 
-host_allocation_info::~host_allocation_info() {
+size_t allocation_pool::getBlockSize(size_t size) const {
+  if (0 == retain_limit || size > max_block_size) {
+    return 0;
+  }
+  size_t block_size = min_block_size;
+  while (block_size < size) {
+    block_size <<= 1;
+  }
+  return block_size;
+}
+
+bool allocation_pool::acquire(cl_device_id device, size_t block_size,
+                              device_block& block) {
+  const std::lock_guard<std::mutex> guard(mutex);
+  auto found = device_blocks.find({device, block_size});
+  if (found == device_blocks.end() || found->second.empty()) {
+    stats.misses++;
+    return false;
+  }
+  block = found->second.back();
+  found->second.pop_back();
+  stats.hits++;
+  stats.cached_blocks--;
+  stats.cached_bytes -= block_size;
+  return true;
+}
+
+bool allocation_pool::acquire(size_t block_size, host_block& block) {
+  const std::lock_guard<std::mutex> guard(mutex);
+  auto found = host_blocks.find(block_size);
+  if (found == host_blocks.end() || found->second.empty()) {
+    stats.misses++;
+    return false;
+  }
+  block = std::move(found->second.back());
+  found->second.pop_back();
+  stats.hits++;
+  stats.cached_blocks--;
+  stats.cached_bytes -= block_size;
+  return true;
+}
+
+bool allocation_pool::release(cl_device_id device, size_t block_size,
+                              const device_block& block) {
+  const std::lock_guard<std::mutex> guard(mutex);
+  if (stats.cached_bytes + block_size > retain_limit) {
+    return false;
+  }
+  device_blocks[{device, block_size}].push_back(block);
+  stats.cached_blocks++;
+  stats.cached_bytes += block_size;
+  return true;
+}
+
+bool allocation_pool::release(size_t block_size, host_block& block) {
+  const std::lock_guard<std::mutex> guard(mutex);
+  if (stats.cached_bytes + block_size > retain_limit) {
+    return false;
+  }
+  host_blocks[block_size].push_back(std::move(block));
+  stats.cached_blocks++;
+  stats.cached_bytes += block_size;
+  return true;
+}
+
+void allocation_pool::clear(cl_context context) {
+  const std::lock_guard<std::mutex> guard(mutex);
+  for (auto& bucket : device_blocks) {
+    for (auto& block : bucket.second) {
+      destroyBlock(bucket.first.first, block);
+    }
+  }
+  device_blocks.clear();
+  for (auto& bucket : host_blocks) {
+    for (auto& block : bucket.second) {
+      destroyBlock(context, block);
+    }
+  }
+  host_blocks.clear();
+  stats.cached_blocks = 0;
+  stats.cached_bytes = 0;
+}
+
+allocation_pool::statistics allocation_pool::getStatistics() {
+  const std::lock_guard<std::mutex> guard(mutex);
+  return stats;
+}
+
+void destroyBlock(cl_device_id device,
+                  const allocation_pool::device_block& block) {
+  if (block.mux_buffer) {
+    (void)muxDestroyBuffer(device->mux_device, block.mux_buffer,
+                           device->mux_allocator);
+  }
+
+  if (block.mux_memory) {
+    muxFreeMemory(device->mux_device, block.mux_memory, device->mux_allocator);
+  }
+}
+
+void destroyBlock(cl_context context, allocation_pool::host_block& block) {
   // Free the Mux objects we've created
-  for (cl_uint index = 0; index < context->devices.size(); ++index) {
+  for (cl_uint index = 0; index < block.mux_buffers.size(); ++index) {
     auto device = context->devices[index];
 
-    mux_buffer_t mux_buffer = mux_buffers[index];
+    mux_buffer_t mux_buffer = block.mux_buffers[index];
     if (mux_buffer) {
       (void)muxDestroyBuffer(device->mux_device, mux_buffer,
                              device->mux_allocator);
     }
 
-    mux_memory_t mux_memory = mux_memories[index];
+    mux_memory_t mux_memory = block.mux_memories[index];
     if (mux_memory) {
       muxFreeMemory(device->mux_device, mux_memory, device->mux_allocator);
     }
   }
 
   // Free the host side allocation
-  if (base_ptr) {
-    cargo::free(base_ptr);
+  if (block.base_ptr) {
+    cargo::free(block.base_ptr);
+  }
+}
+
+host_allocation_info::host_allocation_info(const cl_context context,
+                                           const size_t size)
+    : allocation_info(context, size) {}
+
+host_allocation_info::~host_allocation_info() {
+  allocation_pool::host_block block{base_ptr, std::move(mux_memories),
+                                    std::move(mux_buffers)};
+  if (block_size && context->usm_pool.release(block_size, block)) {
+    return;
   }
+  destroyBlock(context, block);
 };
 
 cargo::expected<std::unique_ptr<host_allocation_info>, cl_int>
@@ -241,7 +367,9 @@ host_allocation_info::create(cl_context context,
     max_align = device_align > max_align ? device_align : max_align;
   }
 
-  if (alignment == 0) {
+  // Pooled blocks are reused by allocations with any requested alignment, so
+  // always give them the largest alignment allowed.
+  if (alignment == 0 || context->usm_pool.getBlockSize(size)) {
     alignment = max_align;
   }
 
@@ -271,7 +399,20 @@ host_allocation_info::create(cl_context context,
 }
 
 cl_int host_allocation_info::allocate(cl_uint alignment) {
-  base_ptr = cargo::alloc(size, alignment);
+  const size_t pool_block_size = context->usm_pool.getBlockSize(size);
+  if (pool_block_size) {
+    allocation_pool::host_block block;
+    if (context->usm_pool.acquire(pool_block_size, block)) {
+      base_ptr = block.base_ptr;
+      mux_memories = std::move(block.mux_memories);
+      mux_buffers = std::move(block.mux_buffers);
+      block_size = pool_block_size;
+      return CL_SUCCESS;
+    }
+  }
+  const size_t alloc_size = pool_block_size ? pool_block_size : size;
+
+  base_ptr = cargo::alloc(alloc_size, alignment);
   if (base_ptr == nullptr) {
     return CL_OUT_OF_HOST_MEMORY;
   }
@@ -294,14 +435,14 @@ cl_int host_allocation_info::allocate(cl_uint alignment) {
     }
 
     // Initialize the Mux objects needed by each device
-    if (muxCreateBuffer(device->mux_device, size, device->mux_allocator,
+    if (muxCreateBuffer(device->mux_device, alloc_size, device->mux_allocator,
                         &mux_buffers[index])) {
       return CL_OUT_OF_HOST_MEMORY;
     }
 
-    mux_result_t mux_error =
-        muxCreateMemoryFromHost(device->mux_device, size, base_ptr,
-                                device->mux_allocator, &mux_memories[index]);
+    mux_result_t mux_error = muxCreateMemoryFromHost(
+        device->mux_device, alloc_size, base_ptr, device->mux_allocator,
+        &mux_memories[index]);
     if (mux_error) {
       return CL_OUT_OF_RESOURCES;
     }
@@ -313,6 +454,9 @@ cl_int host_allocation_info::allocate(cl_uint alignment) {
       return CL_MEM_OBJECT_ALLOCATION_FAILURE;
     }
   }
+
+  // Only fully initialized allocations may be returned to the pool.
+  block_size = pool_block_size;
   return CL_SUCCESS;
 }
 
@@ -336,13 +480,9 @@ device_allocation_info::device_allocation_info(const cl_context context,
 };
 
 device_allocation_info::~device_allocation_info() {
-  if (mux_buffer) {
-    (void)muxDestroyBuffer(device->mux_device, mux_buffer,
-                           device->mux_allocator);
-  }
-
-  if (mux_memory) {
-    muxFreeMemory(device->mux_device, mux_memory, device->mux_allocator);
+  const allocation_pool::device_block block{mux_memory, mux_buffer};
+  if (!block_size || !context->usm_pool.release(device, block_size, block)) {
+    destroyBlock(device, block);
   }
 
   cl::releaseInternal(device);
@@ -368,7 +508,9 @@ device_allocation_info::create(cl_context context, cl_device_id device,
     return cargo::make_unexpected(alloc_properties.error());
   }
 
-  if (alignment == 0) {
+  // Pooled blocks are reused by allocations with any requested alignment, so
+  // always give them the largest alignment allowed.
+  if (alignment == 0 || context->usm_pool.getBlockSize(size)) {
     alignment = device_align;
   }
 
@@ -390,26 +532,36 @@ device_allocation_info::create(cl_context context, cl_device_id device,
 }
 
 cl_int device_allocation_info::allocate(cl_uint alignment) {
-  // Allocation device local memory
-  uint32_t heap = 1;
-  mux_result_t mux_error = muxAllocateMemory(
-      device->mux_device, size, heap, mux_memory_property_device_local,
-      mux_allocation_type_alloc_device, alignment, device->mux_allocator,
-      &mux_memory);
-  if (mux_error) {
-    return CL_OUT_OF_RESOURCES;
-  }
+  const size_t pool_block_size = context->usm_pool.getBlockSize(size);
+  allocation_pool::device_block block;
+  if (pool_block_size &&
+      context->usm_pool.acquire(device, pool_block_size, block)) {
+    mux_memory = block.mux_memory;
+    mux_buffer = block.mux_buffer;
+  } else {
+    const size_t alloc_size = pool_block_size ? pool_block_size : size;
+
+    // Allocation device local memory
+    uint32_t heap = 1;
+    mux_result_t mux_error = muxAllocateMemory(
+        device->mux_device, alloc_size, heap, mux_memory_property_device_local,
+        mux_allocation_type_alloc_device, alignment, device->mux_allocator,
+        &mux_memory);
+    if (mux_error) {
+      return CL_OUT_OF_RESOURCES;
+    }
 
-  mux_error = muxCreateBuffer(device->mux_device, size, device->mux_allocator,
-                              &mux_buffer);
-  if (mux_error) {
-    return CL_OUT_OF_RESOURCES;
-  }
+    mux_error = muxCreateBuffer(device->mux_device, alloc_size,
+                                device->mux_allocator, &mux_buffer);
+    if (mux_error) {
+      return CL_OUT_OF_RESOURCES;
+    }
 
-  mux_error =
-      muxBindBufferMemory(device->mux_device, mux_memory, mux_buffer, 0);
-  if (mux_error) {
-    return CL_OUT_OF_RESOURCES;
+    mux_error =
+        muxBindBufferMemory(device->mux_device, mux_memory, mux_buffer, 0);
+    if (mux_error) {
+      return CL_OUT_OF_RESOURCES;
+    }
   }
 
 #if INTPTR_MAX == INT64_MAX
@@ -424,6 +576,8 @@ cl_int device_allocation_info::allocate(cl_uint alignment) {
 #endif
   OCL_CHECK(nullptr == base_ptr, return CL_OUT_OF_RESOURCES);
 
+  // Only fully initialized allocations may be returned to the pool.
+  block_size = pool_block_size;
   return CL_SUCCESS;
 }
 }  // namespace usm
@@ -492,6 +646,29 @@ cl_int intel_unified_shared_memory::GetDeviceInfo(
 #endif  // OCL_EXTENSION_cl_intel_unified_shared_memory
 }
 
+cl_int intel_unified_shared_memory::GetContextInfo(
+    cl_context context, cl_context_info param_name, size_t param_value_size,
+    void* param_value, size_t* param_value_size_ret) const {
+#ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
+  if (CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY == param_name) {
+    const size_t type_size = sizeof(cl_usm_pool_statistics_codeplay);
+    if (nullptr != param_value) {
+      OCL_CHECK(param_value_size < type_size, return CL_INVALID_VALUE);
+      const auto stats = context->usm_pool.getStatistics();
+      auto result = static_cast<cl_usm_pool_statistics_codeplay*>(param_value);
+      result->hits = stats.hits;
+      result->misses = stats.misses;
+      result->cached_blocks = stats.cached_blocks;
+      result->cached_bytes = stats.cached_bytes;
+    }
+    OCL_SET_IF_NOT_NULL(param_value_size_ret, type_size);
+    return CL_SUCCESS;
+  }
+#endif  // OCL_EXTENSION_cl_intel_unified_shared_memory
+  return extension::GetContextInfo(context, param_name, param_value_size,
+                                   param_value, param_value_size_ret);
+}
+
 #if (defined(CL_VERSION_3_0) || \
      defined(OCL_EXTENSION_cl_codeplay_kernel_exec_info))
 cl_int intel_unified_shared_memory::SetKernelExecInfo(
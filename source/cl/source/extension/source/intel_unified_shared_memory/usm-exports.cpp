@@ -198,16 +198,14 @@ void *clHostMemAllocINTEL(cl_context context,
     return nullptr;
   }
 
-  // Lock context for pushing to list of usm allocations
-  std::lock_guard<std::mutex> context_guard(context->mutex);
-  if (context->usm_allocations.push_back(
-          std::move(new_usm_allocation.value()))) {
-    OCL_SET_IF_NOT_NULL(errcode_ret, CL_OUT_OF_HOST_MEMORY);
-    return nullptr;
-  }
+  // Lock context for inserting into the map of usm allocations
+  void *base_ptr = new_usm_allocation.value()->base_ptr;
+  const std::lock_guard<std::shared_mutex> usm_guard(context->usm_mutex);
+  context->usm_allocations.emplace(base_ptr,
+                                   std::move(new_usm_allocation.value()));
 
   OCL_SET_IF_NOT_NULL(errcode_ret, CL_SUCCESS);
-  return context->usm_allocations.back()->base_ptr;
+  return base_ptr;
 }
 
 CL_API_ENTRY
@@ -231,15 +229,13 @@ void *clDeviceMemAllocINTEL(cl_context context, cl_device_id device,
     return nullptr;
   }
 
-  // Lock context for pushing to list of usm allocations
-  std::lock_guard<std::mutex> context_guard(context->mutex);
-  if (context->usm_allocations.push_back(
-          std::move(new_usm_allocation.value()))) {
-    OCL_SET_IF_NOT_NULL(errcode_ret, CL_OUT_OF_HOST_MEMORY);
-    return nullptr;
-  }
+  // Lock context for inserting into the map of usm allocations
+  void *base_ptr = new_usm_allocation.value()->base_ptr;
+  const std::lock_guard<std::shared_mutex> usm_guard(context->usm_mutex);
+  context->usm_allocations.emplace(base_ptr,
+                                   std::move(new_usm_allocation.value()));
   OCL_SET_IF_NOT_NULL(errcode_ret, CL_SUCCESS);
-  return context->usm_allocations.back()->base_ptr;
+  return base_ptr;
 }
 
 CL_API_ENTRY
@@ -303,16 +299,9 @@ cl_int clMemFreeINTEL(cl_context context, void *ptr) {
   OCL_CHECK(ptr == NULL, return CL_SUCCESS);
 
   // Lock context to ensure usm allocation iterators are valid
-  std::lock_guard<std::mutex> context_guard(context->mutex);
-
-  auto isUsmPtr =
-      [ptr](const std::unique_ptr<extension::usm::allocation_info> &usm_alloc) {
-        return usm_alloc->base_ptr == ptr;
-      };
+  const std::lock_guard<std::shared_mutex> usm_guard(context->usm_mutex);
 
-  auto usm_alloc_iterator =
-      std::find_if(context->usm_allocations.begin(),
-                   context->usm_allocations.end(), isUsmPtr);
+  auto usm_alloc_iterator = context->usm_allocations.find(ptr);
 
   OCL_CHECK(context->usm_allocations.end() == usm_alloc_iterator,
             return CL_INVALID_VALUE);
@@ -330,23 +319,16 @@ cl_int clMemBlockingFreeINTEL(cl_context context, void *ptr) {
   OCL_CHECK(ptr == NULL, return CL_SUCCESS);
 
   // Lock context to ensure usm allocation iterators are valid
-  std::lock_guard<std::mutex> context_guard(context->mutex);
-
-  auto isUsmPtr =
-      [ptr](const std::unique_ptr<extension::usm::allocation_info> &usm_alloc) {
-        return usm_alloc->base_ptr == ptr;
-      };
+  const std::lock_guard<std::shared_mutex> usm_guard(context->usm_mutex);
 
-  auto usm_alloc_iterator =
-      std::find_if(context->usm_allocations.begin(),
-                   context->usm_allocations.end(), isUsmPtr);
+  auto usm_alloc_iterator = context->usm_allocations.find(ptr);
 
   OCL_CHECK(context->usm_allocations.end() == usm_alloc_iterator,
             return CL_INVALID_VALUE);
 
   // Implicitly flush all the queues that the events belong to
   std::unordered_set<_cl_command_queue *> flushed_queues;
-  auto &events = (*usm_alloc_iterator)->queued_commands;
+  auto &events = usm_alloc_iterator->second->queued_commands;
   for (auto &event : events) {
     auto queue = event->queue;
 
@@ -354,8 +336,7 @@ cl_int clMemBlockingFreeINTEL(cl_context context, void *ptr) {
     if (event->command_status == CL_QUEUED) {
       // Don't repeatedly flush queues we've already seen
       if (flushed_queues.count(queue) == 0) {
-        std::lock_guard<std::mutex> lock(
-            queue->context->getCommandQueueMutex());
+        cl::command_queue_lock lock(queue);
 
         cl_int result = queue->flush();
 
@@ -485,6 +466,7 @@ cl_int clSetKernelArgMemPointerINTEL(cl_kernel kernel, cl_uint arg_index,
 
     // Will create a mux_descriptor_info_buffer_s descriptor for the argument
     // using the device specific mux_buffer assigned to the allocation.
+    kernel->invalidateArgDescriptors();
     kernel->saved_args[arg_index] =
         _cl_kernel::argument(*arg_type, usm_alloc, offset);
   }
@@ -522,12 +504,12 @@ cl_int MemFillImpl(cl_command_queue command_queue, void *dst_ptr,
     auto mux_error = usm_alloc->record_event(return_event);
     OCL_CHECK(mux_error, return CL_OUT_OF_RESOURCES);
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, return_event);
-    OCL_CHECK(!mux_command_buffer, return CL_OUT_OF_RESOURCES);
+    OCL_CHECK(!mux_command_buffer, return mux_command_buffer.error());
 
     // Push Mux fill buffer operation
     const cl_device_id device = command_queue->device;
@@ -640,13 +622,13 @@ cl_int clEnqueueMemcpyINTEL(cl_command_queue command_queue, cl_bool blocking,
     extension::usm::allocation_info *usm_src_alloc =
         extension::usm::findAllocation(command_queue->context, src_ptr);
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, return_event);
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     cl_device_id queue_device = command_queue->device;
@@ -804,12 +786,12 @@ cl_int clEnqueueMigrateMemINTEL(cl_command_queue command_queue, const void *ptr,
     const intptr_t bytes_till_end = usm_alloc->size - ptr_offset;
     OCL_CHECK(intptr_t(size) > bytes_till_end, return CL_INVALID_VALUE);
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, return_event);
-    OCL_CHECK(!mux_command_buffer, return CL_OUT_OF_RESOURCES);
+    OCL_CHECK(!mux_command_buffer, return mux_command_buffer.error());
 
     auto mux_error = usm_alloc->record_event(return_event);
     OCL_CHECK(mux_error, return CL_OUT_OF_RESOURCES);
@@ -853,12 +835,12 @@ cl_int clEnqueueMemAdviseINTEL(cl_command_queue command_queue, const void *ptr,
         extension::usm::findAllocation(context, ptr);
     OCL_CHECK(nullptr == usm_alloc, return CL_INVALID_VALUE);
 
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, return_event);
-    OCL_CHECK(!mux_command_buffer, return CL_OUT_OF_RESOURCES);
+    OCL_CHECK(!mux_command_buffer, return mux_command_buffer.error());
 
     auto mux_error = usm_alloc->record_event(return_event);
     OCL_CHECK(mux_error, return CL_OUT_OF_RESOURCES);
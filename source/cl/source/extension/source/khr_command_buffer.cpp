@@ -835,7 +835,7 @@ cl_int _cl_command_buffer_khr::commandNDRangeKernel(
     return CL_OUT_OF_HOST_MEMORY;
   }
 
-  std::unique_ptr<mux_descriptor_info_t[]> descriptor_info_storage;
+  _cl_kernel::descriptor_storage descriptor_info_storage;
   cl_device_id device = command_queue->device;
 
   // create the printf buffer argument if necessary
@@ -855,18 +855,36 @@ cl_int _cl_command_buffer_khr::commandNDRangeKernel(
   }
 
   const cl_uint device_index = kernel->program->context->getDeviceIndex(device);
-  mux_ndrange_options_t mux_execution_options =
-      kernel->createKernelExecutionOptions(
-          device, device_index, work_dim, final_local_work_size,
-          final_global_offset, final_global_size, printf_buffer,
-          descriptor_info_storage);
+  auto mux_execution_options = kernel->createKernelExecutionOptions(
+      device, device_index, work_dim, final_local_work_size,
+      final_global_offset, final_global_size, printf_buffer,
+      descriptor_info_storage);
+  if (!mux_execution_options) {
+    if (printf_buffer) {
+      muxDestroyBuffer(device->mux_device, printf_buffer,
+                       device->mux_allocator);
+    }
+    if (printf_memory) {
+      muxFreeMemory(device->mux_device, printf_memory, device->mux_allocator);
+    }
+    return mux_execution_options.error();
+  }
 
   mux_result_t mux_error;
   mux_kernel_t mux_kernel;
 
   if (kernel->device_kernel_map[device]->supportsDeferredCompilation()) {
+    mux_ndrange_options_t specialization_options = *mux_execution_options;
+#ifdef OCL_EXTENSION_cl_khr_command_buffer_mutable_dispatch
+    // Arguments of a mutable command buffer can be updated after recording,
+    // so the kernel must not be specialized on their current values.
+    if (flags & CL_COMMAND_BUFFER_MUTABLE_KHR) {
+      specialization_options.descriptors = nullptr;
+      specialization_options.descriptors_length = 0;
+    }
+#endif
     auto result = kernel->device_kernel_map[device]->createSpecializedKernel(
-        mux_execution_options);
+        specialization_options);
     if (!result.has_value()) {
       if (printf_buffer) {
         muxDestroyBuffer(device->mux_device, printf_buffer,
@@ -898,7 +916,7 @@ cl_int _cl_command_buffer_khr::commandNDRangeKernel(
   mux_sync_point_t mux_sync_point = nullptr;
   mux_sync_point_t *out_sync_point = cl_sync_point ? &mux_sync_point : nullptr;
   mux_error = muxCommandNDRange(
-      mux_command_buffer, mux_kernel, mux_execution_options, wait_list_length,
+      mux_command_buffer, mux_kernel, *mux_execution_options, wait_list_length,
       wait_list_length ? command_wait_list->data() : nullptr, out_sync_point);
   if (mux_success != mux_error) {
     if (printf_buffer) {
@@ -1246,7 +1264,34 @@ clReleaseCommandBufferKHR(cl_command_buffer_khr command_buffer) {
   tracer::TraceGuard<tracer::OpenCL> guard("clReleaseCommandBufferKHR");
   OCL_CHECK(!command_buffer, return CL_INVALID_COMMAND_BUFFER_KHR);
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  // Stop the command queue capturing into this command-buffer if capture was
+  // never ended. This can't wait for the destructor, the last internal
+  // reference may be dropped with the command queue mutex already held.
+  cl_command_queue command_queue = command_buffer->command_queue;
+  bool should_destroy = false;
+  {
+    cl::command_queue_lock lock(command_queue);
+    const cl_int error = command_buffer->releaseExternal(should_destroy);
+    if (error) {
+      return error;
+    }
+    if (0 == command_buffer->refCountExternal() &&
+        command_queue->capture_command_buffer == command_buffer) {
+      command_queue->capture_command_buffer = nullptr;
+      command_queue->capture_sync_point = cargo::nullopt;
+      command_queue->capture_mutable_handles.clear();
+    }
+  }
+  // Destroy outside the lock, the command-buffer may hold the last reference
+  // to the command queue.
+  if (should_destroy) {
+    delete command_buffer;
+  }
+  return CL_SUCCESS;
+#else
   return cl::releaseExternal(command_buffer);
+#endif
 }
 
 CL_API_ENTRY cl_int CL_API_CALL
@@ -223,7 +223,9 @@ CL_API_ENTRY cl_mem CL_API_CALL cl::CreateImage(
       cl_mem_buffer buffer = static_cast<cl_mem_buffer>(image_desc->buffer);
       image->mux_memories[index] = buffer->mux_memories[index];
       // TODO: Can you actually create an image 1D buffer from a sub-buffer?
-      offset = buffer->offset;
+      const cl_mem owner =
+          buffer->optional_parent ? buffer->optional_parent : buffer;
+      offset = owner->memory_offset + buffer->offset;
     } else {
       cl_int error = image->allocateMemory(
           device->mux_device, mux_image->memory_requirements.supported_heaps,
@@ -446,13 +448,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueReadImage(
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, event_release_guard.get());
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -547,13 +549,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueWriteImage(
                                                   cl::ref_count_type::EXTERNAL);
 
   {
-    std::lock_guard<std::mutex> lock(
-        command_queue->context->getCommandQueueMutex());
+    cl::command_queue_lock lock(command_queue,
+                                {event_wait_list, num_events_in_wait_list});
 
     auto mux_command_buffer = command_queue->getCommandBuffer(
         {event_wait_list, num_events_in_wait_list}, event_release_guard.get());
     if (!mux_command_buffer) {
-      return CL_OUT_OF_RESOURCES;
+      return mux_command_buffer.error();
     }
 
     auto device_index = command_queue->getDeviceIndex();
@@ -621,13 +623,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueFillImage(
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -681,13 +683,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueCopyImage(
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -752,13 +754,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueCopyImageToBuffer(
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -820,13 +822,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueCopyBufferToImage(
     *event = return_event;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   auto device_index = command_queue->getDeviceIndex();
@@ -28,9 +28,13 @@
 #include <cl/sampler.h>
 #include <cl/validate.h>
 
+#include <algorithm>
 #include <array>
 
 #include "cargo/expected.h"
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+#include <extension/codeplay_command_buffer_capture.h>
+#endif
 #ifdef OCL_EXTENSION_cl_khr_command_buffer
 #include <extension/khr_command_buffer.h>
 #endif
@@ -39,19 +43,52 @@
 #include <memory>
 #include <mutex>
 
-mux_ndrange_options_t _cl_kernel::createKernelExecutionOptions(
+cargo::expected<mux_ndrange_options_t, cl_int>
+_cl_kernel::createKernelExecutionOptions(
     cl_device_id device, cl_uint device_index, size_t work_dim,
     const std::array<size_t, cl::max::WORK_ITEM_DIM> &local_size,
     const std::array<size_t, cl::max::WORK_ITEM_DIM> &global_offset,
     const std::array<size_t, cl::max::WORK_ITEM_DIM> &global_size,
-    mux_buffer_t printf_buffer,
-    std::unique_ptr<mux_descriptor_info_t[]> &descriptors) {
+    mux_buffer_t printf_buffer, descriptor_storage &descriptors) {
   const uint32_t num_arguments = info->num_arguments;
   const bool printf = nullptr != printf_buffer;
-  descriptors = std::unique_ptr<mux_descriptor_info_t[]>(
-      new mux_descriptor_info_t[printf ? num_arguments + 1 : num_arguments]);
+  if (descriptors.resize(printf ? num_arguments + 1 : num_arguments)) {
+    return cargo::make_unexpected(CL_OUT_OF_HOST_MEMORY);
+  }
 
-  for (uint32_t i = 0; i < num_arguments; i++) {
+  if (cached_descriptors.empty()) {
+    fillArgDescriptors(device, device_index, descriptors.data());
+  } else {
+    // The arguments haven't changed since clSetKernelArgsCODEPLAY built the
+    // descriptors, copy them rather than walking saved_args again.
+    std::copy_n(cached_descriptors[device_index].begin(), num_arguments,
+                descriptors.begin());
+  }
+
+  // printf buffer argument
+  if (printf) {
+    descriptors[num_arguments].type = mux_descriptor_info_type_buffer;
+    descriptors[num_arguments].buffer_descriptor.buffer = printf_buffer;
+    descriptors[num_arguments].buffer_descriptor.offset = 0;
+  }
+
+  mux_ndrange_options_t execution_options;
+  execution_options.descriptors =
+      ((num_arguments == 0) && !printf) ? nullptr : descriptors.data();
+  execution_options.descriptors_length =
+      printf ? num_arguments + 1 : num_arguments;
+  execution_options.local_size[0] = local_size[0];
+  execution_options.local_size[1] = local_size[1];
+  execution_options.local_size[2] = local_size[2];
+  execution_options.global_offset = global_offset.data();
+  execution_options.global_size = global_size.data();
+  execution_options.dimensions = work_dim;
+  return execution_options;
+}
+
+void _cl_kernel::fillArgDescriptors(cl_device_id device, cl_uint device_index,
+                                    mux_descriptor_info_t *descriptors) {
+  for (uint32_t i = 0; i < info->num_arguments; i++) {
     _cl_kernel::argument &arg = saved_args[i];
 #ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
     if (arg.stype == _cl_kernel::argument::storage_type::usm) {
@@ -168,26 +205,32 @@ mux_ndrange_options_t _cl_kernel::createKernelExecutionOptions(
         break;
     }
   }
+}
 
-  // printf buffer argument
-  if (printf) {
-    descriptors[num_arguments].type = mux_descriptor_info_type_buffer;
-    descriptors[num_arguments].buffer_descriptor.buffer = printf_buffer;
-    descriptors[num_arguments].buffer_descriptor.offset = 0;
+cl_int _cl_kernel::cacheArgDescriptors() {
+  invalidateArgDescriptors();
+  const uint32_t num_arguments = info->num_arguments;
+  for (uint32_t i = 0; i < num_arguments; i++) {
+    if (compiler::ArgumentKind::UNKNOWN == saved_args[i].type.kind) {
+      // Enqueuing will fail with CL_INVALID_KERNEL_ARGS, nothing to cache.
+      return CL_SUCCESS;
+    }
   }
 
-  mux_ndrange_options_t execution_options;
-  execution_options.descriptors =
-      ((num_arguments == 0) && !printf) ? nullptr : descriptors.get();
-  execution_options.descriptors_length =
-      printf ? num_arguments + 1 : num_arguments;
-  execution_options.local_size[0] = local_size[0];
-  execution_options.local_size[1] = local_size[1];
-  execution_options.local_size[2] = local_size[2];
-  execution_options.global_offset = global_offset.data();
-  execution_options.global_size = global_size.data();
-  execution_options.dimensions = work_dim;
-  return execution_options;
+  cl_context context = program->context;
+  cargo::dynamic_array<descriptor_storage> descriptors;
+  if (descriptors.alloc(context->devices.size())) {
+    return CL_OUT_OF_HOST_MEMORY;
+  }
+  for (cl_uint index = 0; index < context->devices.size(); index++) {
+    if (descriptors[index].resize(num_arguments)) {
+      return CL_OUT_OF_HOST_MEMORY;
+    }
+    fillArgDescriptors(context->devices[index], index,
+                       descriptors[index].data());
+  }
+  cached_descriptors = std::move(descriptors);
+  return CL_SUCCESS;
 }
 
 cl_int _cl_kernel::retainMems(cl_command_queue command_queue,
@@ -234,6 +277,10 @@ cl_int _cl_kernel::retainMems(cl_command_queue command_queue,
 }
 
 namespace {
+/// @brief Number of specialized kernels each MuxKernelWrapper keeps loaded for
+/// reuse by later launches.
+constexpr size_t max_cached_specialized_kernels = 16;
+
 /// @brief Push kernel execution to the queue.
 ///
 /// @param command_queue OpenCL command queue to enqueue on.
@@ -254,31 +301,6 @@ cl_int PushExecuteKernel(
     const std::array<size_t, cl::max::WORK_ITEM_DIM> &local_work_size,
     const cl_uint num_events_in_wait_list,
     const cl_event *const event_wait_list, cl_event return_event) {
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
-  auto mux_command_buffer = command_queue->getCommandBuffer(
-      {event_wait_list, num_events_in_wait_list}, return_event);
-  if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
-  }
-
-#ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
-  // We retained the event when creating the command, release it once the
-  // command completes.
-  //
-  // Pass nullptr cl_event so that no command is submitted for profiling, we
-  // need to push the kernel execution command before querying its end time.
-  if (auto error = command_queue->registerDispatchCallback(
-          *mux_command_buffer, nullptr,
-          [return_event]() { cl::releaseInternal(return_event); })) {
-    return error;
-  }
-#endif
-
-  cl::retainInternal(kernel);
-  cl::release_guard<cl_kernel> kernel_release_guard(
-      kernel, cl::ref_count_type::INTERNAL);
-
   cl_device_id device = command_queue->device;
   mux_device_t mux_device = device->mux_device;
 
@@ -286,6 +308,11 @@ cl_int PushExecuteKernel(
 
   mux_allocator_info_t mux_allocator = command_queue->device->mux_allocator;
 
+  // Everything up to recording the command only touches the kernel and the
+  // device, so is done before taking the command queue lock. Specializing the
+  // kernel may invoke the compiler, which would otherwise stall every other
+  // enqueue to the queue and to the queues its wait events belong to.
+
   // create the printf buffer argument if necessary
   mux_buffer_t printf_buffer = nullptr;
   mux_memory_t printf_memory = nullptr;
@@ -303,53 +330,86 @@ cl_int PushExecuteKernel(
     }
   }
 
-  std::unique_ptr<mux_descriptor_info_t[]> descriptor_info_storage;
+  MuxKernelWrapper *kernel_wrapper = kernel->device_kernel_map[device].get();
+  mux_kernel_t mux_specialized_kernel = nullptr;
+
+  // Destroys the per-launch objects created here if the command could not be
+  // recorded.
+  auto destroy_launch_objects = [&]() {
+    if (nullptr != printf_buffer) {
+      muxDestroyBuffer(mux_device, printf_buffer, mux_allocator);
+    }
+    if (nullptr != printf_memory) {
+      muxFreeMemory(mux_device, printf_memory, mux_allocator);
+    }
+    if (nullptr != mux_specialized_kernel) {
+      kernel_wrapper->releaseSpecializedKernel(mux_specialized_kernel);
+    }
+  };
+
+  _cl_kernel::descriptor_storage descriptor_info_storage;
   const cl_uint device_index = kernel->program->context->getDeviceIndex(device);
-  mux_ndrange_options_t mux_execution_options =
-      kernel->createKernelExecutionOptions(
-          command_queue->device, device_index, work_dim, local_work_size,
-          global_work_offset, global_work_size, printf_buffer,
-          descriptor_info_storage);
+  auto mux_execution_options = kernel->createKernelExecutionOptions(
+      command_queue->device, device_index, work_dim, local_work_size,
+      global_work_offset, global_work_size, printf_buffer,
+      descriptor_info_storage);
+  if (!mux_execution_options) {
+    destroy_launch_objects();
+    return mux_execution_options.error();
+  }
 
-  mux_kernel_t mux_specialized_kernel = nullptr;
-  mux_executable_t mux_specialized_executable = nullptr;
   mux_kernel_t kernel_to_execute = nullptr;
-  if (kernel->device_kernel_map[device]->supportsDeferredCompilation()) {
-    auto result = kernel->device_kernel_map[device]->createSpecializedKernel(
-        mux_execution_options);
+  if (kernel_wrapper->supportsDeferredCompilation()) {
+    auto result =
+        kernel_wrapper->acquireSpecializedKernel(*mux_execution_options);
     if (!result.has_value()) {
-      if (printf_buffer) {
-        muxDestroyBuffer(mux_device, printf_buffer, mux_allocator);
-      }
-      if (printf_memory) {
-        muxFreeMemory(mux_device, printf_memory, mux_allocator);
-      }
+      destroy_launch_objects();
       return cl::getErrorFrom(result.error());
     }
 
-    mux_specialized_kernel = result->mux_kernel.release();
-    mux_specialized_executable = result->mux_executable.release();
+    mux_specialized_kernel = *result;
     kernel_to_execute = mux_specialized_kernel;
   } else {
     // Execute the precompiled kernel.
-    kernel_to_execute =
-        kernel->device_kernel_map[device]->getPrecompiledKernel();
+    kernel_to_execute = kernel_wrapper->getPrecompiledKernel();
   }
 
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
+  auto mux_command_buffer = command_queue->getCommandBuffer(
+      {event_wait_list, num_events_in_wait_list}, return_event);
+  if (!mux_command_buffer) {
+    destroy_launch_objects();
+    return mux_command_buffer.error();
+  }
+
+#ifdef OCL_EXTENSION_cl_intel_unified_shared_memory
+  // We retained the event when creating the command, release it once the
+  // command completes.
+  //
+  // Pass nullptr cl_event so that no command is submitted for profiling, we
+  // need to push the kernel execution command before querying its end time.
+  if (auto error = command_queue->registerDispatchCallback(
+          *mux_command_buffer, nullptr,
+          [return_event]() { cl::releaseInternal(return_event); })) {
+    destroy_launch_objects();
+    return error;
+  }
+#endif
+
+  cl::retainInternal(kernel);
+  cl::release_guard<cl_kernel> kernel_release_guard(
+      kernel, cl::ref_count_type::INTERNAL);
+
   mux_result_t mux_error =
       muxCommandNDRange(*mux_command_buffer, kernel_to_execute,
-                        mux_execution_options, 0, nullptr, nullptr);
+                        *mux_execution_options, 0, nullptr, nullptr);
   if (mux_success != mux_error) {
     auto error = cl::getErrorFrom(mux_error);
     if (nullptr != return_event) {
       return_event->complete(error);
     }
-    if (nullptr != printf_buffer) {
-      muxDestroyBuffer(mux_device, printf_buffer, mux_allocator);
-    }
-    if (nullptr != printf_memory) {
-      muxFreeMemory(mux_device, printf_memory, mux_allocator);
-    }
+    destroy_launch_objects();
     return error;
   }
 
@@ -386,17 +446,12 @@ cl_int PushExecuteKernel(
 
   return command_queue->registerDispatchCallback(
       *mux_command_buffer, return_event,
-      [kernel, mems_to_release, mux_device, mux_specialized_kernel,
-       mux_specialized_executable, mux_allocator]() {
+      [kernel, mems_to_release, kernel_wrapper, mux_specialized_kernel]() {
         for (auto mem : mems_to_release) {
           cl::releaseInternal(mem);
         }
         if (mux_specialized_kernel) {
-          muxDestroyKernel(mux_device, mux_specialized_kernel, mux_allocator);
-        }
-        if (mux_specialized_executable) {
-          muxDestroyExecutable(mux_device, mux_specialized_executable,
-                               mux_allocator);
+          kernel_wrapper->releaseSpecializedKernel(mux_specialized_kernel);
         }
         cl::releaseInternal(kernel);
       });
@@ -430,6 +485,16 @@ MuxKernelWrapper::MuxKernelWrapper(cl_device_id device,
       precompiled_kernel(nullptr),
       deferred_kernel(deferred_kernel) {}
 
+MuxKernelWrapper::MuxKernelWrapper(const MuxKernelWrapper &other)
+    : preferred_local_size_x(other.preferred_local_size_x),
+      preferred_local_size_y(other.preferred_local_size_y),
+      preferred_local_size_z(other.preferred_local_size_z),
+      local_memory_size(other.local_memory_size),
+      mux_device(other.mux_device),
+      mux_allocator_info(other.mux_allocator_info),
+      precompiled_kernel(other.precompiled_kernel),
+      deferred_kernel(other.deferred_kernel) {}
+
 bool MuxKernelWrapper::supportsDeferredCompilation() const {
   return deferred_kernel != nullptr;
 }
@@ -471,13 +536,154 @@ MuxKernelWrapper::createSpecializedKernel(
     return cargo::make_unexpected(specialized_kernel.error());
   }
 
+  return loadSpecializedKernel(*specialized_kernel);
+}
+
+cargo::expected<mux_kernel_t, compiler::Result>
+MuxKernelWrapper::acquireSpecializedKernel(
+    const mux_ndrange_options_t &specialization_options) {
+  if (!deferred_kernel) {
+    return cargo::make_unexpected(compiler::Result::FAILURE);
+  }
+
+  // Loading a binary into a Mux executable is expensive, so loaded kernels are
+  // cached keyed by the inputs they were specialized for. A hit skips the
+  // compiler entirely.
+  auto key = getSpecializationKey(specialization_options);
+  auto matches = [&key](const CachedSpecializedKernel &cached) {
+    return cached.key == key;
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(specialized_kernels_mutex);
+    auto found = std::find_if(specialized_kernels.begin(),
+                              specialized_kernels.end(), matches);
+    if (found != specialized_kernels.end()) {
+      found->ref_count++;
+      found->last_use = ++specialized_kernel_uses;
+      return found->specialized_kernel.mux_kernel.get();
+    }
+  }
+
+  auto binary =
+      deferred_kernel->createSpecializedKernel(specialization_options);
+  if (!binary.has_value()) {
+    return cargo::make_unexpected(binary.error());
+  }
+
+  // Load the binary without holding the lock, launches of other variants of
+  // this kernel can carry on in the meantime.
+  auto loaded = loadSpecializedKernel(*binary);
+  if (!loaded.has_value()) {
+    return cargo::make_unexpected(loaded.error());
+  }
+
+  std::lock_guard<std::mutex> lock(specialized_kernels_mutex);
+  // Another thread may have loaded the same kernel while the lock was
+  // released, prefer the existing entry and drop ours.
+  auto found = std::find_if(specialized_kernels.begin(),
+                            specialized_kernels.end(), matches);
+  if (found != specialized_kernels.end()) {
+    found->ref_count++;
+    found->last_use = ++specialized_kernel_uses;
+    return found->specialized_kernel.mux_kernel.get();
+  }
+
+  // Make room by evicting the least recently used kernel which isn't in use.
+  // If every kernel is in use the cache temporarily grows past its limit, and
+  // is trimmed as kernels are released.
+  if (specialized_kernels.size() >= max_cached_specialized_kernels) {
+    auto lru = specialized_kernels.end();
+    for (auto it = specialized_kernels.begin(); it != specialized_kernels.end();
+         ++it) {
+      if (0 == it->ref_count &&
+          (lru == specialized_kernels.end() || it->last_use < lru->last_use)) {
+        lru = it;
+      }
+    }
+    if (lru != specialized_kernels.end()) {
+      specialized_kernels.erase(lru);
+    }
+  }
+
+  mux_kernel_t mux_kernel = loaded->mux_kernel.get();
+  specialized_kernels.push_back(CachedSpecializedKernel{
+      std::move(key), std::move(*loaded), 1, ++specialized_kernel_uses});
+  return mux_kernel;
+}
+
+void MuxKernelWrapper::releaseSpecializedKernel(mux_kernel_t mux_kernel) {
+  std::lock_guard<std::mutex> lock(specialized_kernels_mutex);
+  auto found = std::find_if(
+      specialized_kernels.begin(), specialized_kernels.end(),
+      [mux_kernel](const CachedSpecializedKernel &cached) {
+        return cached.specialized_kernel.mux_kernel.get() == mux_kernel;
+      });
+  OCL_ASSERT(found != specialized_kernels.end() && found->ref_count > 0,
+             "Released a specialized kernel which was not acquired");
+  if (found == specialized_kernels.end()) {
+    return;
+  }
+  if (0 == --found->ref_count &&
+      specialized_kernels.size() > max_cached_specialized_kernels) {
+    specialized_kernels.erase(found);
+  }
+}
+
+MuxKernelWrapper::SpecializationKey MuxKernelWrapper::getSpecializationKey(
+    const mux_ndrange_options_t &specialization_options) const {
+  SpecializationKey key{};
+  auto append = [&key](const void *data, size_t size) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    key.inputs.insert(key.inputs.end(), bytes, bytes + size);
+  };
+
+  append(specialization_options.local_size,
+         sizeof(specialization_options.local_size));
+  if (deferred_kernel->specializesOnGlobalShape()) {
+    append(&specialization_options.dimensions,
+           sizeof(specialization_options.dimensions));
+    const size_t shape_size =
+        specialization_options.dimensions * sizeof(size_t);
+    if (specialization_options.global_size) {
+      append(specialization_options.global_size, shape_size);
+    }
+    if (specialization_options.global_offset) {
+      append(specialization_options.global_offset, shape_size);
+    }
+  }
+  for (const uint32_t index :
+       deferred_kernel->getSpecializedArgumentIndices()) {
+    if (index >= specialization_options.descriptors_length) {
+      continue;
+    }
+    const auto &descriptor = specialization_options.descriptors[index];
+    if (descriptor.type != mux_descriptor_info_type_plain_old_data) {
+      continue;
+    }
+    const auto &pod = descriptor.plain_old_data_descriptor;
+    append(&index, sizeof(index));
+    append(&pod.length, sizeof(pod.length));
+    append(pod.data, pod.length);
+  }
+
+  // FNV-1a.
+  key.hash = 14695981039346656037ULL;
+  for (const uint8_t byte : key.inputs) {
+    key.hash = (key.hash ^ byte) * 1099511628211ULL;
+  }
+  return key;
+}
+
+cargo::expected<MuxKernelWrapper::SpecializedKernel, compiler::Result>
+MuxKernelWrapper::loadSpecializedKernel(
+    cargo::array_view<const uint8_t> binary) {
   // Create a mux executable and kernel that contains this specialized binary.
   mux_result_t result;
   mux_executable_t mux_executable;
   mux_kernel_t mux_kernel;
-  result = muxCreateExecutable(mux_device, specialized_kernel->data(),
-                               specialized_kernel->size(), mux_allocator_info,
-                               &mux_executable);
+  result = muxCreateExecutable(mux_device, binary.data(), binary.size(),
+                               mux_allocator_info, &mux_executable);
   if (result != mux_success) {
     if (result == mux_error_out_of_memory) {
       return cargo::make_unexpected(compiler::Result::OUT_OF_MEMORY);
@@ -922,21 +1128,17 @@ CL_API_ENTRY cl_int CL_API_CALL cl::ReleaseKernel(cl_kernel kernel) {
   return cl::releaseExternal(kernel);
 }
 
-CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
-                                                 cl_uint arg_index,
-                                                 size_t arg_size,
-                                                 const void *arg_value) {
-  tracer::TraceGuard<tracer::OpenCL> guard("clSetKernelArg");
-  OCL_CHECK(!kernel, return CL_INVALID_KERNEL);
-
-  OCL_CHECK(arg_index >= kernel->info->num_arguments,
-            return CL_INVALID_ARG_INDEX);
+cl_int _cl_kernel::setArg(cl_uint arg_index, size_t arg_size,
+                          const void *arg_value) {
+  OCL_CHECK(arg_index >= info->num_arguments, return CL_INVALID_ARG_INDEX);
 
-  auto arg_type = kernel->GetArgType(arg_index);
+  auto arg_type = GetArgType(arg_index);
   OCL_CHECK(!arg_type, return arg_type.error());
 
+  invalidateArgDescriptors();
+
   // Allow extensions to handle kernel arguments first.
-  auto error = extension::SetKernelArg(kernel, arg_index, arg_size, arg_value);
+  auto error = extension::SetKernelArg(this, arg_index, arg_size, arg_value);
   // CL_INVALID_KERNEL is handled specially to signify that the extension was
   // not able to set the kernel argument.
   if (error != CL_INVALID_KERNEL) {
@@ -953,7 +1155,7 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
             (nullptr == *static_cast<const cl_mem *>(arg_value))) {
           // If the argument value is null or points to a null value set the
           // buffer argument to be null.
-          kernel->saved_args[arg_index] =
+          saved_args[arg_index] =
               _cl_kernel::argument(*arg_type, (_cl_mem *)nullptr);
         } else {
           cl_mem mem = *static_cast<const cl_mem *>(arg_value);
@@ -966,12 +1168,12 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
           // therefore check if the argument has this value before the checking
           // if it within limits.
           const cargo::optional<uint64_t> deref_bytes =
-              kernel->GetArgType(arg_index)->dereferenceable_bytes;
+              GetArgType(arg_index)->dereferenceable_bytes;
           if (deref_bytes.has_value() && mem->size > deref_bytes.value()) {
             return CL_MAX_SIZE_RESTRICTION_EXCEEDED;
           }
 #endif
-          kernel->saved_args[arg_index] = _cl_kernel::argument(*arg_type, mem);
+          saved_args[arg_index] = _cl_kernel::argument(*arg_type, mem);
         }
       } else if (arg_type->address_space == cl::binary::AddressSpace::LOCAL) {
         OCL_CHECK(nullptr != arg_value, return CL_INVALID_ARG_VALUE);
@@ -982,13 +1184,12 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
         // therefore check if the argument has this value before the checking
         // if it within limits.
         const cargo::optional<uint64_t> deref_bytes =
-            kernel->GetArgType(arg_index)->dereferenceable_bytes;
+            GetArgType(arg_index)->dereferenceable_bytes;
         if (deref_bytes.has_value() && arg_size > deref_bytes.value()) {
           return CL_MAX_SIZE_RESTRICTION_EXCEEDED;
         }
 #endif
-        kernel->saved_args[arg_index] =
-            _cl_kernel::argument(*arg_type, arg_size);
+        saved_args[arg_index] = _cl_kernel::argument(*arg_type, arg_size);
       } else {
         OCL_CHECK(nullptr != arg_value, return CL_INVALID_ARG_VALUE);
         OCL_CHECK(arg_size == 0, return CL_INVALID_ARG_SIZE);
@@ -996,13 +1197,13 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
         auto isCustomBufferCapable = [](cl_device_id device) {
           return device->mux_device->info->custom_buffer_capabilities != 0;
         };
-        if (std::none_of(kernel->program->context->devices.begin(),
-                         kernel->program->context->devices.end(),
+        if (std::none_of(program->context->devices.begin(),
+                         program->context->devices.end(),
                          isCustomBufferCapable)) {
           return CL_INVALID_ARG_VALUE;
         }
 
-        kernel->saved_args[arg_index] =
+        saved_args[arg_index] =
             _cl_kernel::argument(*arg_type, arg_value, arg_size);
       }
     } break;
@@ -1018,7 +1219,7 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
           (nullptr == *static_cast<const cl_mem *>(arg_value))) {
         // If the argument value is null or points to a null value set the
         // buffer argument to be null.
-        kernel->saved_args[arg_index] =
+        saved_args[arg_index] =
             _cl_kernel::argument(*arg_type, (_cl_mem *)nullptr);
       } else {
         cl_mem mem = *static_cast<const cl_mem *>(arg_value);
@@ -1052,21 +1253,21 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
             return CL_INVALID_ARG_VALUE;
         }
 
-        kernel->saved_args[arg_index] = _cl_kernel::argument(*arg_type, mem);
+        saved_args[arg_index] = _cl_kernel::argument(*arg_type, mem);
       }
     } break;
 
     case compiler::ArgumentKind::SAMPLER: {
       OCL_CHECK(sizeof(cl_sampler) != arg_size, return CL_INVALID_ARG_SIZE);
       OCL_CHECK(nullptr == arg_value, return CL_INVALID_ARG_VALUE);
-      kernel->saved_args[arg_index] = _cl_kernel::argument(
+      saved_args[arg_index] = _cl_kernel::argument(
           *arg_type, *static_cast<const cl_sampler *>(arg_value));
       break;
     }
 
     case compiler::ArgumentKind::INT1:
       // Quick and dirty
-      kernel->saved_args[arg_index] =
+      saved_args[arg_index] =
           _cl_kernel::argument(*arg_type, arg_value, arg_size);
       break;
 
@@ -1082,7 +1283,7 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
   case arg_type: {                                                   \
     OCL_CHECK(sizeof(type) != arg_size, return CL_INVALID_ARG_SIZE); \
     OCL_CHECK(!arg_value, return CL_INVALID_ARG_VALUE);              \
-    kernel->saved_args[arg_index] =                                  \
+    saved_args[arg_index] =                                          \
         _cl_kernel::argument(arg_type, arg_value, arg_size);         \
   } break
 
@@ -1107,7 +1308,7 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
 
     case compiler::ArgumentKind::STRUCTBYVAL: {
       OCL_CHECK(nullptr == arg_value, return CL_INVALID_ARG_VALUE);
-      kernel->saved_args[arg_index] =
+      saved_args[arg_index] =
           _cl_kernel::argument(*arg_type, arg_value, arg_size);
       break;
     }
@@ -1119,6 +1320,16 @@ CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
   return CL_SUCCESS;
 }
 
+CL_API_ENTRY cl_int CL_API_CALL cl::SetKernelArg(cl_kernel kernel,
+                                                 cl_uint arg_index,
+                                                 size_t arg_size,
+                                                 const void *arg_value) {
+  tracer::TraceGuard<tracer::OpenCL> guard("clSetKernelArg");
+  OCL_CHECK(!kernel, return CL_INVALID_KERNEL);
+
+  return kernel->setArg(arg_index, arg_size, arg_value);
+}
+
 CL_API_ENTRY cl_int CL_API_CALL
 cl::CreateKernelsInProgram(cl_program program, cl_uint num_kernels,
                            cl_kernel *kernels, cl_uint *num_kernels_ret) {
@@ -1557,6 +1768,14 @@ CL_API_ENTRY cl_int CL_API_CALL cl::EnqueueNDRangeKernel(
     return error;
   }
 
+#ifdef OCL_EXTENSION_cl_codeplay_command_buffer_capture
+  if (auto captured = extension::CaptureNDRangeKernel(
+          command_queue, kernel, work_dim, global_work_offset,
+          global_work_size, local_work_size, num_events_in_wait_list, event)) {
+    return *captured;
+  }
+#endif
+
   // Handle the signal event.
   cl_event return_event = nullptr;
   cl_int error = 0;
@@ -38,6 +38,7 @@ _cl_mem::_cl_mem(const cl_context context, const cl_mem_flags flags,
       optional_parent(optional_parent),
       host_ptr(host_ptr),
       mux_memories(std::move(mux_memories)),
+      memory_offset(0),
       callbacks(),
       callback_datas(),
       mapCount(0),
@@ -97,13 +98,17 @@ cl_int _cl_mem::allocateMemory(mux_device_t mux_device,
 
   // Device supports host coherent memory and user wants to use a host side
   // pointer. If the pointer alignment is compatible with the device, then
-  // create cl_mem object from this pre-allocated memory.
+  // create cl_mem object from this pre-allocated memory. Buffers with an
+  // unaligned `host_ptr` have a `memory_offset` which rounds it down to an
+  // aligned address, which is always within the same page as `host_ptr`.
   if ((CL_MEM_USE_HOST_PTR & flags) &&
       (device_alloc_caps & mux_allocation_capabilities_coherent_host)) {
-    const uintptr_t host_ptr_uint = reinterpret_cast<uintptr_t>(host_ptr);
-    if (0 == (host_ptr_uint % mux_device->info->buffer_alignment)) {
-      mux_result_t error = muxCreateMemoryFromHost(mux_device, size, host_ptr,
-                                                   mux_allocator, out_memory);
+    void *memory_ptr = static_cast<char *>(host_ptr) - memory_offset;
+    const uintptr_t memory_ptr_uint = reinterpret_cast<uintptr_t>(memory_ptr);
+    if (0 == (memory_ptr_uint % mux_device->info->buffer_alignment)) {
+      mux_result_t error =
+          muxCreateMemoryFromHost(mux_device, memory_offset + size, memory_ptr,
+                                  mux_allocator, out_memory);
       return error ? CL_MEM_OBJECT_ALLOCATION_FAILURE : CL_SUCCESS;
     }
   }
@@ -139,21 +144,23 @@ cl_int _cl_mem::allocateMemory(mux_device_t mux_device,
 
   const uint32_t heap = mux::findFirstSupportedHeap(supported_heaps);
   const uint32_t alignment = 0;  // No alignment preference
-  mux_result_t error =
-      muxAllocateMemory(mux_device, size, heap, memoryProperties,
-                        allocationType, alignment, mux_allocator, out_memory);
+  mux_result_t error = muxAllocateMemory(
+      mux_device, memory_offset + size, heap, memoryProperties, allocationType,
+      alignment, mux_allocator, out_memory);
   OCL_CHECK(error, return CL_MEM_OBJECT_ALLOCATION_FAILURE);
 
   if (CL_MEM_USE_HOST_PTR & flags) {
     // We couldn't use the original user provided host pointer to create device
     // memory. Instead map the newly allocated memory and copy data over from
     // the host pointer.
-    error = muxMapMemory(mux_device, *out_memory, 0, size, &map_base_pointer);
+    error = muxMapMemory(mux_device, *out_memory, memory_offset, size,
+                         &map_base_pointer);
     OCL_CHECK(error, return CL_MEM_OBJECT_ALLOCATION_FAILURE);
 
     std::memcpy(map_base_pointer, host_ptr, size);
 
-    error = muxFlushMappedMemoryToDevice(mux_device, *out_memory, 0, size);
+    error = muxFlushMappedMemoryToDevice(mux_device, *out_memory,
+                                         memory_offset, size);
     OCL_CHECK(error, return CL_MEM_OBJECT_ALLOCATION_FAILURE);
 
     error = muxUnmapMemory(mux_device, *out_memory);
@@ -200,8 +207,9 @@ cl_int _cl_mem::pushMapMemory(cl_command_queue command_queue,
 
       // we map in read to prevent unmap from modifying the buffer on the
       // device if that's not required.
-      auto mux_error = muxMapMemory(device, memory, 0, memory->size,
-                                    &mem_to_map->map_base_pointer);
+      auto mux_error =
+          muxMapMemory(device, memory, mem_to_map->memory_offset,
+                       mem_to_map->size, &mem_to_map->map_base_pointer);
       if (mux_error) {
         return CL_MAP_FAILURE;
       }
@@ -230,13 +238,12 @@ cl_int _cl_mem::pushMapMemory(cl_command_queue command_queue,
     }
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue, event_wait_list);
 
   auto mux_command_buffer =
       command_queue->getCommandBuffer(event_wait_list, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   // mapping state to pass to the user callback
@@ -252,15 +259,17 @@ cl_int _cl_mem::pushMapMemory(cl_command_queue command_queue,
     void flushMemoryFromDevice() {
       mux_device_t device = mem->context->devices[device_index]->mux_device;
       mux_memory_t memory = mem->mux_memories[device_index];
-      mux_result_t error =
-          muxFlushMappedMemoryFromDevice(device, memory, offset, size);
+      mux_result_t error = muxFlushMappedMemoryFromDevice(
+          device, memory, mem->memory_offset + offset, size);
       OCL_ASSERT(mux_success == error,
                  "muxFlushMappedMemoryFromDevice failed!");
       OCL_UNUSED(error);
 
-      if (CL_MEM_USE_HOST_PTR & mem->flags) {
-        // Copy data from `map_base_pointer` containing our cache of the data.
-        // to `host_ptr` user has access to.
+      // Copy data from `map_base_pointer` containing our cache of the data.
+      // to `host_ptr` user has access to, unless the device memory wraps
+      // `host_ptr` in which case there is nothing to copy.
+      if ((CL_MEM_USE_HOST_PTR & mem->flags) &&
+          mem->host_ptr != mem->map_base_pointer) {
         std::memcpy(static_cast<char *>(mem->host_ptr) + offset,
                     static_cast<char *>(mem->map_base_pointer) + offset, size);
       }
@@ -506,13 +515,13 @@ cl::EnqueueUnmapMemObject(cl_command_queue command_queue, cl_mem memobj,
     it->second.is_active = false;
   }
 
-  std::lock_guard<std::mutex> lock(
-      command_queue->context->getCommandQueueMutex());
+  cl::command_queue_lock lock(command_queue,
+                              {event_wait_list, num_events_in_wait_list});
 
   auto mux_command_buffer = command_queue->getCommandBuffer(
       {event_wait_list, num_events_in_wait_list}, return_event);
   if (!mux_command_buffer) {
-    return CL_OUT_OF_RESOURCES;
+    return mux_command_buffer.error();
   }
 
   struct unmap_info_t {
@@ -551,9 +560,11 @@ cl::EnqueueUnmapMemObject(cl_command_queue command_queue, cl_mem memobj,
           if (mem->write_mappings.end() != it) {
             _cl_mem::mapping const &map = it->second;
 
-            if (CL_MEM_USE_HOST_PTR & mem->flags) {
-              // Copy data from `host_ptr` user has accessed/modified to our
-              // cache of the data in `map_base_pointer`.
+            // Copy data from `host_ptr` user has accessed/modified to our
+            // cache of the data in `map_base_pointer`, unless the device
+            // memory wraps `host_ptr` in which case there is nothing to copy.
+            if ((CL_MEM_USE_HOST_PTR & mem->flags) &&
+                mem->host_ptr != mem->map_base_pointer) {
               std::memcpy(
                   static_cast<char *>(mem->map_base_pointer) + map.offset,
                   static_cast<char *>(mem->host_ptr) + map.offset, map.size);
@@ -561,7 +572,8 @@ cl::EnqueueUnmapMemObject(cl_command_queue command_queue, cl_mem memobj,
 
             // flush the memory region back to the device if required
             auto mux_error = muxFlushMappedMemoryToDevice(
-                mux_device, mux_memory, map.offset, map.size);
+                mux_device, mux_memory, mem->memory_offset + map.offset,
+                map.size);
             OCL_ASSERT(!mux_error, "muxFlushMappedMemoryToDevice failed!");
             OCL_UNUSED(mux_error);
 
@@ -98,3 +98,51 @@ void BufferWriteRect(benchmark::State& state) {
 }
 BENCHMARK(BufferWriteRect)->Arg(1)->Arg(256)->Arg(512);
 
+
+// Maps and unmaps a whole CL_MEM_USE_HOST_PTR buffer for writing, the second
+// argument offsets the host pointer from a 4KiB aligned allocation to measure
+// unaligned host pointers.
+void BufferMapUnmapUseHostPtr(benchmark::State& state) {
+  auto device = benchcl::env::get()->device;
+  auto status = CL_SUCCESS;
+
+  auto ctx = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &status);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+  auto qu = clCreateCommandQueue(ctx, device, 0, &status);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+  const size_t size = static_cast<size_t>(state.range(0));
+  const size_t misalignment = static_cast<size_t>(state.range(1));
+  const size_t page_size = 4096;
+
+  auto host_mem = std::vector<char>(size + misalignment + page_size);
+  const uintptr_t host_mem_uint = reinterpret_cast<uintptr_t>(host_mem.data());
+  char* host_ptr = host_mem.data() + (page_size - host_mem_uint % page_size) +
+                   misalignment;
+
+  auto buffer = clCreateBuffer(ctx, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE,
+                               size, host_ptr, &status);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+  for (auto _ : state) {
+    (void)_;
+    void* mapped = clEnqueueMapBuffer(qu, buffer, CL_TRUE,
+                                      CL_MAP_READ | CL_MAP_WRITE, 0, size, 0,
+                                      nullptr, nullptr, &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueUnmapMemObject(qu, buffer, mapped, 0,
+                                                          nullptr, nullptr));
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(qu));
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseMemObject(buffer));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(qu));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseContext(ctx));
+}
+BENCHMARK(BufferMapUnmapUseHostPtr)
+    ->Args({1 << 12, 0})
+    ->Args({1 << 12, 4})
+    ->Args({1 << 24, 0})
+    ->Args({1 << 24, 4});
@@ -38,7 +38,8 @@ struct CreateData {
   }
 };
 
-CreateData create_data_from_source(const std::string& source) {
+CreateData create_data_from_source(const std::string& source,
+                                  const char* options = nullptr) {
   cl_platform_id platform;
   cl_device_id device;
   cl_context context;
@@ -56,7 +57,7 @@ CreateData create_data_from_source(const std::string& source) {
   program = clCreateProgramWithSource(context, 1, &str, nullptr, &status);
   ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
 
-  ASSERT_EQ_ERRCODE(CL_SUCCESS, clBuildProgram(program, 0, nullptr, nullptr,
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clBuildProgram(program, 0, nullptr, options,
                                                nullptr, nullptr));
 
   return CreateData{platform, device, context, program};
@@ -204,6 +205,71 @@ void KernelEnqueueEmpty(benchmark::State& state) {
 }
 BENCHMARK(KernelEnqueueEmpty)->UseManualTime();
 
+// Measures the host-side cost of a single clEnqueueNDRangeKernel call, without
+// waiting for the kernel to run. The argument is the number of kernel
+// arguments, which determines the size of the per-launch descriptor and
+// packed argument storage.
+void KernelEnqueueLatency(benchmark::State& state) {
+  const int num_args = static_cast<int>(state.range(0));
+  std::string source = "kernel void latency(";
+  for (int i = 0; i < num_args; i++) {
+    source += (i ? ", int a" : "int a") + std::to_string(i);
+  }
+  source += ") {}";
+  CreateData cd = create_data_from_source(source);
+
+  cl_int success = CL_SUCCESS;
+  cl_command_queue queue =
+    clCreateCommandQueue(cd.context, cd.device, 0, &success);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, success);
+
+  cl_kernel kernel = clCreateKernel(cd.program, "latency", &success);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, success);
+  for (int i = 0; i < num_args; i++) {
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clSetKernelArg(kernel, i, sizeof(i), &i));
+  }
+
+  // Run once up front so that any kernel specialization is not timed.
+  const size_t global_size = 1;
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                    queue, kernel, 1, nullptr, &global_size,
+                                    nullptr, 0, nullptr, nullptr));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+
+  // Drain the queue periodically, outside of the timed region, so that the
+  // amount of outstanding work stays bounded.
+  constexpr size_t batch_size = 1024;
+  size_t enqueued = 0;
+  for (auto _ : state) {
+    (void)_;
+    namespace chrono = std::chrono;
+    auto start = chrono::high_resolution_clock::now();
+
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                      queue, kernel, 1, nullptr, &global_size,
+                                      nullptr, 0, nullptr, nullptr));
+
+    auto end = chrono::high_resolution_clock::now();
+    auto elapsed = chrono::duration_cast<chrono::duration<double>>(end - start);
+
+    state.SetIterationTime(elapsed.count());
+
+    if (++enqueued % batch_size == 0) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+    }
+  }
+
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseKernel(kernel));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(queue));
+}
+BENCHMARK(KernelEnqueueLatency)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kNanosecond)
+    ->UseManualTime();
+
 void KernelTiledEnqueue(benchmark::State& state) {
   std::string source = R"CL(
     __kernel void vector_addition(__global int *src1, __global int *src2,
@@ -317,6 +383,191 @@ BENCHMARK(KernelTiledEnqueue)
     ->UseManualTime();
 // Nothing special about these values, just more tiles.
 
+void KernelWorkGroupCollective(benchmark::State& state) {
+  cl_device_id device = benchcl::env::get()->device;
+  cl_bool supported = CL_FALSE;
+  if (CL_SUCCESS !=
+          clGetDeviceInfo(device, CL_DEVICE_WORK_GROUP_COLLECTIVE_FUNCTIONS_SUPPORT,
+                          sizeof(supported), &supported, nullptr) ||
+      !supported) {
+    state.SkipWithError("Work-group collective functions not supported");
+    return;
+  }
+
+  const char* const collectives[] = {
+      "work_group_reduce_add(in[gid])",
+      "work_group_scan_inclusive_max(in[gid])",
+      "work_group_scan_exclusive_add(in[gid])",
+      "work_group_broadcast(in[gid], 0)",
+  };
+  const std::string source =
+      "kernel void collective(global int* in, global int* out) {\n"
+      "  size_t gid = get_global_id(0);\n"
+      "  out[gid] = " +
+      std::string(collectives[state.range(0)]) +
+      ";\n"
+      "}\n";
+  CreateData cd = create_data_from_source(source, "-cl-std=CL3.0");
+
+  constexpr size_t item_count = 1 << 20;
+  constexpr size_t bytes = sizeof(cl_int) * item_count;
+  const size_t local_size = state.range(1);
+
+  auto err = cl_int{CL_SUCCESS};
+  cl_mem in_buf =
+      clCreateBuffer(cd.context, CL_MEM_READ_ONLY, bytes, nullptr, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+  cl_mem out_buf =
+      clCreateBuffer(cd.context, CL_MEM_WRITE_ONLY, bytes, nullptr, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+
+  cl_kernel kernel = clCreateKernel(cd.program, "collective", &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clSetKernelArg(kernel, 0, sizeof(in_buf), &in_buf));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clSetKernelArg(kernel, 1, sizeof(out_buf), &out_buf));
+
+  cl_command_queue queue = clCreateCommandQueue(cd.context, device, 0, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+
+  const std::vector<cl_int> in(item_count, 1);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clEnqueueWriteBuffer(queue, in_buf, CL_TRUE, 0, bytes,
+                                         in.data(), 0, nullptr, nullptr));
+
+  // Run once up front so that any kernel specialization is not timed.
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                    queue, kernel, 1, nullptr, &item_count,
+                                    &local_size, 0, nullptr, nullptr));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+
+  for (auto _ : state) {
+    (void)_;
+    namespace chrono = std::chrono;
+    auto start = chrono::high_resolution_clock::now();
+
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                      queue, kernel, 1, nullptr, &item_count,
+                                      &local_size, 0, nullptr, nullptr));
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+
+    auto end = chrono::high_resolution_clock::now();
+    auto elapsed = chrono::duration_cast<chrono::duration<double>>(end - start);
+
+    state.SetIterationTime(elapsed.count());
+  }
+
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseKernel(kernel));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(queue));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseMemObject(out_buf));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseMemObject(in_buf));
+}
+// The first argument selects the collective: reduce, inclusive scan, exclusive
+// scan or broadcast. The second is the local size.
+BENCHMARK(KernelWorkGroupCollective)
+    ->ArgsProduct({{0, 1, 2, 3}, {16, 256}})
+    ->UseManualTime();
+
+// Streams a large buffer through local memory a tile at a time, with a little
+// compute per tile, as tiled kernels do. The argument selects whether tiles
+// are staged with async_work_group_copy (1) or with plain per-item loads and a
+// barrier (0), so the two can be compared to see how much of the copy the
+// target overlaps with computation.
+void KernelAsyncCopyTiled(benchmark::State& state) {
+  const bool use_async = state.range(0);
+  const std::string source = R"CL(
+    #define TILE 256
+    kernel void tiled(global const float* in, global float* out,
+                      uint tiles) {
+      local float tile[TILE];
+      const size_t lid = get_local_id(0);
+      global const float* base = in + get_group_id(0) * tiles * TILE;
+      float acc = 0.0f;
+      for (uint t = 0; t < tiles; t++) {
+    #if USE_ASYNC
+        event_t e = async_work_group_copy(tile, base + t * TILE, TILE, 0);
+        wait_group_events(1, &e);
+    #else
+        tile[lid] = base[t * TILE + lid];
+        barrier(CLK_LOCAL_MEM_FENCE);
+    #endif
+        float v = tile[lid];
+        for (uint k = 1; k < 16; k++) {
+          v = v * 0.5f + tile[(lid + k) % TILE];
+        }
+        acc += v;
+        barrier(CLK_LOCAL_MEM_FENCE);
+      }
+      out[get_global_id(0)] = acc;
+    }
+  )CL";
+  CreateData cd = create_data_from_source(
+      source, use_async ? "-DUSE_ASYNC=1" : "-DUSE_ASYNC=0");
+
+  constexpr size_t tile_size = 256;
+  constexpr cl_uint tiles = 64;
+  constexpr size_t group_count = 1024;
+  constexpr size_t item_count = group_count * tile_size;
+  constexpr size_t in_bytes = sizeof(cl_float) * item_count * tiles;
+  constexpr size_t out_bytes = sizeof(cl_float) * item_count;
+
+  auto err = cl_int{CL_SUCCESS};
+  cl_mem in_buf =
+      clCreateBuffer(cd.context, CL_MEM_READ_ONLY, in_bytes, nullptr, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+  cl_mem out_buf =
+      clCreateBuffer(cd.context, CL_MEM_WRITE_ONLY, out_bytes, nullptr, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+
+  cl_kernel kernel = clCreateKernel(cd.program, "tiled", &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clSetKernelArg(kernel, 0, sizeof(in_buf), &in_buf));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clSetKernelArg(kernel, 1, sizeof(out_buf), &out_buf));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clSetKernelArg(kernel, 2, sizeof(tiles), &tiles));
+
+  cl_command_queue queue =
+      clCreateCommandQueue(cd.context, cd.device, 0, &err);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, err);
+
+  const std::vector<cl_float> in(item_count * tiles, 1.0f);
+  ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                    clEnqueueWriteBuffer(queue, in_buf, CL_TRUE, 0, in_bytes,
+                                         in.data(), 0, nullptr, nullptr));
+
+  // Run once up front so that any kernel specialization is not timed.
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                    queue, kernel, 1, nullptr, &item_count,
+                                    &tile_size, 0, nullptr, nullptr));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+
+  for (auto _ : state) {
+    (void)_;
+    namespace chrono = std::chrono;
+    auto start = chrono::high_resolution_clock::now();
+
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clEnqueueNDRangeKernel(
+                                      queue, kernel, 1, nullptr, &item_count,
+                                      &tile_size, 0, nullptr, nullptr));
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(queue));
+
+    auto end = chrono::high_resolution_clock::now();
+    auto elapsed = chrono::duration_cast<chrono::duration<double>>(end - start);
+
+    state.SetIterationTime(elapsed.count());
+  }
+  state.SetBytesProcessed(state.iterations() * in_bytes);
+
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseKernel(kernel));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(queue));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseMemObject(out_buf));
+  ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseMemObject(in_buf));
+}
+BENCHMARK(KernelAsyncCopyTiled)->Arg(0)->Arg(1)->UseManualTime();
+
 void KernelCreateEmptyKernelFromSource(benchmark::State& state) {
   std::string source = "kernel void empty() {}";
   CreateData cd = create_data_from_source(source);
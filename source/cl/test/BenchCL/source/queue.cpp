@@ -20,6 +20,7 @@
 #include <benchmark/benchmark.h>
 #include <string>
 #include <thread>
+#include <vector>
 
 struct CreateData {
   enum { BUFFER_LENGTH = 16384, BUFFER_SIZE = BUFFER_LENGTH * sizeof(cl_int) };
@@ -254,3 +255,102 @@ BENCHMARK(MultiThreadMultiQueue)
     ->Arg(256)
     ->Arg(1024)
     ->Threads(std::thread::hardware_concurrency());
+
+// Unlike the benchmarks above, where each thread creates its own context, all
+// threads here share one context and kernel and each enqueue to their own
+// queue. This measures how much enqueues to independent queues in the same
+// context contend with each other.
+struct SharedContextData {
+  CreateData cd;
+  std::vector<cl_command_queue> queues;
+
+  explicit SharedContextData(int num_queues) {
+    queues.push_back(cd.queue);
+    for (int i = 1; i < num_queues; i++) {
+      cl_int status = CL_SUCCESS;
+      queues.push_back(clCreateCommandQueue(cd.context, cd.device, 0, &status));
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+    }
+  }
+
+  ~SharedContextData() {
+    for (size_t i = 1; i < queues.size(); i++) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(queues[i]));
+    }
+  }
+};
+
+static SharedContextData* shared_context_data = nullptr;
+
+void MultiThreadSharedContextMultiQueue(benchmark::State& state) {
+  if (0 == state.thread_index) {
+    shared_context_data = new SharedContextData(state.threads);
+  }
+
+  for (auto _ : state) {
+    (void)_;
+    cl_command_queue queue = shared_context_data->queues[state.thread_index];
+    for (unsigned i = 0; i < state.range(0); i++) {
+      size_t size = CreateData::BUFFER_LENGTH;
+      clEnqueueNDRangeKernel(queue, shared_context_data->cd.kernel, 1, nullptr,
+                             &size, nullptr, 0, nullptr, nullptr);
+    }
+
+    clFinish(queue);
+  }
+
+  if (0 == state.thread_index) {
+    delete shared_context_data;
+    shared_context_data = nullptr;
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(MultiThreadSharedContextMultiQueue)
+    ->Arg(1)
+    ->Arg(256)
+    ->Arg(1024)
+    ->ThreadRange(1, std::thread::hardware_concurrency())
+    ->UseRealTime();
+
+// Keeps a large number of events outstanding: every command waits on a user
+// event, which holds it pending, and on the previous command's event, which
+// is alternately on one of two queues. This measures the cost of resolving
+// event dependencies, and of releasing everything once the user event is
+// completed, as the number of in-flight events grows.
+void OutstandingEvents(benchmark::State& state) {
+  SharedContextData data(2);
+  const size_t size = 1;
+  const size_t num_events = state.range(0);
+  std::vector<cl_event> events(num_events);
+
+  for (auto _ : state) {
+    (void)_;
+    cl_int status = CL_SUCCESS;
+    cl_event gate = clCreateUserEvent(data.cd.context, &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+    for (size_t i = 0; i < num_events; i++) {
+      const cl_event wait_list[2] = {gate, i ? events[i - 1] : nullptr};
+      ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                        clEnqueueNDRangeKernel(
+                            data.queues[i % 2], data.cd.kernel, 1, nullptr,
+                            &size, nullptr, i ? 2 : 1, wait_list, &events[i]));
+    }
+
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clSetUserEventStatus(gate, CL_COMPLETE));
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(data.queues[0]));
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(data.queues[1]));
+
+    for (auto event : events) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseEvent(event));
+    }
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseEvent(gate));
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_events);
+}
+BENCHMARK(OutstandingEvents)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
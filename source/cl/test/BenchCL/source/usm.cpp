@@ -0,0 +1,179 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <BenchCL/environment.h>
+#include <BenchCL/error.h>
+#include <CL/cl.h>
+#include <CL/cl_ext.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+/// @brief Context populated with a configurable number of live USM device
+/// allocations, used to measure how USM pointer lookups scale.
+struct UsmData {
+  cl_context context = nullptr;
+  cl_command_queue queue = nullptr;
+  cl_program program = nullptr;
+  cl_kernel kernel = nullptr;
+  std::vector<void*> allocations;
+
+  clDeviceMemAllocINTEL_fn clDeviceMemAllocINTEL = nullptr;
+  clMemBlockingFreeINTEL_fn clMemBlockingFreeINTEL = nullptr;
+  clSetKernelArgMemPointerINTEL_fn clSetKernelArgMemPointerINTEL = nullptr;
+  clEnqueueMemcpyINTEL_fn clEnqueueMemcpyINTEL = nullptr;
+
+  static constexpr size_t allocation_size = 256;
+
+  /// @brief Creates `num_allocations` device USM allocations.
+  ///
+  /// @return False if the device does not support the USM extension.
+  bool setup(size_t num_allocations) {
+    auto platform = benchcl::env::get()->platform;
+    auto device = benchcl::env::get()->device;
+
+    size_t extensions_size = 0;
+    ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                      clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, 0, nullptr,
+                                      &extensions_size));
+    std::string extensions(extensions_size, '\0');
+    ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                      clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS,
+                                      extensions_size, extensions.data(),
+                                      nullptr));
+    if (std::string::npos ==
+        extensions.find("cl_intel_unified_shared_memory")) {
+      return false;
+    }
+
+    clDeviceMemAllocINTEL = reinterpret_cast<clDeviceMemAllocINTEL_fn>(
+        clGetExtensionFunctionAddressForPlatform(platform,
+                                                 "clDeviceMemAllocINTEL"));
+    clMemBlockingFreeINTEL = reinterpret_cast<clMemBlockingFreeINTEL_fn>(
+        clGetExtensionFunctionAddressForPlatform(platform,
+                                                 "clMemBlockingFreeINTEL"));
+    clSetKernelArgMemPointerINTEL =
+        reinterpret_cast<clSetKernelArgMemPointerINTEL_fn>(
+            clGetExtensionFunctionAddressForPlatform(
+                platform, "clSetKernelArgMemPointerINTEL"));
+    clEnqueueMemcpyINTEL = reinterpret_cast<clEnqueueMemcpyINTEL_fn>(
+        clGetExtensionFunctionAddressForPlatform(platform,
+                                                 "clEnqueueMemcpyINTEL"));
+    if (!clDeviceMemAllocINTEL || !clMemBlockingFreeINTEL ||
+        !clSetKernelArgMemPointerINTEL || !clEnqueueMemcpyINTEL) {
+      return false;
+    }
+
+    cl_int status = CL_SUCCESS;
+    context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+    queue = clCreateCommandQueue(context, device, 0, &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+    const char* source =
+        "kernel void foo(global int* a) { a[get_global_id(0)] = 0; }";
+    program = clCreateProgramWithSource(context, 1, &source, nullptr, &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clBuildProgram(program, 0, nullptr, nullptr,
+                                                 nullptr, nullptr));
+
+    kernel = clCreateKernel(program, "foo", &status);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+
+    allocations.reserve(num_allocations);
+    for (size_t i = 0; i < num_allocations; i++) {
+      void* ptr = clDeviceMemAllocINTEL(context, device, nullptr,
+                                        allocation_size, 0, &status);
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, status);
+      allocations.push_back(ptr);
+    }
+    return true;
+  }
+
+  ~UsmData() {
+    for (void* ptr : allocations) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clMemBlockingFreeINTEL(context, ptr));
+    }
+    if (kernel) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseKernel(kernel));
+    }
+    if (program) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseProgram(program));
+    }
+    if (queue) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseCommandQueue(queue));
+    }
+    if (context) {
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, clReleaseContext(context));
+    }
+  }
+};
+}  // namespace
+
+void UsmSetKernelArgMemPointer(benchmark::State& state) {
+  UsmData data;
+  if (!data.setup(static_cast<size_t>(state.range(0)))) {
+    state.SkipWithError("cl_intel_unified_shared_memory not supported");
+    return;
+  }
+
+  // Point into the middle of allocations spread across the whole set so every
+  // call has to resolve the owning allocation rather than a base pointer.
+  const size_t num_allocations = data.allocations.size();
+  size_t index = 0;
+  for (auto _ : state) {
+    (void)_;
+    auto ptr = static_cast<char*>(data.allocations[index]) +
+               (UsmData::allocation_size / 2);
+    ASSERT_EQ_ERRCODE(CL_SUCCESS,
+                      data.clSetKernelArgMemPointerINTEL(data.kernel, 0, ptr));
+    index = (index + 7919) % num_allocations;
+  }
+}
+BENCHMARK(UsmSetKernelArgMemPointer)->Arg(1)->Arg(1000)->Arg(10000);
+
+void UsmEnqueueMemcpy(benchmark::State& state) {
+  UsmData data;
+  if (!data.setup(static_cast<size_t>(state.range(0)))) {
+    state.SkipWithError("cl_intel_unified_shared_memory not supported");
+    return;
+  }
+
+  const size_t num_allocations = data.allocations.size();
+  const size_t copies_per_iteration = 64;
+  size_t index = 0;
+  for (auto _ : state) {
+    (void)_;
+    for (size_t i = 0; i < copies_per_iteration; i++) {
+      // Copy between halves so that source and destination never overlap,
+      // even when they come from the same allocation.
+      void* dst = data.allocations[index];
+      index = (index + 7919) % num_allocations;
+      const void* src = static_cast<const char*>(data.allocations[index]) +
+                        (UsmData::allocation_size / 2);
+      ASSERT_EQ_ERRCODE(CL_SUCCESS, data.clEnqueueMemcpyINTEL(
+                                        data.queue, CL_FALSE, dst, src,
+                                        UsmData::allocation_size / 2, 0,
+                                        nullptr, nullptr));
+    }
+    ASSERT_EQ_ERRCODE(CL_SUCCESS, clFinish(data.queue));
+  }
+  state.SetItemsProcessed(state.iterations() * copies_per_iteration);
+}
+BENCHMARK(UsmEnqueueMemcpy)->Arg(1)->Arg(1000)->Arg(10000);
@@ -0,0 +1,105 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef UNITCL_COMMAND_BUFFER_CAPTURE_H_INCLUDED
+#define UNITCL_COMMAND_BUFFER_CAPTURE_H_INCLUDED
+
+#include <CL/cl_ext_codeplay.h>
+
+#include "cl_khr_command_buffer.h"
+
+// Fixture checks the capture extension is enabled, queries the entry points,
+// and creates a command-buffer, buffers, and a kernel to capture.
+struct cl_codeplay_command_buffer_capture_Test
+    : public cl_khr_command_buffer_Test {
+  void SetUp() override {
+    UCL_RETURN_ON_FATAL_FAILURE(cl_khr_command_buffer_Test::SetUp());
+    if (!UCL::hasDeviceExtensionSupport(device,
+                                        "cl_codeplay_command_buffer_capture")) {
+      GTEST_SKIP();
+    }
+
+    // Requires a compiler to compile the kernel.
+    if (!getDeviceCompilerAvailable()) {
+      GTEST_SKIP();
+    }
+
+#define GET_EXTENSION_ADDRESS(FUNC)                               \
+  FUNC = reinterpret_cast<FUNC##_fn>(                             \
+      clGetExtensionFunctionAddressForPlatform(platform, #FUNC)); \
+  ASSERT_NE(nullptr, FUNC) << "Could not get address of " << #FUNC;
+
+    GET_EXTENSION_ADDRESS(clCommandBufferBeginCaptureCODEPLAY);
+    GET_EXTENSION_ADDRESS(clCommandBufferEndCaptureCODEPLAY);
+
+#undef GET_EXTENSION_ADDRESS
+
+    cl_int error = CL_SUCCESS;
+    command_buffer =
+        clCreateCommandBufferKHR(1, &command_queue, nullptr, &error);
+    ASSERT_SUCCESS(error);
+
+    buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, data_size_in_bytes,
+                            nullptr, &error);
+    ASSERT_SUCCESS(error);
+
+    const char *kernel_source = R"(
+        void kernel add_one(global int *buffer) {
+          size_t gid = get_global_id(0);
+          buffer[gid] += 1;
+        }
+        )";
+    const size_t kernel_source_length = std::strlen(kernel_source);
+    program = clCreateProgramWithSource(context, 1, &kernel_source,
+                                        &kernel_source_length, &error);
+    ASSERT_SUCCESS(error);
+    ASSERT_SUCCESS(clBuildProgram(program, 1, &device, nullptr,
+                                  ucl::buildLogCallback, nullptr));
+    kernel = clCreateKernel(program, "add_one", &error);
+    ASSERT_SUCCESS(error);
+    ASSERT_SUCCESS(clSetKernelArg(kernel, 0, sizeof(cl_mem), &buffer));
+  }
+
+  void TearDown() override {
+    if (nullptr != command_buffer) {
+      EXPECT_SUCCESS(clReleaseCommandBufferKHR(command_buffer));
+    }
+    if (nullptr != kernel) {
+      EXPECT_SUCCESS(clReleaseKernel(kernel));
+    }
+    if (nullptr != program) {
+      EXPECT_SUCCESS(clReleaseProgram(program));
+    }
+    if (nullptr != buffer) {
+      EXPECT_SUCCESS(clReleaseMemObject(buffer));
+    }
+    cl_khr_command_buffer_Test::TearDown();
+  }
+
+  clCommandBufferBeginCaptureCODEPLAY_fn clCommandBufferBeginCaptureCODEPLAY =
+      nullptr;
+  clCommandBufferEndCaptureCODEPLAY_fn clCommandBufferEndCaptureCODEPLAY =
+      nullptr;
+
+  cl_command_buffer_khr command_buffer = nullptr;
+  cl_mem buffer = nullptr;
+  cl_program program = nullptr;
+  cl_kernel kernel = nullptr;
+
+  constexpr static size_t global_size = 256;
+  constexpr static size_t data_size_in_bytes = global_size * sizeof(cl_int);
+};
+#endif  // UNITCL_COMMAND_BUFFER_CAPTURE_H_INCLUDED
@@ -787,6 +787,15 @@ set(KERNEL_FILES
   ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.14_scan_inclusive_max_uint.cl
   ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.14_scan_inclusive_max_long.cl
   ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.14_scan_inclusive_max_ulong.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.15_reduce_add_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.15_reduce_min_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.15_reduce_max_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.16_scan_exclusive_add_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.16_scan_exclusive_min_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.16_scan_exclusive_max_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.17_scan_inclusive_add_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.17_scan_inclusive_min_float.cl
+  ${CMAKE_CURRENT_SOURCE_DIR}/work_group_collective_functions.17_scan_inclusive_max_float.cl
   )
 
 if(${OCL_EXTENSION_cl_khr_extended_async_copies})
@@ -49,6 +49,30 @@ TEST_F(clCreateCommandQueueWithPropertiesTest, DefaultProfiling) {
   ASSERT_SUCCESS(clReleaseCommandQueue(command_queue));
 }
 
+TEST_F(clCreateCommandQueueWithPropertiesTest, OutOfOrderExecMode) {
+  cl_command_queue_properties device_properties = 0;
+  ASSERT_SUCCESS(clGetDeviceInfo(device, CL_DEVICE_QUEUE_PROPERTIES,
+                                 sizeof(device_properties), &device_properties,
+                                 nullptr));
+  std::array<cl_queue_properties, 3> properties{
+      {CL_QUEUE_PROPERTIES, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, 0}};
+  cl_int error;
+  cl_command_queue command_queue = clCreateCommandQueueWithProperties(
+      context, device, properties.data(), &error);
+  if (0 == (CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE & device_properties)) {
+    ASSERT_EQ_ERRCODE(CL_INVALID_QUEUE_PROPERTIES, error);
+    ASSERT_EQ(nullptr, command_queue);
+    return;
+  }
+  ASSERT_SUCCESS(error);
+  cl_command_queue_properties command_queue_properties;
+  EXPECT_SUCCESS(clGetCommandQueueInfo(
+      command_queue, CL_QUEUE_PROPERTIES, sizeof(command_queue_properties),
+      &command_queue_properties, nullptr));
+  EXPECT_EQ(properties[1], command_queue_properties);
+  ASSERT_SUCCESS(clReleaseCommandQueue(command_queue));
+}
+
 TEST_F(clCreateCommandQueueWithPropertiesTest, InvalidContext) {
   cl_int error;
   cl_command_queue command_queue =
@@ -69,7 +93,7 @@ TEST_F(clCreateCommandQueueWithPropertiesTest, InvalidQueueProperties) {
   cl_int error;
   // Try with one bit that we don't support.
   std::array<cl_queue_properties, 3> properties{
-      {CL_QUEUE_PROPERTIES, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, 0}};
+      {CL_QUEUE_PROPERTIES, CL_QUEUE_ON_DEVICE, 0}};
   cl_command_queue command_queue = clCreateCommandQueueWithProperties(
       context, device, properties.data(), &error);
   ASSERT_EQ_ERRCODE(CL_INVALID_QUEUE_PROPERTIES, error);
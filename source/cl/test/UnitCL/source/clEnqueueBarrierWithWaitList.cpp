@@ -91,4 +91,55 @@ TEST_F(clEnqueueBarrierWithWaitListTest, DefaultNoEventWaitList) {
   ASSERT_SUCCESS(clReleaseEvent(barrier_event));
 }
 
+TEST_F(clEnqueueBarrierWithWaitListTest, OutOfOrderQueue) {
+  cl_command_queue_properties properties = 0;
+  ASSERT_SUCCESS(clGetDeviceInfo(device, CL_DEVICE_QUEUE_PROPERTIES,
+                                 sizeof(properties), &properties, nullptr));
+  if (0 == (CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE & properties)) {
+    GTEST_SKIP();
+  }
+
+  cl_int status;
+  cl_command_queue queue = clCreateCommandQueue(
+      context, device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &status);
+  EXPECT_TRUE(queue);
+  ASSERT_SUCCESS(status);
+  cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int),
+                                 nullptr, &status);
+  EXPECT_TRUE(buffer);
+  ASSERT_SUCCESS(status);
+  cl_event user_event = clCreateUserEvent(context, &status);
+  EXPECT_TRUE(user_event);
+  ASSERT_SUCCESS(status);
+
+  // The first fill can't start until the user event is complete, without the
+  // barrier the second fill would be free to execute before it.
+  const cl_int first = 1;
+  ASSERT_SUCCESS(clEnqueueFillBuffer(queue, buffer, &first, sizeof(cl_int), 0,
+                                     sizeof(cl_int), 1, &user_event, nullptr));
+  ASSERT_SUCCESS(clEnqueueBarrierWithWaitList(queue, 0, nullptr, nullptr));
+  const cl_int second = 2;
+  cl_event fill_event;
+  ASSERT_SUCCESS(clEnqueueFillBuffer(queue, buffer, &second, sizeof(cl_int), 0,
+                                     sizeof(cl_int), 0, nullptr, &fill_event));
+  ASSERT_SUCCESS(clFlush(queue));
+
+  cl_int fill_status;
+  ASSERT_SUCCESS(clGetEventInfo(fill_event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                sizeof(fill_status), &fill_status, nullptr));
+  EXPECT_NE(CL_COMPLETE, fill_status);
+
+  ASSERT_SUCCESS(clSetUserEventStatus(user_event, CL_COMPLETE));
+  cl_int result = 0;
+  ASSERT_SUCCESS(clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0,
+                                     sizeof(cl_int), &result, 1, &fill_event,
+                                     nullptr));
+  EXPECT_EQ(second, result);
+
+  ASSERT_SUCCESS(clReleaseEvent(fill_event));
+  ASSERT_SUCCESS(clReleaseEvent(user_event));
+  ASSERT_SUCCESS(clReleaseMemObject(buffer));
+  ASSERT_SUCCESS(clReleaseCommandQueue(queue));
+}
+
 GENERATE_EVENT_WAIT_LIST_TESTS(clEnqueueBarrierWithWaitListTest)
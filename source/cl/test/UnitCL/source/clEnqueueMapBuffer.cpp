@@ -277,6 +277,42 @@ TEST_F(clEnqueueMapBufferTestHostPtr, DefaultWriteInvalidateHostPtr) {
     EXPECT_EQ(-i, outBuffer[i]);
   }
 }
+
+TEST_F(clEnqueueMapBufferTestHostPtr, UnalignedHostPtrSubBuffer) {
+  // The host pointer is deliberately unaligned, check that a sub-buffer of it
+  // sees the same data as the host pointer and mappings of the parent.
+  const size_t origin = getDeviceMemBaseAddrAlign() / 8;
+  const cl_buffer_region region = {origin, int_size - origin};
+  cl_int errcode = !CL_SUCCESS;
+  cl_mem sub_buffer =
+      clCreateSubBuffer(inMem, 0, CL_BUFFER_CREATE_TYPE_REGION, &region,
+                        &errcode);
+  ASSERT_SUCCESS(errcode);
+
+  int *const map = reinterpret_cast<int *>(clEnqueueMapBuffer(
+      command_queue, inMem, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, int_size,
+      0, nullptr, nullptr, &errcode));
+  ASSERT_SUCCESS(errcode);
+  EXPECT_EQ(static_cast<void *>(hostBuffer.data() + 1),
+            static_cast<void *>(map));
+  for (int i = 0; i < static_cast<cl_int>(size); i++) {
+    EXPECT_EQ(inBuffer[i], map[i]);
+    map[i] = -i;
+  }
+  ASSERT_SUCCESS(clEnqueueUnmapMemObject(command_queue, inMem, map, 0, nullptr,
+                                         nullptr));
+
+  ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, sub_buffer, CL_TRUE, 0,
+                                     region.size, outBuffer.data(), 0, nullptr,
+                                     nullptr));
+  const size_t first = origin / sizeof(int);
+  for (size_t i = 0; i < region.size / sizeof(int); i++) {
+    EXPECT_EQ(-static_cast<cl_int>(first + i), outBuffer[i]);
+  }
+
+  EXPECT_SUCCESS(clReleaseMemObject(sub_buffer));
+}
+
 TEST_F(clEnqueueMapBufferTest, DefaultWriteInvalidateBlocking) {
   cl_int errcode = !CL_SUCCESS;
   int *const map = static_cast<int *>(clEnqueueMapBuffer(
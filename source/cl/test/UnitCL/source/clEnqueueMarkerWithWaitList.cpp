@@ -58,6 +58,51 @@ TEST_F(clEnqueueMarkerWithWaitListTest, EmptyList) {
   ASSERT_SUCCESS(clReleaseEvent(markerEvent));
 }
 
+TEST_F(clEnqueueMarkerWithWaitListTest, OutOfOrderQueueEmptyList) {
+  cl_command_queue_properties properties = 0;
+  ASSERT_SUCCESS(clGetDeviceInfo(device, CL_DEVICE_QUEUE_PROPERTIES,
+                                 sizeof(properties), &properties, nullptr));
+  if (0 == (CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE & properties)) {
+    GTEST_SKIP();
+  }
+
+  cl_int errorcode = !CL_SUCCESS;
+  cl_command_queue queue = clCreateCommandQueue(
+      context, device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &errorcode);
+  EXPECT_TRUE(queue);
+  ASSERT_SUCCESS(errorcode);
+  cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int),
+                                 nullptr, &errorcode);
+  EXPECT_TRUE(buffer);
+  ASSERT_SUCCESS(errorcode);
+  cl_event event = clCreateUserEvent(context, &errorcode);
+  EXPECT_TRUE(event);
+  ASSERT_SUCCESS(errorcode);
+
+  // A marker with an empty wait list waits for all previously enqueued
+  // commands, including those which are blocked on a user event.
+  const cl_int pattern = 42;
+  ASSERT_SUCCESS(clEnqueueFillBuffer(queue, buffer, &pattern, sizeof(cl_int),
+                                     0, sizeof(cl_int), 1, &event, nullptr));
+  cl_event markerEvent = nullptr;
+  ASSERT_SUCCESS(clEnqueueMarkerWithWaitList(queue, 0, nullptr, &markerEvent));
+  ASSERT_TRUE(markerEvent);
+  ASSERT_SUCCESS(clFlush(queue));
+
+  cl_int status;
+  ASSERT_SUCCESS(clGetEventInfo(markerEvent, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                                sizeof(status), &status, nullptr));
+  EXPECT_NE(CL_COMPLETE, status);
+
+  ASSERT_SUCCESS(clSetUserEventStatus(event, CL_COMPLETE));
+  ASSERT_SUCCESS(clWaitForEvents(1, &markerEvent));
+
+  ASSERT_SUCCESS(clReleaseEvent(markerEvent));
+  ASSERT_SUCCESS(clReleaseEvent(event));
+  ASSERT_SUCCESS(clReleaseMemObject(buffer));
+  ASSERT_SUCCESS(clReleaseCommandQueue(queue));
+}
+
 TEST_F(clEnqueueMarkerWithWaitListTest, InvalidCommandQueue) {
   cl_event markerEvent = nullptr;
   ASSERT_EQ_ERRCODE(
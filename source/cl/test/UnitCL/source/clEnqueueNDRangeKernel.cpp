@@ -455,6 +455,38 @@ TEST_F(clEnqueueNDRangeKernelTest, NullBuffer) {
                                         nullptr));
 }
 
+// Enqueues more distinct local sizes than the runtime keeps specialized
+// kernels loaded for, while they are all in flight, then enqueues them all
+// again. This checks that kernels still in use aren't evicted from the cache
+// and that evicted kernels are correctly recreated.
+TEST_F(clEnqueueNDRangeKernelTest, ManyLocalSizesInFlight) {
+  const size_t max_local_size =
+      std::min<size_t>(getDeviceMaxWorkGroupSize(), 24);
+
+  for (int pass = 0; pass < 2; pass++) {
+    cl_int err;
+    cl_event user_event = clCreateUserEvent(context, &err);
+    ASSERT_TRUE(user_event);
+    ASSERT_SUCCESS(err);
+
+    for (size_t local_size = 1; local_size <= max_local_size; local_size++) {
+      const size_t global_size = local_size * 2;
+      ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                            &global_size, &local_size, 1,
+                                            &user_event, nullptr));
+    }
+
+    ASSERT_SUCCESS(clSetUserEventStatus(user_event, CL_COMPLETE));
+    ASSERT_SUCCESS(clFinish(command_queue));
+    EXPECT_SUCCESS(clReleaseEvent(user_event));
+
+    char readBuffer[SIZE];
+    ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, outMem, CL_TRUE, 0, SIZE,
+                                       readBuffer, 0, nullptr, nullptr));
+    ASSERT_EQ(buffer[0], readBuffer[0]);
+  }
+}
+
 GENERATE_EVENT_WAIT_LIST_TESTS(clEnqueueNDRangeKernelTest)
 
 // This test exists to prove that no data-race on LLVM global variables exists
@@ -229,3 +229,40 @@ TEST_F(clFlushTest, EnqueueFlushCallback) {
   clReleaseKernel(kernel);
   clReleaseProgram(program);
 }
+
+// Enqueues waiting on an event from another command queue lock both queues,
+// and flushing the waiting queue flushes the signalling one once its lock is
+// released. Do both from two threads in opposite directions, the signalling
+// markers are never flushed explicitly so waiting relies on the implicit
+// flush.
+TEST_F(clFlushTest, ConcurrentCrossQueueDependencies) {
+  cl_int errcode = !CL_SUCCESS;
+  cl_command_queue other_queue =
+      clCreateCommandQueue(context, device, 0, &errcode);
+  EXPECT_TRUE(other_queue);
+  ASSERT_SUCCESS(errcode);
+
+  auto worker = [](cl_command_queue signal_queue, cl_command_queue wait_queue) {
+    for (int i = 0; i < 64; i++) {
+      cl_event signal_event;
+      ASSERT_SUCCESS(clEnqueueMarkerWithWaitList(signal_queue, 0, nullptr,
+                                                 &signal_event));
+      cl_event wait_event;
+      ASSERT_SUCCESS(clEnqueueMarkerWithWaitList(wait_queue, 1, &signal_event,
+                                                 &wait_event));
+      ASSERT_SUCCESS(clFlush(wait_queue));
+      ASSERT_SUCCESS(clWaitForEvents(1, &wait_event));
+      ASSERT_SUCCESS(clReleaseEvent(wait_event));
+      ASSERT_SUCCESS(clReleaseEvent(signal_event));
+    }
+  };
+
+  std::thread first(worker, command_queue, other_queue);
+  std::thread second(worker, other_queue, command_queue);
+  first.join();
+  second.join();
+
+  ASSERT_SUCCESS(clFinish(command_queue));
+  ASSERT_SUCCESS(clFinish(other_queue));
+  ASSERT_SUCCESS(clReleaseCommandQueue(other_queue));
+}
@@ -0,0 +1,261 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "cl_codeplay_command_buffer_capture.h"
+
+#if __cplusplus < 201703L
+// C++14 and below require static member definitions be defined outside the
+// class even if they are initialized inline. TODO: Remove condition once we no
+// longer support earlier than LLVM 15.
+constexpr size_t cl_codeplay_command_buffer_capture_Test::global_size;
+constexpr size_t cl_codeplay_command_buffer_capture_Test::data_size_in_bytes;
+#endif
+
+using clCommandBufferCaptureCODEPLAYTest =
+    cl_codeplay_command_buffer_capture_Test;
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, InvalidCommandQueue) {
+  EXPECT_EQ_ERRCODE(CL_INVALID_COMMAND_QUEUE,
+                    clCommandBufferBeginCaptureCODEPLAY(nullptr,
+                                                        command_buffer));
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_COMMAND_QUEUE,
+      clCommandBufferEndCaptureCODEPLAY(nullptr, 0, nullptr, nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, InvalidCommandBuffer) {
+  EXPECT_EQ_ERRCODE(CL_INVALID_COMMAND_BUFFER_KHR,
+                    clCommandBufferBeginCaptureCODEPLAY(command_queue,
+                                                        nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, FinalizedCommandBuffer) {
+  ASSERT_SUCCESS(clFinalizeCommandBufferKHR(command_buffer));
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_OPERATION,
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, AlreadyCapturing) {
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_OPERATION,
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  EXPECT_SUCCESS(
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, NotCapturing) {
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_OPERATION,
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, EventsNotAllowed) {
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  cl_event event = nullptr;
+  EXPECT_EQ_ERRCODE(CL_INVALID_OPERATION,
+                    clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                           &global_size, nullptr, 0, nullptr,
+                                           &event));
+  EXPECT_EQ(nullptr, event);
+  EXPECT_SUCCESS(
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, UnsupportedCommand) {
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  std::vector<cl_int> data(global_size, 0);
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_OPERATION,
+      clEnqueueWriteBuffer(command_queue, buffer, CL_FALSE, 0,
+                           data_size_in_bytes, data.data(), 0, nullptr,
+                           nullptr));
+  EXPECT_SUCCESS(
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, CaptureAndReplay) {
+  std::vector<cl_int> data(global_size, 100);
+  ASSERT_SUCCESS(clEnqueueWriteBuffer(command_queue, buffer, CL_TRUE, 0,
+                                      data_size_in_bytes, data.data(), 0,
+                                      nullptr, nullptr));
+
+  // Capture the same sequence of commands an application would enqueue each
+  // iteration.
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  const cl_int zero = 0;
+  ASSERT_SUCCESS(clEnqueueFillBuffer(command_queue, buffer, &zero,
+                                     sizeof(zero), 0, data_size_in_bytes, 0,
+                                     nullptr, nullptr));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                          &global_size, nullptr, 0, nullptr,
+                                          nullptr));
+  }
+  cl_uint num_mutable_handles = 42;
+  ASSERT_SUCCESS(clCommandBufferEndCaptureCODEPLAY(
+      command_queue, 0, nullptr, &num_mutable_handles));
+  // The command-buffer is not mutable so no handles are returned.
+  EXPECT_EQ(0, num_mutable_handles);
+
+  // Captured commands must not have been executed.
+  ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, 0,
+                                     data_size_in_bytes, data.data(), 0,
+                                     nullptr, nullptr));
+  EXPECT_EQ(std::vector<cl_int>(global_size, 100), data);
+
+  cl_command_buffer_state_khr state = 0;
+  ASSERT_SUCCESS(clGetCommandBufferInfoKHR(command_buffer,
+                                           CL_COMMAND_BUFFER_STATE_KHR,
+                                           sizeof(state), &state, nullptr));
+  EXPECT_EQ(CL_COMMAND_BUFFER_STATE_EXECUTABLE_KHR, state);
+
+  for (int replay = 0; replay < 2; replay++) {
+    ASSERT_SUCCESS(clEnqueueCommandBufferKHR(0, nullptr, command_buffer, 0,
+                                             nullptr, nullptr));
+    ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, 0,
+                                       data_size_in_bytes, data.data(), 0,
+                                       nullptr, nullptr));
+    EXPECT_EQ(std::vector<cl_int>(global_size, 3), data);
+  }
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, ReplayWithUpdatedArguments) {
+  if (!UCL::hasDeviceExtensionSupport(
+          device, "cl_khr_command_buffer_mutable_dispatch")) {
+    GTEST_SKIP();
+  }
+  auto clUpdateMutableCommandsKHR =
+      reinterpret_cast<clUpdateMutableCommandsKHR_fn>(
+          clGetExtensionFunctionAddressForPlatform(
+              platform, "clUpdateMutableCommandsKHR"));
+  ASSERT_NE(nullptr, clUpdateMutableCommandsKHR);
+
+  cl_int error = CL_SUCCESS;
+  cl_command_buffer_properties_khr properties[3] = {
+      CL_COMMAND_BUFFER_FLAGS_KHR, CL_COMMAND_BUFFER_MUTABLE_KHR, 0};
+  cl_command_buffer_khr mutable_command_buffer =
+      clCreateCommandBufferKHR(1, &command_queue, properties, &error);
+  ASSERT_SUCCESS(error);
+  cl_mem other_buffer = clCreateBuffer(context, CL_MEM_READ_WRITE,
+                                       data_size_in_bytes, nullptr, &error);
+  ASSERT_SUCCESS(error);
+
+  std::vector<cl_int> data(global_size, 7);
+  ASSERT_SUCCESS(clEnqueueWriteBuffer(command_queue, buffer, CL_TRUE, 0,
+                                      data_size_in_bytes, data.data(), 0,
+                                      nullptr, nullptr));
+  ASSERT_SUCCESS(clEnqueueWriteBuffer(command_queue, other_buffer, CL_TRUE, 0,
+                                      data_size_in_bytes, data.data(), 0,
+                                      nullptr, nullptr));
+
+  ASSERT_SUCCESS(clCommandBufferBeginCaptureCODEPLAY(command_queue,
+                                                     mutable_command_buffer));
+  ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                        &global_size, nullptr, 0, nullptr,
+                                        nullptr));
+  // Too little storage for the captured handles leaves capture running.
+  cl_mutable_command_khr command_handle = nullptr;
+  EXPECT_EQ_ERRCODE(CL_INVALID_VALUE,
+                    clCommandBufferEndCaptureCODEPLAY(
+                        command_queue, 0, &command_handle, nullptr));
+  cl_uint num_mutable_handles = 0;
+  ASSERT_SUCCESS(clCommandBufferEndCaptureCODEPLAY(
+      command_queue, 1, &command_handle, &num_mutable_handles));
+  ASSERT_EQ(1, num_mutable_handles);
+  ASSERT_NE(nullptr, command_handle);
+
+  // Replay with the kernel argument pointing at a different buffer.
+  cl_mutable_dispatch_arg_khr arg{0, sizeof(cl_mem), &other_buffer};
+  cl_mutable_dispatch_config_khr dispatch_config{
+      CL_STRUCTURE_TYPE_MUTABLE_DISPATCH_CONFIG_KHR,
+      nullptr,
+      command_handle,
+      1,
+      0,
+      0,
+      0,
+      &arg,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr};
+  cl_mutable_base_config_khr mutable_config{
+      CL_STRUCTURE_TYPE_MUTABLE_BASE_CONFIG_KHR, nullptr, 1, &dispatch_config};
+  EXPECT_SUCCESS(
+      clUpdateMutableCommandsKHR(mutable_command_buffer, &mutable_config));
+  EXPECT_SUCCESS(clEnqueueCommandBufferKHR(0, nullptr, mutable_command_buffer,
+                                           0, nullptr, nullptr));
+
+  ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, 0,
+                                     data_size_in_bytes, data.data(), 0,
+                                     nullptr, nullptr));
+  EXPECT_EQ(std::vector<cl_int>(global_size, 7), data);
+  ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, other_buffer, CL_TRUE, 0,
+                                     data_size_in_bytes, data.data(), 0,
+                                     nullptr, nullptr));
+  EXPECT_EQ(std::vector<cl_int>(global_size, 8), data);
+
+  EXPECT_SUCCESS(clReleaseMemObject(other_buffer));
+  EXPECT_SUCCESS(clReleaseCommandBufferKHR(mutable_command_buffer));
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, ReleaseWhileCapturing) {
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  ASSERT_SUCCESS(clReleaseCommandBufferKHR(command_buffer));
+  command_buffer = nullptr;
+
+  // Releasing the command-buffer ends capture, so commands execute again.
+  EXPECT_EQ_ERRCODE(
+      CL_INVALID_OPERATION,
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+  std::vector<cl_int> data(global_size, 100);
+  ASSERT_SUCCESS(clEnqueueWriteBuffer(command_queue, buffer, CL_FALSE, 0,
+                                      data_size_in_bytes, data.data(), 0,
+                                      nullptr, nullptr));
+  ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                        &global_size, nullptr, 0, nullptr,
+                                        nullptr));
+  ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, 0,
+                                     data_size_in_bytes, data.data(), 0,
+                                     nullptr, nullptr));
+  EXPECT_EQ(std::vector<cl_int>(global_size, 101), data);
+}
+
+TEST_F(clCommandBufferCaptureCODEPLAYTest, ReleaseWhileExecuting) {
+  ASSERT_SUCCESS(
+      clCommandBufferBeginCaptureCODEPLAY(command_queue, command_buffer));
+  ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                        &global_size, nullptr, 0, nullptr,
+                                        nullptr));
+  ASSERT_SUCCESS(
+      clCommandBufferEndCaptureCODEPLAY(command_queue, 0, nullptr, nullptr));
+  ASSERT_SUCCESS(clEnqueueCommandBufferKHR(0, nullptr, command_buffer, 0,
+                                           nullptr, nullptr));
+
+  // The queue now holds the last reference, which is dropped while the queue
+  // cleans up completed work.
+  ASSERT_SUCCESS(clReleaseCommandBufferKHR(command_buffer));
+  command_buffer = nullptr;
+  EXPECT_SUCCESS(clFinish(command_queue));
+}
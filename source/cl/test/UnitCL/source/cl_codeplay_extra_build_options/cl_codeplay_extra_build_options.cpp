@@ -147,6 +147,133 @@ TEST_F(cl_codeplay_extra_build_options_BuildFlags,
                      nullptr, nullptr));
 }
 
+TEST_F(cl_codeplay_extra_build_options_BuildFlags,
+       clBuildSpecializeArgsInvalid) {
+  ASSERT_EQ_ERRCODE(CL_INVALID_BUILD_OPTIONS,
+                    clBuildProgram(program, 0, nullptr,
+                                   "-cl-specialize-args=1,apples", nullptr,
+                                   nullptr));
+  ASSERT_EQ_ERRCODE(
+      CL_INVALID_BUILD_OPTIONS,
+      clBuildProgram(program, 0, nullptr, "-cl-specialize-args=-1", nullptr,
+                     nullptr));
+}
+
+TEST_F(cl_codeplay_extra_build_options_BuildFlags,
+       clBuildAndRunSpecializeArgs) {
+  const char *source = R"(
+      void kernel scale(global int *out, int n, int factor) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+          sum += factor;
+        }
+        out[get_global_id(0)] = sum;
+      })";
+  cl_int errorcode = CL_SUCCESS;
+  cl_program scale_program =
+      clCreateProgramWithSource(context, 1, &source, nullptr, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+  ASSERT_SUCCESS(clBuildProgram(scale_program, 0, nullptr,
+                                "-cl-specialize-args=1,2", nullptr, nullptr));
+
+  cl_kernel kernel = clCreateKernel(scale_program, "scale", &errorcode);
+  ASSERT_SUCCESS(errorcode);
+
+  const size_t work_size = 16;
+  cl_mem out_buffer =
+      clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_int) * work_size,
+                     nullptr, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+  EXPECT_SUCCESS(clSetKernelArg(kernel, 0, sizeof(cl_mem), &out_buffer));
+
+  cl_command_queue command_queue =
+      clCreateCommandQueue(context, device, 0, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+
+  // Each distinct set of values gets its own variant, check that a variant
+  // with the old values folded in isn't reused for the new values.
+  const cl_int args[][2] = {{4, 3}, {7, 2}, {4, 3}};
+  for (const auto &arg : args) {
+    EXPECT_SUCCESS(clSetKernelArg(kernel, 1, sizeof(cl_int), &arg[0]));
+    EXPECT_SUCCESS(clSetKernelArg(kernel, 2, sizeof(cl_int), &arg[1]));
+    ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                          &work_size, nullptr, 0, nullptr,
+                                          nullptr));
+    std::vector<cl_int> results(work_size);
+    ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, out_buffer, CL_TRUE, 0,
+                                       sizeof(cl_int) * work_size,
+                                       results.data(), 0, nullptr, nullptr));
+    for (const cl_int result : results) {
+      EXPECT_EQ(arg[0] * arg[1], result);
+    }
+  }
+
+  EXPECT_SUCCESS(clReleaseKernel(kernel));
+  EXPECT_SUCCESS(clReleaseMemObject(out_buffer));
+  EXPECT_SUCCESS(clReleaseCommandQueue(command_queue));
+  EXPECT_SUCCESS(clReleaseProgram(scale_program));
+}
+
+TEST_F(cl_codeplay_extra_build_options_BuildFlags,
+       clBuildAndRunSpecializeGlobalSize) {
+  const char *source = R"(
+      void kernel shape(global uint *out, uint n) {
+        size_t gid = get_global_id(0);
+        if (gid < n) {
+          out[gid - get_global_offset(0)] =
+              get_global_size(0) + get_num_groups(0) * 1000;
+        }
+      })";
+  cl_int errorcode = CL_SUCCESS;
+  cl_program shape_program =
+      clCreateProgramWithSource(context, 1, &source, nullptr, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+  ASSERT_SUCCESS(clBuildProgram(shape_program, 0, nullptr,
+                                "-cl-specialize-global-size", nullptr,
+                                nullptr));
+
+  cl_kernel kernel = clCreateKernel(shape_program, "shape", &errorcode);
+  ASSERT_SUCCESS(errorcode);
+
+  const size_t max_work_size = 64;
+  const size_t local_size = 4;
+  cl_mem out_buffer =
+      clCreateBuffer(context, CL_MEM_WRITE_ONLY,
+                     sizeof(cl_uint) * max_work_size, nullptr, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+  EXPECT_SUCCESS(clSetKernelArg(kernel, 0, sizeof(cl_mem), &out_buffer));
+
+  cl_command_queue command_queue =
+      clCreateCommandQueue(context, device, 0, &errorcode);
+  ASSERT_SUCCESS(errorcode);
+
+  // Each global size and offset gets its own variant, check that a variant
+  // specialized for one shape isn't reused for another.
+  const size_t shapes[][2] = {{16, 0}, {64, 0}, {16, 8}, {16, 0}};
+  for (const auto &shape : shapes) {
+    const size_t global_size = shape[0];
+    const size_t global_offset = shape[1];
+    const cl_uint n = global_offset + global_size;
+    EXPECT_SUCCESS(clSetKernelArg(kernel, 1, sizeof(cl_uint), &n));
+    ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1,
+                                          &global_offset, &global_size,
+                                          &local_size, 0, nullptr, nullptr));
+    std::vector<cl_uint> results(global_size);
+    ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, out_buffer, CL_TRUE, 0,
+                                       sizeof(cl_uint) * global_size,
+                                       results.data(), 0, nullptr, nullptr));
+    const cl_uint expected = global_size + (global_size / local_size) * 1000;
+    for (const cl_uint result : results) {
+      EXPECT_EQ(expected, result);
+    }
+  }
+
+  EXPECT_SUCCESS(clReleaseKernel(kernel));
+  EXPECT_SUCCESS(clReleaseMemObject(out_buffer));
+  EXPECT_SUCCESS(clReleaseCommandQueue(command_queue));
+  EXPECT_SUCCESS(clReleaseProgram(shape_program));
+}
+
 // Disabled because this test sets the global variable `Enabled`
 // from llvm::Statistics to true which causes later vecz runs to have
 // Statistics printed, which we don't want to unless explicitely asked.
@@ -0,0 +1,159 @@
+// Copyright (C) Codeplay Software Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License") with LLVM
+// Exceptions; you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://github.com/codeplaysoftware/oneapi-construction-kit/blob/main/LICENSE.txt
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <CL/cl_ext_codeplay.h>
+
+#include <array>
+#include <cstring>
+
+#include "Common.h"
+
+// Fixture checks the extension is enabled and creates a kernel with a buffer
+// and a scalar argument to set in a single call.
+struct clSetKernelArgsCODEPLAYTest : ucl::CommandQueueTest {
+  void SetUp() override {
+    UCL_RETURN_ON_FATAL_FAILURE(CommandQueueTest::SetUp());
+
+    // Requires a compiler to compile the kernel.
+    if (!getDeviceCompilerAvailable()) {
+      GTEST_SKIP();
+    }
+
+    if (!isPlatformExtensionSupported("cl_codeplay_set_kernel_args")) {
+      GTEST_SKIP();
+    }
+
+    clSetKernelArgsCODEPLAY = reinterpret_cast<clSetKernelArgsCODEPLAY_fn>(
+        clGetExtensionFunctionAddressForPlatform(platform,
+                                                 "clSetKernelArgsCODEPLAY"));
+    ASSERT_NE(clSetKernelArgsCODEPLAY, nullptr);
+
+    const char *code = R"(
+kernel void test(global int* out, int value) {
+  size_t id = get_global_id(0);
+  out[id] = value + (int)id;
+}
+)";
+    const size_t length = std::strlen(code);
+    cl_int error = !CL_SUCCESS;
+    program = clCreateProgramWithSource(context, 1, &code, &length, &error);
+    ASSERT_SUCCESS(error);
+    ASSERT_SUCCESS(clBuildProgram(program, 1, &device, nullptr,
+                                  ucl::buildLogCallback, nullptr));
+    kernel = clCreateKernel(program, "test", &error);
+    ASSERT_SUCCESS(error);
+
+    buffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY,
+                            sizeof(cl_int) * elements, nullptr, &error);
+    ASSERT_SUCCESS(error);
+  }
+
+  void TearDown() override {
+    if (buffer) {
+      EXPECT_SUCCESS(clReleaseMemObject(buffer));
+    }
+    if (kernel) {
+      EXPECT_SUCCESS(clReleaseKernel(kernel));
+    }
+    if (program) {
+      EXPECT_SUCCESS(clReleaseProgram(program));
+    }
+    CommandQueueTest::TearDown();
+  }
+
+  // Run the kernel and check every element was written with `value`.
+  void runAndCheck(cl_int value) {
+    ASSERT_SUCCESS(clEnqueueNDRangeKernel(command_queue, kernel, 1, nullptr,
+                                          &elements, nullptr, 0, nullptr,
+                                          nullptr));
+    std::array<cl_int, elements> result{};
+    ASSERT_SUCCESS(clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, 0,
+                                       sizeof(cl_int) * elements,
+                                       result.data(), 0, nullptr, nullptr));
+    for (size_t i = 0; i < elements; i++) {
+      EXPECT_EQ(value + static_cast<cl_int>(i), result[i]) << "at index " << i;
+    }
+  }
+
+  static constexpr size_t elements = 16;
+
+  cl_program program = nullptr;
+  cl_kernel kernel = nullptr;
+  cl_mem buffer = nullptr;
+  clSetKernelArgsCODEPLAY_fn clSetKernelArgsCODEPLAY = nullptr;
+};
+
+TEST_F(clSetKernelArgsCODEPLAYTest, InvalidKernel) {
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer}};
+  EXPECT_EQ_ERRCODE(CL_INVALID_KERNEL,
+                    clSetKernelArgsCODEPLAY(nullptr, 1, args));
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, InvalidValue) {
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer}};
+  EXPECT_EQ_ERRCODE(CL_INVALID_VALUE, clSetKernelArgsCODEPLAY(kernel, 0, args));
+  EXPECT_EQ_ERRCODE(CL_INVALID_VALUE,
+                    clSetKernelArgsCODEPLAY(kernel, 1, nullptr));
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, InvalidArgIndex) {
+  const cl_int value = 42;
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer},
+                                         {2, sizeof(cl_int), &value}};
+  EXPECT_EQ_ERRCODE(CL_INVALID_ARG_INDEX,
+                    clSetKernelArgsCODEPLAY(kernel, 2, args));
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, InvalidArgSize) {
+  const cl_int value = 42;
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer},
+                                         {1, sizeof(cl_long), &value}};
+  EXPECT_EQ_ERRCODE(CL_INVALID_ARG_SIZE,
+                    clSetKernelArgsCODEPLAY(kernel, 2, args));
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, Default) {
+  const cl_int value = 42;
+  const cl_kernel_arg_codeplay args[] = {{1, sizeof(cl_int), &value},
+                                         {0, sizeof(cl_mem), &buffer}};
+  ASSERT_SUCCESS(clSetKernelArgsCODEPLAY(kernel, 2, args));
+  runAndCheck(value);
+  // Enqueue again to reuse the descriptors prepared by the call.
+  runAndCheck(value);
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, PartialThenSetKernelArg) {
+  // Setting only some of the arguments must still allow the remaining ones to
+  // be set individually.
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer}};
+  ASSERT_SUCCESS(clSetKernelArgsCODEPLAY(kernel, 1, args));
+  const cl_int value = 7;
+  ASSERT_SUCCESS(clSetKernelArg(kernel, 1, sizeof(cl_int), &value));
+  runAndCheck(value);
+}
+
+TEST_F(clSetKernelArgsCODEPLAYTest, SetKernelArgAfterBatch) {
+  cl_int value = 42;
+  const cl_kernel_arg_codeplay args[] = {{0, sizeof(cl_mem), &buffer},
+                                         {1, sizeof(cl_int), &value}};
+  ASSERT_SUCCESS(clSetKernelArgsCODEPLAY(kernel, 2, args));
+  runAndCheck(42);
+
+  // Changing an argument afterwards must not enqueue the stale value.
+  value = 13;
+  ASSERT_SUCCESS(clSetKernelArg(kernel, 1, sizeof(cl_int), &value));
+  runAndCheck(13);
+}
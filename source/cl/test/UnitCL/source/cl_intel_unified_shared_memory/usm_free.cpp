@@ -14,6 +14,7 @@
 //
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <CL/cl_ext_codeplay.h>
 #include <Common.h>
 
 #include <thread>
@@ -89,6 +90,55 @@ TEST_F(USMTests, MemFree_ValidUsage) {
   EXPECT_SUCCESS(err);
 }
 
+// Test that freed allocations are returned to and reused from the context's
+// USM pool.
+TEST_F(USMTests, MemFree_PoolReuse) {
+  const size_t bytes = 256;
+  const cl_uint align = 4;
+
+  cl_usm_pool_statistics_codeplay before{};
+  ASSERT_SUCCESS(clGetContextInfo(context,
+                                  CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY,
+                                  sizeof(before), &before, nullptr));
+
+  cl_int err;
+  void *device_ptr =
+      clDeviceMemAllocINTEL(context, device, nullptr, bytes, align, &err);
+  ASSERT_SUCCESS(err);
+  ASSERT_SUCCESS(clMemBlockingFreeINTEL(context, device_ptr));
+
+  cl_usm_pool_statistics_codeplay freed{};
+  ASSERT_SUCCESS(clGetContextInfo(context,
+                                  CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY,
+                                  sizeof(freed), &freed, nullptr));
+  if (freed.cached_blocks == before.cached_blocks) {
+    // Pooling has been disabled with CA_CL_USM_POOL_SIZE=0.
+    GTEST_SKIP();
+  }
+  EXPECT_EQ(before.cached_blocks + 1, freed.cached_blocks);
+  EXPECT_LE(bytes, freed.cached_bytes - before.cached_bytes);
+
+  void *reused_ptr =
+      clDeviceMemAllocINTEL(context, device, nullptr, bytes, align, &err);
+  ASSERT_SUCCESS(err);
+  EXPECT_EQ(device_ptr, reused_ptr);
+
+  cl_usm_pool_statistics_codeplay after{};
+  ASSERT_SUCCESS(clGetContextInfo(context,
+                                  CL_CONTEXT_USM_POOL_STATISTICS_CODEPLAY,
+                                  sizeof(after), &after, nullptr));
+  EXPECT_EQ(freed.hits + 1, after.hits);
+  EXPECT_EQ(before.cached_blocks, after.cached_blocks);
+
+  size_t size = 0;
+  ASSERT_SUCCESS(clGetMemAllocInfoINTEL(context, reused_ptr,
+                                        CL_MEM_ALLOC_SIZE_INTEL, sizeof(size),
+                                        &size, nullptr));
+  EXPECT_EQ(bytes, size);
+
+  EXPECT_SUCCESS(clMemFreeINTEL(context, reused_ptr));
+}
+
 namespace {
 // Fixture to help testing of clMemBlockingFreeINTEL
 struct USMBlockingFreeTest : public cl_intel_unified_shared_memory_Test {
@@ -1013,3 +1013,65 @@ TEST_F(SubstituteCommandQueueTest, IncompatibleQueueContext) {
   EXPECT_SUCCESS(clReleaseCommandQueue(incompatible_command_queue));
   EXPECT_SUCCESS(clReleaseContext(new_context));
 }
+
+// Tests that a command-buffer enqueued to an out-of-order queue is ordered
+// after an earlier barrier.
+TEST_F(CommandBufferEnqueueTest, OutOfOrderQueueBarrier) {
+  cl_command_queue_properties properties = 0;
+  ASSERT_SUCCESS(clGetDeviceInfo(device, CL_DEVICE_QUEUE_PROPERTIES,
+                                 sizeof(properties), &properties, nullptr));
+  if (0 == (CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE & properties)) {
+    GTEST_SKIP();
+  }
+
+  cl_int error = CL_SUCCESS;
+  cl_command_queue queue = clCreateCommandQueue(
+      context, device, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &error);
+  ASSERT_SUCCESS(error);
+  cl_mem buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int),
+                                 nullptr, &error);
+  ASSERT_SUCCESS(error);
+  cl_event user_event = clCreateUserEvent(context, &error);
+  ASSERT_SUCCESS(error);
+
+  const cl_int second = 2;
+  cl_command_buffer_khr command_buffer =
+      clCreateCommandBufferKHR(1, &queue, nullptr, &error);
+  ASSERT_SUCCESS(error);
+  ASSERT_SUCCESS(clCommandFillBufferKHR(command_buffer, nullptr, buffer,
+                                        &second, sizeof(cl_int), 0,
+                                        sizeof(cl_int), 0, nullptr, nullptr,
+                                        nullptr));
+  ASSERT_SUCCESS(clFinalizeCommandBufferKHR(command_buffer));
+
+  // The first fill can't start until the user event is complete, without the
+  // barrier the command-buffer would be free to execute before it.
+  const cl_int first = 1;
+  ASSERT_SUCCESS(clEnqueueFillBuffer(queue, buffer, &first, sizeof(cl_int), 0,
+                                     sizeof(cl_int), 1, &user_event, nullptr));
+  ASSERT_SUCCESS(clEnqueueBarrierWithWaitList(queue, 0, nullptr, nullptr));
+  ASSERT_SUCCESS(clFlush(queue));
+  cl_event command_buffer_event;
+  ASSERT_SUCCESS(clEnqueueCommandBufferKHR(0, nullptr, command_buffer, 0,
+                                           nullptr, &command_buffer_event));
+  ASSERT_SUCCESS(clFlush(queue));
+
+  cl_int command_buffer_status;
+  ASSERT_SUCCESS(clGetEventInfo(
+      command_buffer_event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+      sizeof(command_buffer_status), &command_buffer_status, nullptr));
+  EXPECT_NE(CL_COMPLETE, command_buffer_status);
+
+  ASSERT_SUCCESS(clSetUserEventStatus(user_event, CL_COMPLETE));
+  cl_int result = 0;
+  ASSERT_SUCCESS(clEnqueueReadBuffer(queue, buffer, CL_TRUE, 0,
+                                     sizeof(cl_int), &result, 1,
+                                     &command_buffer_event, nullptr));
+  EXPECT_EQ(second, result);
+
+  EXPECT_SUCCESS(clReleaseEvent(command_buffer_event));
+  EXPECT_SUCCESS(clReleaseCommandBufferKHR(command_buffer));
+  EXPECT_SUCCESS(clReleaseEvent(user_event));
+  EXPECT_SUCCESS(clReleaseMemObject(buffer));
+  EXPECT_SUCCESS(clReleaseCommandQueue(queue));
+}
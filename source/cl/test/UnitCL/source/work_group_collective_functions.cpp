@@ -16,6 +16,7 @@
 #include <cargo/optional.h>
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "Common.h"
@@ -881,6 +882,139 @@ TEST_P(WorkGroupCollectiveScans,
   doReductionTest<cl_ulong>(scanMaxRefFn<cl_ulong, true>);
 }
 
+// Floating-point collectives take a separate path through the work-group
+// collective lowering (different neutral values, and NaN-aware identities for
+// exclusive min/max scans), so check them at runtime too. Additions use small
+// integer-valued inputs so the result is exact whatever order the
+// implementation combines sub-group results in; min and max are exact for any
+// finite input.
+struct WorkGroupCollectiveFloat
+    : public WorkGroupCollectiveScanReductionTestBase {
+  template <bool IntegerValued>
+  void doFloatTest(
+      const std::function<bool(size_t, cl_float,
+                               const std::vector<cl_float> &input_data,
+                               const NDRange &global_sizes,
+                               const NDRange &local_sizes)> &output_ref_fn) {
+    const auto &local_sizes = std::get<1>(GetParam());
+    NDRange global_sizes{local_sizes.x() * 4, local_sizes.y(), local_sizes.z()};
+
+    const auto global_size =
+        global_sizes[0] * global_sizes[1] * global_sizes[2];
+
+    std::vector<cl_float> input_data(global_size);
+
+    if (IntegerValued) {
+      std::vector<cl_int> int_data(global_size);
+      ucl::Environment::instance->GetInputGenerator().GenerateIntData<cl_int>(
+          int_data, -1024, 1024);
+      std::transform(int_data.begin(), int_data.end(), input_data.begin(),
+                     [](cl_int v) { return static_cast<cl_float>(v); });
+    } else {
+      ucl::Environment::instance->GetInputGenerator().GenerateFiniteFloatData(
+          input_data);
+    }
+
+    kts::Reference1D<cl_float> input_ref = [&input_data](size_t id) {
+      return input_data[id];
+    };
+
+    kts::Reference1D<cl_float> output_ref =
+        [&input_data, &global_sizes, &local_sizes, &output_ref_fn](
+            size_t global_linear_id, cl_float result) {
+          return output_ref_fn(global_linear_id, result, input_data,
+                               global_sizes, local_sizes);
+        };
+
+    this->AddInputBuffer(global_size, input_ref);
+    this->AddOutputBuffer(global_size, output_ref);
+    this->RunGenericND(3, global_sizes, local_sizes);
+  }
+};
+
+bool reduceMinFloatRefFn(size_t global_linear_id, cl_float result,
+                         const std::vector<cl_float> &input_data,
+                         const NDRange &global_sizes,
+                         const NDRange &local_sizes) {
+  const std::function<cl_float(cl_float, cl_float)> &reduce_fn =
+      [](cl_float a, cl_float b) { return std::fmin(a, b); };
+  return reduceBinOpRefFn<cl_float>(
+      global_linear_id, result, input_data, global_sizes, local_sizes,
+      std::numeric_limits<cl_float>::infinity(), reduce_fn);
+}
+
+bool reduceMaxFloatRefFn(size_t global_linear_id, cl_float result,
+                         const std::vector<cl_float> &input_data,
+                         const NDRange &global_sizes,
+                         const NDRange &local_sizes) {
+  const std::function<cl_float(cl_float, cl_float)> &reduce_fn =
+      [](cl_float a, cl_float b) { return std::fmax(a, b); };
+  return reduceBinOpRefFn<cl_float>(
+      global_linear_id, result, input_data, global_sizes, local_sizes,
+      -std::numeric_limits<cl_float>::infinity(), reduce_fn);
+}
+
+template <bool IsInclusive>
+bool scanMinFloatRefFn(size_t global_linear_id, cl_float result,
+                       const std::vector<cl_float> &input_data,
+                       const NDRange &global_sizes,
+                       const NDRange &local_sizes) {
+  const std::function<cl_float(cl_float, cl_float)> &scan_fn =
+      [](cl_float a, cl_float b) { return std::fmin(a, b); };
+  return scanBinOpRefFn<cl_float, IsInclusive>(
+      global_linear_id, result, input_data, global_sizes, local_sizes,
+      std::numeric_limits<cl_float>::infinity(), scan_fn);
+}
+
+template <bool IsInclusive>
+bool scanMaxFloatRefFn(size_t global_linear_id, cl_float result,
+                       const std::vector<cl_float> &input_data,
+                       const NDRange &global_sizes,
+                       const NDRange &local_sizes) {
+  const std::function<cl_float(cl_float, cl_float)> &scan_fn =
+      [](cl_float a, cl_float b) { return std::fmax(a, b); };
+  return scanBinOpRefFn<cl_float, IsInclusive>(
+      global_linear_id, result, input_data, global_sizes, local_sizes,
+      -std::numeric_limits<cl_float>::infinity(), scan_fn);
+}
+
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_15_Reduce_Add_Float) {
+  doFloatTest</*IntegerValued*/ true>(reduceAddRefFn<cl_float>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_15_Reduce_Min_Float) {
+  doFloatTest</*IntegerValued*/ false>(reduceMinFloatRefFn);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_15_Reduce_Max_Float) {
+  doFloatTest</*IntegerValued*/ false>(reduceMaxFloatRefFn);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_16_Scan_Exclusive_Add_Float) {
+  doFloatTest</*IntegerValued*/ true>(scanAddRefFn<cl_float, false>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_16_Scan_Exclusive_Min_Float) {
+  doFloatTest</*IntegerValued*/ false>(scanMinFloatRefFn<false>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_16_Scan_Exclusive_Max_Float) {
+  doFloatTest</*IntegerValued*/ false>(scanMaxFloatRefFn<false>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_17_Scan_Inclusive_Add_Float) {
+  doFloatTest</*IntegerValued*/ true>(scanAddRefFn<cl_float, true>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_17_Scan_Inclusive_Min_Float) {
+  doFloatTest</*IntegerValued*/ false>(scanMinFloatRefFn<true>);
+}
+TEST_P(WorkGroupCollectiveFloat,
+       Work_Group_Collective_Functions_17_Scan_Inclusive_Max_Float) {
+  doFloatTest</*IntegerValued*/ false>(scanMaxFloatRefFn<true>);
+}
+
 static const NDRange local_sizes[] = {
     NDRange{64u, 1u, 1u}, NDRange{1u, 64u, 1u}, NDRange{1u, 1u, 64u},
     NDRange{67u, 1u, 1u}, NDRange{67u, 5u, 1u}, NDRange{67u, 2u, 3u},
@@ -917,3 +1051,11 @@ UCL_EXECUTION_TEST_SUITE_P(WorkGroupCollectiveScans,
 UCL_EXECUTION_TEST_SUITE_P(WorkGroupCollectiveReductions,
                            testing::ValuesIn(source_types),
                            testing::ValuesIn(local_sizes));
+
+// There are no pre-compiled SPIR-V modules for the floating-point kernels.
+static const kts::ucl::SourceType float_source_types[] = {kts::ucl::OPENCL_C,
+                                                          kts::ucl::OFFLINE};
+
+UCL_EXECUTION_TEST_SUITE_P(WorkGroupCollectiveFloat,
+                           testing::ValuesIn(float_source_types),
+                           testing::ValuesIn(local_sizes));